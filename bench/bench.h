@@ -0,0 +1,77 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file bench.h
+ * @brief ベンチマークの計測と結果出力に関する定義・宣言
+ * @details 時間は SysTick (プロセッサクロック, 24 ビットのダウンカウンタ) で測る。
+ *          QEMU を -icount shift=0 で動かすと 1 命令 = 1 ns になるので、
+ *          カウント値からそのまま命令数が求まる (bench/run.sh を参照)。
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdint.h>
+#include "system.h"
+
+#ifndef BENCH_ITER
+  #define BENCH_ITER 10000              /* 1 項目あたりの繰り返し回数 */
+#endif
+#ifndef BENCH_CLOCK_HZ
+  #define BENCH_CLOCK_HZ 25000000       /* SysTick のクロック (QEMU mps2-an385 は 25 MHz) */
+#endif
+#ifndef BENCH_OUT
+  #define BENCH_OUT "bench.tsv"         /* 結果ファイル (QEMU を起動したディレクトリに作られる) */
+#endif
+
+#define BENCH_TICK_MASK 0xFFFFFF
+
+/**
+ * @def BENCH(name, stmt)
+ * @details stmt を BENCH_ITER 回繰り返した時間を計測して結果に書く。
+ *          ループ変数 __i を stmt の中で使ってよい。
+ */
+#define BENCH(name, stmt) BENCH_BLOCK(name, 1, stmt)
+
+/**
+ * @def BENCH_BLOCK(name, n, stmt)
+ * @details BENCH() と同じだが、stmt が n サンプルを処理するものとして結果に n も書く
+ *          (bench/run.sh が 1 サンプルあたりの値も出す)。
+ */
+#define BENCH_BLOCK(name, n, stmt) \
+    do { \
+        uint32_t __i, __t = bench_now(); \
+        for (__i = 0; __i < BENCH_ITER; __i++) { \
+            stmt; \
+            __asm volatile ("" ::: "memory"); \
+        } \
+        bench_report_block(name, BENCH_ITER, bench_elapsed(__t), n); \
+    } while (0)
+
+/**
+ * @brief 現在のカウント値を返す
+ * @return SysTick の現在値
+ */
+static inline uint32_t bench_now(void)
+{
+    return reg_read(SYST(CVR));
+}
+
+/**
+ * @brief bench_now() からの経過カウント数を返す
+ * @param[in] t bench_now() の値
+ * @return 経過カウント数 (2^24 未満であること)
+ */
+static inline uint32_t bench_elapsed(uint32_t t)
+{
+    return (t - bench_now()) & BENCH_TICK_MASK;
+}
+
+void bench_open(void);
+void bench_note(const char *key, uint32_t v);
+void bench_report(const char *name, uint32_t iter, uint32_t ticks);
+void bench_report_block(const char *name, uint32_t iter, uint32_t ticks, uint32_t n);
+void bench_exit(uint8_t ok) __attribute__ ((noreturn));
+void dsp_bench(void);
+
+#endif
@@ -0,0 +1,86 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file board.c
+ * @brief QEMU (mps2-an385) 上で動かすための system.c, fault.c の代替
+ * @details LPC1343 のクロック設定やリセット要因のレジスタは QEMU にないので、
+ *          startup.c から呼ばれる関数をここで置き換える。
+ *          sys_init() は .data/.bss の初期化より前に呼ばれるので、
+ *          ここで SysTick を動かしておけば main() の先頭で初期化にかかった時間がわかる。
+ */
+
+#include "system.h"
+#include "fault.h"
+#include "bench.h"
+
+/**
+ * @brief リセット要因の取得 (何もしない)
+ * @return なし
+ */
+void sys_capture_reset(void)
+{
+}
+
+/**
+ * @brief SysTick をフリーランで動かす
+ * @return なし
+ */
+void sys_init(void)
+{
+    reg_write(SYST(RVR), BENCH_TICK_MASK);
+    reg_write(SYST(CVR), 0);
+    reg_write(SYST(CSR), SYST_CSR_ENABLE | SYST_CSR_CLKSOURCE);
+}
+
+/**
+ * @brief システムクロック周波数を返す
+ * @return 周波数 [Hz]
+ */
+uint32_t sys_clock(void)
+{
+    return BENCH_CLOCK_HZ;
+}
+
+/**
+ * @brief クロック変更時の関数を登録する (周波数は変わらないので何もしない)
+ * @return 0
+ */
+int8_t sys_clock_hook(sys_clock_hook_t fn)
+{
+    return 0;
+}
+
+/**
+ * @brief ウォームスタートかどうか (QEMU では常にコールドスタート)
+ * @return 0
+ */
+uint8_t sys_warm_start(void)
+{
+    return 0;
+}
+
+/**
+ * @brief リセットの代わりに異常終了する
+ * @return なし
+ */
+void sys_reset(void)
+{
+    bench_exit(0);
+}
+
+/**
+ * @brief 例外の捕捉 (startup.c の ex_handler から呼ばれる)
+ * @param[in] frame 例外フレーム
+ * @param[in] r4_r11 退避した r4-r11
+ * @param[in] exc_return EXC_RETURN
+ * @return なし
+ */
+void fault_capture(const uint32_t *frame, const uint32_t *r4_r11, uint32_t exc_return)
+{
+    uint32_t ipsr;
+
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    bench_note("fault_vector", ipsr & 0x1FF);
+    bench_note("fault_pc", frame[6]);
+    bench_exit(0);
+}
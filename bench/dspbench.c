@@ -0,0 +1,270 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file dspbench.c
+ * @brief dsp.h の検証とベンチマーク
+ * @details 1 サンプルずつ素直に計算する参照実装と出力がビット単位で一致することを確かめてから、
+ *          DSPBENCH_BLOCK サンプルのブロック 1 回あたりの時間を測り、1 サンプルあたりの値も出す。
+ *          一致しなければ検証に失敗した項目を注記に書いて異常終了する。\n
+ *          ホストのテスト (test/test_dsp.c) は C の代替実装しか通らないので、SSAT や SMLAL を使う
+ *          ターゲットのコードはここで確かめる。
+ */
+
+#include <stdint.h>
+#include "dsp.h"
+#include "bench.h"
+
+#define DSPBENCH_BLOCK 32               /* 1 回に処理するサンプル数 */
+#define DSPBENCH_TAPS  16               /* FIR のタップ数 */
+#define DSPBENCH_LEN   (DSPBENCH_BLOCK * 8)    /* 検証に使う入力の長さ */
+#define DSPBENCH_MED   9                /* メディアンの窓 */
+
+/* 低域通過 FIR (Q15, 絶対値の和 < 2) */
+static const q15_t s_fir15[DSPBENCH_TAPS] = {
+    -120, -310, -280, 390, 1820, 3650, 5160, 5740,
+    5160, 3650, 1820, 390, -280, -310, -120, 40,
+};
+
+/* 2 段の双二次 (Q14; a1, a2 は符号を反転したもの) */
+static const q15_t s_bq15[10] = {
+    1024, 2048, 1024, 21000, -8900,
+    4096, -8192, 4096, 24000, -11000,
+};
+
+static q15_t s_in15[DSPBENCH_LEN];
+static q31_t s_in31[DSPBENCH_LEN];
+static q15_t s_out15[DSPBENCH_LEN];
+static q31_t s_out31[DSPBENCH_LEN];
+static q31_t s_fir31[DSPBENCH_TAPS];
+static q31_t s_bq31[10];
+
+static q15_t s_st15[DSPBENCH_TAPS * 2];
+static q31_t s_st31[DSPBENCH_TAPS * 2];
+static q15_t s_hist[DSPBENCH_MED];
+static q15_t s_sorted[DSPBENCH_MED];
+static q15_t s_mbuf[DSPBENCH_TAPS];
+
+static int32_t clamp(int64_t v, int32_t lo, int32_t hi);
+static void fail(const char *what);
+static void verify_fir(void);
+static void verify_biquad(void);
+static void verify_median(void);
+static void verify_misc(void);
+
+/**
+ * @brief dsp.h を検証して測る
+ * @return なし
+ */
+void dsp_bench(void)
+{
+    dsp_fir_q15_t f15;
+    dsp_fir_q31_t f31;
+    dsp_biquad_q15_t b15;
+    dsp_biquad_q31_t b31;
+    dsp_mavg_t ma;
+    dsp_median_t md;
+    dsp_decim_q15_t dc;
+    uint32_t i, seed = 12345;
+
+    /* 入力: 大きめの正弦波もどきに雑音を足したもの (飽和も起こるように) */
+    for (i = 0; i < DSPBENCH_LEN; i++) {
+        seed = seed * 1103515245 + 12345;
+        s_in15[i] = (int16_t)(((i & 31) < 16 ? 1500 : -1500) * (int32_t)(i & 15) + ((int32_t)(seed >> 16) & 0x3FFF) - 0x2000);
+        s_in31[i] = (int32_t)seed;
+    }
+    for (i = 0; i < DSPBENCH_TAPS; i++) s_fir31[i] = s_fir15[i] * 65536;
+    for (i = 0; i < 10; i++) s_bq31[i] = s_bq15[i] * 65536;
+
+    verify_fir();
+    verify_biquad();
+    verify_median();
+    verify_misc();
+
+    bench_note("dsp_block", DSPBENCH_BLOCK);
+    bench_note("dsp_taps", DSPBENCH_TAPS);
+
+    dsp_fir_q15_init(&f15, s_fir15, s_st15, DSPBENCH_TAPS);
+    BENCH_BLOCK("dsp_fir_q15", DSPBENCH_BLOCK, dsp_fir_q15(&f15, s_in15, s_out15, DSPBENCH_BLOCK));
+    dsp_fir_q31_init(&f31, s_fir31, s_st31, DSPBENCH_TAPS);
+    BENCH_BLOCK("dsp_fir_q31", DSPBENCH_BLOCK, dsp_fir_q31(&f31, s_in31, s_out31, DSPBENCH_BLOCK));
+    dsp_biquad_q15_init(&b15, s_bq15, s_st15, 2);
+    BENCH_BLOCK("dsp_biquad_q15_2st", DSPBENCH_BLOCK, dsp_biquad_q15(&b15, s_in15, s_out15, DSPBENCH_BLOCK));
+    dsp_biquad_q31_init(&b31, s_bq31, s_st31, 2);
+    BENCH_BLOCK("dsp_biquad_q31_2st", DSPBENCH_BLOCK, dsp_biquad_q31(&b31, s_in31, s_out31, DSPBENCH_BLOCK));
+    dsp_mavg_init(&ma, s_mbuf, DSPBENCH_TAPS);
+    BENCH_BLOCK("dsp_mavg", DSPBENCH_BLOCK, dsp_mavg(&ma, s_in15, s_out15, DSPBENCH_BLOCK));
+    dsp_median_init(&md, s_hist, s_sorted, DSPBENCH_MED);
+    BENCH_BLOCK("dsp_median_9", DSPBENCH_BLOCK, dsp_median(&md, s_in15, s_out15, DSPBENCH_BLOCK));
+    dsp_decim_q15_init(&dc, s_fir15, s_st15, DSPBENCH_TAPS, 4);
+    BENCH_BLOCK("dsp_decim_q15_4", DSPBENCH_BLOCK, dsp_decim_q15(&dc, s_in15, s_out15, DSPBENCH_BLOCK));
+    BENCH("dsp_isqrt32", s_out31[0] = dsp_isqrt32(__i * 429497));
+    BENCH("dsp_atan2_q15", s_out15[0] = dsp_atan2_q15(s_in15[__i & 31], s_in15[(__i + 7) & 31]));
+}
+
+/**
+ * @brief FIR を参照実装と比べる (ブロックの切れ目も試すため、長さを変えながら処理する)
+ * @return なし
+ */
+static void verify_fir(void)
+{
+    dsp_fir_q15_t f15;
+    dsp_fir_q31_t f31;
+    uint32_t i, k, n;
+
+    dsp_fir_q15_init(&f15, s_fir15, s_st15, DSPBENCH_TAPS);
+    dsp_fir_q31_init(&f31, s_fir31, s_st31, DSPBENCH_TAPS);
+    for (i = 0; i < DSPBENCH_LEN; i += n) {
+        n = (i & 7) + 1;
+        if (i + n > DSPBENCH_LEN) n = DSPBENCH_LEN - i;
+        dsp_fir_q15(&f15, &s_in15[i], &s_out15[i], n);
+        dsp_fir_q31(&f31, &s_in31[i], &s_out31[i], n);
+    }
+
+    for (i = 0; i < DSPBENCH_LEN; i++) {
+        int64_t a15 = 0x4000, a31 = 1L << 30;
+        for (k = 0; k < DSPBENCH_TAPS && k <= i; k++) {
+            a15 += (int32_t)s_fir15[k] * s_in15[i - k];
+            a31 += (int64_t)s_fir31[k] * s_in31[i - k];
+        }
+        if (s_out15[i] != clamp(a15 >> 15, -32768, 32767)) fail("fir_q15");
+        if (s_out31[i] != clamp(a31 >> 31, -0x7FFFFFFF - 1, 0x7FFFFFFF)) fail("fir_q31");
+    }
+}
+
+/**
+ * @brief 双二次 IIR を参照実装 (1 サンプルずつ全段を通す) と比べる
+ * @return なし
+ */
+static void verify_biquad(void)
+{
+    dsp_biquad_q15_t b15;
+    dsp_biquad_q31_t b31;
+    int32_t z15[2][4] = { { 0 } };
+    int32_t z31[2][4] = { { 0 } };
+    uint32_t i, s;
+
+    dsp_biquad_q15_init(&b15, s_bq15, s_st15, 2);
+    dsp_biquad_q31_init(&b31, s_bq31, s_st31, 2);
+    for (i = 0; i < DSPBENCH_LEN; i += DSPBENCH_BLOCK) {
+        dsp_biquad_q15(&b15, &s_in15[i], &s_out15[i], DSPBENCH_BLOCK);
+        dsp_biquad_q31(&b31, &s_in31[i], &s_out31[i], DSPBENCH_BLOCK);
+    }
+
+    for (i = 0; i < DSPBENCH_LEN; i++) {
+        int32_t x15 = s_in15[i], x31 = s_in31[i];
+        for (s = 0; s < 2; s++) {
+            const q15_t *c = &s_bq15[s * 5];
+            const q31_t *d = &s_bq31[s * 5];
+            int64_t a15 = (1 << 13) + (int64_t)c[0] * x15 + (int64_t)c[1] * z15[s][0] + (int64_t)c[2] * z15[s][1]
+                          + (int64_t)c[3] * z15[s][2] + (int64_t)c[4] * z15[s][3];
+            int64_t a31 = (1 << 29) + (int64_t)d[0] * x31 + (int64_t)d[1] * z31[s][0] + (int64_t)d[2] * z31[s][1]
+                          + (int64_t)d[3] * z31[s][2] + (int64_t)d[4] * z31[s][3];
+            z15[s][1] = z15[s][0];
+            z15[s][0] = x15;
+            z15[s][3] = z15[s][2];
+            z15[s][2] = x15 = clamp(a15 >> 14, -32768, 32767);
+            z31[s][1] = z31[s][0];
+            z31[s][0] = x31;
+            z31[s][3] = z31[s][2];
+            z31[s][2] = x31 = clamp(a31 >> 30, -0x7FFFFFFF - 1, 0x7FFFFFFF);
+        }
+        if (s_out15[i] != x15) fail("biquad_q15");
+        if (s_out31[i] != x31) fail("biquad_q31");
+    }
+}
+
+/**
+ * @brief メディアンを参照実装 (窓を毎回並べ替える) と比べる
+ * @return なし
+ */
+static void verify_median(void)
+{
+    dsp_median_t md;
+    q15_t w[DSPBENCH_MED];
+    uint32_t i, j, k;
+
+    if (dsp_median_init(&md, s_hist, s_sorted, DSPBENCH_MED - 1) == 0) fail("median_init");
+    dsp_median_init(&md, s_hist, s_sorted, DSPBENCH_MED);
+    dsp_median(&md, s_in15, s_out15, DSPBENCH_LEN);
+
+    for (i = 0; i < DSPBENCH_LEN; i++) {
+        for (j = 0; j < DSPBENCH_MED; j++) {
+            q15_t v = (i + j >= DSPBENCH_MED - 1) ? s_in15[i + j - (DSPBENCH_MED - 1)] : 0;
+            for (k = j; k > 0 && w[k - 1] > v; k--) w[k] = w[k - 1];
+            w[k] = v;
+        }
+        if (s_out15[i] != w[DSPBENCH_MED / 2]) fail("median");
+    }
+}
+
+/**
+ * @brief 移動平均, 間引き, 整数の平方根を確かめる
+ * @return なし
+ */
+static void verify_misc(void)
+{
+    dsp_mavg_t ma;
+    dsp_decim_q15_t dc;
+    uint32_t i, k, n, len;
+
+    /* 移動平均: 2 のべき (シフト) とそれ以外 (除算) で、負の方向に切り捨てること */
+    for (len = 15; len <= 16; len++) {
+        dsp_mavg_init(&ma, s_mbuf, len);
+        dsp_mavg(&ma, s_in15, s_out15, DSPBENCH_LEN);
+        for (i = 0; i < DSPBENCH_LEN; i++) {
+            int32_t sum = 0, q;
+            for (k = 0; k < len && k <= i; k++) sum += s_in15[i - k];
+            q = sum / (int32_t)len;
+            if (q * (int32_t)len > sum) q--;
+            if (s_out15[i] != q) fail("mavg");
+        }
+    }
+
+    /* 間引き: 同じ係数の FIR の出力の m 個に 1 個と一致すること */
+    dsp_decim_q15_init(&dc, s_fir15, s_st15, DSPBENCH_TAPS, 3);
+    for (i = n = 0; i < DSPBENCH_LEN; i += DSPBENCH_BLOCK) {
+        n += dsp_decim_q15(&dc, &s_in15[i], &s_out15[n], DSPBENCH_BLOCK);
+    }
+    if (n != DSPBENCH_LEN / 3) fail("decim_count");
+    for (i = 0; i < n; i++) {
+        int32_t acc = 0x4000;
+        uint32_t t = i * 3 + 2;
+        for (k = 0; k < DSPBENCH_TAPS && k <= t; k++) acc += s_fir15[k] * s_in15[t - k];
+        if (s_out15[i] != clamp(acc >> 15, -32768, 32767)) fail("decim");
+    }
+
+    /* 整数の平方根: r^2 <= x < (r + 1)^2 */
+    for (i = 0; i < 4096; i++) {
+        uint32_t x = (i < 2048) ? i : i * 1048573 + (i >> 3);
+        uint64_t r = dsp_isqrt32(x);
+        if (r * r > x || (r + 1) * (r + 1) <= x) fail("isqrt32");
+    }
+    if (dsp_isqrt32(0xFFFFFFFF) != 0xFFFF) fail("isqrt32");
+
+    /* atan2: 軸と対角線 (pi は -32768 に折り返す) */
+    if (dsp_atan2_q15(0, 100) != 0 || dsp_atan2_q15(100, 0) != 16384
+        || dsp_atan2_q15(0, -100) != -32768 || dsp_atan2_q15(-100, 0) != -16384) fail("atan2");
+    if (dsp_atan2_q15(100, 100) != 8192 || dsp_atan2_q15(-100, -100) != -24576) fail("atan2");
+}
+
+/**
+ * @brief 値を範囲内に収める
+ * @param[in] v 値
+ * @param[in] lo, hi 範囲
+ * @return 収めた値
+ */
+static int32_t clamp(int64_t v, int32_t lo, int32_t hi)
+{
+    return (v < lo) ? lo : (v > hi) ? hi : (int32_t)v;
+}
+
+/**
+ * @brief 検証の失敗を書いて異常終了する
+ * @param[in] what 失敗した項目
+ * @return なし
+ */
+static void fail(const char *what)
+{
+    bench_note(what, 0);
+    bench_exit(0);
+}
@@ -0,0 +1,143 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file main.c
+ * @brief common/ のベンチマーク
+ * @details QEMU (mps2-an385) の上で動かし、項目ごとの所要カウント数を結果ファイルに書く。
+ *          ペリフェラルのレジスタは Makefile で RAM 上の領域に置き換えてあるので、
+ *          命令列は実機と同じだがバスの待ち時間は反映されない。
+ */
+
+#include <stdint.h>
+#include "system.h"
+#include "pool.h"
+#include "log.h"
+#include "bitbang.h"
+#include "initseq.h"
+#include "bench.h"
+
+#ifndef BENCH_BITBAND
+  #define BENCH_BITBAND 1               /* ペリフェラルのビットバンド経路も測る */
+#endif
+#ifndef BENCH_BB_REG
+  #define BENCH_BB_REG 0x40000008       /* ビットバンドで書き換えてよいレジスタ (mps2 の TIMER0 RELOAD) */
+#endif
+
+/* スタートアップルーチンの .data/.bss 初期化を測るための領域 */
+uint32_t g_data_blob[256] = { 1 };
+uint32_t g_bss_blob[1024];
+
+static volatile uint32_t s_reg;         /* レジスタの代わり */
+static volatile uint32_t s_sink;        /* 結果の捨て先 (最適化で消されないように) */
+
+/* クロック設定 (system.c) と同じ形の初期化シーケンス。SYSCON は shadow の RAM に置き換わっている */
+static const initseq_t initseq_bench[] = {
+    INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_SYSOSC_PD_Msk),
+    INITSEQ_WRITE(SYSCON(SYSOSCCTRL), 0),
+    INITSEQ_WRITE(SYSCON(SYSPLLCLKSEL), 1),
+    INITSEQ_UPDATE(SYSCON(SYSPLLCLKUEN)),
+    INITSEQ_WRITE(SYSCON(SYSPLLCTRL), 0x25),
+    INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_SYSPLL_PD_Msk),
+    INITSEQ_POLL(SYSCON(SYSPLLSTAT), SYSCON_SYSPLLSTAT_LOCK_Msk),
+    INITSEQ_WRITE(SYSCON(SYSAHBCLKDIV), 1),
+    INITSEQ_WRITE(SYSCON(MAINCLKSEL), 3),
+    INITSEQ_UPDATE(SYSCON(MAINCLKUEN)),
+};
+
+/* リンカスクリプトのロケーションカウンタを参照する */
+extern uint32_t _sdata;
+extern uint32_t _edata;
+extern uint32_t _sbss;
+extern uint32_t _ebss;
+
+/**
+ * @brief initseq_bench と同じ設定を、変更前の system.c と同じく 1 つずつ書く
+ * @return なし
+ */
+static void clk_open_coded(void)
+{
+    syscon_regs_t *const syscon = LPC_SYSCON;
+
+    syscon->PDRUNCFG &= ~SYSCON_PDRUNCFG_SYSOSC_PD_Msk;
+    syscon->SYSOSCCTRL = 0;
+    syscon->SYSPLLCLKSEL = 1;
+    syscon->SYSPLLCLKUEN = 1;
+    syscon->SYSPLLCLKUEN = 0;
+    syscon->SYSPLLCLKUEN = 1;
+    while (!(syscon->SYSPLLCLKUEN & 1));
+    syscon->SYSPLLCTRL = 0x25;
+    syscon->PDRUNCFG &= ~SYSCON_PDRUNCFG_SYSPLL_PD_Msk;
+    while (!(syscon->SYSPLLSTAT & SYSCON_SYSPLLSTAT_LOCK_Msk));
+    syscon->SYSAHBCLKDIV = 1;
+    syscon->MAINCLKSEL = 3;
+    syscon->MAINCLKUEN = 1;
+    syscon->MAINCLKUEN = 0;
+    syscon->MAINCLKUEN = 1;
+    while (!(syscon->MAINCLKUEN & 1));
+}
+
+/**
+ * @brief ベンチマークを順に実行して結果を書く
+ * @return 0: 正常終了
+ */
+int main(void)
+{
+    uint32_t startup = BENCH_TICK_MASK - bench_now();   /* sys_init() から main() まで */
+    uint32_t a = (uint32_t)&s_reg;
+    bb_pin_t pin;
+
+    bench_open();
+    bench_note("iter", BENCH_ITER);
+    bench_note("data_bytes", (uint32_t)&_edata - (uint32_t)&_sdata);
+    bench_note("bss_bytes", (uint32_t)&_ebss - (uint32_t)&_sbss);
+    bench_report("startup_data_bss", 1, startup);
+
+    reg_write(SYSCON(SYSAHBCLKDIV), 1);
+    pool_init();
+    log_init();
+    bb_pin_init(&pin, BB_PIN(0, 7), BB_PUSHPULL);
+
+    /* ループ自体のオーバーヘッド (run.sh が他の項目から差し引く) */
+    BENCH("loop", );
+
+    /* レジスタ層 */
+    BENCH("reg_write", reg_write(a, __i));
+    BENCH("reg_read", s_sink = reg_read(a));
+    BENCH("reg_set_bits", reg_set_bits(a, 0x10));
+    BENCH("reg_modify", reg_modify(a, 0xF0, __i & 0xF0));
+    BENCH("reg_write_bit", reg_write_bit(a, 3, __i & 1));
+    #if (BENCH_BITBAND)
+        BENCH("reg_write_bit_bb", reg_write_bit(BENCH_BB_REG, 3, __i & 1));
+    #endif
+    BENCH("atomic_add", atomic_add(&s_reg, 1));
+    BENCH("crit_enter_exit", crit_exit(crit_enter(2)));
+
+    /* GPIO */
+    BENCH("gpio_set_dir", gpio_set_dir(0, 7, __i & 1));
+    BENCH("gpio_write", gpio_write(0, 7, __i & 1));
+    BENCH("gpio_read", s_sink = gpio_read(0, 1));
+    BENCH("bb_pin_write", (__i & 1) ? bb_high(&pin) : bb_low(&pin));
+
+    /* 遅延時間の換算, タイマの設定 */
+    BENCH("tmr32_to_ticks_ms", s_sink = tmr32_to_ticks(__i, 1000));
+    BENCH("tmr32_to_ticks_us", s_sink = tmr32_to_ticks(__i, 1000000));
+    BENCH("tmr32_start", tmr32_start(1, __i));
+
+    /* メモリプール, ログ */
+    BENCH("pool_alloc_free", pool_free(pool_alloc(24)));
+    BENCH("log_2args", LOG("bench %u %u", __i, s_reg));
+
+    /* 初期化シーケンス: 表のインタプリタと 1 つずつ書くコード (PLL はロック済みにしておく) */
+    reg_write(SYSCON(SYSPLLSTAT), SYSCON_SYSPLLSTAT_LOCK_Msk);
+    BENCH("initseq_clk_table", INITSEQ_RUN(initseq_bench));
+    BENCH("initseq_clk_open", clk_open_coded());
+    bench_note("initseq_clk_table_bytes", sizeof(initseq_bench));
+
+    /* 固定小数点の信号処理 (検証してから測る) */
+    dsp_bench();
+
+    s_sink = g_data_blob[0] + g_bss_blob[0];
+    bench_exit(1);
+
+    return 0;
+}
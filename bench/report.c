@@ -0,0 +1,182 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file report.c
+ * @brief ベンチマーク結果の出力 (ARM セミホスティング)
+ * @details 結果は 1 行 1 項目のタブ区切りテキストで BENCH_OUT とコンソールに書く。\n
+ *          "名前 繰り返し回数 カウント数 [1 回あたりのサンプル数]" の行と、"# キー 値" の注記行からなる。
+ *          QEMU では -semihosting-config enable=on,target=native で有効になる。
+ *          実機でも OpenOCD の "arm semihosting enable" で同じように動く。
+ */
+
+#include "bench.h"
+
+#define SYS_OPEN   0x01
+#define SYS_CLOSE  0x02
+#define SYS_WRITE0 0x04
+#define SYS_WRITE  0x05
+#define SYS_EXIT   0x18
+
+#define OPEN_MODE_W 4                   /* fopen() の "w" */
+
+#define ADP_STOPPED_APPLICATION_EXIT 0x20026
+#define ADP_STOPPED_RUNTIME_ERROR    0x20023
+
+static int32_t s_fd = -1;
+
+static int32_t semihost(uint32_t op, const void *arg);
+static void put(const char *s);
+static char *utoa(char *p, uint32_t v);
+static uint32_t length(const char *s);
+
+/**
+ * @brief 結果ファイルを開いて注記を書く
+ * @return なし
+ */
+void bench_open(void)
+{
+    uint32_t arg[3];
+
+    arg[0] = (uint32_t)BENCH_OUT;
+    arg[1] = OPEN_MODE_W;
+    arg[2] = length(BENCH_OUT);
+    s_fd = semihost(SYS_OPEN, arg);
+
+    bench_note("clock", BENCH_CLOCK_HZ);
+}
+
+/**
+ * @brief 注記行 "# key v" を書く
+ * @param[in] key キー
+ * @param[in] v 値
+ * @return なし
+ */
+void bench_note(const char *key, uint32_t v)
+{
+    char num[12];
+
+    put("# ");
+    put(key);
+    put("\t");
+    *utoa(num, v) = '\0';
+    put(num);
+    put("\n");
+}
+
+/**
+ * @brief 結果行 "name iter ticks" を書く
+ * @param[in] name 項目名
+ * @param[in] iter 繰り返し回数
+ * @param[in] ticks カウント数
+ * @return なし
+ */
+void bench_report(const char *name, uint32_t iter, uint32_t ticks)
+{
+    bench_report_block(name, iter, ticks, 1);
+}
+
+/**
+ * @brief 結果行 "name iter ticks n" を書く (n が 1 なら n は省く)
+ * @param[in] name 項目名
+ * @param[in] iter 繰り返し回数
+ * @param[in] ticks カウント数
+ * @param[in] n 1 回あたりのサンプル数
+ * @return なし
+ */
+void bench_report_block(const char *name, uint32_t iter, uint32_t ticks, uint32_t n)
+{
+    char num[36];
+    char *p;
+
+    put(name);
+    p = utoa(num, iter);
+    *p++ = '\t';
+    p = utoa(p, ticks);
+    if (n > 1) {
+        *p++ = '\t';
+        p = utoa(p, n);
+    }
+    *p = '\0';
+    put("\t");
+    put(num);
+    put("\n");
+}
+
+/**
+ * @brief 結果ファイルを閉じて QEMU を終了させる
+ * @param[in] ok 0 なら異常終了
+ * @return なし
+ */
+void bench_exit(uint8_t ok)
+{
+    uint32_t reason = ok ? ADP_STOPPED_APPLICATION_EXIT : ADP_STOPPED_RUNTIME_ERROR;
+
+    if (s_fd >= 0) semihost(SYS_CLOSE, &s_fd);
+    semihost(SYS_EXIT, (const void *)reason);
+    while (1);
+}
+
+/**
+ * @brief セミホスティング呼び出し
+ * @param[in] op 操作番号
+ * @param[in] arg 引数ブロック
+ * @return 戻り値
+ */
+static int32_t semihost(uint32_t op, const void *arg)
+{
+    register uint32_t r0 __asm("r0") = op;
+    register const void *r1 __asm("r1") = arg;
+
+    __asm volatile ("bkpt 0xAB" : "+r" (r0) : "r" (r1) : "memory");
+    return (int32_t)r0;
+}
+
+/**
+ * @brief 文字列をコンソールと結果ファイルに書く
+ * @param[in] s 文字列
+ * @return なし
+ */
+static void put(const char *s)
+{
+    uint32_t arg[3];
+
+    semihost(SYS_WRITE0, s);
+    if (s_fd < 0) return;
+
+    arg[0] = s_fd;
+    arg[1] = (uint32_t)s;
+    arg[2] = length(s);
+    semihost(SYS_WRITE, arg);
+}
+
+/**
+ * @brief 10 進数の文字列にする
+ * @param[out] p 書き込み先
+ * @param[in] v 値
+ * @return 書き込んだ文字列の直後
+ */
+static char *utoa(char *p, uint32_t v)
+{
+    char tmp[10];
+    uint8_t n = 0;
+
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+/**
+ * @brief 文字列の長さを返す
+ * @param[in] s 文字列
+ * @return 長さ
+ */
+static uint32_t length(const char *s)
+{
+    uint32_t n = 0;
+
+    while (s[n]) n++;
+    return n;
+}
@@ -0,0 +1,83 @@
+#!/bin/sh
+
+#
+# ベンチマークを QEMU で実行し、1 回あたりの命令数を求めて前回の結果と比べる
+# フロー:
+#   1. qemu-system-arm (mps2-an385) を -icount shift=0 (1 命令 = 1 ns) で起動する。
+#      ファームウェアはセミホスティングで bench.tsv を書いて終了する
+#   2. カウント数を命令数に換算し、ループのオーバーヘッドを差し引いて bench.result.tsv に書く。
+#      ブロック単位の項目 (4 列目にサンプル数がある) は "名前/sample" に 1 サンプルあたりの値も書く
+#   3. 比較対象が指定されていれば、許容幅 (TOLERANCE [%]) を超えて増えた項目を報告して 1 で終わる
+#
+
+QEMU=qemu-system-arm
+MACHINE=mps2-an385
+TIMEOUT=60
+TOLERANCE=${TOLERANCE:-5}
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: run.sh elffile [baseline]" 1>&2
+    exit 1
+}
+
+#
+# メイン関数
+#
+main() {
+    if [ $# -lt 1 ]; then
+        usage
+    fi
+
+    local elf=`realpath $1`
+    local base=$2
+    local dir=`dirname $elf`
+    local raw=$dir/bench.tsv
+    local result=$dir/bench.result.tsv
+
+    rm -f $raw
+    (cd $dir && timeout $TIMEOUT $QEMU -M $MACHINE -nographic -monitor none \
+        -semihosting-config enable=on,target=native -icount shift=0 -kernel $elf)
+    if [ $? -ne 0 ] || [ ! -s $raw ]; then
+        echo "error: benchmark did not finish." 1>&2
+        exit 1
+    fi
+
+    # 命令数 = カウント数 * (1e9 / clock) / 繰り返し回数 - ループ 1 回分
+    awk -F '\t' '
+    /^# clock/ { ns = 1e9 / $2 }
+    /^#/ { print; next }
+    { name[++n] = $1; iter[n] = $2; ticks[n] = $3; per[n] = (NF > 3) ? $4 : 1 }
+    END {
+        for (i = 1; i <= n; i++) if (name[i] == "loop") loop = ticks[i] * ns / iter[i]
+        for (i = 1; i <= n; i++) {
+            if (name[i] == "loop") continue
+            v = ticks[i] * ns / iter[i]
+            if (iter[i] > 1) v -= loop
+            printf "%s\t%.1f\n", name[i], v
+            if (per[i] > 1) printf "%s/sample\t%.1f\n", name[i], v / per[i]
+        }
+    }' $raw > $result
+    cat $result
+
+    if [ "$base" = "" ]; then
+        exit 0
+    fi
+
+    # 比較: 許容幅を超えて増えた項目があれば 1 で終わる
+    awk -F '\t' -v tol=$TOLERANCE '
+    /^#/ { next }
+    FNR == NR { old[$1] = $2; next }
+    ($1 in old) {
+        d = $2 - old[$1]
+        if (d > old[$1] * tol / 100 && d >= 1) {
+            printf "REGRESSION %s: %.1f -> %.1f\n", $1, old[$1], $2
+            bad = 1
+        }
+    }
+    END { exit bad }' $base $result
+}
+
+main $*
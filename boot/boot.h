@@ -0,0 +1,59 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file boot.h
+ * @brief ブートローダの配置と UART のプロトコルに関する定義
+ * @details ブートローダはフラッシュのセクタ 0 に常駐し、アプリケーションは BOOT_APP_BASE から
+ *          kvs 領域の手前までに置く (アプリケーションは make BOOT=1 でビルドする)。
+ *          アプリケーション領域の最後のページには、更新が完了したときに記述子 (boot_desc_t) を書く。\n
+ *          プロトコル (115200 bps, 8N1):
+ *          -# ホストは BOOT_SYNC を送り続ける。ブートローダはリセット後 BOOT_WAIT_MS の間
+ *             (アプリケーションが壊れていればいつまでも) これを待ち、BOOT_ACK を返す
+ *          -# ホストはブロックを 1 つずつ送り、応答を待つ。最初のブロックはヘッダ (fwp_hdr_t)。
+ *             ブロック: 長さ - 1 (1 バイト), データ, データの CRC-32 (4 バイト, リトルエンディアン)
+ *          -# ブートローダはブロックを受け取って処理し終えてから BOOT_ACK を返す。
+ *             CRC が合わなければ BOOT_NAK を返すので、ホストは同じブロックを送り直す
+ *          -# イメージを書き終えると BOOT_DONE を、失敗すると BOOT_ERROR と理由 (BOOT_E_*) を返す
+ *
+ *          このファイルはホストのツール (tools/fwpack.c) からもインクルードする。
+ */
+
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+#include <stdint.h>
+
+#define BOOT_APP_BASE 0x1000                    /* アプリケーションの先頭 (ベクタテーブル) */
+#define BOOT_APP_END  0x6000                    /* アプリケーション領域の終わり (kvs 領域の先頭) */
+#define BOOT_DESC     (BOOT_APP_END - 0x100)    /* 記述子のページ */
+#define BOOT_APP_MAX  (BOOT_DESC - BOOT_APP_BASE)
+#define BOOT_DESC_MAGIC 0x43534544              /* "DESC" */
+
+#define BOOT_BAUD     115200
+#define BOOT_WAIT_MS  200                       /* リセット後に BOOT_SYNC を待つ時間 */
+#define BOOT_BLOCK    256                       /* ブロックのデータの最大バイト数 */
+#define BOOT_TIMEOUT_MS 1000                    /* ブロック内のバイト間のタイムアウト */
+
+#define BOOT_SYNC     0x55
+#define BOOT_ACK      0x06
+#define BOOT_NAK      0x15
+#define BOOT_DONE     'K'
+#define BOOT_ERROR    'E'
+
+/* BOOT_ERROR に続く理由 */
+#define BOOT_E_HEADER 1                         /* ヘッダが壊れている, 大きすぎる */
+#define BOOT_E_BASE   2                         /* 差分の元が書き込まれているイメージと違う */
+#define BOOT_E_DATA   3                         /* ペイロードが不正, 途中で途切れた */
+#define BOOT_E_FLASH  4                         /* フラッシュの消去/書き込みエラー */
+#define BOOT_E_VERIFY 5                         /* CRC またはベクタテーブルのチェックサムが合わない */
+
+/**
+ * アプリケーションの記述子
+ */
+typedef struct boot_desc {
+    uint32_t magic;                             /* BOOT_DESC_MAGIC */
+    uint32_t size;                              /* イメージのバイト数 */
+    uint32_t crc;                               /* イメージの CRC-32 */
+} boot_desc_t;
+
+#endif
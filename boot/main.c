@@ -0,0 +1,468 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file main.c
+ * @brief 常駐ブートローダ (UART によるファームウェア更新)
+ * @details ブートローダは IRC (12 MHz) のまま動き、PLL やリセット要因 (SYSRESSTAT) には触れない。
+ *          アプリケーションへは、使ったペリフェラルをリセット時の状態に戻し、
+ *          VTOR をアプリケーションのベクタテーブルに向けてから飛ぶ。\n
+ *          RAM は先頭の数十バイト (.data, .bss) とスタックだけを使い、
+ *          更新用の大きなバッファは .noinit に置いて更新するときにだけ触れるので、
+ *          アプリケーションの .noinit (retain.h) は通常の起動では壊さない。
+ */
+
+#include <stdint.h>
+#include "system.h"
+#include "iap.h"
+#include "boot.h"
+#include "unpack.h"
+
+#define IRC_CLOCK 12000000UL
+#define IOCON_FUNC_UART 0x01            /* PIO1_6: RXD, PIO1_7: TXD */
+#define IOCON_DEFAULT   0xD0            /* リセット時の値 (GPIO, プルアップ) */
+
+/* 12 MHz / (16 * 4 * (1 + 5 / 8)) = 115385 bps (+0.2 %) */
+#define UART_DL        4
+#define UART_DIVADDVAL 5
+#define UART_MULVAL    8
+
+/* リンカスクリプトのロケーションカウンタを参照する */
+extern unsigned long _main_sp;
+extern unsigned long _data_org;
+extern unsigned long _sdata;
+extern unsigned long _edata;
+extern unsigned long _sbss;
+extern unsigned long _ebss;
+
+void reset_handler(void) __attribute__ ((noreturn, section(".reset")));
+static void default_handler(void);
+
+typedef void (* vector_entry)(void);
+
+/* ベクタテーブル (割込みは使わないのでシステム例外のみ) */
+__attribute__ ((section(".vector")))
+const vector_entry vectors[] = {
+    (vector_entry)&_main_sp,
+    reset_handler,
+    default_handler,
+    default_handler,
+    default_handler,
+    default_handler,
+    default_handler,
+    0,                                  /* チェックサム (lpcsum) */
+    0,
+    0,
+    0,
+    default_handler,
+    default_handler,
+    0,
+    default_handler,
+    default_handler,
+};
+
+/**
+ * 更新中の状態
+ */
+typedef struct update {
+    fwp_hdr_t hdr;
+    uint32_t pos;                       /* 出力したバイト数 */
+    uint32_t flushed;                   /* フラッシュに書き込んだバイト数 (ページ境界) */
+    int32_t erased;                     /* 消去した最後のセクタ (アプリケーション領域内の番号) */
+    uint8_t saved;                      /* oldsec にセクタ erased の古い内容がある */
+    uint8_t err;                        /* BOOT_E_* (0 ならエラーなし) */
+    uint16_t blen;                      /* 受信したブロックのバイト数 */
+    uint16_t bpos;                      /* 受信したブロックの次に読む位置 */
+    uint32_t page[IAP_PAGE_SIZE / 4];   /* 書き込み中のページ */
+    uint32_t blk[(BOOT_BLOCK + 4) / 4]; /* 受信したブロック */
+    uint32_t oldsec[FWP_SECTOR / 4];    /* 古いイメージの退避 (差分のとき) */
+} update_t;
+
+static update_t s_up __noinit;
+static uint32_t s_ahbclk;               /* SYSAHBCLKCTRL の元の値 */
+
+static void update(void);
+static int16_t recv_block(uint8_t skip_sync);
+static int16_t get(void *ctx);
+static int16_t peek(void *ctx, uint32_t pos);
+static int16_t old(void *ctx, uint32_t pos);
+static int8_t put(void *ctx, uint8_t c);
+static int8_t flush(void);
+static int8_t write_page(uint32_t addr, const uint32_t *page);
+static uint8_t app_valid(void);
+static void start_app(void) __attribute__ ((noreturn));
+static void uart_init(void);
+static void uart_deinit(void);
+static void uart_putc(uint8_t c);
+static int16_t uart_getc(uint32_t ms);
+
+static const fwp_io_t s_io = { get, peek, old, put, 0 };
+
+/**
+ * @brief スタートアップルーチン
+ * @return なし
+ */
+void reset_handler(void)
+{
+    unsigned long *src, *dst;
+
+    src = &_data_org;
+    for (dst = &_sdata; dst < &_edata;) {
+        *dst++ = *src++;
+    }
+    for (dst = &_sbss; dst < &_ebss;) {
+        *dst++ = 0;
+    }
+
+    uart_init();
+
+    /* アプリケーションが正しければ BOOT_WAIT_MS だけ、壊れていれば更新が成功するまで待つ */
+    if (uart_getc(BOOT_WAIT_MS) == BOOT_SYNC) update();
+    while (!app_valid()) {
+        if (uart_getc(BOOT_TIMEOUT_MS) == BOOT_SYNC) update();
+    }
+    start_app();
+}
+
+/**
+ * @brief システムクロックの周波数を返す (iap.c が使う)
+ * @return システムクロックの周波数
+ */
+uint32_t sys_clock(void)
+{
+    return IRC_CLOCK;
+}
+
+/**
+ * @brief 例外のハンドラ (ブートローダでは起きないはず)
+ * @return なし (戻らない)
+ */
+static void default_handler(void)
+{
+    while (1);
+}
+
+/**
+ * @brief 更新ストリームを受け取ってアプリケーション領域に書き込む
+ * @return なし
+ * @details 書き始める前に記述子を消すので、途中で止まればアプリケーションは起動しない。
+ *          差分の更新が途中で止まると元のイメージも失われるので、全体のイメージを送り直すこと。
+ */
+static void update(void)
+{
+    fwp_hdr_t *h = &s_up.hdr;
+    const boot_desc_t *d = (const boot_desc_t *)BOOT_DESC;
+    const uint8_t *app = (const uint8_t *)BOOT_APP_BASE;
+    uint32_t i, sum;
+
+    uart_putc(BOOT_ACK);
+
+    s_up.err = 0;
+    if (recv_block(1) != sizeof(fwp_hdr_t)) {
+        s_up.err = BOOT_E_HEADER;
+        goto end;
+    }
+    for (i = 0; i < sizeof(fwp_hdr_t) / 4; i++) ((uint32_t *)h)[i] = s_up.blk[i];
+    if (!fwp_hdr_valid(h) || h->size < 32 || h->size > BOOT_APP_MAX) {
+        s_up.err = BOOT_E_HEADER;
+        goto end;
+    }
+    if (h->base_size && (d->magic != BOOT_DESC_MAGIC || d->size != h->base_size
+                         || d->crc != h->base_crc || !app_valid())) {
+        s_up.err = BOOT_E_BASE;
+        goto end;
+    }
+
+    /* 記述子を消す (消去せずに 0 を書く) */
+    for (i = 0; i < IAP_PAGE_SIZE / 4; i++) s_up.page[i] = 0;
+    if (write_page(BOOT_DESC, s_up.page) < 0) goto end;
+
+    s_up.pos = 0;
+    s_up.flushed = 0;
+    s_up.erased = -1;
+    s_up.saved = 0;
+    s_up.bpos = s_up.blen;              /* 次の get() でヘッダに応答する */
+    if (fwp_unpack(&s_io, h) < 0 || (s_up.pos > s_up.flushed && flush() < 0)) {
+        if (!s_up.err) s_up.err = BOOT_E_DATA;
+        goto end;
+    }
+
+    /* 記述子のセクタがイメージの外なら、ここで消去する */
+    if (s_up.erased < (BOOT_DESC - BOOT_APP_BASE) / FWP_SECTOR
+        && iap_erase(BOOT_DESC / IAP_SECTOR_SIZE, BOOT_DESC / IAP_SECTOR_SIZE) != IAP_CMD_SUCCESS) {
+        s_up.err = BOOT_E_FLASH;
+        goto end;
+    }
+
+    /* CRC とベクタテーブルのチェックサム (エントリ 0..7 の和が 0) を確かめてから記述子を書く */
+    for (sum = 0, i = 0; i < 8; i++) sum += ((const uint32_t *)app)[i];
+    if (fwp_crc32(0, app, h->size) != h->crc || sum != 0) {
+        s_up.err = BOOT_E_VERIFY;
+        goto end;
+    }
+    for (i = 0; i < IAP_PAGE_SIZE / 4; i++) s_up.page[i] = 0xFFFFFFFF;
+    s_up.page[0] = BOOT_DESC_MAGIC;
+    s_up.page[1] = h->size;
+    s_up.page[2] = h->crc;
+    write_page(BOOT_DESC, s_up.page);
+
+end:
+    if (s_up.err) {
+        uart_putc(BOOT_ERROR);
+        uart_putc(s_up.err);
+    } else {
+        uart_putc(BOOT_DONE);
+    }
+}
+
+
+/**
+ * @brief ブロックを 1 つ受け取る (CRC が合わなければ送り直してもらう)
+ * @param[in] skip_sync !0 なら先頭の BOOT_SYNC を読み捨てる (同期の直後)
+ * @return データのバイト数, -1: タイムアウト
+ */
+static int16_t recv_block(uint8_t skip_sync)
+{
+    uint8_t *p = (uint8_t *)s_up.blk;
+    uint8_t tries;
+    uint16_t n, i;
+    int16_t c;
+
+    for (tries = 0; tries < 8; tries++) {
+        if (tries) {
+            while (uart_getc(20) >= 0);    /* 残りを読み捨ててから送り直してもらう */
+            uart_putc(BOOT_NAK);
+        }
+        do {
+            c = uart_getc(BOOT_TIMEOUT_MS);
+        } while (skip_sync && c == BOOT_SYNC);
+        if (c < 0) return -1;
+
+        n = c + 1;
+        for (i = 0; i < n + 4; i++) {
+            if ((c = uart_getc(BOOT_TIMEOUT_MS)) < 0) break;
+            p[i] = c;
+        }
+        if (i == n + 4 && fwp_crc32(0, p, n)
+            == (p[n] | (p[n + 1] << 8) | (p[n + 2] << 16) | ((uint32_t)p[n + 3] << 24))) {
+            s_up.blen = n;
+            s_up.bpos = 0;
+            return n;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief ペイロードの次のバイトを返す (ブロックを読み終えていたら応答して次を受け取る)
+ * @return バイト, -1: 受信できない
+ */
+static int16_t get(void *ctx)
+{
+    if (s_up.bpos >= s_up.blen) {
+        uart_putc(BOOT_ACK);
+        if (recv_block(0) < 0) return -1;
+    }
+    return ((const uint8_t *)s_up.blk)[s_up.bpos++];
+}
+
+/**
+ * @brief 新しいイメージの出力済みのバイトを返す
+ * @return バイト
+ */
+static int16_t peek(void *ctx, uint32_t pos)
+{
+    if (pos < s_up.flushed) return *(const uint8_t *)(BOOT_APP_BASE + pos);
+    return ((const uint8_t *)s_up.page)[pos - s_up.flushed];
+}
+
+/**
+ * @brief 古いイメージのバイトを返す
+ * @return バイト, -1: 既に消去した
+ */
+static int16_t old(void *ctx, uint32_t pos)
+{
+    int32_t sec = pos / FWP_SECTOR;
+
+    if (sec == s_up.erased && s_up.saved) return ((const uint8_t *)s_up.oldsec)[pos % FWP_SECTOR];
+    if (sec <= s_up.erased) return -1;
+    return *(const uint8_t *)(BOOT_APP_BASE + pos);
+}
+
+/**
+ * @brief 1 バイト出力する (ページが埋まったら書き込む)
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t put(void *ctx, uint8_t c)
+{
+    ((uint8_t *)s_up.page)[s_up.pos++ - s_up.flushed] = c;
+    if (s_up.pos - s_up.flushed < IAP_PAGE_SIZE) return 0;
+    return flush();
+}
+
+/**
+ * @brief 書き込み中のページを書き込む (余りは 0xFF で埋める)
+ * @return 0: 成功, -1: 失敗
+ * @details セクタの最初のページなら、先に古い内容を退避してからセクタを消去する。
+ */
+static int8_t flush(void)
+{
+    uint8_t *pg = (uint8_t *)s_up.page;
+    int32_t sec = s_up.flushed / FWP_SECTOR;
+    uint32_t i;
+
+    for (i = s_up.pos - s_up.flushed; i < IAP_PAGE_SIZE; i++) pg[i] = 0xFF;
+
+    if (sec > s_up.erased) {
+        const uint32_t *src = (const uint32_t *)(BOOT_APP_BASE + sec * FWP_SECTOR);
+        uint32_t fs = BOOT_APP_BASE / IAP_SECTOR_SIZE + sec;
+
+        s_up.saved = s_up.hdr.base_size > (uint32_t)sec * FWP_SECTOR;
+        if (s_up.saved) {
+            for (i = 0; i < FWP_SECTOR / 4; i++) s_up.oldsec[i] = src[i];
+        }
+        s_up.erased = sec;
+        if (iap_erase(fs, fs) != IAP_CMD_SUCCESS) {
+            s_up.err = BOOT_E_FLASH;
+            return -1;
+        }
+    }
+
+    if (write_page(BOOT_APP_BASE + s_up.flushed, s_up.page) < 0) return -1;
+    s_up.flushed += IAP_PAGE_SIZE;
+    return 0;
+}
+
+/**
+ * @brief 1 ページを書き込んで、書けたことを確かめる
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t write_page(uint32_t addr, const uint32_t *page)
+{
+    const uint32_t *dst = (const uint32_t *)addr;
+    uint32_t i;
+
+    if (iap_write(addr, page, IAP_PAGE_SIZE) != IAP_CMD_SUCCESS) {
+        s_up.err = BOOT_E_FLASH;
+        return -1;
+    }
+    for (i = 0; i < IAP_PAGE_SIZE / 4; i++) {
+        if (dst[i] != page[i]) {
+            s_up.err = BOOT_E_FLASH;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief アプリケーションが正しく書き込まれているかを判定する
+ * @return !0: 是, 0: 否
+ * @details 記述子, ベクタテーブルのチェックサム, イメージ全体の CRC を確かめる。
+ */
+static uint8_t app_valid(void)
+{
+    const boot_desc_t *d = (const boot_desc_t *)BOOT_DESC;
+    const uint32_t *v = (const uint32_t *)BOOT_APP_BASE;
+    uint32_t sum;
+    uint8_t i;
+
+    if (d->magic != BOOT_DESC_MAGIC || d->size < 32 || d->size > BOOT_APP_MAX) return 0;
+    for (sum = 0, i = 0; i < 8; i++) sum += v[i];
+    return sum == 0 && fwp_crc32(0, (const uint8_t *)v, d->size) == d->crc;
+}
+
+/**
+ * @brief アプリケーションを起動する
+ * @return なし (戻らない)
+ */
+static void start_app(void)
+{
+    const uint32_t *v = (const uint32_t *)BOOT_APP_BASE;
+
+    reg_write(SYST(CSR), 0);
+    reg_write(SYST(RVR), 0);
+    reg_write(SYST(CVR), 0);
+    uart_deinit();
+
+    reg_write(SCB(VTOR), BOOT_APP_BASE);
+    __asm volatile ("dsb\n isb" ::: "memory");
+    __asm volatile (
+        "msr    msp, %0         \n"
+        "bx     %1              \n"
+        :: "r" (v[0]), "r" (v[1])
+    );
+    while (1);
+}
+
+/**
+ * @brief UART (PIO1_6: RXD, PIO1_7: TXD) と SysTick (1 ms) の初期設定
+ * @return なし
+ */
+static void uart_init(void)
+{
+    uart_regs_t *const uart = LPC_UART;
+
+    s_ahbclk = LPC_SYSCON->SYSAHBCLKCTRL;
+    LPC_SYSCON->SYSAHBCLKCTRL = s_ahbclk | SYSCON_SYSAHBCLKCTRL_IOCON_Msk | SYSCON_SYSAHBCLKCTRL_UART_Msk;
+    LPC_IOCON->PIO1_6 = IOCON_FUNC_UART;
+    LPC_IOCON->PIO1_7 = IOCON_FUNC_UART;
+    LPC_SYSCON->UARTCLKDIV = 1;
+
+    uart->LCR = UART_LCR_DLAB_Msk | (3 << UART_LCR_WLS_Pos);       /* 8N1 */
+    uart->DLL = UART_DL;
+    uart->DLM = 0;
+    uart->FDR = (UART_MULVAL << UART_FDR_MULVAL_Pos) | (UART_DIVADDVAL << UART_FDR_DIVADDVAL_Pos);
+    uart->LCR = 3 << UART_LCR_WLS_Pos;
+    uart->FCR = UART_FCR_FIFOEN_Msk | UART_FCR_RXFIFORES_Msk | UART_FCR_TXFIFORES_Msk;
+
+    reg_write(SYST(RVR), IRC_CLOCK / 1000 - 1);
+    reg_write(SYST(CVR), 0);
+    reg_write(SYST(CSR), SYST_CSR_ENABLE | SYST_CSR_CLKSOURCE);
+}
+
+/**
+ * @brief UART をリセット時の状態に戻す
+ * @return なし
+ */
+static void uart_deinit(void)
+{
+    uart_regs_t *const uart = LPC_UART;
+
+    while (!(uart->LSR & UART_LSR_TEMT_Msk));
+    uart->FCR = UART_FCR_RXFIFORES_Msk | UART_FCR_TXFIFORES_Msk;
+    uart->LCR = UART_LCR_DLAB_Msk;
+    uart->DLL = 1;
+    uart->DLM = 0;
+    uart->LCR = 0;
+    uart->FDR = 1 << UART_FDR_MULVAL_Pos;
+
+    LPC_SYSCON->UARTCLKDIV = 0;
+    LPC_IOCON->PIO1_6 = IOCON_DEFAULT;
+    LPC_IOCON->PIO1_7 = IOCON_DEFAULT;
+    LPC_SYSCON->SYSAHBCLKCTRL = s_ahbclk;
+}
+
+/**
+ * @brief 1 バイト送信する
+ * @return なし
+ */
+static void uart_putc(uint8_t c)
+{
+    while (!(LPC_UART->LSR & UART_LSR_THRE_Msk));
+    LPC_UART->THR = c;
+}
+
+/**
+ * @brief 1 バイト受信する
+ * @param[in] ms タイムアウト [ms]
+ * @return 受信したバイト, -1: タイムアウト
+ */
+static int16_t uart_getc(uint32_t ms)
+{
+    reg_read(SYST(CSR));                /* COUNTFLAG を落とす */
+    reg_write(SYST(CVR), 0);
+    while (!(LPC_UART->LSR & UART_LSR_RDR_Msk)) {
+        if ((reg_read(SYST(CSR)) & SYST_CSR_COUNTFLAG) && --ms == 0) return -1;
+    }
+    return LPC_UART->RBR & 0xFF;
+}
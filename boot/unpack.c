@@ -0,0 +1,116 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file unpack.c
+ * @brief ファームウェア更新ストリームの展開
+ */
+
+#include <stdint.h>
+#include "unpack.h"
+
+static int32_t length(const fwp_io_t *io, uint8_t op);
+static int32_t word16(const fwp_io_t *io);
+
+/* CRC-32 の 4 ビット単位の表 (64 バイトで済み、ビット単位の 2 倍以上速い) */
+static const uint32_t s_crctab[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+/**
+ * @brief ペイロードを展開する
+ * @param[in] io 入出力
+ * @param[in] h ヘッダ (検査済みであること)
+ * @return 0: 成功, -1: 失敗 (入出力のエラー, 不正な命令)
+ * @note 命令を実行する前に h->size を超えないことを確かめるので、put() が h->size バイトより
+ *       多く呼ばれることはない (ブートローダは書き込み先の範囲をこれに頼っている)。
+ *       展開したイメージの CRC は呼び出し側で確かめる。
+ */
+int8_t fwp_unpack(const fwp_io_t *io, const fwp_hdr_t *h)
+{
+    uint32_t pos = 0;
+
+    while (pos < h->size) {
+        int16_t op = io->get(io->ctx);
+        int32_t n, a;
+        int16_t c;
+
+        if (op < 0) return -1;
+
+        if (op < 0x80) {
+            /* リテラル */
+            if (pos + op + 1 > h->size) return -1;
+            for (n = op + 1; n > 0; n--, pos++) {
+                if ((c = io->get(io->ctx)) < 0 || io->put(io->ctx, c) < 0) return -1;
+            }
+        } else {
+            if ((n = length(io, op)) < 0 || (a = word16(io)) < 0) return -1;
+            if (pos + n > h->size) return -1;
+            if (op < 0xC0) {
+                /* 新しいイメージからコピー */
+                if ((uint32_t)a + 1 > pos) return -1;
+                for (a = pos - (a + 1); n > 0; n--, pos++, a++) {
+                    if ((c = io->peek(io->ctx, a)) < 0 || io->put(io->ctx, c) < 0) return -1;
+                }
+            } else {
+                /* 古いイメージからコピー */
+                if (!h->base_size || (uint32_t)(a + n) > h->base_size) return -1;
+                for (; n > 0; n--, pos++, a++) {
+                    if ((c = io->old(io->ctx, a)) < 0 || io->put(io->ctx, c) < 0) return -1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief ヘッダを検査する
+ * @return !0: 正しい, 0: 壊れている
+ */
+uint8_t fwp_hdr_valid(const fwp_hdr_t *h)
+{
+    return h->magic == FWP_MAGIC
+        && h->hcrc == fwp_crc32(0, (const uint8_t *)h, sizeof(fwp_hdr_t) - 4);
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3) を計算する
+ * @param[in] crc 前の部分の CRC (最初は 0)
+ * @return p までを含めた CRC
+ */
+uint32_t fwp_crc32(uint32_t crc, const uint8_t *p, uint32_t n)
+{
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ s_crctab[crc & 0xF];
+        crc = (crc >> 4) ^ s_crctab[crc & 0xF];
+    }
+    return ~crc;
+}
+
+/**
+ * @brief コピーの長さを読む
+ * @return 長さ, -1: 入力のエラー
+ */
+static int32_t length(const fwp_io_t *io, uint8_t op)
+{
+    int16_t c;
+
+    if ((op & 0x3F) < 63) return (op & 0x3F) + FWP_MIN_MATCH;
+    if ((c = io->get(io->ctx)) < 0) return -1;
+    return c + 63 + FWP_MIN_MATCH;
+}
+
+/**
+ * @brief 16 ビットの値 (リトルエンディアン) を読む
+ * @return 値, -1: 入力のエラー
+ */
+static int32_t word16(const fwp_io_t *io)
+{
+    int16_t lo, hi;
+
+    if ((lo = io->get(io->ctx)) < 0 || (hi = io->get(io->ctx)) < 0) return -1;
+    return lo | (hi << 8);
+}
@@ -0,0 +1,59 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file unpack.h
+ * @brief ファームウェア更新ストリームの形式と展開に関する定義・宣言
+ * @details ストリームはヘッダ (fwp_hdr_t) とペイロードからなる。ペイロードは次の命令の列で、
+ *          展開後のイメージを先頭から順に作る。
+ *          - 0x00..0x7F: リテラル。続く (op + 1) バイトをそのまま出力する
+ *          - 0x80..0xBF: 新しいイメージの既に出力した部分からコピーする (LZ77)。
+ *                        長さのあとに 2 バイトの距離 - 1 (リトルエンディアン) が続く
+ *          - 0xC0..0xFF: 古いイメージ (差分の元) からコピーする。
+ *                        長さのあとに 2 バイトのコピー元の位置が続く
+ *
+ *          コピーの長さは op の下位 6 ビットが 0..62 なら + FWP_MIN_MATCH、
+ *          63 なら次の 1 バイト + 63 + FWP_MIN_MATCH。\n
+ *          イメージは書き込み先に上書きしながら展開する。セクタ k に書き始めるときに
+ *          古いイメージのセクタ k は RAM に退避され、それより前のセクタは消えるので、
+ *          古いイメージの参照はコピーする各バイトについて「出力位置のセクタの先頭以降」に限る。
+ *          このファイルと unpack.c はターゲットに依存しない (tools/fwpack.c もリンクする)。
+ */
+
+#ifndef __UNPACK_H__
+#define __UNPACK_H__
+
+#include <stdint.h>
+
+#define FWP_MAGIC     0x31505746        /* "FWP1" */
+#define FWP_SECTOR    4096              /* 消去単位 (古いイメージを退避する単位) */
+#define FWP_MIN_MATCH 3                 /* コピーの最小の長さ */
+#define FWP_MAX_MATCH (63 + 255 + FWP_MIN_MATCH)
+
+/**
+ * ストリームのヘッダ (リトルエンディアン)
+ */
+typedef struct fwp_hdr {
+    uint32_t magic;                     /* FWP_MAGIC */
+    uint32_t size;                      /* 展開後のイメージのバイト数 */
+    uint32_t crc;                       /* 展開後のイメージの CRC-32 */
+    uint32_t base_size;                 /* 差分の元のイメージのバイト数, 0 なら差分でない */
+    uint32_t base_crc;                  /* 差分の元のイメージの CRC-32 */
+    uint32_t hcrc;                      /* ここまでの CRC-32 */
+} fwp_hdr_t;
+
+/**
+ * 展開の入出力
+ */
+typedef struct fwp_io {
+    int16_t (*get)(void *ctx);                  /* ペイロードの次のバイト, -1 ならエラー */
+    int16_t (*peek)(void *ctx, uint32_t pos);   /* 出力済みのバイト, -1 ならエラー */
+    int16_t (*old)(void *ctx, uint32_t pos);    /* 古いイメージのバイト, -1 なら参照できない */
+    int8_t (*put)(void *ctx, uint8_t c);        /* 1 バイト出力する, -1 ならエラー */
+    void *ctx;
+} fwp_io_t;
+
+int8_t fwp_unpack(const fwp_io_t *io, const fwp_hdr_t *h);
+uint8_t fwp_hdr_valid(const fwp_hdr_t *h);
+uint32_t fwp_crc32(uint32_t crc, const uint8_t *p, uint32_t n);
+
+#endif
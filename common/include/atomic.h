@@ -0,0 +1,201 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file atomic.h
+ * @brief 排他アクセス (LDREX/STREX) による不可分操作と BASEPRI によるクリティカルセクション
+ * @details Cortex-M3 では例外の出入りで排他モニタがクリアされるので、
+ *          LDREX から STREX までの間に割込みハンドラが走ると STREX が失敗して
+ *          やり直しになる。これにより割込みを禁止せずに読み出し-変更-書き込みを不可分にできる。\n
+ *          割込みを止める必要がある場合も、PRIMASK (cpsid i) で全部止めるのではなく、
+ *          crit_enter() で指定した優先度以下の割込みだけをマスクすること。
+ */
+
+#ifndef __ATOMIC_H__
+#define __ATOMIC_H__
+
+#include <stdint.h>
+
+typedef uint32_t crit_t;    /* crit_enter() が返す、元の BASEPRI の値 */
+
+/**
+ * @brief 排他ロード
+ * @param[in] p アドレス
+ * @return 読み出した値
+ */
+static inline uint32_t __ldrex(volatile uint32_t *p)
+{
+    uint32_t v;
+    __asm volatile ("ldrex %0, [%1]" : "=r" (v) : "r" (p) : "memory");
+    return v;
+}
+
+/**
+ * @brief 排他ストア
+ * @param[in] v 書き込む値
+ * @param[in] p アドレス
+ * @return 0: 成功, 1: 失敗 (LDREX 以降に排他状態が失われた)
+ */
+static inline uint32_t __strex(uint32_t v, volatile uint32_t *p)
+{
+    uint32_t r;
+    __asm volatile ("strex %0, %1, [%2]" : "=&r" (r) : "r" (v), "r" (p) : "memory");
+    return r;
+}
+
+/**
+ * @brief 排他モニタをクリアする
+ * @return なし
+ */
+static inline void __clrex(void)
+{
+    __asm volatile ("clrex" ::: "memory");
+}
+
+/**
+ * @brief *p に v を不可分に加算する
+ * @param[in,out] p 対象のアドレス
+ * @param[in] v 加算する値
+ * @return 加算後の値
+ */
+static inline uint32_t atomic_add(volatile uint32_t *p, uint32_t v)
+{
+    uint32_t n;
+    do {
+        n = __ldrex(p) + v;
+    } while (__strex(n, p));
+    return n;
+}
+
+/**
+ * @brief *p に mask を不可分に論理和する
+ * @param[in,out] p 対象のアドレス
+ * @param[in] mask 立てるビット
+ * @return 変更前の値
+ */
+static inline uint32_t atomic_or(volatile uint32_t *p, uint32_t mask)
+{
+    uint32_t o;
+    do {
+        o = __ldrex(p);
+    } while (__strex(o | mask, p));
+    return o;
+}
+
+/**
+ * @brief *p に mask を不可分に論理積する
+ * @param[in,out] p 対象のアドレス
+ * @param[in] mask 残すビット
+ * @return 変更前の値
+ */
+static inline uint32_t atomic_and(volatile uint32_t *p, uint32_t mask)
+{
+    uint32_t o;
+    do {
+        o = __ldrex(p);
+    } while (__strex(o & mask, p));
+    return o;
+}
+
+/**
+ * @brief *p の clr のビットをクリアし、set のビットを立てる操作を不可分に行う
+ * @param[in,out] p 対象のアドレス
+ * @param[in] clr クリアするビット
+ * @param[in] set 立てるビット
+ * @return 変更前の値
+ */
+static inline uint32_t atomic_modify(volatile uint32_t *p, uint32_t clr, uint32_t set)
+{
+    uint32_t o;
+    do {
+        o = __ldrex(p);
+    } while (__strex((o & ~clr) | set, p));
+    return o;
+}
+
+/**
+ * @brief *p が expected と等しければ desired に置き換える (compare and swap)
+ * @param[in,out] p 対象のアドレス
+ * @param[in] expected 期待する値
+ * @param[in] desired 新しい値
+ * @return 1: 置き換えた, 0: *p が expected と異なっていた
+ */
+static inline uint8_t atomic_cas(volatile uint32_t *p, uint32_t expected, uint32_t desired)
+{
+    do {
+        if (__ldrex(p) != expected) {
+            __clrex();
+            return 0;
+        }
+    } while (__strex(desired, p));
+    return 1;
+}
+
+/**
+ * @brief BASEPRI を読み出す
+ * @return BASEPRI の値
+ */
+static inline uint32_t __get_basepri(void)
+{
+    uint32_t v;
+    __asm volatile ("mrs %0, basepri" : "=r" (v));
+    return v;
+}
+
+/**
+ * @brief BASEPRI を書き込む
+ * @param[in] v BASEPRI の値 (0 ならマスクしない)
+ * @return なし
+ */
+static inline void __set_basepri(uint32_t v)
+{
+    __asm volatile ("msr basepri, %0" :: "r" (v) : "memory");
+}
+
+/**
+ * @brief 優先度 prio 以下 (数値が prio 以上) の割込みをマスクするクリティカルセクションに入る
+ * @param[in] prio マスクする優先度 (1..(1 << __NVIC_PRIO_BITS) - 1)
+ * @return 元の BASEPRI の値 (crit_exit() に渡す)
+ * @note BASEPRI_MAX に書くので、既により強くマスクしていれば緩めることはない (ネスト可)。\n
+ *       prio に 0 は指定できない (BASEPRI = 0 はマスクなしを意味する)。
+ */
+static inline crit_t crit_enter(uint8_t prio)
+{
+    crit_t old = __get_basepri();
+    __asm volatile ("msr basepri_max, %0" :: "r" ((uint32_t)prio << (8 - __NVIC_PRIO_BITS)) : "memory");
+    return old;
+}
+
+/**
+ * @brief crit_enter() で入ったクリティカルセクションから出る
+ * @param[in] old crit_enter() が返した値
+ * @return なし
+ */
+static inline void crit_exit(crit_t old)
+{
+    __set_basepri(old);
+}
+
+/**
+ * @brief すべての割込み (NMI と HardFault を除く) を禁止する
+ * @return 元の PRIMASK の値 (irq_restore() に渡す)
+ * @note 優先度の高い割込みの遅延を増やすので、できるだけ crit_enter() を使うこと。\n
+ *       RAM 上の関数 (__ramfunc) からフラッシュを呼ばずに済むよう、常にインライン展開する。
+ */
+static inline __attribute__ ((always_inline)) uint32_t irq_save(void)
+{
+    uint32_t v;
+    __asm volatile ("mrs %0, primask\n cpsid i" : "=r" (v) :: "memory");
+    return v;
+}
+
+/**
+ * @brief irq_save() で禁止した割込みを元に戻す
+ * @param[in] v irq_save() が返した値
+ * @return なし
+ */
+static inline __attribute__ ((always_inline)) void irq_restore(uint32_t v)
+{
+    __asm volatile ("msr primask, %0" :: "r" (v) : "memory");
+}
+
+#endif
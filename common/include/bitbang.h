@@ -0,0 +1,153 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file bitbang.h
+ * @brief GPIO によるビットバング (ソフトウェアで波形を作る) の基本部品
+ * @details ピンの操作は GPIOnDATA のマスク付きアドレスへの 1 回のストアで行う (RMW しない)。
+ *          待ち時間は RAM 上で回すループの回数で作る。ループ 1 回のサイクル数は bb_init() で
+ *          DWT のサイクルカウンタを使って測り、ns からの換算には sys_clock() を使う。\n
+ *          プロトコルの実装は ws2812.h, onewire.h, softbus.h を参照。
+ */
+
+#ifndef __BITBANG_H__
+#define __BITBANG_H__
+
+#include <stdint.h>
+#include "system.h"
+
+#ifndef BB_LOOP_CYCLES
+  #define BB_LOOP_CYCLES 3              /* DWT がないときに仮定するループ 1 回のサイクル数 */
+#endif
+#ifndef BB_CAL_LOOPS
+  #define BB_CAL_LOOPS 1000             /* 較正で回すループの回数 */
+#endif
+
+#define BB_PUSHPULL  0                  /* 出力は H/L を駆動する */
+#define BB_OPENDRAIN 1                  /* L のときだけ駆動し、H は外部のプルアップに任せる */
+
+/**
+ * @def BB_PIN(pno, nthbit)
+ * ポート番号とビット位置を 1 バイトにまとめる。bb_pin_init() などのピン指定に使う。
+ */
+#define BB_PIN(pno, nthbit) ((uint8_t)(((pno) << 4) | (nthbit)))
+#define BB_NC 0xFF                      /* 接続しない (使わないピン) */
+
+/**
+ * ビットバングに使うピン\n
+ * data は GPIOnDATA(pno, 1 << nthbit) なので、書き込みはそのピンにしか影響しない。
+ */
+typedef struct bb_pin {
+    volatile uint32_t *data;            /* マスク付きの DATA レジスタ */
+    volatile uint32_t *dir;             /* DIR レジスタ (オープンドレインで使う) */
+    uint32_t mask;                      /* 1 << nthbit */
+} bb_pin_t;
+
+/**
+ * 較正結果
+ */
+typedef struct bb_cal {
+    uint32_t khz;                       /* 較正したときのコアクロック [kHz] */
+    uint32_t loop_q8;                   /* ループ 1 回のサイクル数 (下位 8 ビットは小数部) */
+    uint8_t dwt;                        /* 1: DWT で測った, 0: BB_LOOP_CYCLES を仮定した */
+} bb_cal_t;
+
+extern bb_cal_t g_bb_cal;
+
+void bb_init(void);
+int8_t bb_pin_init(bb_pin_t *pin, uint8_t spec, uint8_t mode);
+void bb_pin_deinit(bb_pin_t *pin);
+uint32_t bb_cycles(uint32_t ns);
+uint32_t bb_loops(uint32_t ns);
+void bb_delay(uint32_t n) __ramfunc;
+void bb_delay_ns(uint32_t ns);
+int32_t bb_verify(uint32_t ns);
+
+/*
+ * 以下はタイミングを決める部分なので最適化レベルによらずインライン展開させる
+ */
+#define __bb_inline static inline __attribute__ ((always_inline))
+
+/**
+ * @brief ループを n 回まわして待つ
+ * @param[in] n ループ回数 (bb_loops() で求めた値, 1 以上)
+ * @return なし
+ */
+__bb_inline void bb_spin(uint32_t n)
+{
+    __asm volatile (
+        "1: subs %0, %0, #1\n"
+        "   bne 1b\n"
+        : "+r" (n) :: "cc");
+}
+
+/**
+ * @brief ピンを H にする
+ * @param[in] pin ピン
+ * @return なし
+ */
+__bb_inline void bb_high(const bb_pin_t *pin)
+{
+    *pin->data = pin->mask;
+}
+
+/**
+ * @brief ピンを L にする
+ * @param[in] pin ピン
+ * @return なし
+ */
+__bb_inline void bb_low(const bb_pin_t *pin)
+{
+    *pin->data = 0;
+}
+
+/**
+ * @brief ピンの状態を読む
+ * @param[in] pin ピン
+ * @return 0 または 1
+ */
+__bb_inline uint8_t bb_get(const bb_pin_t *pin)
+{
+    return *pin->data != 0;
+}
+
+/**
+ * @brief オープンドレインのピンを L に引く
+ * @param[in] pin ピン (DATA は bb_pin_init() で 0 にしてある)
+ * @return なし
+ * @note DIR を RMW するので、同じポートの DIR を割込みでも変えるなら割込み禁止の区間で呼ぶこと。
+ */
+__bb_inline void bb_drive_low(const bb_pin_t *pin)
+{
+    *pin->dir |= pin->mask;
+}
+
+/**
+ * @brief オープンドレインのピンを開放する (外部のプルアップで H になる)
+ * @param[in] pin ピン
+ * @return なし
+ * @note bb_drive_low() と同じ注意がある。
+ */
+__bb_inline void bb_release(const bb_pin_t *pin)
+{
+    *pin->dir &= ~pin->mask;
+}
+
+/**
+ * @brief ピンを H にしてから n 回ループしたあと L に戻す
+ * @param[in] pin ピン
+ * @param[in] n ループ回数 (1 以上)
+ * @return なし
+ * @details 2 つのストアの間には待ちループしかないので、パルス幅は呼び出し側の
+ *          コードに左右されない。
+ */
+__bb_inline void bb_pulse(const bb_pin_t *pin, uint32_t n)
+{
+    __asm volatile (
+        "   str %1, [%2]\n"
+        "1: subs %0, %0, #1\n"
+        "   bne 1b\n"
+        "   str %3, [%2]\n"
+        : "+r" (n) : "r" (pin->mask), "r" (pin->data), "r" (0) : "cc", "memory");
+}
+
+#endif
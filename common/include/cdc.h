@@ -0,0 +1,58 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file cdc.h
+ * @brief USB CDC-ACM (仮想 COM ポート) に関する定義・宣言
+ * @details 受信/送信ともパケット単位のバッファを直接アプリケーションに渡す (ゼロコピー)。
+ * @code
+ * uint16_t len;
+ * const uint8_t *rx = cdc_rx_peek(&len);    // 受信パケットを覗く
+ * uint8_t *tx = cdc_tx_alloc();             // 送信パケットのバッファを借りる
+ * if (rx && tx) {
+ *     ... tx に最大 CDC_PKT_SIZE バイト書く ...
+ *     cdc_tx_commit(n);                     // 送信キューに積む
+ *     cdc_rx_release();                     // 受信パケットを返す
+ * }
+ * @endcode
+ */
+
+#ifndef __CDC_H__
+#define __CDC_H__
+
+#include <stdint.h>
+#include "usbhw.h"
+
+#ifndef CDC_VID
+  #define CDC_VID 0x1FC9    /* NXP */
+#endif
+#ifndef CDC_PID
+  #define CDC_PID 0x2002
+#endif
+
+#ifndef CDC_RX_NPKT
+  #define CDC_RX_NPKT 4     /* 受信パケットバッファの数 (2 のべき乗) */
+#endif
+#ifndef CDC_TX_NPKT
+  #define CDC_TX_NPKT 4     /* 送信パケットバッファの数 (2 のべき乗) */
+#endif
+
+#define CDC_PKT_SIZE  USB_BULK_SIZE
+
+#define CDC_EP_NOTIFY 0x81    /* 論理 EP1 IN (インタラプト) */
+#define CDC_EP_OUT    0x03    /* 論理 EP3 OUT (バルク, ダブルバッファ) */
+#define CDC_EP_IN     0x83    /* 論理 EP3 IN (バルク, ダブルバッファ) */
+
+/* SET_CONTROL_LINE_STATE の wValue */
+#define CDC_LINE_DTR (1 << 0)
+#define CDC_LINE_RTS (1 << 1)
+
+void cdc_init(void);
+uint8_t cdc_line_state(void);
+uint32_t cdc_baudrate(void);
+const uint8_t *cdc_rx_peek(uint16_t *len);
+void cdc_rx_release(void);
+uint8_t *cdc_tx_alloc(void);
+void cdc_tx_commit(uint16_t len);
+uint16_t cdc_write(const uint8_t *p, uint16_t n);
+
+#endif
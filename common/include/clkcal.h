@@ -0,0 +1,41 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file clkcal.h
+ * @brief クロックの検証と較正に関する定義・宣言
+ * @details 基準のクロックのエッジを 32-bit タイマのカウンタモードで数え、その間のコアクロックの
+ *          サイクル数を DWT のサイクルカウンタで数えて、コアクロックの実際の周波数を求める。
+ *          基準は CLKOUT (PIO0_1) に出した水晶発振 (システムオシレータ) か IRC、
+ *          または外部から与えた既知の周波数の信号で、タイマのキャプチャ入力につないでおく。
+ *          - CLKCAL_TMR = 0: CT32B0_CAP0 (PIO1_5)
+ *          - CLKCAL_TMR = 1: CT32B1_CAP0 (PIO1_0)
+ *
+ *          QSB では PIO0_1 は SW2 につながっているので、測定中は SW2 を押さないこと。\n
+ *          WDT オシレータは精度が ±40 % しかないので基準にはしない。\n
+ *          測った周波数は clkcal_calibrate() で sys_set_clock() に渡し、
+ *          sys_clock_hook() で登録された待ち時間などの定数も計算し直させる。
+ */
+
+#ifndef __CLKCAL_H__
+#define __CLKCAL_H__
+
+#include <stdint.h>
+
+#ifndef CLKCAL_TMR
+  #define CLKCAL_TMR 0                  /* 使う 32-bit タイマ (0 または 1) */
+#endif
+#define CLKCAL_DIV 12                   /* CLKOUT の分周比 (12 MHz -> 1 MHz) */
+#define CLKCAL_IRC_HZ 12000000UL        /* IRC の公称周波数 */
+
+/* 基準 */
+#define CLKCAL_SYSOSC 0                 /* システムオシレータ (水晶) を CLKOUT から */
+#define CLKCAL_IRC    1                 /* IRC を CLKOUT から */
+#define CLKCAL_EXT    2                 /* 外部の信号 (1 kHz 以上) */
+
+uint32_t clkcal_nominal(void);
+int8_t clkcal_measure(uint8_t ref, uint32_t ref_hz, uint32_t ms, uint32_t *hz);
+int8_t clkcal_verify(uint32_t tol_ppm, int32_t *err_ppm);
+int8_t clkcal_calibrate(uint8_t ref, uint32_t ref_hz, uint32_t ms);
+int16_t clkcal_trim_irc(uint8_t ref, uint32_t ref_hz, uint32_t ms);
+
+#endif
@@ -0,0 +1,66 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file clkgate.h
+ * @brief ペリフェラルのクロックの参照カウントによる管理に関する定義・宣言
+ * @details ドライバは使うペリフェラルのクロック (SYSAHBCLKCTRL のビット) を
+ *          clkgate_acquire() で得て、使い終わったら clkgate_release() で返す。
+ *          参照が 0 になったクロックはすぐに止める。
+ *          ペリフェラルのクロック分周器 (SSP0CLKDIV など; 0 で停止) も同じように
+ *          clkgate_div_acquire()/clkgate_div_release() で管理する。\n
+ *          リセット直後やブートローダから戻ったときに点いたままのクロックは、
+ *          clkgate_idle() (カーネルのアイドルタスクなら kern_idle_hook(clkgate_idle)) か
+ *          clkgate_trim() で、参照のないものを止める。\n
+ *          SYS, ROM, RAM, FLASHREG, FLASHARRAY は止めない (命令の実行と IAP に要る)。
+ *          clkgate_trim() の前に IOCON に書くなら、IOCON のクロックも得ておくこと。
+ */
+
+#ifndef __CLKGATE_H__
+#define __CLKGATE_H__
+
+#include <stdint.h>
+
+/* クロック (SYSAHBCLKCTRL のビット位置) [3.5.18] */
+#define CLKGATE_SYS        0
+#define CLKGATE_ROM        1
+#define CLKGATE_RAM        2
+#define CLKGATE_FLASHREG   3
+#define CLKGATE_FLASHARRAY 4
+#define CLKGATE_I2C        5
+#define CLKGATE_GPIO       6
+#define CLKGATE_CT16B0     7
+#define CLKGATE_CT16B1     8
+#define CLKGATE_CT32B0     9
+#define CLKGATE_CT32B1     10
+#define CLKGATE_SSP0       11
+#define CLKGATE_UART       12
+#define CLKGATE_ADC        13
+#define CLKGATE_USB_REG    14
+#define CLKGATE_WDT        15
+#define CLKGATE_IOCON      16
+#define CLKGATE_SSP1       18
+#define CLKGATE_NUM        19
+
+#define CLKGATE_PINNED 0x0000001F       /* 止めないクロック (SYS..FLASHARRAY) */
+
+/* ペリフェラルのクロック分周器 */
+#define CLKGATE_DIV_SSP0    0
+#define CLKGATE_DIV_UART    1
+#define CLKGATE_DIV_SSP1    2
+#define CLKGATE_DIV_TRACE   3
+#define CLKGATE_DIV_SYSTICK 4
+#define CLKGATE_DIV_USB     5
+#define CLKGATE_DIV_WDT     6
+#define CLKGATE_DIV_CLKOUT  7
+#define CLKGATE_DIV_NUM     8
+
+int8_t clkgate_acquire(uint8_t gate);
+void clkgate_release(uint8_t gate);
+int8_t clkgate_div_acquire(uint8_t div, uint8_t val);
+void clkgate_div_release(uint8_t div);
+void clkgate_trim(void);
+void clkgate_idle(void);
+uint32_t clkgate_mask(void);
+uint32_t clkgate_estimate_ua(uint32_t mask);
+
+#endif
@@ -0,0 +1,84 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file clkplan.h
+ * @brief クロック構成 (PLL の逓倍/分周, フラッシュのアクセス時間) をコンパイル時に決める
+ * @details 水晶の周波数 (__XTAL) と目標のシステムクロック (CLKPLAN_HZ) から
+ *          システム PLL の M, P とフラッシュのアクセス時間を求め、PLL の制約を
+ *          静的アサーションで確かめる。値は -D で差し替えられる。\n
+ *          PLL の制約 [3.11.4]:
+ *          - 入力 FCLKIN: 10..25 MHz
+ *          - 出力 FCLKOUT = M * FCLKIN (M = 1..32), システムクロックは 72 MHz 以下
+ *          - CCO FCCO = FCLKOUT * 2 * P (P = 1, 2, 4, 8): 156..320 MHz
+ *          P は FCCO が下限を超える最小の値にする (消費電力が少ない)。
+ *          USB PLL は水晶から 48 MHz を同じ規則で作る。\n
+ *          フラッシュのアクセス時間 (FLASHCFG の FLASHTIM):
+ *          20 MHz 以下で 1 クロック, 40 MHz 以下で 2 クロック, 72 MHz 以下で 3 クロック。\n
+ *          ホストでは tools/clkplan.c (各例題で gmake clkplan) が構成を表示する。
+ *          このファイルはホストでもコンパイルするので、レジスタの定義を参照しないこと。
+ */
+
+#ifndef __CLKPLAN_H__
+#define __CLKPLAN_H__
+
+#ifndef __XTAL
+  #define __XTAL 12000000UL             /* 外部水晶の発振周波数 */
+#endif
+#define CLKPLAN_IRC_HZ 12000000UL       /* IRC の周波数 */
+#define CLKPLAN_USB_HZ 48000000UL       /* USB のクロック */
+
+/* 入力 (-D で差し替える) */
+#ifndef CLKPLAN_HZ
+  #define CLKPLAN_HZ 72000000UL         /* 目標のシステムクロック */
+#endif
+#ifndef CLKPLAN_SRC
+  #define CLKPLAN_SRC 1                 /* PLL の入力 (SYSPLLCLKSEL): 0: IRC, 1: 水晶 */
+#endif
+#ifndef CLKPLAN_AHBDIV
+  #define CLKPLAN_AHBDIV 1              /* システムクロックの分周比 (SYSAHBCLKDIV, 1..255) */
+#endif
+#ifndef CLKPLAN_USB
+  #define CLKPLAN_USB 1                 /* 1: USB PLL を使う */
+#endif
+
+/* システム PLL */
+#define CLKPLAN_PLLIN_HZ ((CLKPLAN_SRC) ? __XTAL : CLKPLAN_IRC_HZ)
+#define CLKPLAN_MAIN_HZ  (CLKPLAN_HZ * CLKPLAN_AHBDIV)
+#define CLKPLAN_PLL      (CLKPLAN_MAIN_HZ != CLKPLAN_PLLIN_HZ)    /* PLL を使うか */
+#define CLKPLAN_M        (CLKPLAN_MAIN_HZ / CLKPLAN_PLLIN_HZ)
+#define CLKPLAN_P        __CLKPLAN_P(CLKPLAN_MAIN_HZ)
+#define CLKPLAN_FCCO_HZ  (CLKPLAN_MAIN_HZ * 2 * CLKPLAN_P)
+
+/* USB PLL (入力は水晶) */
+#define CLKPLAN_USB_M       (CLKPLAN_USB_HZ / __XTAL)
+#define CLKPLAN_USB_P       __CLKPLAN_P(CLKPLAN_USB_HZ)
+#define CLKPLAN_USB_FCCO_HZ (CLKPLAN_USB_HZ * 2 * CLKPLAN_USB_P)
+
+/* レジスタの値 */
+#define CLKPLAN_SYSPLLCLKSEL CLKPLAN_SRC
+#define CLKPLAN_MAINCLKSEL   ((CLKPLAN_PLL) ? 3 : (CLKPLAN_SRC) ? 1 : 0)    /* PLL 出力, PLL 入力, IRC */
+#define CLKPLAN_SYSPLLCTRL   ((CLKPLAN_M - 1) | (__CLKPLAN_PSEL(CLKPLAN_P) << 5))
+#define CLKPLAN_USBPLLCTRL   ((CLKPLAN_USB_M - 1) | (__CLKPLAN_PSEL(CLKPLAN_USB_P) << 5))
+#define CLKPLAN_FLASHTIM     ((CLKPLAN_HZ <= 20000000UL) ? 0 : (CLKPLAN_HZ <= 40000000UL) ? 1 : 2)
+
+/* FCCO >= 156 MHz となる最小の P と, その PSEL の値 */
+#define __CLKPLAN_P(out) \
+    (((out) * 2 >= 156000000UL) ? 1 : ((out) * 4 >= 156000000UL) ? 2 : ((out) * 8 >= 156000000UL) ? 4 : 8)
+#define __CLKPLAN_PSEL(p) (((p) == 1) ? 0 : ((p) == 2) ? 1 : ((p) == 4) ? 2 : 3)
+
+_Static_assert(CLKPLAN_HZ <= 72000000UL, "clkplan: system clock exceeds 72 MHz");
+_Static_assert(CLKPLAN_AHBDIV >= 1 && CLKPLAN_AHBDIV <= 255, "clkplan: SYSAHBCLKDIV must be 1..255");
+_Static_assert(!CLKPLAN_PLL || (CLKPLAN_PLLIN_HZ >= 10000000UL && CLKPLAN_PLLIN_HZ <= 25000000UL),
+               "clkplan: PLL input must be 10..25 MHz");
+_Static_assert(!CLKPLAN_PLL || CLKPLAN_M * CLKPLAN_PLLIN_HZ == CLKPLAN_MAIN_HZ,
+               "clkplan: main clock is not a multiple of the PLL input");
+_Static_assert(!CLKPLAN_PLL || (CLKPLAN_M >= 1 && CLKPLAN_M <= 32), "clkplan: PLL M must be 1..32");
+_Static_assert(!CLKPLAN_PLL || (CLKPLAN_FCCO_HZ >= 156000000UL && CLKPLAN_FCCO_HZ <= 320000000UL),
+               "clkplan: FCCO out of 156..320 MHz");
+_Static_assert(!CLKPLAN_USB || CLKPLAN_USB_M * __XTAL == CLKPLAN_USB_HZ,
+               "clkplan: 48 MHz is not a multiple of the crystal");
+_Static_assert(!CLKPLAN_USB || (CLKPLAN_USB_M >= 1 && CLKPLAN_USB_M <= 32), "clkplan: USB PLL M must be 1..32");
+_Static_assert(!CLKPLAN_USB || (CLKPLAN_USB_FCCO_HZ >= 156000000UL && CLKPLAN_USB_FCCO_HZ <= 320000000UL),
+               "clkplan: USB FCCO out of 156..320 MHz");
+
+#endif
@@ -9,6 +9,15 @@
 #define __CORTEXM3_H__
 
 #include <stdint.h>
+
+/**
+ * @def __NVIC_PRIO_BITS
+ * 割込み優先度レジスタの実装ビット数。マイコンごとに別途定義する。
+ */
+#ifndef __NVIC_PRIO_BITS
+  #define __NVIC_PRIO_BITS 4
+#endif
+
 #include "cortexm3_reg.h"
 
 /**
@@ -59,6 +68,113 @@
 #define NVIC_IPR14 (NVIC_IPR + 0x38)
 #define NVIC_STIR  0xF00
 
+/**
+ * @def SCB(reg)
+ * @details System control block レジスタのアドレスを得るためのマクロ。\n
+ *          例えば SCB(AIRCR) とすると 0xE000ED0C (SCB_AIRCR のアドレス) を得る。
+ */
+#define SCB(reg) ((SCB_BASE + SCB_##reg))
+
+#define SCB_BASE  0xE000ED00
+#define SCB_CPUID 0x000
+#define SCB_ICSR  0x004
+#define SCB_VTOR  0x008
+#define SCB_AIRCR 0x00C
+#define SCB_SCR   0x010
+#define SCB_CCR   0x014
+#define SCB_SHPR1 0x018
+#define SCB_SHPR2 0x01C
+#define SCB_SHPR3 0x020
+#define SCB_SHCSR 0x024
+#define SCB_CFSR  0x028
+#define SCB_HFSR  0x02C
+#define SCB_DFSR  0x030
+#define SCB_MMFAR 0x034
+#define SCB_BFAR  0x038
+#define SCB_AFSR  0x03C
+
+#define ICSR_PENDSVSET    (1 << 28)     /* PendSV 例外を保留する */
+#define ICSR_VECTPENDING  (0x1FF << 12) /* 保留中で最も優先度の高い例外の番号 (0: なし) */
+
+#define AIRCR_VECTKEY     0x05FA0000    /* AIRCR 書き込み時のキー */
+#define AIRCR_SYSRESETREQ (1 << 2)      /* システムリセット要求 */
+#define AIRCR_PRIGROUP    (7 << 8)      /* 優先度グループ */
+
+#define SHCSR_MEMFAULTENA (1 << 16)     /* MemManage 例外の許可 */
+#define SHCSR_BUSFAULTENA (1 << 17)     /* BusFault 例外の許可 */
+#define SHCSR_USGFAULTENA (1 << 18)     /* UsageFault 例外の許可 */
+
+#define CCR_DIV_0_TRP     (1 << 4)      /* 0 除算で UsageFault を発生させる */
+
+/**
+ * @def SYST(reg)
+ * @details SysTick タイマのレジスタのアドレスを得るためのマクロ。\n
+ *          例えば SYST(CVR) とすると 0xE000E018 (SYST_CVR のアドレス) を得る。
+ */
+#define SYST(reg) ((SYST_BASE + SYST_##reg))
+
+#define SYST_BASE  0xE000E010
+#define SYST_CSR   0x000
+#define SYST_RVR   0x004
+#define SYST_CVR   0x008
+#define SYST_CALIB 0x00C
+
+#define SYST_CSR_ENABLE    (1 << 0)     /* カウンタの許可 */
+#define SYST_CSR_TICKINT   (1 << 1)     /* 0 になったら SysTick 例外を発生させる */
+#define SYST_CSR_CLKSOURCE (1 << 2)     /* プロセッサクロックで数える */
+#define SYST_CSR_COUNTFLAG (1 << 16)    /* 前回の読み出し以降に 0 になった */
+
+/**
+ * @def DCB(reg)
+ * @details Debug control block レジスタのアドレスを得るためのマクロ。\n
+ *          例えば DCB(DHCSR) とすると 0xE000EDF0 (DCB_DHCSR のアドレス) を得る。
+ */
+#define DCB(reg) ((DCB_BASE + DCB_##reg))
+
+#define DCB_BASE  0xE000EDF0
+#define DCB_DHCSR 0x000
+#define DCB_DCRSR 0x004
+#define DCB_DCRDR 0x008
+#define DCB_DEMCR 0x00C
+
+#define DHCSR_C_DEBUGEN (1 << 0)        /* デバッガが接続されている */
+#define DEMCR_TRCENA    (1 << 24)       /* DWT, ITM の許可 */
+
+/**
+ * @def ITM(reg)
+ * @details Instrumentation trace macrocell レジスタのアドレスを得るためのマクロ。\n
+ *          例えば ITM(TCR) とすると 0xE0000E80 (ITM_TCR のアドレス) を得る。
+ */
+#define ITM(reg) ((ITM_BASE + ITM_##reg))
+
+/**
+ * @def ITM_STIM(n)
+ * @details ITM のスティミュラスポート n (0..31) のアドレスを得るためのマクロ。
+ */
+#define ITM_STIM(n) (ITM_BASE + ((n) << 2))
+
+#define ITM_BASE 0xE0000000
+#define ITM_TER  0xE00
+#define ITM_TPR  0xE40
+#define ITM_TCR  0xE80
+#define ITM_LAR  0xFB0
+
+#define ITM_TCR_ITMENA  (1 << 0)        /* ITM の許可 (デバッガが設定する) */
+
+/**
+ * @def DWT(reg)
+ * @details Data watchpoint and trace レジスタのアドレスを得るためのマクロ。\n
+ *          例えば DWT(CYCCNT) とすると 0xE0001004 (DWT_CYCCNT のアドレス) を得る。
+ */
+#define DWT(reg) ((DWT_BASE + DWT_##reg))
+
+#define DWT_BASE   0xE0001000
+#define DWT_CTRL   0x000
+#define DWT_CYCCNT 0x004
+
+#define DWT_CTRL_CYCCNTENA (1 << 0)     /* サイクルカウンタの許可 */
+#define DWT_CTRL_NOCYCCNT  (1 << 25)    /* サイクルカウンタが実装されていない */
+
 /**
  * Cortex-M3 IRQ 番号\n
  * 負の値のとき、プロセッサ内部の例外を表す。\n
@@ -72,6 +188,7 @@ typedef enum irq {
     EX_BUSFAULT = -11,
     EX_USAGEFAULT = -10,
     EX_SVCALL = -5,
+    EX_DEBUGMON = -4,
     EX_PENDSV = -2,
     EX_SYSTICK = -1,
     /* 0..239: 外部割込み入力 (マイコンごとに別途定義する) */
@@ -81,10 +198,11 @@ typedef enum irq {
  * @brief 外部割込み n 番を許可する
  * @param[in] n 許可する割込みの番号 (0..239)
  * @return なし
+ * @note ISER は 1 を書いたビットだけが有効になるので、読み出し-変更-書き込みは不要。
  */
 static inline void nvic_enable_irq(irq_t n)
 {
-    __reg_set_bit(NVICn(ISER, (n >> 5)), n & 0x1F);
+    reg_write(NVICn(ISER, (n >> 5)), 1UL << (n & 0x1F));
 }
 
 /**
@@ -94,7 +212,163 @@ static inline void nvic_enable_irq(irq_t n)
  */
 static inline void nvic_disable_irq(irq_t n)
 {
-    __reg_set_bit(NVICn(ICER, (n >> 5)), n & 0x1F);
+    reg_write(NVICn(ICER, (n >> 5)), 1UL << (n & 0x1F));
+    __asm volatile ("dsb\n isb" ::: "memory");    /* 戻った時点で確実に禁止されているようにする */
+}
+
+/**
+ * @brief 外部割込み n 番が許可されているかを返す
+ * @param[in] n 割込みの番号 (0..239)
+ * @return 1: 許可, 0: 禁止
+ */
+static inline uint8_t nvic_is_enabled(irq_t n)
+{
+    return __reg_read_bit(NVICn(ISER, (n >> 5)), n & 0x1F);
+}
+
+/**
+ * @brief 外部割込み n 番をペンディングにする (ソフトウェアから割込みを発生させる)
+ * @param[in] n 割込みの番号 (0..239)
+ * @return なし
+ */
+static inline void nvic_set_pending(irq_t n)
+{
+    reg_write(NVICn(ISPR, (n >> 5)), 1UL << (n & 0x1F));
+}
+
+/**
+ * @brief 外部割込み n 番のペンディングを解除する
+ * @param[in] n 割込みの番号 (0..239)
+ * @return なし
+ */
+static inline void nvic_clear_pending(irq_t n)
+{
+    reg_write(NVICn(ICPR, (n >> 5)), 1UL << (n & 0x1F));
+}
+
+/**
+ * @brief 外部割込み n 番がペンディングかを返す
+ * @param[in] n 割込みの番号 (0..239)
+ * @return 1: ペンディング, 0: そうでない
+ */
+static inline uint8_t nvic_is_pending(irq_t n)
+{
+    return __reg_read_bit(NVICn(ISPR, (n >> 5)), n & 0x1F);
+}
+
+/**
+ * @brief 外部割込み n 番のハンドラが実行中 (ネストして中断中を含む) かを返す
+ * @param[in] n 割込みの番号 (0..239)
+ * @return 1: 実行中, 0: そうでない
+ */
+static inline uint8_t nvic_is_active(irq_t n)
+{
+    return __reg_read_bit(NVICn(IABR, (n >> 5)), n & 0x1F);
+}
+
+/**
+ * @brief 優先度レジスタ (1 バイト) のアドレスを返す
+ * @param[in] n 割込みの番号 (システム例外は負の値)
+ * @return 優先度レジスタのアドレス
+ * @note IRQ は NVIC_IPRn、システム例外は SCB_SHPRn にある。
+ */
+static inline uint32_t __nvic_prio_addr(irq_t n)
+{
+    return (n < 0) ? (SCB(SHPR1) + ((n & 0xF) - 4)) : (NVIC(IPR) + n);
+}
+
+/**
+ * @brief 割込み (またはシステム例外) の優先度を設定する
+ * @param[in] n 割込みの番号 (システム例外は負の値; EX_SVCALL など)
+ * @param[in] prio 優先度 (0..(1 << __NVIC_PRIO_BITS) - 1, 小さいほど優先)
+ * @return なし
+ * @note NMI と HardFault の優先度は固定なので指定しないこと。
+ */
+static inline void nvic_set_priority(irq_t n, uint8_t prio)
+{
+    reg_write_byte(__nvic_prio_addr(n), prio << (8 - __NVIC_PRIO_BITS));
+}
+
+/**
+ * @brief 割込み (またはシステム例外) の優先度を返す
+ * @param[in] n 割込みの番号 (システム例外は負の値)
+ * @return 優先度 (0..(1 << __NVIC_PRIO_BITS) - 1)
+ */
+static inline uint8_t nvic_get_priority(irq_t n)
+{
+    return reg_read_byte(__nvic_prio_addr(n)) >> (8 - __NVIC_PRIO_BITS);
+}
+
+/**
+ * @brief 優先度グループ (プリエンプション優先度とサブ優先度の境界) を設定する
+ * @param[in] group AIRCR PRIGROUP の値 (0..7)。優先度の下位 (group + 1) ビットがサブ優先度になる
+ * @return なし
+ */
+static inline void nvic_set_priority_grouping(uint32_t group)
+{
+    uint32_t v = reg_read(SCB(AIRCR)) & ~(0xFFFF0000 | AIRCR_PRIGROUP);
+    reg_write(SCB(AIRCR), v | AIRCR_VECTKEY | ((group & 7) << 8));
+}
+
+/**
+ * @brief 優先度グループを返す
+ * @return AIRCR PRIGROUP の値 (0..7)
+ */
+static inline uint32_t nvic_get_priority_grouping(void)
+{
+    return (reg_read(SCB(AIRCR)) & AIRCR_PRIGROUP) >> 8;
+}
+
+/**
+ * @brief プリエンプション優先度とサブ優先度から nvic_set_priority() に渡す優先度を作る
+ * @param[in] group 優先度グループ (0..7)
+ * @param[in] preempt プリエンプション優先度
+ * @param[in] sub サブ優先度
+ * @return 優先度 (0..(1 << __NVIC_PRIO_BITS) - 1)
+ */
+static inline uint8_t nvic_encode_priority(uint32_t group, uint32_t preempt, uint32_t sub)
+{
+    uint32_t g = group & 7;
+    uint32_t pbits = ((7 - g) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7 - g);          /* プリエンプション優先度のビット数 */
+    uint32_t sbits = ((g + __NVIC_PRIO_BITS) < 7) ? 0 : (g + __NVIC_PRIO_BITS - 7);      /* サブ優先度のビット数 */
+
+    return ((preempt & ((1UL << pbits) - 1)) << sbits) | (sub & ((1UL << sbits) - 1));
+}
+
+/**
+ * @brief システムリセットを要求する (ソフトウェアリセット)
+ * @return なし (戻らない)
+ */
+static inline void scb_sys_reset(void)
+{
+    __asm volatile ("dsb" ::: "memory");
+    reg_write(SCB(AIRCR), AIRCR_VECTKEY | (reg_read(SCB(AIRCR)) & AIRCR_PRIGROUP) | AIRCR_SYSRESETREQ);
+    __asm volatile ("dsb" ::: "memory");
+    while (1);
+}
+
+/**
+ * @brief DWT のサイクルカウンタ (CYCCNT) を動かす
+ * @return 1: 動いている, 0: サイクルカウンタが実装されていない
+ * @note すでに動いていればカウンタの値はそのままにする (複数のモジュールから呼んでよい)。
+ */
+static inline uint8_t dwt_cyccnt_start(void)
+{
+    reg_set_bits(DCB(DEMCR), DEMCR_TRCENA);
+    if (reg_read(DWT(CTRL)) & DWT_CTRL_NOCYCCNT) return 0;
+    if (reg_read(DWT(CTRL)) & DWT_CTRL_CYCCNTENA) return 1;
+    reg_write(DWT(CYCCNT), 0);
+    reg_set_bits(DWT(CTRL), DWT_CTRL_CYCCNTENA);
+    return 1;
+}
+
+/**
+ * @brief DWT のサイクルカウンタを読み出す
+ * @return CYCCNT の値 (コアクロックで数える 32 ビットの周回カウンタ)
+ */
+static inline uint32_t dwt_cyccnt(void)
+{
+    return reg_read(DWT(CYCCNT));
 }
 
 #endif
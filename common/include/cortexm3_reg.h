@@ -8,6 +8,8 @@
 #ifndef __CORTEXM3_REG_H__
 #define __CORTEXM3_REG_H__
 
+#include "atomic.h"
+
 #define __BB_PMEM_START 0x40000000        /* ペリフェラルメモリのビットバンド先頭アドレス */
 #define __BB_PMEM_END   0x400FFFFC        /* ペリフェラルメモリのビットバンド終了アドレス */
 
@@ -28,6 +30,12 @@ static inline uint8_t __is_pmem_bb(uint32_t addr);
  */
 #define __deref(addr) (*(volatile uint32_t *)(addr))
 
+/**
+ * @def __deref8(addr)
+ * addr で指定された番地へのバイト単位の逆参照を得るためのマクロ
+ */
+#define __deref8(addr) (*(volatile uint8_t *)(addr))
+
 /**
  * @brief レジスタへの書き込み
  * @param[in] addr レジスタアドレス
@@ -49,6 +57,28 @@ static inline uint32_t reg_read(uint32_t addr)
     return __deref(addr);
 }
 
+/**
+ * @brief レジスタへのバイト単位の書き込み
+ * @param[in] addr レジスタアドレス
+ * @param[in] val 書き込むデータ
+ * @return なし
+ * @note NVIC_IPRn のようにバイトアクセスできるレジスタに使う
+ */
+static inline void reg_write_byte(uint32_t addr, uint8_t val)
+{
+    __deref8(addr) = val;
+}
+
+/**
+ * @brief レジスタからのバイト単位の読み出し
+ * @param[in] addr レジスタアドレス
+ * @return 読み出したデータ
+ */
+static inline uint8_t reg_read_byte(uint32_t addr)
+{
+    return __deref8(addr);
+}
+
 /**
  * @brief レジスタの第 n ビットを立てる
  * @param[in] addr レジスタアドレス
@@ -94,16 +124,53 @@ static inline uint8_t reg_read_bit(uint32_t addr, uint32_t nthbit)
     return __is_pmem_bb(addr) ? __bb_read_bit(addr, nthbit) : __reg_read_bit(addr, nthbit);
 }
 
+/**
+ * @brief レジスタの mask で指定したビットを不可分に立てる
+ * @param[in] addr レジスタアドレス
+ * @param[in] mask 立てるビット
+ * @return なし
+ * @note 割込みハンドラが同じレジスタを書き換えても更新が失われない (atomic.h を参照)。\n
+ *       ビットバンド領域の 1 ビットだけなら reg_set_bit() の方が速い。
+ */
+static inline void reg_set_bits(uint32_t addr, uint32_t mask)
+{
+    atomic_or(&__deref(addr), mask);
+}
+
+/**
+ * @brief レジスタの mask で指定したビットを不可分にクリアする
+ * @param[in] addr レジスタアドレス
+ * @param[in] mask クリアするビット
+ * @return なし
+ */
+static inline void reg_clr_bits(uint32_t addr, uint32_t mask)
+{
+    atomic_and(&__deref(addr), ~mask);
+}
+
+/**
+ * @brief レジスタの clr のビットをクリアし、set のビットを立てる操作を不可分に行う
+ * @param[in] addr レジスタアドレス
+ * @param[in] clr クリアするビット
+ * @param[in] set 立てるビット
+ * @return なし
+ */
+static inline void reg_modify(uint32_t addr, uint32_t clr, uint32_t set)
+{
+    atomic_modify(&__deref(addr), clr, set);
+}
+
 /**
  * @brief 非ビットバンド領域にあるレジスタの第 n ビットを立てる
  * @param[in] addr レジスタアドレス (非ビットバンド領域)
  * @param[in] nthbit ビット位置
  * @return なし
- * @note アドレスチェックはしないので呼び出し側で責任を持つこと
+ * @note アドレスチェックはしないので呼び出し側で責任を持つこと\n
+ *       LDREX/STREX で不可分に更新する
  */
 static inline void __reg_set_bit(uint32_t addr, uint8_t nthbit)
 {
-    __deref(addr) |= (1 << nthbit);
+    atomic_or(&__deref(addr), 1UL << nthbit);
 }
 
 /**
@@ -111,11 +178,12 @@ static inline void __reg_set_bit(uint32_t addr, uint8_t nthbit)
  * @param[in] addr レジスタアドレス (非ビットバンド領域)
  * @param[in] nthbit ビット位置
  * @return なし
- * @note アドレスチェックはしないので呼び出し側で責任を持つこと
+ * @note アドレスチェックはしないので呼び出し側で責任を持つこと\n
+ *       LDREX/STREX で不可分に更新する
  */
 static inline void __reg_clr_bit(uint32_t addr, uint32_t nthbit)
 {
-    __deref(addr) &= ~(1 << nthbit);
+    atomic_and(&__deref(addr), ~(1UL << nthbit));
 }
 
 /**
@@ -124,14 +192,12 @@ static inline void __reg_clr_bit(uint32_t addr, uint32_t nthbit)
  * @param[in] nthbit ビット位置
  * @param[in] 書き込む値
  * @return なし
- * @note アドレスチェックはしないので呼び出し側で責任を持つこと
+ * @note アドレスチェックはしないので呼び出し側で責任を持つこと\n
+ *       クリアと書き込みを 1 回の不可分操作で行うので、途中で 0 が見えることもない
  */
 static inline void __reg_write_bit(uint32_t addr, uint32_t nthbit, uint8_t v)
 {
-    __reg_clr_bit(addr, nthbit);
-    if (v & 1) {
-        __reg_set_bit(addr, nthbit);
-    }
+    atomic_modify(&__deref(addr), 1UL << nthbit, (uint32_t)(v & 1) << nthbit);
 }
 
 /**
@@ -180,10 +246,7 @@ static inline void __bb_clr_bit(uint32_t addr, uint32_t nthbit)
  */
 static inline void __bb_write_bit(uint32_t addr, uint32_t nthbit, uint8_t v)
 {
-    __bb_clr_bit(addr, nthbit);
-    if (v & 1) {
-        __bb_set_bit(addr, nthbit);
-    }
+    __deref(__bb_alias(addr, nthbit)) = v & 1;    /* 1 回のストアで済むので途中で 0 が見えない */
 }
 
 /**
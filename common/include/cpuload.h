@@ -0,0 +1,68 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file cpuload.h
+ * @brief CPU 負荷と割込みごとの実行時間の計測に関する定義・宣言
+ * @details cpuload_start() は RAM 上のベクタテーブル (vector.h) の SysTick と IRQ のエントリを
+ *          計測用の関数に差し替え、元のハンドラの前後で DWT のサイクルカウンタを読む。
+ *          ネストした割込みの時間は外側の割込みから差し引くので、各割込みの時間は自分自身の分だけになる。\n
+ *          アイドルは待ちの間の時間として数える。
+ *          - tmr32_delay_ms()/tmr32_delay_us() の待ち: cpuload_start() がフックを登録する。
+ *          - カーネルのアイドルタスク: kern_idle_hook(cpuload_idle) で登録する。
+ *          スレッドモードの時間は、窓の長さからアイドルと割込みを引いた残り。\n
+ *          結果は CPULOAD_WINDOW_MS ごとに g_cpuload に書き出すので、デバッガからも読める。
+ *
+ *          差し替えない例外:
+ *          - NMI とフォルト (fault.h が例外フレームを EXC_RETURN から探すため)
+ *          - SVCall と PendSV (カーネルのコンテキストスイッチが LR と MSP をそのまま使うため)
+ *          - ハンドラが登録されていない IRQ (startup.c のデフォルトハンドラ)
+ *          cpuload_start() より後に vector_install() したハンドラは計測されないので、
+ *          もう一度 cpuload_start() を呼ぶ (kern_start() の後なら最初のタスクの中で呼ぶ)。
+ */
+
+#ifndef __CPULOAD_H__
+#define __CPULOAD_H__
+
+#include <stdint.h>
+
+#ifndef CPULOAD_SOURCES
+  #define CPULOAD_SOURCES 12            /* 計測する割込みの数の上限 */
+#endif
+#ifndef CPULOAD_WINDOW_MS
+  #define CPULOAD_WINDOW_MS 100         /* 集計の窓の長さ [ms] (CYCCNT が一周する時間より短くする) */
+#endif
+
+/**
+ * 割込みごとの計測値
+ */
+typedef struct cpuload_src {
+    uint32_t cycles;                    /* 直近の窓での実行時間 (ネストした割込みを除く) [cycles] */
+    uint32_t count;                     /* 直近の窓での実行回数 */
+    uint32_t max;                       /* 1 回の実行時間の最大 (cpuload_start() から) [cycles] */
+    uint8_t vec;                        /* 例外番号 (IRQ なら IRQ 番号 + 16) */
+} cpuload_src_t;
+
+/**
+ * 計測結果\n
+ * 窓の時間はサイクル数。計測用の関数自身の出入り (1 回あたり数十サイクル) はスレッドモードに入る。
+ */
+typedef struct cpuload {
+    uint32_t window;                    /* 窓の長さ [cycles] */
+    uint32_t windows;                   /* 集計した窓の数 */
+    uint32_t thread;                    /* 直近の窓: スレッドモード */
+    uint32_t irq;                       /* 直近の窓: 割込み (合計) */
+    uint32_t idle;                      /* 直近の窓: アイドル */
+    uint16_t load;                      /* 直近の窓の負荷 [0.1 %] */
+    uint16_t avg;                       /* 負荷の指数移動平均 (係数 1/8) [0.1 %] */
+    uint16_t peak;                      /* 負荷の最大 [0.1 %] */
+    uint8_t nsrc;                       /* src[] の有効な数 */
+    cpuload_src_t src[CPULOAD_SOURCES];
+} cpuload_t;
+
+extern volatile cpuload_t g_cpuload;
+
+int8_t cpuload_start(void);
+void cpuload_idle(void);
+void cpuload_wait(uint8_t enter);
+
+#endif
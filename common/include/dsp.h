@@ -0,0 +1,141 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file dsp.h
+ * @brief 固定小数点の信号処理 (FIR, 双二次 IIR, 移動平均, メディアン, 間引き, sqrt, atan2) に関する定義・宣言
+ * @details Cortex-M3 には FPU も SIMD (DSP 拡張) もないので、Q15 (int16_t) と Q31 (int32_t) で計算する。
+ *          フィルタはブロック単位で処理し、状態は呼び出し側が用意した配列に持つ。
+ *          - Q15 の FIR: 32 ビットの積和 (MLA)。係数の絶対値の和が 2.0 未満であること。
+ *          - Q31 の FIR と双二次 IIR: 64 ビットの積和 (SMLAL)。
+ *          - 出力は丸めてから飽和させる (SSAT)。
+ *          ARM 以外 (ホスト) でコンパイルすると、同じ結果になる C の式を使う。
+ */
+
+#ifndef __DSP_H__
+#define __DSP_H__
+
+#include <stdint.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+/**
+ * FIR フィルタ (Q15)\n
+ * state は 2 * ntaps 個。同じ値を 2 か所に書いて、窓を折り返さずに読めるようにする。
+ */
+typedef struct dsp_fir_q15 {
+    const q15_t *coef;                  /* 係数 h[0..ntaps-1] (h[0] が最新の入力に掛かる) */
+    q15_t *state;
+    uint16_t ntaps;
+    uint16_t pos;                       /* 最新の入力の位置 */
+} dsp_fir_q15_t;
+
+/**
+ * FIR フィルタ (Q31)
+ */
+typedef struct dsp_fir_q31 {
+    const q31_t *coef;
+    q31_t *state;                       /* 2 * ntaps 個 */
+    uint16_t ntaps;
+    uint16_t pos;
+} dsp_fir_q31_t;
+
+/**
+ * 双二次 IIR フィルタの縦続接続 (直接形 I, Q15)\n
+ * y = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]。
+ * 係数は Q14 (|係数| < 2) で、a1, a2 は伝達関数の分母の係数の符号を反転したもの。
+ */
+typedef struct dsp_biquad_q15 {
+    const q15_t *coef;                  /* 段ごとに b0, b1, b2, a1, a2 */
+    q15_t *state;                       /* 段ごとに x[n-1], x[n-2], y[n-1], y[n-2] */
+    uint8_t nstages;
+} dsp_biquad_q15_t;
+
+/**
+ * 双二次 IIR フィルタの縦続接続 (直接形 I, Q31; 係数は Q30)
+ */
+typedef struct dsp_biquad_q31 {
+    const q31_t *coef;
+    q31_t *state;
+    uint8_t nstages;
+} dsp_biquad_q31_t;
+
+/**
+ * 移動平均 (Q15)
+ */
+typedef struct dsp_mavg {
+    q15_t *buf;                         /* len 個 */
+    int32_t sum;
+    uint16_t len;
+    uint16_t pos;
+    uint8_t shift;                      /* len が 2 のべきなら log2(len), でなければ 0xFF (除算する) */
+} dsp_mavg_t;
+
+/**
+ * メディアンフィルタ (Q15, 窓は奇数で 255 以下)
+ */
+typedef struct dsp_median {
+    q15_t *hist;                        /* 入力の履歴 (len 個, 古い順に巡回) */
+    q15_t *sorted;                      /* 履歴を昇順に並べたもの (len 個) */
+    uint8_t len;
+    uint8_t pos;
+} dsp_median_t;
+
+/**
+ * FIR による間引き (Q15)\n
+ * m 個の入力ごとに 1 個出力する。出力しない入力は状態に入れるだけで積和をしない。
+ */
+typedef struct dsp_decim_q15 {
+    dsp_fir_q15_t fir;
+    uint8_t m;
+    uint8_t phase;
+} dsp_decim_q15_t;
+
+void dsp_fir_q15_init(dsp_fir_q15_t *f, const q15_t *coef, q15_t *state, uint16_t ntaps);
+void dsp_fir_q15(dsp_fir_q15_t *f, const q15_t *in, q15_t *out, uint32_t n);
+void dsp_fir_q31_init(dsp_fir_q31_t *f, const q31_t *coef, q31_t *state, uint16_t ntaps);
+void dsp_fir_q31(dsp_fir_q31_t *f, const q31_t *in, q31_t *out, uint32_t n);
+void dsp_biquad_q15_init(dsp_biquad_q15_t *f, const q15_t *coef, q15_t *state, uint8_t nstages);
+void dsp_biquad_q15(dsp_biquad_q15_t *f, const q15_t *in, q15_t *out, uint32_t n);
+void dsp_biquad_q31_init(dsp_biquad_q31_t *f, const q31_t *coef, q31_t *state, uint8_t nstages);
+void dsp_biquad_q31(dsp_biquad_q31_t *f, const q31_t *in, q31_t *out, uint32_t n);
+void dsp_mavg_init(dsp_mavg_t *m, q15_t *buf, uint16_t len);
+void dsp_mavg(dsp_mavg_t *m, const q15_t *in, q15_t *out, uint32_t n);
+int8_t dsp_median_init(dsp_median_t *m, q15_t *hist, q15_t *sorted, uint8_t len);
+void dsp_median(dsp_median_t *m, const q15_t *in, q15_t *out, uint32_t n);
+void dsp_decim_q15_init(dsp_decim_q15_t *d, const q15_t *coef, q15_t *state, uint16_t ntaps, uint8_t m);
+uint32_t dsp_decim_q15(dsp_decim_q15_t *d, const q15_t *in, q15_t *out, uint32_t n);
+uint16_t dsp_isqrt32(uint32_t x);
+q15_t dsp_atan2_q15(int32_t y, int32_t x);
+
+/**
+ * @def dsp_ssat(x, n)
+ * x を n ビットの符号付き整数の範囲に飽和させる (n は定数)。
+ */
+#if defined(__ARM_ARCH_7M__)
+  #define dsp_ssat(x, n) \
+      __extension__ ({ int32_t __r; __asm ("ssat %0, %1, %2" : "=r" (__r) : "I" (n), "r" ((int32_t)(x))); __r; })
+#else
+  #define dsp_ssat(x, n) \
+      __extension__ ({ int32_t __x = (x); int32_t __m = (1L << ((n) - 1)) - 1; \
+                       (__x > __m) ? __m : (__x < -__m - 1) ? -__m - 1 : __x; })
+#endif
+
+/**
+ * @brief 64 ビットの積和 acc + a * b (SMLAL)
+ * @param[in] acc 累算値
+ * @param[in] a, b 乗数
+ * @return 累算値
+ */
+static inline __attribute__ ((always_inline)) int64_t dsp_smlal(int64_t acc, int32_t a, int32_t b)
+{
+    #if defined(__ARM_ARCH_7M__)
+        union { int64_t v; struct { uint32_t lo, hi; } w; } u = { acc };
+        __asm ("smlal %0, %1, %2, %3" : "+r" (u.w.lo), "+r" (u.w.hi) : "r" (a), "r" (b));
+        return u.v;
+    #else
+        return acc + (int64_t)a * b;
+    #endif
+}
+
+#endif
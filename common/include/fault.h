@@ -0,0 +1,45 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file fault.h
+ * @brief フォルト/想定外割込み発生時のクラッシュレコードに関する定義・宣言
+ * @details デフォルトハンドラ (startup.c の ex_handler/irq_handler) に入ると、
+ *          スタックされた例外フレームとフォルトステータスレジスタを .noinit の
+ *          クラッシュレコードに保存してリセットする (デバッガ接続中はブレークする)。
+ *          リセット後に fault_record() で読み出すか、tools/faultdump.sh で解析する。
+ */
+
+#ifndef __FAULT_H__
+#define __FAULT_H__
+
+#include <stdint.h>
+
+#define FAULT_MAGIC       0x544C5546    /* "FULT" */
+#define FAULT_STACK_WORDS 16            /* 例外フレーム直後から保存するスタックのワード数 */
+
+/**
+ * クラッシュレコード\n
+ * tools/faultdump.sh がこのレイアウトを前提にしているので、変更する場合は合わせること。
+ */
+typedef struct fault_record {
+    uint32_t magic;                     /* FAULT_MAGIC */
+    uint32_t vector;                    /* 例外番号 (IPSR); 16 以上は IRQ (vector - 16) */
+    uint32_t exc_return;                /* 例外復帰値 (LR) */
+    uint32_t sp;                        /* 例外発生時のスタックポインタ (例外フレームの直後) */
+    uint32_t r[13];                     /* r0..r12 */
+    uint32_t lr;                        /* 例外発生時の LR */
+    uint32_t pc;                        /* 例外発生時の PC */
+    uint32_t xpsr;                      /* 例外発生時の xPSR */
+    uint32_t cfsr;                      /* Configurable fault status */
+    uint32_t hfsr;                      /* HardFault status */
+    uint32_t mmfar;                     /* MemManage fault address */
+    uint32_t bfar;                      /* BusFault address */
+    uint32_t stack[FAULT_STACK_WORDS];  /* スタックの内容 (sp から) */
+} fault_record_t;
+
+void fault_init(void);
+const fault_record_t *fault_record(void);
+void fault_clear(void);
+void fault_capture(const uint32_t *frame, const uint32_t *r4_r11, uint32_t exc_return) __attribute__ ((noreturn));
+
+#endif
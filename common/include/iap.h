@@ -0,0 +1,46 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file iap.h
+ * @brief ROM の In-Application Programming (IAP) ルーチンに関する定義・宣言
+ * @details LPC1311/13/42/43 ユーザマニュアル (UM10375) 21.14 節を参照。
+ *          IAP は RAM の最上位 32 バイトを使うので、リンカスクリプトでスタックから外してある。
+ *          フラッシュの消去/書き込み中はフラッシュを読めないので、割込みを禁止して呼ぶ。
+ */
+
+#ifndef __IAP_H__
+#define __IAP_H__
+
+#include <stdint.h>
+
+#define IAP_ENTRY       0x1FFF1FF1      /* IAP の入口 (Thumb) */
+#define IAP_SECTOR_SIZE 4096            /* セクタのバイト数 */
+#define IAP_PAGE_SIZE   256             /* Copy RAM to Flash の最小バイト数 */
+
+/* コマンド */
+#define IAP_PREPARE     50
+#define IAP_COPY        51
+#define IAP_ERASE       52
+#define IAP_BLANK_CHECK 53
+#define IAP_PART_ID     54
+
+/* ステータスコード */
+#define IAP_CMD_SUCCESS         0
+#define IAP_INVALID_COMMAND     1
+#define IAP_SRC_ADDR_ERROR      2
+#define IAP_DST_ADDR_ERROR      3
+#define IAP_SRC_ADDR_NOT_MAPPED 4
+#define IAP_DST_ADDR_NOT_MAPPED 5
+#define IAP_COUNT_ERROR         6
+#define IAP_INVALID_SECTOR      7
+#define IAP_SECTOR_NOT_BLANK    8
+#define IAP_SECTOR_NOT_PREPARED 9
+#define IAP_COMPARE_ERROR       10
+#define IAP_BUSY                11
+
+uint32_t iap_erase(uint32_t start, uint32_t end);
+uint32_t iap_write(uint32_t dst, const uint32_t *src, uint32_t n);
+uint32_t iap_blank_check(uint32_t start, uint32_t end);
+uint32_t iap_part_id(void);
+
+#endif
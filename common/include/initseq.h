@@ -0,0 +1,96 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file initseq.h
+ * @brief レジスタの初期化シーケンス (表) とそのインタプリタに関する定義・宣言
+ * @details 初期化の手順を、レジスタのアドレスと値の組 (1 手順 8 バイト) の const 配列として
+ *          コンパイル時に作り、initseq_run() の 1 つのループで実行する。
+ *          手順ごとにアドレスと値の即値を命令列に埋め込まずに済み、手順は表を見ればわかる。
+ *          表の名前を initseq_ で始めておくと、tools/initseq.sh が ELF から読み出して
+ *          レジスタ名付きで表示する。\n
+ *          手順の種類はアドレスの下位 2 ビットに入れる (レジスタは 4 バイト境界にある)。
+ *          アドレス 0 の手順は、レジスタを触らない擬似命令 (INITSEQ_DELAY(), INITSEQ_MODIFY() の前半)。\n
+ *          INITSEQ_SET() などの読み出し-変更-書き込みは排他しないので、割込みハンドラも
+ *          書き換えるレジスタには使わない。
+ *          @code
+ *          static const initseq_t initseq_foo[] = {
+ *              INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_SYSOSC_PD_Msk),
+ *              INITSEQ_DELAY(200),
+ *              INITSEQ_POLL(SYSCON(SYSPLLSTAT), SYSCON_SYSPLLSTAT_LOCK_Msk),
+ *          };
+ *          INITSEQ_RUN(initseq_foo);
+ *          @endcode
+ */
+
+#ifndef __INITSEQ_H__
+#define __INITSEQ_H__
+
+#include <stdint.h>
+
+/* 手順の種類 (アドレスの下位 2 ビット) */
+#define INITSEQ_OP_WRITE 0              /* *addr = val (addr が 0 なら val 回の nop) */
+#define INITSEQ_OP_SET   1              /* *addr = (*addr & ~mask) | val (mask は直前の INITSEQ_OP_CLR の擬似命令) */
+#define INITSEQ_OP_CLR   2              /* *addr &= ~val (addr が 0 なら次の INITSEQ_OP_SET の mask を val にする) */
+#define INITSEQ_OP_POLL  3              /* (*addr & val) == val になるまで待つ */
+#define INITSEQ_OP_Msk   3
+
+/**
+ * 初期化の 1 手順
+ */
+typedef struct initseq {
+    uint32_t op;                        /* レジスタのアドレス | INITSEQ_OP_* */
+    uint32_t val;
+} initseq_t;
+
+/**
+ * @def INITSEQ_WRITE(addr, v)
+ * レジスタ addr に v を書く。
+ */
+#define INITSEQ_WRITE(addr, v) { (addr) | INITSEQ_OP_WRITE, (v) }
+
+/**
+ * @def INITSEQ_SET(addr, bits)
+ * レジスタ addr の bits のビットを立てる。
+ */
+#define INITSEQ_SET(addr, bits) { (addr) | INITSEQ_OP_SET, (bits) }
+
+/**
+ * @def INITSEQ_CLR(addr, bits)
+ * レジスタ addr の bits のビットをクリアする。
+ */
+#define INITSEQ_CLR(addr, bits) { (addr) | INITSEQ_OP_CLR, (bits) }
+
+/**
+ * @def INITSEQ_MODIFY(addr, mask, v)
+ * レジスタ addr の mask のビットを v にする (1 回の書き込みで。2 手順を使う)。
+ */
+#define INITSEQ_MODIFY(addr, mask, v) { INITSEQ_OP_CLR, (mask) }, { (addr) | INITSEQ_OP_SET, (v) }
+
+/**
+ * @def INITSEQ_POLL(addr, bits)
+ * レジスタ addr の bits のビットがすべて立つまで待つ。
+ */
+#define INITSEQ_POLL(addr, bits) { (addr) | INITSEQ_OP_POLL, (bits) }
+
+/**
+ * @def INITSEQ_DELAY(n)
+ * nop を n 回実行する。
+ */
+#define INITSEQ_DELAY(n) { INITSEQ_OP_WRITE, (n) }
+
+/**
+ * @def INITSEQ_UPDATE(uen)
+ * クロックソースの更新 (*CLKUEN に 1, 0, 1 を書いて 1 になるまで待つ。4 手順を使う)。
+ */
+#define INITSEQ_UPDATE(uen) \
+    INITSEQ_WRITE(uen, 1), INITSEQ_WRITE(uen, 0), INITSEQ_WRITE(uen, 1), INITSEQ_POLL(uen, 1)
+
+/**
+ * @def INITSEQ_RUN(seq)
+ * 配列 seq の手順をすべて実行する。
+ */
+#define INITSEQ_RUN(seq) initseq_run(seq, sizeof(seq) / sizeof((seq)[0]))
+
+void initseq_run(const initseq_t *seq, uint32_t n);
+
+#endif
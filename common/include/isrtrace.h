@@ -0,0 +1,56 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file isrtrace.h
+ * @brief 割込みの出入りのトレースに関する定義・宣言
+ * @details isrtrace_start() は RAM 上のベクタテーブル (vector.h) の SysTick と IRQ のエントリを
+ *          記録用の関数に差し替え、元のハンドラの前後で DWT のサイクルカウンタを g_isrtrace.buf に書く。
+ *          バッファは一周したら古いものから上書きする (直前の様子が残る)。\n
+ *          tools/isrtrace.sh が OpenOCD で g_isrtrace を吸い出し、Chrome/Perfetto のトレース (JSON) にする。
+ *          ネストした割込みは外側の割込みの中に入れ子で表示される。\n
+ *          レコードは 1 ワード: CYCCNT の下位 24 ビット << 8 | ISRTRACE_EXIT | 例外番号。
+ *          CYCCNT の上位 8 ビットが変わったら、その前に ISRTRACE_EPOCH のレコード (上位 8 ビット << 8) を入れる。\n
+ *          時刻は元のハンドラを呼ぶ直前と直後なので、例外の受け付け (スタッキング) と記録用の関数の出入り
+ *          (合わせて 30 サイクル程度) は含まない。
+ *
+ *          差し替えない例外は cpuload.h と同じ (NMI, フォルト, SVCall, PendSV, 未登録の IRQ)。
+ *          isrtrace_start() より後に vector_install() したハンドラは記録されないので、もう一度呼ぶ。
+ */
+
+#ifndef __ISRTRACE_H__
+#define __ISRTRACE_H__
+
+#include <stdint.h>
+#include "vector.h"
+
+#ifndef ISRTRACE_ENABLE
+  #define ISRTRACE_ENABLE 0             /* 1 にするとサンプルの main() がトレースを始める */
+#endif
+#ifndef ISRTRACE_WORDS
+  #define ISRTRACE_WORDS 512            /* バッファのワード数 (2 のべき乗) */
+#endif
+
+#define ISRTRACE_MAGIC 0x54525349       /* "ISRT" */
+#define ISRTRACE_EXIT  0x80             /* ハンドラから戻った */
+#define ISRTRACE_EPOCH 0x7F             /* CYCCNT の上位 8 ビット */
+
+/**
+ * トレースバッファ\n
+ * wr は折り返さずに増え続ける。wr > size なら古い wr - size ワードは上書きされている。
+ */
+typedef struct isrtrace {
+    uint32_t magic;                     /* ISRTRACE_MAGIC */
+    uint32_t size;                      /* buf のワード数 */
+    volatile uint32_t wr;               /* 書き込み位置 (ワード単位) */
+    volatile uint32_t run;              /* 0 にすると記録を止める (ハンドラは呼ぶ) */
+    uint32_t hz;                        /* CYCCNT の周波数 (システムクロック) */
+    vector_entry handler[NUM_VECTORS];  /* 例外番号ごとの元のハンドラ (ツールがシンボル名を引く) */
+    uint32_t buf[ISRTRACE_WORDS];
+} isrtrace_t;
+
+extern isrtrace_t g_isrtrace;
+
+int8_t isrtrace_start(void);
+void isrtrace_stop(void);
+
+#endif
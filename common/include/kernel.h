@@ -0,0 +1,141 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file kernel.h
+ * @brief 固定優先度のプリエンプティブなタスクカーネルに関する定義・宣言
+ * @details タスクはそれぞれのスタック (PSP) で動き、優先度の高いタスクが実行可能になると
+ *          PendSV でただちに切り替わる。同じ優先度のタスクはティックごとに順番に実行する。\n
+ *          待ちを伴う操作 (kern_delay(), kern_sem_wait(), kern_queue_send/recv() など) は
+ *          SVC 命令でカーネルに入る。SVCall と SysTick は KERN_IRQ_PRIO, PendSV は最低の優先度で動く。\n
+ *          割込みの優先度による使い分け:
+ *          - KERN_IRQ_PRIO より優先度の高い割込み: カーネルが一切マスクしないので遅延が増えない。
+ *            カーネルの関数は呼べない。
+ *          - KERN_IRQ_PRIO 以下の割込み: kern_sem_post() と待ち時間 0 の kern_queue_send/recv() を呼べる。
+ */
+
+#ifndef __KERNEL_H__
+#define __KERNEL_H__
+
+#include <stdint.h>
+
+#ifndef KERN_NPRIO
+  #define KERN_NPRIO 8                  /* タスクの優先度の数 (0 が最高) */
+#endif
+#ifndef KERN_TICK_HZ
+  #define KERN_TICK_HZ 1000             /* ティックの周波数 */
+#endif
+#ifndef KERN_IRQ_PRIO
+  #define KERN_IRQ_PRIO 5               /* SVCall, SysTick の割込み優先度 (1..6) */
+#endif
+#ifndef KERN_IDLE_WORDS
+  #define KERN_IDLE_WORDS 64            /* アイドルタスクのスタックのワード数 */
+#endif
+
+#if (KERN_NPRIO > 31)
+  #error "KERN_NPRIO must be 31 or less."
+#endif
+#if (KERN_IRQ_PRIO < 1 || KERN_IRQ_PRIO > 6)
+  #error "KERN_IRQ_PRIO must be between 1 and 6."
+#endif
+
+#define KERN_FOREVER 0xFFFFFFFF         /* 待ち時間を無限にする */
+
+/* 待ちを伴う操作の戻り値 */
+#define KERN_OK      0
+#define KERN_TIMEOUT (-1)               /* 待ち時間が過ぎた (待ち時間 0 なら、すぐにはできなかった) */
+
+/* タスクの状態 */
+#define KERN_DORMANT 0                  /* 生成前, または終了した */
+#define KERN_READY   1                  /* 実行中または実行可能 */
+#define KERN_BLOCKED 2                  /* 待ち */
+
+typedef struct kern_task kern_task_t;
+
+/**
+ * 待ち行列 (優先度順, 同じ優先度なら先着順)
+ */
+typedef struct kern_wait {
+    kern_task_t *head;
+} kern_wait_t;
+
+/**
+ * タスク制御ブロック
+ */
+struct kern_task {
+    uint32_t *sp;                       /* 切り替えたときの PSP (PendSV が読み書きするので先頭に置く) */
+    kern_task_t *next;                  /* 実行可能リストまたは待ち行列のリンク */
+    kern_task_t *tnext;                 /* タイマリストのリンク */
+    kern_wait_t *wq;                    /* 待っている待ち行列 (なければ 0) */
+    uint32_t *frame;                    /* SVC で積んだ例外フレーム (戻り値を r0 に書く) */
+    void *msg;                          /* キューの送受信で待っている要素 */
+    uint32_t wake;                      /* タイムアウトするティック */
+    uint32_t *stack;                    /* スタック領域の先頭 (最下位アドレス) */
+    uint32_t words;                     /* スタック領域のワード数 */
+    const char *name;
+    uint8_t prio;
+    uint8_t state;
+};
+
+/**
+ * 計数セマフォ
+ */
+typedef struct kern_sem {
+    uint32_t count;
+    kern_wait_t waiters;
+} kern_sem_t;
+
+/**
+ * 固定長要素のメッセージキュー
+ */
+typedef struct kern_queue {
+    uint8_t *buf;                       /* item * len バイト */
+    uint16_t item;                      /* 要素のバイト数 */
+    uint16_t len;                       /* 要素の数 */
+    uint16_t head;                      /* 次に取り出す位置 */
+    uint16_t count;                     /* 入っている要素の数 */
+    kern_wait_t senders;                /* 満杯で送信を待っているタスク */
+    kern_wait_t receivers;              /* 空で受信を待っているタスク */
+} kern_queue_t;
+
+/**
+ * 統計\n
+ * 切り替えのサイクル数は PendSV の入口から次のタスクを選び終わるまで (DWT で測る)。
+ * 例外の出入りのハードウェアによる退避/復帰 (合わせて約 24 サイクル) と r4..r11 の復帰は含まない。
+ */
+typedef struct kern_stat {
+    uint32_t ticks;                     /* 起動からのティック数 */
+    uint32_t switches;                  /* コンテキストスイッチの回数 */
+    uint32_t sw_last;                   /* 直前の切り替えのサイクル数 */
+    uint32_t sw_min;                    /* 最小 */
+    uint32_t sw_max;                    /* 最大 */
+} kern_stat_t;
+
+extern volatile kern_stat_t g_kern_stat;
+
+int8_t kern_task_create(kern_task_t *t, void (*entry)(void *), void *arg,
+                        uint32_t *stack, uint32_t words, uint8_t prio, const char *name);
+void kern_start(void) __attribute__ ((noreturn));
+kern_task_t *kern_self(void);
+uint32_t kern_ticks(void);
+uint32_t kern_stack_free(const kern_task_t *t);
+void kern_idle_hook(void (*fn)(void));
+
+void kern_yield(void);
+void kern_delay(uint32_t ticks);
+void kern_exit(void) __attribute__ ((noreturn));
+
+void kern_sem_init(kern_sem_t *sem, uint32_t count);
+int8_t kern_sem_wait(kern_sem_t *sem, uint32_t timeout);
+void kern_sem_post(kern_sem_t *sem);
+
+void kern_queue_init(kern_queue_t *q, void *buf, uint16_t item, uint16_t len);
+int8_t kern_queue_send(kern_queue_t *q, const void *item, uint32_t timeout);
+int8_t kern_queue_recv(kern_queue_t *q, void *item, uint32_t timeout);
+
+/**
+ * @def KERN_MS(ms)
+ * ミリ秒をティック数に換算する (切り上げ)。
+ */
+#define KERN_MS(ms) (((ms) * KERN_TICK_HZ + 999) / 1000)
+
+#endif
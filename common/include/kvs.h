@@ -0,0 +1,86 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file kvs.h
+ * @brief フラッシュ上のログ構造のキーバリューストアに関する定義・宣言
+ * @details 値を更新するたびに、レコード (キー, 長さ, CRC, 値) を現在のセクタの末尾に
+ *          追記する。セクタを消去するのは、使い切ったセクタがリングを一周して再利用されるときだけで、
+ *          その前に中の有効なレコードを先頭のセクタへ移す (ガベージコレクション)。
+ *          セクタを順に回すので消去回数は全セクタに均等に分散する。\n
+ *          RAM にはキーから最新のレコードの位置を引くハッシュ表だけを持つ。\n
+ *          フラッシュの操作は kvs_flash_t を通して行うので、ホスト上でも消去/書き込みの単位を
+ *          模したフラッシュを与えれば動かせる (このファイルと kvs.c はターゲットに依存しない)。
+ *          ターゲットでは kvs_iap() が ROM の IAP で操作するフラッシュを返す。\n
+ *          電源断の扱い: レコードは CRC で検査し、壊れたものは読み飛ばす。
+ *          ガベージコレクションの途中で止まっても、次の kvs_mount() でやり直す。
+ */
+
+#ifndef __KVS_H__
+#define __KVS_H__
+
+#include <stdint.h>
+
+#ifndef KVS_PAGE
+  #define KVS_PAGE 256                  /* 書き込み単位のバイト数 */
+#endif
+#ifndef KVS_MAX_KEYS
+  #define KVS_MAX_KEYS 32               /* マウント中に扱えるキーの数 */
+#endif
+#ifndef KVS_MAX_VALUE
+  #define KVS_MAX_VALUE 64              /* 値の最大バイト数 */
+#endif
+
+#define KVS_INDEX_SIZE (KVS_MAX_KEYS * 2)   /* ハッシュ表の大きさ (2 のべき乗) */
+#define KVS_MAGIC 0x3153564B                /* "KVS1" (セクタヘッダ) */
+#define KVS_NOKEY 0xFFFF                    /* 使えないキー (消去状態と区別できない) */
+
+#if (KVS_INDEX_SIZE & (KVS_INDEX_SIZE - 1))
+  #error "KVS_MAX_KEYS must be a power of 2."
+#endif
+
+typedef struct kvs_flash kvs_flash_t;
+
+/**
+ * フラッシュの操作\n
+ * 読み出しは base からのメモリアクセスで行う。
+ * program() は消去済みでない部分を含むページも書き込めること (ビットは 1 から 0 にしか変わらない)。
+ */
+struct kvs_flash {
+    const uint8_t *base;                /* 先頭 (セクタ境界) */
+    uint32_t sector_size;               /* セクタのバイト数 (KVS_PAGE の倍数) */
+    uint8_t nsectors;                   /* セクタ数 (2 以上) */
+    int8_t (*erase)(const kvs_flash_t *f, uint8_t sector);
+    int8_t (*program)(const kvs_flash_t *f, uint32_t off, const uint32_t *page);    /* KVS_PAGE バイト */
+};
+
+/**
+ * ハッシュ表の要素
+ */
+typedef struct kvs_entry {
+    uint16_t key;                       /* KVS_NOKEY なら空き */
+    uint16_t off;                       /* 最新のレコードの位置 (base から), 0 なら削除済み */
+} kvs_entry_t;
+
+/**
+ * ストア
+ */
+typedef struct kvs {
+    const kvs_flash_t *flash;
+    uint32_t seq;                       /* 書き込み中のセクタの通し番号 */
+    uint32_t wr;                        /* 書き込み中のセクタ内の次の書き込み位置 */
+    uint32_t erases;                    /* マウントしてからの消去回数 */
+    uint16_t nkeys;                     /* ハッシュ表に入っているキーの数 */
+    uint8_t head;                       /* 書き込み中のセクタ */
+    kvs_entry_t index[KVS_INDEX_SIZE];
+    uint32_t page[KVS_PAGE / 4];        /* 書き込み用のバッファ (IAP はワード境界の RAM を要求する) */
+} kvs_t;
+
+int8_t kvs_mount(kvs_t *kv, const kvs_flash_t *flash);
+int8_t kvs_format(kvs_t *kv);
+int16_t kvs_get(kvs_t *kv, uint16_t key, void *buf, uint16_t size);
+int8_t kvs_set(kvs_t *kv, uint16_t key, const void *val, uint16_t len);
+int8_t kvs_delete(kvs_t *kv, uint16_t key);
+
+const kvs_flash_t *kvs_iap(void);
+
+#endif
@@ -0,0 +1,84 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file la.h
+ * @brief ロジックアナライザ (GPIO ポートのサンプリング) に関する定義・宣言
+ * @details 32 ビットタイマ (LA_TMR) の MR0 一致を一定間隔の刻みにして、1 つのポートを
+ *          マスク付きの GPIOnDATA の 1 回の読み出しでサンプリングする。
+ *          値が変わったときだけ、直前の値とそれが続いたサンプル数を 1 ワードのレコードにして
+ *          g_la.buf に書く (ランレングス圧縮)。\n
+ *          レコード: 続いたサンプル数 << 12 | ピンの値 (12 ビット)。2^20 - 1 サンプルを超えて続いたら分ける。\n
+ *          トリガまではバッファを巡回して上書きし (プリトリガ)、トリガの後は post サンプルか
+ *          バッファが一周するまで書く (ポストトリガ)。
+ *          tools/la2vcd.sh が OpenOCD で g_la を吸い出し、VCD ファイルにする。\n
+ *          サンプリングの間は割込みを禁止する。1 サンプルあたり 20 サイクル程度なので、
+ *          72 MHz で 3 MHz 程度まで取れる (それより速いと間隔が乱れる)。
+ */
+
+#ifndef __LA_H__
+#define __LA_H__
+
+#include <stdint.h>
+
+#ifndef LA_TMR
+  #define LA_TMR 1                      /* サンプリングの刻みに使うタイマ (CT32B0 または CT32B1) */
+#endif
+#ifndef LA_WORDS_LOG2
+  #define LA_WORDS_LOG2 11              /* バッファのワード数 (2 のべき乗) の log2 */
+#endif
+#define LA_WORDS (1 << LA_WORDS_LOG2)
+
+#ifndef LA_MIN_CYCLES
+  #define LA_MIN_CYCLES 24              /* 1 サンプルにかかるサイクル数 (これより短い間隔は受け付けない) */
+#endif
+
+#define LA_MAGIC 0x5043414C             /* "LACP" */
+#define LA_NO_TRIGGER 0xFFFFFFFF
+
+/* トリガの種類 */
+#define LA_TRIG_NONE    0               /* すぐに始める (すべてポストトリガ) */
+#define LA_TRIG_PATTERN 1               /* (値 & trig_mask) が trig_match になった */
+#define LA_TRIG_CHANGE  2               /* trig_mask のどれかのピンが変わった (エッジ) */
+
+/* 状態 */
+#define LA_IDLE      0
+#define LA_DONE      1                  /* トリガの後 post サンプルを取った */
+#define LA_FULL      2                  /* トリガの後、post サンプルの前にバッファが一杯になった */
+#define LA_TIMEOUT   3                  /* トリガが来なかった (直前の様子は残っている) */
+
+/**
+ * キャプチャの設定
+ */
+typedef struct la_config {
+    uint32_t rate;                      /* サンプリング周波数 [Hz] */
+    uint32_t pre;                       /* トリガを受け付けるまでに取るサンプル数 (プリトリガの最小) */
+    uint32_t post;                      /* トリガから取るサンプル数 (1 以上, トリガのサンプルを含む) */
+    uint32_t timeout;                   /* トリガを待つサンプル数の上限 (1 以上) */
+    uint16_t mask;                      /* 取るピン (ビット 0..11) */
+    uint16_t trig_mask;                 /* トリガを見るピン */
+    uint16_t trig_match;                /* LA_TRIG_PATTERN の値 */
+    uint8_t port;                       /* ポート番号 (0..3) */
+    uint8_t trig;                       /* LA_TRIG_NONE など */
+} la_config_t;
+
+/**
+ * キャプチャの結果 (デバッガから読む)\n
+ * 有効なレコードは wr - min(wr, size) から wr - 1 (buf の添字はその size の剰余)。
+ */
+typedef struct la_capture {
+    uint32_t magic;                     /* LA_MAGIC */
+    uint32_t size;                      /* buf のワード数 */
+    uint32_t wr;                        /* 書いたレコードの数 (折り返さずに増え続ける) */
+    uint32_t trig;                      /* トリガのサンプルから始まるレコードの番号 (LA_NO_TRIGGER: なし) */
+    uint32_t rate;                      /* 実際のサンプリング周波数 [Hz] */
+    uint16_t mask;
+    uint8_t port;
+    uint8_t status;                     /* LA_IDLE など */
+    uint32_t buf[LA_WORDS];
+} la_capture_t;
+
+extern la_capture_t g_la;
+
+int8_t la_capture(const la_config_t *cfg);
+
+#endif
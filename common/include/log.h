@@ -0,0 +1,80 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file log.h
+ * @brief 遅延フォーマットのバイナリログに関する定義・宣言
+ * @details LOG("x=%u", x) は書式文字列をロードされない ELF セクション (.logstr) に置き、
+ *          ターゲットからは書式の ID (.logstr 内のオフセット) と引数の生の値だけを出力する。
+ *          文字列の整形はホスト側の tools/logdump.sh が ELF を見て行う。\n
+ *          レコードは 32 ビットワードの並び: ヘッダ (引数の数 << 28 | ID), 引数 0..LOG_MAX_ARGS-1。\n
+ *          引数は uint32_t にキャストされる。%s はフラッシュ上の文字列を指すポインタのときだけ展開される。
+ *          浮動小数点数は渡せない。
+ */
+
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <stdint.h>
+
+#define LOG_TRANSPORT_RING 0            /* RAM 上のリングバッファ (デバッガが吸い出す) */
+#define LOG_TRANSPORT_ITM  1            /* ITM スティミュラスポート (SWO) */
+
+#ifndef LOG_ENABLE
+  #define LOG_ENABLE 1                  /* 0 にすると LOG() は何も生成しない */
+#endif
+#ifndef LOG_TRANSPORT
+  #define LOG_TRANSPORT LOG_TRANSPORT_RING
+#endif
+#ifndef LOG_RING_WORDS
+  #define LOG_RING_WORDS 128            /* リングバッファのワード数 (2 のべき乗) */
+#endif
+#ifndef LOG_ITM_PORT
+  #define LOG_ITM_PORT 0                /* 使用するスティミュラスポート */
+#endif
+
+#define LOG_MAX_ARGS 4
+#define LOG_RING_MAGIC 0x474F4C42       /* "BLOG" */
+
+/**
+ * RAM リングバッファ (LOG_TRANSPORT_RING)\n
+ * ターゲットは wr を、デバッガは rd を進める。満杯のときレコードは捨てて dropped を数える。
+ */
+typedef struct log_ring {
+    uint32_t magic;                     /* LOG_RING_MAGIC */
+    uint32_t size;                      /* buf のワード数 */
+    volatile uint32_t wr;               /* 書き込み位置 (ワード単位, 折り返さずに増え続ける) */
+    volatile uint32_t rd;               /* 読み出し位置 (同上) */
+    volatile uint32_t dropped;          /* 捨てたレコードの数 */
+    uint32_t buf[LOG_RING_WORDS];
+} log_ring_t;
+
+extern log_ring_t g_log_ring;
+
+void log_init(void);
+void log_emit(uint32_t hdr, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+
+#if (LOG_ENABLE)
+
+/**
+ * @def LOG(fmt, ...)
+ * @details 書式 fmt と 0..LOG_MAX_ARGS 個の引数をログに出力する。割込みハンドラから呼んでもよい。
+ */
+#define LOG(fmt, ...) \
+    do { \
+        static const char __log_fmt[] __attribute__((section(".logstr"), used)) = fmt; \
+        _Static_assert(__LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS, "too many LOG() arguments"); \
+        log_emit(((uint32_t)__LOG_NARGS(__VA_ARGS__) << 28) | (uint32_t)__log_fmt, \
+                 __LOG_ARGS(_, ##__VA_ARGS__, 0, 0, 0, 0)); \
+    } while (0)
+
+#define __LOG_NARGS(...) __LOG_NARGS_(_, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define __LOG_NARGS_(_, a, b, c, d, e, n, ...) n
+#define __LOG_ARGS(_, a, b, c, d, ...) (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d)
+
+#else
+
+#define LOG(fmt, ...) do { } while (0)
+
+#endif
+
+#endif
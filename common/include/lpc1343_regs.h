@@ -0,0 +1,1108 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file lpc1343_regs.h
+ * @brief LPC1343 ペリフェラルレジスタの構造体オーバーレイ
+ * @details tools/svd2h.sh で LPC1343-subset.svd から生成した。手で編集しないこと。
+ */
+
+#ifndef __LPC1343_REGS_H__
+#define __LPC1343_REGS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * SYSCON: System configuration
+ */
+typedef struct syscon_regs {
+    volatile uint32_t SYSMEMREMAP;           /* 0x000 System memory remap */
+    volatile uint32_t PRESETCTRL;            /* 0x004 Peripheral reset control */
+    volatile uint32_t SYSPLLCTRL;            /* 0x008 System PLL control */
+    const volatile uint32_t SYSPLLSTAT;      /* 0x00C System PLL status */
+    volatile uint32_t USBPLLCTRL;            /* 0x010 USB PLL control */
+    const volatile uint32_t USBPLLSTAT;      /* 0x014 USB PLL status */
+    uint32_t __reserved0[2];                 /* 0x018 */
+    volatile uint32_t SYSOSCCTRL;            /* 0x020 System oscillator control */
+    volatile uint32_t WDTOSCCTRL;            /* 0x024 Watchdog oscillator control */
+    volatile uint32_t IRCCTRL;               /* 0x028 IRC control */
+    uint32_t __reserved1[1];                 /* 0x02C */
+    volatile uint32_t SYSRESSTAT;            /* 0x030 System reset status */
+    uint32_t __reserved2[3];                 /* 0x034 */
+    volatile uint32_t SYSPLLCLKSEL;          /* 0x040 System PLL clock source select */
+    volatile uint32_t SYSPLLCLKUEN;          /* 0x044 System PLL clock source update enable */
+    volatile uint32_t USBPLLCLKSEL;          /* 0x048 USB PLL clock source select */
+    volatile uint32_t USBPLLCLKUEN;          /* 0x04C USB PLL clock source update enable */
+    uint32_t __reserved3[8];                 /* 0x050 */
+    volatile uint32_t MAINCLKSEL;            /* 0x070 Main clock source select */
+    volatile uint32_t MAINCLKUEN;            /* 0x074 Main clock source update enable */
+    volatile uint32_t SYSAHBCLKDIV;          /* 0x078 System AHB clock divider */
+    uint32_t __reserved4[1];                 /* 0x07C */
+    volatile uint32_t SYSAHBCLKCTRL;         /* 0x080 System AHB clock control */
+    uint32_t __reserved5[4];                 /* 0x084 */
+    volatile uint32_t SSP0CLKDIV;            /* 0x094 SSP0 clock divider */
+    volatile uint32_t UARTCLKDIV;            /* 0x098 UART clock divider */
+    volatile uint32_t SSP1CLKDIV;            /* 0x09C SSP1 clock divider */
+    uint32_t __reserved6[3];                 /* 0x0A0 */
+    volatile uint32_t TRACECLKDIV;           /* 0x0AC ARM trace clock divider */
+    volatile uint32_t SYSTICKCLKDIV;         /* 0x0B0 SYSTICK clock divider */
+    uint32_t __reserved7[3];                 /* 0x0B4 */
+    volatile uint32_t USBCLKSEL;             /* 0x0C0 USB clock source select */
+    volatile uint32_t USBCLKUEN;             /* 0x0C4 USB clock source update enable */
+    volatile uint32_t USBCLKDIV;             /* 0x0C8 USB clock divider */
+    uint32_t __reserved8[1];                 /* 0x0CC */
+    volatile uint32_t WDTCLKSEL;             /* 0x0D0 WDT clock source select */
+    volatile uint32_t WDTCLKUEN;             /* 0x0D4 WDT clock source update enable */
+    volatile uint32_t WDTCLKDIV;             /* 0x0D8 WDT clock divider */
+    uint32_t __reserved9[1];                 /* 0x0DC */
+    volatile uint32_t CLKOUTCLKSEL;          /* 0x0E0 CLKOUT clock source select */
+    volatile uint32_t CLKOUTUEN;             /* 0x0E4 CLKOUT clock source update enable */
+    volatile uint32_t CLKOUTDIV;             /* 0x0E8 CLKOUT clock divider */
+    uint32_t __reserved10[5];                /* 0x0EC */
+    const volatile uint32_t PIOPORCAP0;      /* 0x100 POR captured PIO status 0 */
+    const volatile uint32_t PIOPORCAP1;      /* 0x104 POR captured PIO status 1 */
+    uint32_t __reserved11[18];               /* 0x108 */
+    volatile uint32_t BODCTRL;               /* 0x150 BOD control */
+    volatile uint32_t SYSTCKCAL;             /* 0x154 System tick counter calibration */
+    uint32_t __reserved12[42];               /* 0x158 */
+    volatile uint32_t STARTAPRP0;            /* 0x200 Start logic edge control 0 */
+    volatile uint32_t STARTERP0;             /* 0x204 Start logic signal enable 0 */
+    volatile uint32_t STARTRSRP0CLR;         /* 0x208 Start logic reset 0 */
+    const volatile uint32_t STARTSRP0;       /* 0x20C Start logic status 0 */
+    volatile uint32_t STARTAPRP1;            /* 0x210 Start logic edge control 1 */
+    volatile uint32_t STARTERP1;             /* 0x214 Start logic signal enable 1 */
+    volatile uint32_t STARTRSRP1CLR;         /* 0x218 Start logic reset 1 */
+    const volatile uint32_t STARTSRP1;       /* 0x21C Start logic status 1 */
+    uint32_t __reserved13[4];                /* 0x220 */
+    volatile uint32_t PDSLEEPCFG;            /* 0x230 Power-down states in Deep-sleep mode */
+    volatile uint32_t PDAWAKECFG;            /* 0x234 Power-down states after wake-up */
+    volatile uint32_t PDRUNCFG;              /* 0x238 Power-down configuration */
+    uint32_t __reserved14[110];              /* 0x23C */
+    const volatile uint32_t DEVICEID;        /* 0x3F4 Device ID */
+} syscon_regs_t;
+
+_Static_assert(offsetof(syscon_regs_t, SYSMEMREMAP) == 0x000, "SYSCON.SYSMEMREMAP");
+_Static_assert(offsetof(syscon_regs_t, PRESETCTRL) == 0x004, "SYSCON.PRESETCTRL");
+_Static_assert(offsetof(syscon_regs_t, SYSPLLCTRL) == 0x008, "SYSCON.SYSPLLCTRL");
+_Static_assert(offsetof(syscon_regs_t, SYSPLLSTAT) == 0x00C, "SYSCON.SYSPLLSTAT");
+_Static_assert(offsetof(syscon_regs_t, USBPLLCTRL) == 0x010, "SYSCON.USBPLLCTRL");
+_Static_assert(offsetof(syscon_regs_t, USBPLLSTAT) == 0x014, "SYSCON.USBPLLSTAT");
+_Static_assert(offsetof(syscon_regs_t, SYSOSCCTRL) == 0x020, "SYSCON.SYSOSCCTRL");
+_Static_assert(offsetof(syscon_regs_t, WDTOSCCTRL) == 0x024, "SYSCON.WDTOSCCTRL");
+_Static_assert(offsetof(syscon_regs_t, IRCCTRL) == 0x028, "SYSCON.IRCCTRL");
+_Static_assert(offsetof(syscon_regs_t, SYSRESSTAT) == 0x030, "SYSCON.SYSRESSTAT");
+_Static_assert(offsetof(syscon_regs_t, SYSPLLCLKSEL) == 0x040, "SYSCON.SYSPLLCLKSEL");
+_Static_assert(offsetof(syscon_regs_t, SYSPLLCLKUEN) == 0x044, "SYSCON.SYSPLLCLKUEN");
+_Static_assert(offsetof(syscon_regs_t, USBPLLCLKSEL) == 0x048, "SYSCON.USBPLLCLKSEL");
+_Static_assert(offsetof(syscon_regs_t, USBPLLCLKUEN) == 0x04C, "SYSCON.USBPLLCLKUEN");
+_Static_assert(offsetof(syscon_regs_t, MAINCLKSEL) == 0x070, "SYSCON.MAINCLKSEL");
+_Static_assert(offsetof(syscon_regs_t, MAINCLKUEN) == 0x074, "SYSCON.MAINCLKUEN");
+_Static_assert(offsetof(syscon_regs_t, SYSAHBCLKDIV) == 0x078, "SYSCON.SYSAHBCLKDIV");
+_Static_assert(offsetof(syscon_regs_t, SYSAHBCLKCTRL) == 0x080, "SYSCON.SYSAHBCLKCTRL");
+_Static_assert(offsetof(syscon_regs_t, SSP0CLKDIV) == 0x094, "SYSCON.SSP0CLKDIV");
+_Static_assert(offsetof(syscon_regs_t, UARTCLKDIV) == 0x098, "SYSCON.UARTCLKDIV");
+_Static_assert(offsetof(syscon_regs_t, SSP1CLKDIV) == 0x09C, "SYSCON.SSP1CLKDIV");
+_Static_assert(offsetof(syscon_regs_t, TRACECLKDIV) == 0x0AC, "SYSCON.TRACECLKDIV");
+_Static_assert(offsetof(syscon_regs_t, SYSTICKCLKDIV) == 0x0B0, "SYSCON.SYSTICKCLKDIV");
+_Static_assert(offsetof(syscon_regs_t, USBCLKSEL) == 0x0C0, "SYSCON.USBCLKSEL");
+_Static_assert(offsetof(syscon_regs_t, USBCLKUEN) == 0x0C4, "SYSCON.USBCLKUEN");
+_Static_assert(offsetof(syscon_regs_t, USBCLKDIV) == 0x0C8, "SYSCON.USBCLKDIV");
+_Static_assert(offsetof(syscon_regs_t, WDTCLKSEL) == 0x0D0, "SYSCON.WDTCLKSEL");
+_Static_assert(offsetof(syscon_regs_t, WDTCLKUEN) == 0x0D4, "SYSCON.WDTCLKUEN");
+_Static_assert(offsetof(syscon_regs_t, WDTCLKDIV) == 0x0D8, "SYSCON.WDTCLKDIV");
+_Static_assert(offsetof(syscon_regs_t, CLKOUTCLKSEL) == 0x0E0, "SYSCON.CLKOUTCLKSEL");
+_Static_assert(offsetof(syscon_regs_t, CLKOUTUEN) == 0x0E4, "SYSCON.CLKOUTUEN");
+_Static_assert(offsetof(syscon_regs_t, CLKOUTDIV) == 0x0E8, "SYSCON.CLKOUTDIV");
+_Static_assert(offsetof(syscon_regs_t, PIOPORCAP0) == 0x100, "SYSCON.PIOPORCAP0");
+_Static_assert(offsetof(syscon_regs_t, PIOPORCAP1) == 0x104, "SYSCON.PIOPORCAP1");
+_Static_assert(offsetof(syscon_regs_t, BODCTRL) == 0x150, "SYSCON.BODCTRL");
+_Static_assert(offsetof(syscon_regs_t, SYSTCKCAL) == 0x154, "SYSCON.SYSTCKCAL");
+_Static_assert(offsetof(syscon_regs_t, STARTAPRP0) == 0x200, "SYSCON.STARTAPRP0");
+_Static_assert(offsetof(syscon_regs_t, STARTERP0) == 0x204, "SYSCON.STARTERP0");
+_Static_assert(offsetof(syscon_regs_t, STARTRSRP0CLR) == 0x208, "SYSCON.STARTRSRP0CLR");
+_Static_assert(offsetof(syscon_regs_t, STARTSRP0) == 0x20C, "SYSCON.STARTSRP0");
+_Static_assert(offsetof(syscon_regs_t, STARTAPRP1) == 0x210, "SYSCON.STARTAPRP1");
+_Static_assert(offsetof(syscon_regs_t, STARTERP1) == 0x214, "SYSCON.STARTERP1");
+_Static_assert(offsetof(syscon_regs_t, STARTRSRP1CLR) == 0x218, "SYSCON.STARTRSRP1CLR");
+_Static_assert(offsetof(syscon_regs_t, STARTSRP1) == 0x21C, "SYSCON.STARTSRP1");
+_Static_assert(offsetof(syscon_regs_t, PDSLEEPCFG) == 0x230, "SYSCON.PDSLEEPCFG");
+_Static_assert(offsetof(syscon_regs_t, PDAWAKECFG) == 0x234, "SYSCON.PDAWAKECFG");
+_Static_assert(offsetof(syscon_regs_t, PDRUNCFG) == 0x238, "SYSCON.PDRUNCFG");
+_Static_assert(offsetof(syscon_regs_t, DEVICEID) == 0x3F4, "SYSCON.DEVICEID");
+
+#define SYSCON_SYSMEMREMAP_MAP_Pos               0
+#define SYSCON_SYSMEMREMAP_MAP_Msk               (0x3U << 0)    /* Memory map select */
+#define SYSCON_SYSPLLCTRL_MSEL_Pos               0
+#define SYSCON_SYSPLLCTRL_MSEL_Msk               (0x1FU << 0)    /* Feedback divider value (M - 1) */
+#define SYSCON_SYSPLLCTRL_PSEL_Pos               5
+#define SYSCON_SYSPLLCTRL_PSEL_Msk               (0x3U << 5)    /* Post divider ratio (2P) */
+#define SYSCON_SYSPLLSTAT_LOCK_Pos               0
+#define SYSCON_SYSPLLSTAT_LOCK_Msk               (0x1U << 0)    /* PLL lock status */
+#define SYSCON_USBPLLCTRL_MSEL_Pos               0
+#define SYSCON_USBPLLCTRL_MSEL_Msk               (0x1FU << 0)    /* Feedback divider value (M - 1) */
+#define SYSCON_USBPLLCTRL_PSEL_Pos               5
+#define SYSCON_USBPLLCTRL_PSEL_Msk               (0x3U << 5)    /* Post divider ratio (2P) */
+#define SYSCON_USBPLLSTAT_LOCK_Pos               0
+#define SYSCON_USBPLLSTAT_LOCK_Msk               (0x1U << 0)    /* PLL lock status */
+#define SYSCON_SYSOSCCTRL_BYPASS_Pos             0
+#define SYSCON_SYSOSCCTRL_BYPASS_Msk             (0x1U << 0)    /* Bypass system oscillator */
+#define SYSCON_SYSOSCCTRL_FREQRANGE_Pos          1
+#define SYSCON_SYSOSCCTRL_FREQRANGE_Msk          (0x1U << 1)    /* 1: 15 - 25 MHz */
+#define SYSCON_SYSRESSTAT_POR_Pos                0
+#define SYSCON_SYSRESSTAT_POR_Msk                (0x1U << 0)    /* Power-on reset */
+#define SYSCON_SYSRESSTAT_EXTRST_Pos             1
+#define SYSCON_SYSRESSTAT_EXTRST_Msk             (0x1U << 1)    /* External reset */
+#define SYSCON_SYSRESSTAT_WDT_Pos                2
+#define SYSCON_SYSRESSTAT_WDT_Msk                (0x1U << 2)    /* Watchdog reset */
+#define SYSCON_SYSRESSTAT_BOD_Pos                3
+#define SYSCON_SYSRESSTAT_BOD_Msk                (0x1U << 3)    /* Brown-out detection reset */
+#define SYSCON_SYSRESSTAT_SYSRST_Pos             4
+#define SYSCON_SYSRESSTAT_SYSRST_Msk             (0x1U << 4)    /* System reset request */
+#define SYSCON_SYSPLLCLKSEL_SEL_Pos              0
+#define SYSCON_SYSPLLCLKSEL_SEL_Msk              (0x3U << 0)    /* 0: IRC, 1: system oscillator */
+#define SYSCON_SYSPLLCLKUEN_ENA_Pos              0
+#define SYSCON_SYSPLLCLKUEN_ENA_Msk              (0x1U << 0)    /* Update clock source */
+#define SYSCON_USBPLLCLKSEL_SEL_Pos              0
+#define SYSCON_USBPLLCLKSEL_SEL_Msk              (0x3U << 0)    /* 0: IRC, 1: system oscillator */
+#define SYSCON_USBPLLCLKUEN_ENA_Pos              0
+#define SYSCON_USBPLLCLKUEN_ENA_Msk              (0x1U << 0)    /* Update clock source */
+#define SYSCON_MAINCLKSEL_SEL_Pos                0
+#define SYSCON_MAINCLKSEL_SEL_Msk                (0x3U << 0)    /* 0: IRC, 1: PLL input, 2: WDT oscillator, 3: PLL output */
+#define SYSCON_MAINCLKUEN_ENA_Pos                0
+#define SYSCON_MAINCLKUEN_ENA_Msk                (0x1U << 0)    /* Update clock source */
+#define SYSCON_SYSAHBCLKDIV_DIV_Pos              0
+#define SYSCON_SYSAHBCLKDIV_DIV_Msk              (0xFFU << 0)    /* 0: disabled, 1..255: divide by DIV */
+#define SYSCON_SYSAHBCLKCTRL_SYS_Pos             0
+#define SYSCON_SYSAHBCLKCTRL_SYS_Msk             (0x1U << 0)
+#define SYSCON_SYSAHBCLKCTRL_ROM_Pos             1
+#define SYSCON_SYSAHBCLKCTRL_ROM_Msk             (0x1U << 1)
+#define SYSCON_SYSAHBCLKCTRL_RAM_Pos             2
+#define SYSCON_SYSAHBCLKCTRL_RAM_Msk             (0x1U << 2)
+#define SYSCON_SYSAHBCLKCTRL_FLASHREG_Pos        3
+#define SYSCON_SYSAHBCLKCTRL_FLASHREG_Msk        (0x1U << 3)
+#define SYSCON_SYSAHBCLKCTRL_FLASHARRAY_Pos      4
+#define SYSCON_SYSAHBCLKCTRL_FLASHARRAY_Msk      (0x1U << 4)
+#define SYSCON_SYSAHBCLKCTRL_I2C_Pos             5
+#define SYSCON_SYSAHBCLKCTRL_I2C_Msk             (0x1U << 5)
+#define SYSCON_SYSAHBCLKCTRL_GPIO_Pos            6
+#define SYSCON_SYSAHBCLKCTRL_GPIO_Msk            (0x1U << 6)
+#define SYSCON_SYSAHBCLKCTRL_CT16B0_Pos          7
+#define SYSCON_SYSAHBCLKCTRL_CT16B0_Msk          (0x1U << 7)
+#define SYSCON_SYSAHBCLKCTRL_CT16B1_Pos          8
+#define SYSCON_SYSAHBCLKCTRL_CT16B1_Msk          (0x1U << 8)
+#define SYSCON_SYSAHBCLKCTRL_CT32B0_Pos          9
+#define SYSCON_SYSAHBCLKCTRL_CT32B0_Msk          (0x1U << 9)
+#define SYSCON_SYSAHBCLKCTRL_CT32B1_Pos          10
+#define SYSCON_SYSAHBCLKCTRL_CT32B1_Msk          (0x1U << 10)
+#define SYSCON_SYSAHBCLKCTRL_SSP0_Pos            11
+#define SYSCON_SYSAHBCLKCTRL_SSP0_Msk            (0x1U << 11)
+#define SYSCON_SYSAHBCLKCTRL_UART_Pos            12
+#define SYSCON_SYSAHBCLKCTRL_UART_Msk            (0x1U << 12)
+#define SYSCON_SYSAHBCLKCTRL_ADC_Pos             13
+#define SYSCON_SYSAHBCLKCTRL_ADC_Msk             (0x1U << 13)
+#define SYSCON_SYSAHBCLKCTRL_USB_REG_Pos         14
+#define SYSCON_SYSAHBCLKCTRL_USB_REG_Msk         (0x1U << 14)
+#define SYSCON_SYSAHBCLKCTRL_WDT_Pos             15
+#define SYSCON_SYSAHBCLKCTRL_WDT_Msk             (0x1U << 15)
+#define SYSCON_SYSAHBCLKCTRL_IOCON_Pos           16
+#define SYSCON_SYSAHBCLKCTRL_IOCON_Msk           (0x1U << 16)
+#define SYSCON_SYSAHBCLKCTRL_SSP1_Pos            18
+#define SYSCON_SYSAHBCLKCTRL_SSP1_Msk            (0x1U << 18)
+#define SYSCON_TRACECLKDIV_DIV_Pos               0
+#define SYSCON_TRACECLKDIV_DIV_Msk               (0xFFU << 0)    /* 0: disabled, 1..255: divide by DIV */
+#define SYSCON_USBCLKSEL_SEL_Pos                 0
+#define SYSCON_USBCLKSEL_SEL_Msk                 (0x3U << 0)    /* 0: USB PLL output, 1: main clock */
+#define SYSCON_USBCLKUEN_ENA_Pos                 0
+#define SYSCON_USBCLKUEN_ENA_Msk                 (0x1U << 0)    /* Update clock source */
+#define SYSCON_USBCLKDIV_DIV_Pos                 0
+#define SYSCON_USBCLKDIV_DIV_Msk                 (0xFFU << 0)    /* 0: disabled, 1..255: divide by DIV */
+#define SYSCON_PDRUNCFG_IRCOUT_PD_Pos            0
+#define SYSCON_PDRUNCFG_IRCOUT_PD_Msk            (0x1U << 0)
+#define SYSCON_PDRUNCFG_IRC_PD_Pos               1
+#define SYSCON_PDRUNCFG_IRC_PD_Msk               (0x1U << 1)
+#define SYSCON_PDRUNCFG_FLASH_PD_Pos             2
+#define SYSCON_PDRUNCFG_FLASH_PD_Msk             (0x1U << 2)
+#define SYSCON_PDRUNCFG_BOD_PD_Pos               3
+#define SYSCON_PDRUNCFG_BOD_PD_Msk               (0x1U << 3)
+#define SYSCON_PDRUNCFG_ADC_PD_Pos               4
+#define SYSCON_PDRUNCFG_ADC_PD_Msk               (0x1U << 4)
+#define SYSCON_PDRUNCFG_SYSOSC_PD_Pos            5
+#define SYSCON_PDRUNCFG_SYSOSC_PD_Msk            (0x1U << 5)
+#define SYSCON_PDRUNCFG_WDTOSC_PD_Pos            6
+#define SYSCON_PDRUNCFG_WDTOSC_PD_Msk            (0x1U << 6)
+#define SYSCON_PDRUNCFG_SYSPLL_PD_Pos            7
+#define SYSCON_PDRUNCFG_SYSPLL_PD_Msk            (0x1U << 7)
+#define SYSCON_PDRUNCFG_USBPLL_PD_Pos            8
+#define SYSCON_PDRUNCFG_USBPLL_PD_Msk            (0x1U << 8)
+#define SYSCON_PDRUNCFG_USBPAD_PD_Pos            10
+#define SYSCON_PDRUNCFG_USBPAD_PD_Msk            (0x1U << 10)
+
+/*
+ * IOCON: I/O configuration
+ */
+typedef struct iocon_regs {
+    volatile uint32_t PIO2_6;                /* 0x000 I/O configuration for pin PIO2_6 */
+    uint32_t __reserved0[1];                 /* 0x004 */
+    volatile uint32_t PIO2_0;                /* 0x008 I/O configuration for pin PIO2_0 */
+    volatile uint32_t RESET_PIO0_0;          /* 0x00C I/O configuration for pin RESET_PIO0_0 */
+    volatile uint32_t PIO0_1;                /* 0x010 I/O configuration for pin PIO0_1 */
+    volatile uint32_t PIO1_8;                /* 0x014 I/O configuration for pin PIO1_8 */
+    uint32_t __reserved1[1];                 /* 0x018 */
+    volatile uint32_t PIO0_2;                /* 0x01C I/O configuration for pin PIO0_2 */
+    volatile uint32_t PIO2_7;                /* 0x020 I/O configuration for pin PIO2_7 */
+    volatile uint32_t PIO2_8;                /* 0x024 I/O configuration for pin PIO2_8 */
+    volatile uint32_t PIO2_1;                /* 0x028 I/O configuration for pin PIO2_1 */
+    volatile uint32_t PIO0_3;                /* 0x02C I/O configuration for pin PIO0_3 */
+    volatile uint32_t PIO0_4;                /* 0x030 I/O configuration for pin PIO0_4 */
+    volatile uint32_t PIO0_5;                /* 0x034 I/O configuration for pin PIO0_5 */
+    volatile uint32_t PIO1_9;                /* 0x038 I/O configuration for pin PIO1_9 */
+    volatile uint32_t PIO3_4;                /* 0x03C I/O configuration for pin PIO3_4 */
+    volatile uint32_t PIO2_4;                /* 0x040 I/O configuration for pin PIO2_4 */
+    volatile uint32_t PIO2_5;                /* 0x044 I/O configuration for pin PIO2_5 */
+    volatile uint32_t PIO3_5;                /* 0x048 I/O configuration for pin PIO3_5 */
+    volatile uint32_t PIO0_6;                /* 0x04C I/O configuration for pin PIO0_6 */
+    volatile uint32_t PIO0_7;                /* 0x050 I/O configuration for pin PIO0_7 */
+    volatile uint32_t PIO2_9;                /* 0x054 I/O configuration for pin PIO2_9 */
+    volatile uint32_t PIO2_10;               /* 0x058 I/O configuration for pin PIO2_10 */
+    volatile uint32_t PIO2_2;                /* 0x05C I/O configuration for pin PIO2_2 */
+    volatile uint32_t PIO0_8;                /* 0x060 I/O configuration for pin PIO0_8 */
+    volatile uint32_t PIO0_9;                /* 0x064 I/O configuration for pin PIO0_9 */
+    volatile uint32_t SWCLK_PIO0_10;         /* 0x068 I/O configuration for pin SWCLK_PIO0_10 */
+    volatile uint32_t PIO1_10;               /* 0x06C I/O configuration for pin PIO1_10 */
+    volatile uint32_t PIO2_11;               /* 0x070 I/O configuration for pin PIO2_11 */
+    volatile uint32_t R_PIO0_11;             /* 0x074 I/O configuration for pin R_PIO0_11 */
+    volatile uint32_t R_PIO1_0;              /* 0x078 I/O configuration for pin R_PIO1_0 */
+    volatile uint32_t R_PIO1_1;              /* 0x07C I/O configuration for pin R_PIO1_1 */
+    volatile uint32_t R_PIO1_2;              /* 0x080 I/O configuration for pin R_PIO1_2 */
+    volatile uint32_t PIO3_0;                /* 0x084 I/O configuration for pin PIO3_0 */
+    volatile uint32_t PIO3_1;                /* 0x088 I/O configuration for pin PIO3_1 */
+    volatile uint32_t PIO2_3;                /* 0x08C I/O configuration for pin PIO2_3 */
+    volatile uint32_t SWDIO_PIO1_3;          /* 0x090 I/O configuration for pin SWDIO_PIO1_3 */
+    volatile uint32_t PIO1_4;                /* 0x094 I/O configuration for pin PIO1_4 */
+    volatile uint32_t PIO1_11;               /* 0x098 I/O configuration for pin PIO1_11 */
+    volatile uint32_t PIO3_2;                /* 0x09C I/O configuration for pin PIO3_2 */
+    volatile uint32_t PIO1_5;                /* 0x0A0 I/O configuration for pin PIO1_5 */
+    volatile uint32_t PIO1_6;                /* 0x0A4 I/O configuration for pin PIO1_6 */
+    volatile uint32_t PIO1_7;                /* 0x0A8 I/O configuration for pin PIO1_7 */
+    volatile uint32_t PIO3_3;                /* 0x0AC I/O configuration for pin PIO3_3 */
+    volatile uint32_t SCK0_LOC;              /* 0x0B0 I/O configuration for pin SCK0_LOC */
+    volatile uint32_t DSR_LOC;               /* 0x0B4 I/O configuration for pin DSR_LOC */
+    volatile uint32_t DCD_LOC;               /* 0x0B8 I/O configuration for pin DCD_LOC */
+    volatile uint32_t RI_LOC;                /* 0x0BC I/O configuration for pin RI_LOC */
+} iocon_regs_t;
+
+_Static_assert(offsetof(iocon_regs_t, PIO2_6) == 0x000, "IOCON.PIO2_6");
+_Static_assert(offsetof(iocon_regs_t, PIO2_0) == 0x008, "IOCON.PIO2_0");
+_Static_assert(offsetof(iocon_regs_t, RESET_PIO0_0) == 0x00C, "IOCON.RESET_PIO0_0");
+_Static_assert(offsetof(iocon_regs_t, PIO0_1) == 0x010, "IOCON.PIO0_1");
+_Static_assert(offsetof(iocon_regs_t, PIO1_8) == 0x014, "IOCON.PIO1_8");
+_Static_assert(offsetof(iocon_regs_t, PIO0_2) == 0x01C, "IOCON.PIO0_2");
+_Static_assert(offsetof(iocon_regs_t, PIO2_7) == 0x020, "IOCON.PIO2_7");
+_Static_assert(offsetof(iocon_regs_t, PIO2_8) == 0x024, "IOCON.PIO2_8");
+_Static_assert(offsetof(iocon_regs_t, PIO2_1) == 0x028, "IOCON.PIO2_1");
+_Static_assert(offsetof(iocon_regs_t, PIO0_3) == 0x02C, "IOCON.PIO0_3");
+_Static_assert(offsetof(iocon_regs_t, PIO0_4) == 0x030, "IOCON.PIO0_4");
+_Static_assert(offsetof(iocon_regs_t, PIO0_5) == 0x034, "IOCON.PIO0_5");
+_Static_assert(offsetof(iocon_regs_t, PIO1_9) == 0x038, "IOCON.PIO1_9");
+_Static_assert(offsetof(iocon_regs_t, PIO3_4) == 0x03C, "IOCON.PIO3_4");
+_Static_assert(offsetof(iocon_regs_t, PIO2_4) == 0x040, "IOCON.PIO2_4");
+_Static_assert(offsetof(iocon_regs_t, PIO2_5) == 0x044, "IOCON.PIO2_5");
+_Static_assert(offsetof(iocon_regs_t, PIO3_5) == 0x048, "IOCON.PIO3_5");
+_Static_assert(offsetof(iocon_regs_t, PIO0_6) == 0x04C, "IOCON.PIO0_6");
+_Static_assert(offsetof(iocon_regs_t, PIO0_7) == 0x050, "IOCON.PIO0_7");
+_Static_assert(offsetof(iocon_regs_t, PIO2_9) == 0x054, "IOCON.PIO2_9");
+_Static_assert(offsetof(iocon_regs_t, PIO2_10) == 0x058, "IOCON.PIO2_10");
+_Static_assert(offsetof(iocon_regs_t, PIO2_2) == 0x05C, "IOCON.PIO2_2");
+_Static_assert(offsetof(iocon_regs_t, PIO0_8) == 0x060, "IOCON.PIO0_8");
+_Static_assert(offsetof(iocon_regs_t, PIO0_9) == 0x064, "IOCON.PIO0_9");
+_Static_assert(offsetof(iocon_regs_t, SWCLK_PIO0_10) == 0x068, "IOCON.SWCLK_PIO0_10");
+_Static_assert(offsetof(iocon_regs_t, PIO1_10) == 0x06C, "IOCON.PIO1_10");
+_Static_assert(offsetof(iocon_regs_t, PIO2_11) == 0x070, "IOCON.PIO2_11");
+_Static_assert(offsetof(iocon_regs_t, R_PIO0_11) == 0x074, "IOCON.R_PIO0_11");
+_Static_assert(offsetof(iocon_regs_t, R_PIO1_0) == 0x078, "IOCON.R_PIO1_0");
+_Static_assert(offsetof(iocon_regs_t, R_PIO1_1) == 0x07C, "IOCON.R_PIO1_1");
+_Static_assert(offsetof(iocon_regs_t, R_PIO1_2) == 0x080, "IOCON.R_PIO1_2");
+_Static_assert(offsetof(iocon_regs_t, PIO3_0) == 0x084, "IOCON.PIO3_0");
+_Static_assert(offsetof(iocon_regs_t, PIO3_1) == 0x088, "IOCON.PIO3_1");
+_Static_assert(offsetof(iocon_regs_t, PIO2_3) == 0x08C, "IOCON.PIO2_3");
+_Static_assert(offsetof(iocon_regs_t, SWDIO_PIO1_3) == 0x090, "IOCON.SWDIO_PIO1_3");
+_Static_assert(offsetof(iocon_regs_t, PIO1_4) == 0x094, "IOCON.PIO1_4");
+_Static_assert(offsetof(iocon_regs_t, PIO1_11) == 0x098, "IOCON.PIO1_11");
+_Static_assert(offsetof(iocon_regs_t, PIO3_2) == 0x09C, "IOCON.PIO3_2");
+_Static_assert(offsetof(iocon_regs_t, PIO1_5) == 0x0A0, "IOCON.PIO1_5");
+_Static_assert(offsetof(iocon_regs_t, PIO1_6) == 0x0A4, "IOCON.PIO1_6");
+_Static_assert(offsetof(iocon_regs_t, PIO1_7) == 0x0A8, "IOCON.PIO1_7");
+_Static_assert(offsetof(iocon_regs_t, PIO3_3) == 0x0AC, "IOCON.PIO3_3");
+_Static_assert(offsetof(iocon_regs_t, SCK0_LOC) == 0x0B0, "IOCON.SCK0_LOC");
+_Static_assert(offsetof(iocon_regs_t, DSR_LOC) == 0x0B4, "IOCON.DSR_LOC");
+_Static_assert(offsetof(iocon_regs_t, DCD_LOC) == 0x0B8, "IOCON.DCD_LOC");
+_Static_assert(offsetof(iocon_regs_t, RI_LOC) == 0x0BC, "IOCON.RI_LOC");
+
+/*
+ * GPIO0: General purpose I/O port 0
+ */
+typedef struct gpio_regs {
+    volatile uint32_t MASKED_ACCESS[4095];   /* 0x000 Masked data access (the word offset is the mask) */
+    volatile uint32_t DATA;                  /* 0x3FFC Port n data */
+    uint32_t __reserved0[4096];              /* 0x4000 */
+    volatile uint32_t DIR;                   /* 0x8000 Data direction */
+    volatile uint32_t IS;                    /* 0x8004 Interrupt sense */
+    volatile uint32_t IBE;                   /* 0x8008 Interrupt both edges */
+    volatile uint32_t IEV;                   /* 0x800C Interrupt event */
+    volatile uint32_t IE;                    /* 0x8010 Interrupt mask */
+    const volatile uint32_t RIS;             /* 0x8014 Raw interrupt status */
+    const volatile uint32_t MIS;             /* 0x8018 Masked interrupt status */
+    volatile uint32_t IC;                    /* 0x801C Interrupt clear */
+} gpio_regs_t;
+
+_Static_assert(offsetof(gpio_regs_t, MASKED_ACCESS) == 0x000, "GPIO0.MASKED_ACCESS");
+_Static_assert(offsetof(gpio_regs_t, DATA) == 0x3FFC, "GPIO0.DATA");
+_Static_assert(offsetof(gpio_regs_t, DIR) == 0x8000, "GPIO0.DIR");
+_Static_assert(offsetof(gpio_regs_t, IS) == 0x8004, "GPIO0.IS");
+_Static_assert(offsetof(gpio_regs_t, IBE) == 0x8008, "GPIO0.IBE");
+_Static_assert(offsetof(gpio_regs_t, IEV) == 0x800C, "GPIO0.IEV");
+_Static_assert(offsetof(gpio_regs_t, IE) == 0x8010, "GPIO0.IE");
+_Static_assert(offsetof(gpio_regs_t, RIS) == 0x8014, "GPIO0.RIS");
+_Static_assert(offsetof(gpio_regs_t, MIS) == 0x8018, "GPIO0.MIS");
+_Static_assert(offsetof(gpio_regs_t, IC) == 0x801C, "GPIO0.IC");
+
+/*
+ * CT32B0: 32-bit counter/timer 0
+ */
+typedef struct ct32b_regs {
+    volatile uint32_t IR;                    /* 0x000 Interrupt register */
+    volatile uint32_t TCR;                   /* 0x004 Timer control */
+    volatile uint32_t TC;                    /* 0x008 Timer counter (16 bits) */
+    volatile uint32_t PR;                    /* 0x00C Prescale register (16 bits) */
+    volatile uint32_t PC;                    /* 0x010 Prescale counter (16 bits) */
+    volatile uint32_t MCR;                   /* 0x014 Match control */
+    volatile uint32_t MR0;                   /* 0x018 Match register (16 bits) */
+    volatile uint32_t MR1;                   /* 0x01C Match register (16 bits) */
+    volatile uint32_t MR2;                   /* 0x020 Match register (16 bits) */
+    volatile uint32_t MR3;                   /* 0x024 Match register (16 bits) */
+    volatile uint32_t CCR;                   /* 0x028 Capture control */
+    const volatile uint32_t CR0;             /* 0x02C Capture register 0 (16 bits) */
+    uint32_t __reserved0[3];                 /* 0x030 */
+    volatile uint32_t EMR;                   /* 0x03C External match */
+    uint32_t __reserved1[12];                /* 0x040 */
+    volatile uint32_t CTCR;                  /* 0x070 Count control */
+    volatile uint32_t PWMC;                  /* 0x074 PWM control */
+} ct32b_regs_t;
+
+_Static_assert(offsetof(ct32b_regs_t, IR) == 0x000, "CT32B0.IR");
+_Static_assert(offsetof(ct32b_regs_t, TCR) == 0x004, "CT32B0.TCR");
+_Static_assert(offsetof(ct32b_regs_t, TC) == 0x008, "CT32B0.TC");
+_Static_assert(offsetof(ct32b_regs_t, PR) == 0x00C, "CT32B0.PR");
+_Static_assert(offsetof(ct32b_regs_t, PC) == 0x010, "CT32B0.PC");
+_Static_assert(offsetof(ct32b_regs_t, MCR) == 0x014, "CT32B0.MCR");
+_Static_assert(offsetof(ct32b_regs_t, MR0) == 0x018, "CT32B0.MR0");
+_Static_assert(offsetof(ct32b_regs_t, MR1) == 0x01C, "CT32B0.MR1");
+_Static_assert(offsetof(ct32b_regs_t, MR2) == 0x020, "CT32B0.MR2");
+_Static_assert(offsetof(ct32b_regs_t, MR3) == 0x024, "CT32B0.MR3");
+_Static_assert(offsetof(ct32b_regs_t, CCR) == 0x028, "CT32B0.CCR");
+_Static_assert(offsetof(ct32b_regs_t, CR0) == 0x02C, "CT32B0.CR0");
+_Static_assert(offsetof(ct32b_regs_t, EMR) == 0x03C, "CT32B0.EMR");
+_Static_assert(offsetof(ct32b_regs_t, CTCR) == 0x070, "CT32B0.CTCR");
+_Static_assert(offsetof(ct32b_regs_t, PWMC) == 0x074, "CT32B0.PWMC");
+
+#define CT32B_IR_MR0INT_Pos                      0
+#define CT32B_IR_MR0INT_Msk                      (0x1U << 0)
+#define CT32B_IR_MR1INT_Pos                      1
+#define CT32B_IR_MR1INT_Msk                      (0x1U << 1)
+#define CT32B_IR_MR2INT_Pos                      2
+#define CT32B_IR_MR2INT_Msk                      (0x1U << 2)
+#define CT32B_IR_MR3INT_Pos                      3
+#define CT32B_IR_MR3INT_Msk                      (0x1U << 3)
+#define CT32B_IR_CR0INT_Pos                      4
+#define CT32B_IR_CR0INT_Msk                      (0x1U << 4)
+#define CT32B_TCR_CEN_Pos                        0
+#define CT32B_TCR_CEN_Msk                        (0x1U << 0)    /* Counter enable */
+#define CT32B_TCR_CRST_Pos                       1
+#define CT32B_TCR_CRST_Msk                       (0x1U << 1)    /* Counter reset */
+#define CT32B_MCR_MR0I_Pos                       0
+#define CT32B_MCR_MR0I_Msk                       (0x1U << 0)
+#define CT32B_MCR_MR0R_Pos                       1
+#define CT32B_MCR_MR0R_Msk                       (0x1U << 1)
+#define CT32B_MCR_MR0S_Pos                       2
+#define CT32B_MCR_MR0S_Msk                       (0x1U << 2)
+#define CT32B_MCR_MR1I_Pos                       3
+#define CT32B_MCR_MR1I_Msk                       (0x1U << 3)
+#define CT32B_MCR_MR1R_Pos                       4
+#define CT32B_MCR_MR1R_Msk                       (0x1U << 4)
+#define CT32B_MCR_MR1S_Pos                       5
+#define CT32B_MCR_MR1S_Msk                       (0x1U << 5)
+#define CT32B_MCR_MR2I_Pos                       6
+#define CT32B_MCR_MR2I_Msk                       (0x1U << 6)
+#define CT32B_MCR_MR2R_Pos                       7
+#define CT32B_MCR_MR2R_Msk                       (0x1U << 7)
+#define CT32B_MCR_MR2S_Pos                       8
+#define CT32B_MCR_MR2S_Msk                       (0x1U << 8)
+#define CT32B_MCR_MR3I_Pos                       9
+#define CT32B_MCR_MR3I_Msk                       (0x1U << 9)
+#define CT32B_MCR_MR3R_Pos                       10
+#define CT32B_MCR_MR3R_Msk                       (0x1U << 10)
+#define CT32B_MCR_MR3S_Pos                       11
+#define CT32B_MCR_MR3S_Msk                       (0x1U << 11)
+
+/*
+ * USB: USB device controller
+ */
+typedef struct usb_regs {
+    const volatile uint32_t DevIntSt;        /* 0x000 Device interrupt status */
+    volatile uint32_t DevIntEn;              /* 0x004 Device interrupt enable */
+    volatile uint32_t DevIntClr;             /* 0x008 Device interrupt clear */
+    volatile uint32_t DevIntSet;             /* 0x00C Device interrupt set */
+    volatile uint32_t CmdCode;               /* 0x010 Command code */
+    const volatile uint32_t CmdData;         /* 0x014 Command data */
+    const volatile uint32_t RxData;          /* 0x018 Receive data */
+    volatile uint32_t TxData;                /* 0x01C Transmit data */
+    const volatile uint32_t RxPLen;          /* 0x020 Receive packet length */
+    volatile uint32_t TxPLen;                /* 0x024 Transmit packet length */
+    volatile uint32_t Ctrl;                  /* 0x028 USB control */
+    volatile uint32_t DevFIQSel;             /* 0x02C Device FIQ select */
+} usb_regs_t;
+
+_Static_assert(offsetof(usb_regs_t, DevIntSt) == 0x000, "USB.DevIntSt");
+_Static_assert(offsetof(usb_regs_t, DevIntEn) == 0x004, "USB.DevIntEn");
+_Static_assert(offsetof(usb_regs_t, DevIntClr) == 0x008, "USB.DevIntClr");
+_Static_assert(offsetof(usb_regs_t, DevIntSet) == 0x00C, "USB.DevIntSet");
+_Static_assert(offsetof(usb_regs_t, CmdCode) == 0x010, "USB.CmdCode");
+_Static_assert(offsetof(usb_regs_t, CmdData) == 0x014, "USB.CmdData");
+_Static_assert(offsetof(usb_regs_t, RxData) == 0x018, "USB.RxData");
+_Static_assert(offsetof(usb_regs_t, TxData) == 0x01C, "USB.TxData");
+_Static_assert(offsetof(usb_regs_t, RxPLen) == 0x020, "USB.RxPLen");
+_Static_assert(offsetof(usb_regs_t, TxPLen) == 0x024, "USB.TxPLen");
+_Static_assert(offsetof(usb_regs_t, Ctrl) == 0x028, "USB.Ctrl");
+_Static_assert(offsetof(usb_regs_t, DevFIQSel) == 0x02C, "USB.DevFIQSel");
+
+#define USB_DevIntSt_FRAME_Pos                   0
+#define USB_DevIntSt_FRAME_Msk                   (0x1U << 0)
+#define USB_DevIntSt_EP0_Pos                     1
+#define USB_DevIntSt_EP0_Msk                     (0x1U << 1)
+#define USB_DevIntSt_EP1_Pos                     2
+#define USB_DevIntSt_EP1_Msk                     (0x1U << 2)
+#define USB_DevIntSt_EP2_Pos                     3
+#define USB_DevIntSt_EP2_Msk                     (0x1U << 3)
+#define USB_DevIntSt_EP3_Pos                     4
+#define USB_DevIntSt_EP3_Msk                     (0x1U << 4)
+#define USB_DevIntSt_EP4_Pos                     5
+#define USB_DevIntSt_EP4_Msk                     (0x1U << 5)
+#define USB_DevIntSt_EP5_Pos                     6
+#define USB_DevIntSt_EP5_Msk                     (0x1U << 6)
+#define USB_DevIntSt_EP6_Pos                     7
+#define USB_DevIntSt_EP6_Msk                     (0x1U << 7)
+#define USB_DevIntSt_EP7_Pos                     8
+#define USB_DevIntSt_EP7_Msk                     (0x1U << 8)
+#define USB_DevIntSt_DEV_STAT_Pos                9
+#define USB_DevIntSt_DEV_STAT_Msk                (0x1U << 9)
+#define USB_DevIntSt_CCEMPTY_Pos                 10
+#define USB_DevIntSt_CCEMPTY_Msk                 (0x1U << 10)
+#define USB_DevIntSt_CDFULL_Pos                  11
+#define USB_DevIntSt_CDFULL_Msk                  (0x1U << 11)
+#define USB_DevIntSt_RxENDPKT_Pos                12
+#define USB_DevIntSt_RxENDPKT_Msk                (0x1U << 12)
+#define USB_DevIntSt_TxENDPKT_Pos                13
+#define USB_DevIntSt_TxENDPKT_Msk                (0x1U << 13)
+#define USB_RxPLen_PKT_LNGTH_Pos                 0
+#define USB_RxPLen_PKT_LNGTH_Msk                 (0x3FFU << 0)    /* Packet length */
+#define USB_RxPLen_DV_Pos                        10
+#define USB_RxPLen_DV_Msk                        (0x1U << 10)    /* Data valid */
+#define USB_RxPLen_PKT_RDY_Pos                   11
+#define USB_RxPLen_PKT_RDY_Msk                   (0x1U << 11)    /* Packet ready */
+#define USB_Ctrl_RD_EN_Pos                       0
+#define USB_Ctrl_RD_EN_Msk                       (0x1U << 0)    /* Read enable */
+#define USB_Ctrl_WR_EN_Pos                       1
+#define USB_Ctrl_WR_EN_Msk                       (0x1U << 1)    /* Write enable */
+#define USB_Ctrl_LOG_ENDPOINT_Pos                2
+#define USB_Ctrl_LOG_ENDPOINT_Msk                (0xFU << 2)    /* Logical endpoint number */
+#define USB_DevFIQSel_FRAME_Pos                  0
+#define USB_DevFIQSel_FRAME_Msk                  (0x1U << 0)
+#define USB_DevFIQSel_BULKOUT_Pos                1
+#define USB_DevFIQSel_BULKOUT_Msk                (0x1U << 1)
+#define USB_DevFIQSel_BULKIN_Pos                 2
+#define USB_DevFIQSel_BULKIN_Msk                 (0x1U << 2)
+
+/*
+ * UART: UART
+ */
+typedef struct uart_regs {
+    union {
+        const volatile uint32_t RBR;             /* 0x000 Receiver buffer (DLAB = 0) */
+        volatile uint32_t THR;                   /* 0x000 Transmit holding (DLAB = 0) */
+        volatile uint32_t DLL;                   /* 0x000 Divisor latch LSB (DLAB = 1) */
+    };
+    union {
+        volatile uint32_t DLM;                   /* 0x004 Divisor latch MSB (DLAB = 1) */
+        volatile uint32_t IER;                   /* 0x004 Interrupt enable (DLAB = 0) */
+    };
+    union {
+        const volatile uint32_t IIR;             /* 0x008 Interrupt identification */
+        volatile uint32_t FCR;                   /* 0x008 FIFO control */
+    };
+    volatile uint32_t LCR;                   /* 0x00C Line control */
+    volatile uint32_t MCR;                   /* 0x010 Modem control */
+    const volatile uint32_t LSR;             /* 0x014 Line status */
+    const volatile uint32_t MSR;             /* 0x018 Modem status */
+    volatile uint32_t SCR;                   /* 0x01C Scratch pad */
+    volatile uint32_t ACR;                   /* 0x020 Auto-baud control */
+    uint32_t __reserved0[1];                 /* 0x024 */
+    volatile uint32_t FDR;                   /* 0x028 Fractional divider */
+    uint32_t __reserved1[1];                 /* 0x02C */
+    volatile uint32_t TER;                   /* 0x030 Transmit enable */
+    uint32_t __reserved2[6];                 /* 0x034 */
+    volatile uint32_t RS485CTRL;             /* 0x04C RS-485/EIA-485 control */
+    volatile uint32_t RS485ADRMATCH;         /* 0x050 RS-485/EIA-485 address match */
+    volatile uint32_t RS485DLY;              /* 0x054 RS-485/EIA-485 direction control delay */
+    const volatile uint32_t FIFOLVL;         /* 0x058 FIFO level */
+} uart_regs_t;
+
+_Static_assert(offsetof(uart_regs_t, RBR) == 0x000, "UART.RBR");
+_Static_assert(offsetof(uart_regs_t, THR) == 0x000, "UART.THR");
+_Static_assert(offsetof(uart_regs_t, DLL) == 0x000, "UART.DLL");
+_Static_assert(offsetof(uart_regs_t, DLM) == 0x004, "UART.DLM");
+_Static_assert(offsetof(uart_regs_t, IER) == 0x004, "UART.IER");
+_Static_assert(offsetof(uart_regs_t, IIR) == 0x008, "UART.IIR");
+_Static_assert(offsetof(uart_regs_t, FCR) == 0x008, "UART.FCR");
+_Static_assert(offsetof(uart_regs_t, LCR) == 0x00C, "UART.LCR");
+_Static_assert(offsetof(uart_regs_t, MCR) == 0x010, "UART.MCR");
+_Static_assert(offsetof(uart_regs_t, LSR) == 0x014, "UART.LSR");
+_Static_assert(offsetof(uart_regs_t, MSR) == 0x018, "UART.MSR");
+_Static_assert(offsetof(uart_regs_t, SCR) == 0x01C, "UART.SCR");
+_Static_assert(offsetof(uart_regs_t, ACR) == 0x020, "UART.ACR");
+_Static_assert(offsetof(uart_regs_t, FDR) == 0x028, "UART.FDR");
+_Static_assert(offsetof(uart_regs_t, TER) == 0x030, "UART.TER");
+_Static_assert(offsetof(uart_regs_t, RS485CTRL) == 0x04C, "UART.RS485CTRL");
+_Static_assert(offsetof(uart_regs_t, RS485ADRMATCH) == 0x050, "UART.RS485ADRMATCH");
+_Static_assert(offsetof(uart_regs_t, RS485DLY) == 0x054, "UART.RS485DLY");
+_Static_assert(offsetof(uart_regs_t, FIFOLVL) == 0x058, "UART.FIFOLVL");
+
+#define UART_IER_RBRIE_Pos                       0
+#define UART_IER_RBRIE_Msk                       (0x1U << 0)
+#define UART_IER_THREIE_Pos                      1
+#define UART_IER_THREIE_Msk                      (0x1U << 1)
+#define UART_IER_RLSIE_Pos                       2
+#define UART_IER_RLSIE_Msk                       (0x1U << 2)
+#define UART_IIR_INTSTATUS_Pos                   0
+#define UART_IIR_INTSTATUS_Msk                   (0x1U << 0)
+#define UART_IIR_INTID_Pos                       1
+#define UART_IIR_INTID_Msk                       (0x7U << 1)
+#define UART_FCR_FIFOEN_Pos                      0
+#define UART_FCR_FIFOEN_Msk                      (0x1U << 0)
+#define UART_FCR_RXFIFORES_Pos                   1
+#define UART_FCR_RXFIFORES_Msk                   (0x1U << 1)
+#define UART_FCR_TXFIFORES_Pos                   2
+#define UART_FCR_TXFIFORES_Msk                   (0x1U << 2)
+#define UART_FCR_RXTL_Pos                        6
+#define UART_FCR_RXTL_Msk                        (0x3U << 6)
+#define UART_LCR_WLS_Pos                         0
+#define UART_LCR_WLS_Msk                         (0x3U << 0)
+#define UART_LCR_SBS_Pos                         2
+#define UART_LCR_SBS_Msk                         (0x1U << 2)
+#define UART_LCR_PE_Pos                          3
+#define UART_LCR_PE_Msk                          (0x1U << 3)
+#define UART_LCR_PS_Pos                          4
+#define UART_LCR_PS_Msk                          (0x3U << 4)
+#define UART_LCR_BC_Pos                          6
+#define UART_LCR_BC_Msk                          (0x1U << 6)
+#define UART_LCR_DLAB_Pos                        7
+#define UART_LCR_DLAB_Msk                        (0x1U << 7)
+#define UART_LSR_RDR_Pos                         0
+#define UART_LSR_RDR_Msk                         (0x1U << 0)
+#define UART_LSR_OE_Pos                          1
+#define UART_LSR_OE_Msk                          (0x1U << 1)
+#define UART_LSR_PE_Pos                          2
+#define UART_LSR_PE_Msk                          (0x1U << 2)
+#define UART_LSR_FE_Pos                          3
+#define UART_LSR_FE_Msk                          (0x1U << 3)
+#define UART_LSR_BI_Pos                          4
+#define UART_LSR_BI_Msk                          (0x1U << 4)
+#define UART_LSR_THRE_Pos                        5
+#define UART_LSR_THRE_Msk                        (0x1U << 5)
+#define UART_LSR_TEMT_Pos                        6
+#define UART_LSR_TEMT_Msk                        (0x1U << 6)
+#define UART_LSR_RXFE_Pos                        7
+#define UART_LSR_RXFE_Msk                        (0x1U << 7)
+#define UART_FDR_DIVADDVAL_Pos                   0
+#define UART_FDR_DIVADDVAL_Msk                   (0xFU << 0)
+#define UART_FDR_MULVAL_Pos                      4
+#define UART_FDR_MULVAL_Msk                      (0xFU << 4)
+
+/*
+ * FMC: Flash memory controller
+ */
+typedef struct fmc_regs {
+    uint32_t __reserved0[4];                 /* 0x000 */
+    volatile uint32_t FLASHCFG;              /* 0x010 Flash access time configuration */
+    uint32_t __reserved1[3];                 /* 0x014 */
+    volatile uint32_t FMSSTART;              /* 0x020 Signature start address */
+    volatile uint32_t FMSSTOP;               /* 0x024 Signature stop address */
+    uint32_t __reserved2[1];                 /* 0x028 */
+    const volatile uint32_t FMSW0;           /* 0x02C Signature word */
+    const volatile uint32_t FMSW1;           /* 0x030 Signature word */
+    const volatile uint32_t FMSW2;           /* 0x034 Signature word */
+    const volatile uint32_t FMSW3;           /* 0x038 Signature word */
+    uint32_t __reserved3[1001];              /* 0x03C */
+    const volatile uint32_t FMSTAT;          /* 0xFE0 Signature generation status */
+    uint32_t __reserved4[1];                 /* 0xFE4 */
+    volatile uint32_t FMSTATCLR;             /* 0xFE8 Signature generation status clear */
+} fmc_regs_t;
+
+_Static_assert(offsetof(fmc_regs_t, FLASHCFG) == 0x010, "FMC.FLASHCFG");
+_Static_assert(offsetof(fmc_regs_t, FMSSTART) == 0x020, "FMC.FMSSTART");
+_Static_assert(offsetof(fmc_regs_t, FMSSTOP) == 0x024, "FMC.FMSSTOP");
+_Static_assert(offsetof(fmc_regs_t, FMSW0) == 0x02C, "FMC.FMSW0");
+_Static_assert(offsetof(fmc_regs_t, FMSW1) == 0x030, "FMC.FMSW1");
+_Static_assert(offsetof(fmc_regs_t, FMSW2) == 0x034, "FMC.FMSW2");
+_Static_assert(offsetof(fmc_regs_t, FMSW3) == 0x038, "FMC.FMSW3");
+_Static_assert(offsetof(fmc_regs_t, FMSTAT) == 0xFE0, "FMC.FMSTAT");
+_Static_assert(offsetof(fmc_regs_t, FMSTATCLR) == 0xFE8, "FMC.FMSTATCLR");
+
+#define FMC_FLASHCFG_FLASHTIM_Pos                0
+#define FMC_FLASHCFG_FLASHTIM_Msk                (0x3U << 0)
+#define FMC_FMSSTOP_STOP_Pos                     0
+#define FMC_FMSSTOP_STOP_Msk                     (0x1FFFFU << 0)
+#define FMC_FMSSTOP_STRTBIST_Pos                 17
+#define FMC_FMSSTOP_STRTBIST_Msk                 (0x1U << 17)    /* Start signature generation */
+#define FMC_FMSTAT_SIG_DONE_Pos                  2
+#define FMC_FMSTAT_SIG_DONE_Msk                  (0x1U << 2)
+#define FMC_FMSTATCLR_SIG_DONE_CLR_Pos           2
+#define FMC_FMSTATCLR_SIG_DONE_CLR_Msk           (0x1U << 2)
+
+/*
+ * I2C: I2C-bus controller
+ */
+typedef struct i2c_regs {
+    volatile uint32_t CONSET;                /* 0x000 Control set */
+    const volatile uint32_t STAT;            /* 0x004 Status */
+    volatile uint32_t DAT;                   /* 0x008 Data */
+    volatile uint32_t ADR0;                  /* 0x00C Slave address 0 */
+    volatile uint32_t SCLH;                  /* 0x010 SCL duty cycle high half word */
+    volatile uint32_t SCLL;                  /* 0x014 SCL duty cycle low half word */
+    volatile uint32_t CONCLR;                /* 0x018 Control clear */
+    volatile uint32_t MMCTRL;                /* 0x01C Monitor mode control */
+    volatile uint32_t ADR1;                  /* 0x020 Slave address 1 */
+    volatile uint32_t ADR2;                  /* 0x024 Slave address 2 */
+    volatile uint32_t ADR3;                  /* 0x028 Slave address 3 */
+    const volatile uint32_t DATA_BUFFER;     /* 0x02C Data buffer (monitor mode) */
+    volatile uint32_t MASK0;                 /* 0x030 Slave address mask */
+    volatile uint32_t MASK1;                 /* 0x034 Slave address mask */
+    volatile uint32_t MASK2;                 /* 0x038 Slave address mask */
+    volatile uint32_t MASK3;                 /* 0x03C Slave address mask */
+} i2c_regs_t;
+
+_Static_assert(offsetof(i2c_regs_t, CONSET) == 0x000, "I2C.CONSET");
+_Static_assert(offsetof(i2c_regs_t, STAT) == 0x004, "I2C.STAT");
+_Static_assert(offsetof(i2c_regs_t, DAT) == 0x008, "I2C.DAT");
+_Static_assert(offsetof(i2c_regs_t, ADR0) == 0x00C, "I2C.ADR0");
+_Static_assert(offsetof(i2c_regs_t, SCLH) == 0x010, "I2C.SCLH");
+_Static_assert(offsetof(i2c_regs_t, SCLL) == 0x014, "I2C.SCLL");
+_Static_assert(offsetof(i2c_regs_t, CONCLR) == 0x018, "I2C.CONCLR");
+_Static_assert(offsetof(i2c_regs_t, MMCTRL) == 0x01C, "I2C.MMCTRL");
+_Static_assert(offsetof(i2c_regs_t, ADR1) == 0x020, "I2C.ADR1");
+_Static_assert(offsetof(i2c_regs_t, ADR2) == 0x024, "I2C.ADR2");
+_Static_assert(offsetof(i2c_regs_t, ADR3) == 0x028, "I2C.ADR3");
+_Static_assert(offsetof(i2c_regs_t, DATA_BUFFER) == 0x02C, "I2C.DATA_BUFFER");
+_Static_assert(offsetof(i2c_regs_t, MASK0) == 0x030, "I2C.MASK0");
+_Static_assert(offsetof(i2c_regs_t, MASK1) == 0x034, "I2C.MASK1");
+_Static_assert(offsetof(i2c_regs_t, MASK2) == 0x038, "I2C.MASK2");
+_Static_assert(offsetof(i2c_regs_t, MASK3) == 0x03C, "I2C.MASK3");
+
+#define I2C_CONSET_AA_Pos                        2
+#define I2C_CONSET_AA_Msk                        (0x1U << 2)    /* Assert acknowledge */
+#define I2C_CONSET_SI_Pos                        3
+#define I2C_CONSET_SI_Msk                        (0x1U << 3)    /* Interrupt flag */
+#define I2C_CONSET_STO_Pos                       4
+#define I2C_CONSET_STO_Msk                       (0x1U << 4)    /* STOP flag */
+#define I2C_CONSET_STA_Pos                       5
+#define I2C_CONSET_STA_Msk                       (0x1U << 5)    /* START flag */
+#define I2C_CONSET_I2EN_Pos                      6
+#define I2C_CONSET_I2EN_Msk                      (0x1U << 6)    /* Interface enable */
+#define I2C_STAT_Status_Pos                      3
+#define I2C_STAT_Status_Msk                      (0x1FU << 3)
+#define I2C_CONCLR_AAC_Pos                       2
+#define I2C_CONCLR_AAC_Msk                       (0x1U << 2)
+#define I2C_CONCLR_SIC_Pos                       3
+#define I2C_CONCLR_SIC_Msk                       (0x1U << 3)
+#define I2C_CONCLR_STAC_Pos                      5
+#define I2C_CONCLR_STAC_Msk                      (0x1U << 5)
+#define I2C_CONCLR_I2ENC_Pos                     6
+#define I2C_CONCLR_I2ENC_Msk                     (0x1U << 6)
+
+/*
+ * WDT: Watchdog timer
+ */
+typedef struct wdt_regs {
+    volatile uint32_t MOD;                   /* 0x000 Watchdog mode */
+    volatile uint32_t TC;                    /* 0x004 Watchdog timer constant */
+    volatile uint32_t FEED;                  /* 0x008 Watchdog feed sequence */
+    const volatile uint32_t TV;              /* 0x00C Watchdog timer value */
+} wdt_regs_t;
+
+_Static_assert(offsetof(wdt_regs_t, MOD) == 0x000, "WDT.MOD");
+_Static_assert(offsetof(wdt_regs_t, TC) == 0x004, "WDT.TC");
+_Static_assert(offsetof(wdt_regs_t, FEED) == 0x008, "WDT.FEED");
+_Static_assert(offsetof(wdt_regs_t, TV) == 0x00C, "WDT.TV");
+
+#define WDT_MOD_WDEN_Pos                         0
+#define WDT_MOD_WDEN_Msk                         (0x1U << 0)    /* Watchdog enable */
+#define WDT_MOD_WDRESET_Pos                      1
+#define WDT_MOD_WDRESET_Msk                      (0x1U << 1)    /* Reset on time-out */
+#define WDT_MOD_WDTOF_Pos                        2
+#define WDT_MOD_WDTOF_Msk                        (0x1U << 2)    /* Time-out flag */
+#define WDT_MOD_WDINT_Pos                        3
+#define WDT_MOD_WDINT_Msk                        (0x1U << 3)    /* Interrupt flag */
+
+/*
+ * CT16B0: 16-bit counter/timer 0
+ */
+typedef struct ct16b_regs {
+    volatile uint32_t IR;                    /* 0x000 Interrupt register */
+    volatile uint32_t TCR;                   /* 0x004 Timer control */
+    volatile uint32_t TC;                    /* 0x008 Timer counter (16 bits) */
+    volatile uint32_t PR;                    /* 0x00C Prescale register (16 bits) */
+    volatile uint32_t PC;                    /* 0x010 Prescale counter (16 bits) */
+    volatile uint32_t MCR;                   /* 0x014 Match control */
+    volatile uint32_t MR0;                   /* 0x018 Match register (16 bits) */
+    volatile uint32_t MR1;                   /* 0x01C Match register (16 bits) */
+    volatile uint32_t MR2;                   /* 0x020 Match register (16 bits) */
+    volatile uint32_t MR3;                   /* 0x024 Match register (16 bits) */
+    volatile uint32_t CCR;                   /* 0x028 Capture control */
+    const volatile uint32_t CR0;             /* 0x02C Capture register 0 (16 bits) */
+    uint32_t __reserved0[3];                 /* 0x030 */
+    volatile uint32_t EMR;                   /* 0x03C External match */
+    uint32_t __reserved1[12];                /* 0x040 */
+    volatile uint32_t CTCR;                  /* 0x070 Count control */
+    volatile uint32_t PWMC;                  /* 0x074 PWM control */
+} ct16b_regs_t;
+
+_Static_assert(offsetof(ct16b_regs_t, IR) == 0x000, "CT16B0.IR");
+_Static_assert(offsetof(ct16b_regs_t, TCR) == 0x004, "CT16B0.TCR");
+_Static_assert(offsetof(ct16b_regs_t, TC) == 0x008, "CT16B0.TC");
+_Static_assert(offsetof(ct16b_regs_t, PR) == 0x00C, "CT16B0.PR");
+_Static_assert(offsetof(ct16b_regs_t, PC) == 0x010, "CT16B0.PC");
+_Static_assert(offsetof(ct16b_regs_t, MCR) == 0x014, "CT16B0.MCR");
+_Static_assert(offsetof(ct16b_regs_t, MR0) == 0x018, "CT16B0.MR0");
+_Static_assert(offsetof(ct16b_regs_t, MR1) == 0x01C, "CT16B0.MR1");
+_Static_assert(offsetof(ct16b_regs_t, MR2) == 0x020, "CT16B0.MR2");
+_Static_assert(offsetof(ct16b_regs_t, MR3) == 0x024, "CT16B0.MR3");
+_Static_assert(offsetof(ct16b_regs_t, CCR) == 0x028, "CT16B0.CCR");
+_Static_assert(offsetof(ct16b_regs_t, CR0) == 0x02C, "CT16B0.CR0");
+_Static_assert(offsetof(ct16b_regs_t, EMR) == 0x03C, "CT16B0.EMR");
+_Static_assert(offsetof(ct16b_regs_t, CTCR) == 0x070, "CT16B0.CTCR");
+_Static_assert(offsetof(ct16b_regs_t, PWMC) == 0x074, "CT16B0.PWMC");
+
+#define CT16B_IR_MR0INT_Pos                      0
+#define CT16B_IR_MR0INT_Msk                      (0x1U << 0)
+#define CT16B_IR_MR1INT_Pos                      1
+#define CT16B_IR_MR1INT_Msk                      (0x1U << 1)
+#define CT16B_IR_MR2INT_Pos                      2
+#define CT16B_IR_MR2INT_Msk                      (0x1U << 2)
+#define CT16B_IR_MR3INT_Pos                      3
+#define CT16B_IR_MR3INT_Msk                      (0x1U << 3)
+#define CT16B_IR_CR0INT_Pos                      4
+#define CT16B_IR_CR0INT_Msk                      (0x1U << 4)
+#define CT16B_TCR_CEN_Pos                        0
+#define CT16B_TCR_CEN_Msk                        (0x1U << 0)    /* Counter enable */
+#define CT16B_TCR_CRST_Pos                       1
+#define CT16B_TCR_CRST_Msk                       (0x1U << 1)    /* Counter reset */
+#define CT16B_MCR_MR0I_Pos                       0
+#define CT16B_MCR_MR0I_Msk                       (0x1U << 0)
+#define CT16B_MCR_MR0R_Pos                       1
+#define CT16B_MCR_MR0R_Msk                       (0x1U << 1)
+#define CT16B_MCR_MR0S_Pos                       2
+#define CT16B_MCR_MR0S_Msk                       (0x1U << 2)
+#define CT16B_MCR_MR1I_Pos                       3
+#define CT16B_MCR_MR1I_Msk                       (0x1U << 3)
+#define CT16B_MCR_MR1R_Pos                       4
+#define CT16B_MCR_MR1R_Msk                       (0x1U << 4)
+#define CT16B_MCR_MR1S_Pos                       5
+#define CT16B_MCR_MR1S_Msk                       (0x1U << 5)
+#define CT16B_MCR_MR2I_Pos                       6
+#define CT16B_MCR_MR2I_Msk                       (0x1U << 6)
+#define CT16B_MCR_MR2R_Pos                       7
+#define CT16B_MCR_MR2R_Msk                       (0x1U << 7)
+#define CT16B_MCR_MR2S_Pos                       8
+#define CT16B_MCR_MR2S_Msk                       (0x1U << 8)
+#define CT16B_MCR_MR3I_Pos                       9
+#define CT16B_MCR_MR3I_Msk                       (0x1U << 9)
+#define CT16B_MCR_MR3R_Pos                       10
+#define CT16B_MCR_MR3R_Msk                       (0x1U << 10)
+#define CT16B_MCR_MR3S_Pos                       11
+#define CT16B_MCR_MR3S_Msk                       (0x1U << 11)
+
+/*
+ * ADC: A/D converter
+ */
+typedef struct adc_regs {
+    volatile uint32_t CR;                    /* 0x000 Control */
+    volatile uint32_t GDR;                   /* 0x004 Global data */
+    uint32_t __reserved0[1];                 /* 0x008 */
+    volatile uint32_t INTEN;                 /* 0x00C Interrupt enable */
+    const volatile uint32_t DR0;             /* 0x010 Channel data */
+    const volatile uint32_t DR1;             /* 0x014 Channel data */
+    const volatile uint32_t DR2;             /* 0x018 Channel data */
+    const volatile uint32_t DR3;             /* 0x01C Channel data */
+    const volatile uint32_t DR4;             /* 0x020 Channel data */
+    const volatile uint32_t DR5;             /* 0x024 Channel data */
+    const volatile uint32_t DR6;             /* 0x028 Channel data */
+    const volatile uint32_t DR7;             /* 0x02C Channel data */
+    const volatile uint32_t STAT;            /* 0x030 Status */
+} adc_regs_t;
+
+_Static_assert(offsetof(adc_regs_t, CR) == 0x000, "ADC.CR");
+_Static_assert(offsetof(adc_regs_t, GDR) == 0x004, "ADC.GDR");
+_Static_assert(offsetof(adc_regs_t, INTEN) == 0x00C, "ADC.INTEN");
+_Static_assert(offsetof(adc_regs_t, DR0) == 0x010, "ADC.DR0");
+_Static_assert(offsetof(adc_regs_t, DR1) == 0x014, "ADC.DR1");
+_Static_assert(offsetof(adc_regs_t, DR2) == 0x018, "ADC.DR2");
+_Static_assert(offsetof(adc_regs_t, DR3) == 0x01C, "ADC.DR3");
+_Static_assert(offsetof(adc_regs_t, DR4) == 0x020, "ADC.DR4");
+_Static_assert(offsetof(adc_regs_t, DR5) == 0x024, "ADC.DR5");
+_Static_assert(offsetof(adc_regs_t, DR6) == 0x028, "ADC.DR6");
+_Static_assert(offsetof(adc_regs_t, DR7) == 0x02C, "ADC.DR7");
+_Static_assert(offsetof(adc_regs_t, STAT) == 0x030, "ADC.STAT");
+
+#define ADC_CR_SEL_Pos                           0
+#define ADC_CR_SEL_Msk                           (0xFFU << 0)    /* Channel select */
+#define ADC_CR_CLKDIV_Pos                        8
+#define ADC_CR_CLKDIV_Msk                        (0xFFU << 8)    /* Clock divider (ADC clock = PCLK / (CLKDIV + 1)) */
+#define ADC_CR_BURST_Pos                         16
+#define ADC_CR_BURST_Msk                         (0x1U << 16)
+#define ADC_CR_CLKS_Pos                          17
+#define ADC_CR_CLKS_Msk                          (0x7U << 17)    /* Bits per conversion in burst mode */
+#define ADC_CR_START_Pos                         24
+#define ADC_CR_START_Msk                         (0x7U << 24)
+#define ADC_CR_EDGE_Pos                          27
+#define ADC_CR_EDGE_Msk                          (0x1U << 27)
+#define ADC_GDR_V_VREF_Pos                       6
+#define ADC_GDR_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_GDR_CHN_Pos                          24
+#define ADC_GDR_CHN_Msk                          (0x7U << 24)
+#define ADC_GDR_OVERRUN_Pos                      30
+#define ADC_GDR_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_GDR_DONE_Pos                         31
+#define ADC_GDR_DONE_Msk                         (0x1U << 31)
+#define ADC_DR0_V_VREF_Pos                       6
+#define ADC_DR0_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR0_OVERRUN_Pos                      30
+#define ADC_DR0_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR0_DONE_Pos                         31
+#define ADC_DR0_DONE_Msk                         (0x1U << 31)
+#define ADC_DR1_V_VREF_Pos                       6
+#define ADC_DR1_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR1_OVERRUN_Pos                      30
+#define ADC_DR1_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR1_DONE_Pos                         31
+#define ADC_DR1_DONE_Msk                         (0x1U << 31)
+#define ADC_DR2_V_VREF_Pos                       6
+#define ADC_DR2_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR2_OVERRUN_Pos                      30
+#define ADC_DR2_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR2_DONE_Pos                         31
+#define ADC_DR2_DONE_Msk                         (0x1U << 31)
+#define ADC_DR3_V_VREF_Pos                       6
+#define ADC_DR3_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR3_OVERRUN_Pos                      30
+#define ADC_DR3_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR3_DONE_Pos                         31
+#define ADC_DR3_DONE_Msk                         (0x1U << 31)
+#define ADC_DR4_V_VREF_Pos                       6
+#define ADC_DR4_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR4_OVERRUN_Pos                      30
+#define ADC_DR4_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR4_DONE_Pos                         31
+#define ADC_DR4_DONE_Msk                         (0x1U << 31)
+#define ADC_DR5_V_VREF_Pos                       6
+#define ADC_DR5_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR5_OVERRUN_Pos                      30
+#define ADC_DR5_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR5_DONE_Pos                         31
+#define ADC_DR5_DONE_Msk                         (0x1U << 31)
+#define ADC_DR6_V_VREF_Pos                       6
+#define ADC_DR6_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR6_OVERRUN_Pos                      30
+#define ADC_DR6_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR6_DONE_Pos                         31
+#define ADC_DR6_DONE_Msk                         (0x1U << 31)
+#define ADC_DR7_V_VREF_Pos                       6
+#define ADC_DR7_V_VREF_Msk                       (0x3FFU << 6)    /* Conversion result */
+#define ADC_DR7_OVERRUN_Pos                      30
+#define ADC_DR7_OVERRUN_Msk                      (0x1U << 30)
+#define ADC_DR7_DONE_Pos                         31
+#define ADC_DR7_DONE_Msk                         (0x1U << 31)
+
+/*
+ * PMU: Power management unit
+ */
+typedef struct pmu_regs {
+    volatile uint32_t PCON;                  /* 0x000 Power control */
+    volatile uint32_t GPREG0;                /* 0x004 General purpose (retained in deep power-down) */
+    volatile uint32_t GPREG1;                /* 0x008 General purpose (retained in deep power-down) */
+    volatile uint32_t GPREG2;                /* 0x00C General purpose (retained in deep power-down) */
+    volatile uint32_t GPREG3;                /* 0x010 General purpose (retained in deep power-down) */
+    volatile uint32_t GPREG4;                /* 0x014 General purpose / WAKEUP hysteresis */
+} pmu_regs_t;
+
+_Static_assert(offsetof(pmu_regs_t, PCON) == 0x000, "PMU.PCON");
+_Static_assert(offsetof(pmu_regs_t, GPREG0) == 0x004, "PMU.GPREG0");
+_Static_assert(offsetof(pmu_regs_t, GPREG1) == 0x008, "PMU.GPREG1");
+_Static_assert(offsetof(pmu_regs_t, GPREG2) == 0x00C, "PMU.GPREG2");
+_Static_assert(offsetof(pmu_regs_t, GPREG3) == 0x010, "PMU.GPREG3");
+_Static_assert(offsetof(pmu_regs_t, GPREG4) == 0x014, "PMU.GPREG4");
+
+#define PMU_PCON_DPDEN_Pos                       1
+#define PMU_PCON_DPDEN_Msk                       (0x1U << 1)    /* Deep power-down enable */
+#define PMU_PCON_SLEEPFLAG_Pos                   8
+#define PMU_PCON_SLEEPFLAG_Msk                   (0x1U << 8)
+#define PMU_PCON_DPDFLAG_Pos                     11
+#define PMU_PCON_DPDFLAG_Msk                     (0x1U << 11)
+
+/*
+ * SSP0: SPI/SSP controller 0
+ */
+typedef struct ssp_regs {
+    volatile uint32_t CR0;                   /* 0x000 Control 0 */
+    volatile uint32_t CR1;                   /* 0x004 Control 1 */
+    volatile uint32_t DR;                    /* 0x008 Data */
+    const volatile uint32_t SR;              /* 0x00C Status */
+    volatile uint32_t CPSR;                  /* 0x010 Clock prescale */
+    volatile uint32_t IMSC;                  /* 0x014 Interrupt mask set/clear */
+    const volatile uint32_t RIS;             /* 0x018 Raw interrupt status */
+    const volatile uint32_t MIS;             /* 0x01C Masked interrupt status */
+    volatile uint32_t ICR;                   /* 0x020 Interrupt clear */
+} ssp_regs_t;
+
+_Static_assert(offsetof(ssp_regs_t, CR0) == 0x000, "SSP0.CR0");
+_Static_assert(offsetof(ssp_regs_t, CR1) == 0x004, "SSP0.CR1");
+_Static_assert(offsetof(ssp_regs_t, DR) == 0x008, "SSP0.DR");
+_Static_assert(offsetof(ssp_regs_t, SR) == 0x00C, "SSP0.SR");
+_Static_assert(offsetof(ssp_regs_t, CPSR) == 0x010, "SSP0.CPSR");
+_Static_assert(offsetof(ssp_regs_t, IMSC) == 0x014, "SSP0.IMSC");
+_Static_assert(offsetof(ssp_regs_t, RIS) == 0x018, "SSP0.RIS");
+_Static_assert(offsetof(ssp_regs_t, MIS) == 0x01C, "SSP0.MIS");
+_Static_assert(offsetof(ssp_regs_t, ICR) == 0x020, "SSP0.ICR");
+
+#define SSP_CR0_DSS_Pos                          0
+#define SSP_CR0_DSS_Msk                          (0xFU << 0)    /* Data size select (bits - 1) */
+#define SSP_CR0_FRF_Pos                          4
+#define SSP_CR0_FRF_Msk                          (0x3U << 4)    /* Frame format */
+#define SSP_CR0_CPOL_Pos                         6
+#define SSP_CR0_CPOL_Msk                         (0x1U << 6)
+#define SSP_CR0_CPHA_Pos                         7
+#define SSP_CR0_CPHA_Msk                         (0x1U << 7)
+#define SSP_CR0_SCR_Pos                          8
+#define SSP_CR0_SCR_Msk                          (0xFFU << 8)    /* Serial clock rate */
+#define SSP_CR1_LBM_Pos                          0
+#define SSP_CR1_LBM_Msk                          (0x1U << 0)    /* Loop back mode */
+#define SSP_CR1_SSE_Pos                          1
+#define SSP_CR1_SSE_Msk                          (0x1U << 1)    /* SSP enable */
+#define SSP_CR1_MS_Pos                           2
+#define SSP_CR1_MS_Msk                           (0x1U << 2)    /* Slave mode */
+#define SSP_CR1_SOD_Pos                          3
+#define SSP_CR1_SOD_Msk                          (0x1U << 3)    /* Slave output disable */
+#define SSP_SR_TFE_Pos                           0
+#define SSP_SR_TFE_Msk                           (0x1U << 0)    /* Transmit FIFO empty */
+#define SSP_SR_TNF_Pos                           1
+#define SSP_SR_TNF_Msk                           (0x1U << 1)    /* Transmit FIFO not full */
+#define SSP_SR_RNE_Pos                           2
+#define SSP_SR_RNE_Msk                           (0x1U << 2)    /* Receive FIFO not empty */
+#define SSP_SR_RFF_Pos                           3
+#define SSP_SR_RFF_Msk                           (0x1U << 3)    /* Receive FIFO full */
+#define SSP_SR_BSY_Pos                           4
+#define SSP_SR_BSY_Msk                           (0x1U << 4)    /* Busy */
+
+/*
+ * ベースアドレス
+ */
+
+#ifndef SYSCON_BASE
+  #define SYSCON_BASE 0x40048000
+#endif
+#define LPC_SYSCON   ((syscon_regs_t *)SYSCON_BASE)
+
+#ifndef IOCON_BASE
+  #define IOCON_BASE 0x40044000
+#endif
+#define LPC_IOCON    ((iocon_regs_t *)IOCON_BASE)
+
+#ifndef GPIO0_BASE
+  #define GPIO0_BASE 0x50000000
+#endif
+#define LPC_GPIO0    ((gpio_regs_t *)GPIO0_BASE)
+
+#ifndef GPIO1_BASE
+  #define GPIO1_BASE 0x50010000
+#endif
+#define LPC_GPIO1    ((gpio_regs_t *)GPIO1_BASE)
+
+#ifndef GPIO2_BASE
+  #define GPIO2_BASE 0x50020000
+#endif
+#define LPC_GPIO2    ((gpio_regs_t *)GPIO2_BASE)
+
+#ifndef GPIO3_BASE
+  #define GPIO3_BASE 0x50030000
+#endif
+#define LPC_GPIO3    ((gpio_regs_t *)GPIO3_BASE)
+
+#ifndef CT32B0_BASE
+  #define CT32B0_BASE 0x40014000
+#endif
+#define LPC_CT32B0   ((ct32b_regs_t *)CT32B0_BASE)
+
+#ifndef CT32B1_BASE
+  #define CT32B1_BASE 0x40018000
+#endif
+#define LPC_CT32B1   ((ct32b_regs_t *)CT32B1_BASE)
+
+#ifndef USB_BASE
+  #define USB_BASE 0x40020000
+#endif
+#define LPC_USB      ((usb_regs_t *)USB_BASE)
+
+#ifndef UART_BASE
+  #define UART_BASE 0x40008000
+#endif
+#define LPC_UART     ((uart_regs_t *)UART_BASE)
+
+#ifndef FMC_BASE
+  #define FMC_BASE 0x4003C000
+#endif
+#define LPC_FMC      ((fmc_regs_t *)FMC_BASE)
+
+#ifndef I2C_BASE
+  #define I2C_BASE 0x40000000
+#endif
+#define LPC_I2C      ((i2c_regs_t *)I2C_BASE)
+
+#ifndef WDT_BASE
+  #define WDT_BASE 0x40004000
+#endif
+#define LPC_WDT      ((wdt_regs_t *)WDT_BASE)
+
+#ifndef CT16B0_BASE
+  #define CT16B0_BASE 0x4000C000
+#endif
+#define LPC_CT16B0   ((ct16b_regs_t *)CT16B0_BASE)
+
+#ifndef CT16B1_BASE
+  #define CT16B1_BASE 0x40010000
+#endif
+#define LPC_CT16B1   ((ct16b_regs_t *)CT16B1_BASE)
+
+#ifndef ADC_BASE
+  #define ADC_BASE 0x4001C000
+#endif
+#define LPC_ADC      ((adc_regs_t *)ADC_BASE)
+
+#ifndef PMU_BASE
+  #define PMU_BASE 0x40038000
+#endif
+#define LPC_PMU      ((pmu_regs_t *)PMU_BASE)
+
+#ifndef SSP0_BASE
+  #define SSP0_BASE 0x40040000
+#endif
+#define LPC_SSP0     ((ssp_regs_t *)SSP0_BASE)
+
+#endif
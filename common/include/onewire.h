@@ -0,0 +1,35 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file onewire.h
+ * @brief 1-Wire バス (標準速度) をビットバングで駆動するための定義・宣言
+ * @details バスはオープンドレインで、外部のプルアップ (4.7k 程度) が必要。
+ *          割込みを禁止するのは L を引いてから標本化するまでの数 us ～ 60us の区間だけで、
+ *          タイムスロット間の回復時間やリセットパルスの L 期間は割込みで延びてもよい。\n
+ *          タイミングは Maxim AN126 の推奨値 (A..J) に従う。
+ */
+
+#ifndef __ONEWIRE_H__
+#define __ONEWIRE_H__
+
+#include <stdint.h>
+#include "bitbang.h"
+
+/**
+ * 1-Wire バス
+ */
+typedef struct onewire {
+    bb_pin_t pin;
+    uint32_t a, b, c, d, e, f, h, i, j; /* AN126 の各区間のループ回数 */
+} onewire_t;
+
+int8_t ow_init(onewire_t *ow, uint8_t spec);
+void ow_deinit(onewire_t *ow);
+int8_t ow_reset(onewire_t *ow);
+void ow_write_bit(onewire_t *ow, uint8_t bit) __ramfunc;
+uint8_t ow_read_bit(onewire_t *ow) __ramfunc;
+void ow_write(onewire_t *ow, uint8_t v);
+uint8_t ow_read(onewire_t *ow);
+uint8_t ow_crc8(const uint8_t *p, uint16_t n);
+
+#endif
@@ -0,0 +1,44 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file pool.h
+ * @brief 固定長ブロックのプールアロケータに関する定義・宣言
+ * @details .bss の後ろ (_end) からスタック領域の手前 (_stack_bottom) までの空き RAM を
+ *          サイズクラスごとのブロックに切り分けて、確保/解放とも O(1) で行う。
+ *          サイズクラスは 16 << i バイト (i = 0..POOL_NCLASS - 1)。
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdint.h>
+
+#ifndef POOL_NCLASS
+  #define POOL_NCLASS 4                 /* サイズクラスの数 (16, 32, 64, 128 バイト) */
+#endif
+#ifndef POOL_SHARES
+  #define POOL_SHARES 25, 25, 25, 25    /* 空き RAM を各クラスに割り当てる割合 [%] */
+#endif
+#ifndef POOL_ISR_SAFE
+  #define POOL_ISR_SAFE 1               /* 1: 割込みハンドラからも使える (LDREX/STREX を使う) */
+#endif
+
+#define POOL_MIN_SIZE 16
+
+/**
+ * サイズクラスごとの統計
+ */
+typedef struct pool_stat {
+    uint16_t size;                      /* ブロックのバイト数 */
+    uint16_t total;                     /* ブロックの総数 */
+    uint16_t used;                      /* 使用中のブロック数 */
+    uint16_t peak;                      /* 使用中のブロック数の最大値 */
+    uint32_t fails;                     /* 確保に失敗した回数 */
+} pool_stat_t;
+
+void pool_init(void);
+void *pool_alloc(uint32_t size);
+int8_t pool_free(void *p);
+void pool_stat(uint8_t cls, pool_stat_t *st);
+
+#endif
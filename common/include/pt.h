@@ -0,0 +1,215 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file pt.h
+ * @brief スタックを持たないコルーチン (プロトスレッド) と協調スケジューラに関する定義・宣言
+ * @details 関数の途中で待ち、次に呼ばれたときにその続きから再開する。再開位置は pt_t に
+ *          ラベルのアドレス (GCC の &&label) として持つので、1 つあたり 4 バイトで済む。
+ *          スタックは呼ぶ側のものを使い、待つたびに関数から戻る。\n
+ *          制約:
+ *          - 待ちをまたぐ変数は static か、引数で渡す構造体に置く (自動変数は待つと失われる)。
+ *          - PT_* の待ちは 1 行に 1 つまで (行番号でラベルを作るため)。
+ *          - switch の中で待ってもよい (switch による実装と違い、case ラベルを使わない)。
+ *
+ *          待ちの条件は再開のたびに評価する。pt_sched_poll() は登録されたタスクを順に 1 回ずつ再開する。
+ *          @code
+ *          static int8_t sensor(pt_t *pt, void *arg)
+ *          {
+ *              static pt_timer_t t;
+ *
+ *              PT_BEGIN(pt);
+ *              reg_write(..., CONFIG);
+ *              PT_DELAY_MS(pt, &t, 5);
+ *              PT_WAIT_BITS(pt, SYSCON(SYSPLLSTAT), 1, 1);
+ *              PT_WAIT_EDGE(pt, 0, 1, PT_EDGE_FALLING);
+ *              PT_END(pt);
+ *          }
+ *          @endcode
+ */
+
+#ifndef __PT_H__
+#define __PT_H__
+
+#include <stdint.h>
+#include "lpc1343.h"
+
+/* 関数の戻り値 */
+#define PT_WAITING 0                    /* 条件が満たされるのを待っている */
+#define PT_YIELDED 1                    /* PT_YIELD() で譲った */
+#define PT_EXITED  2                    /* PT_EXIT() で終わった */
+#define PT_ENDED   3                    /* PT_END() に達した */
+
+/* PT_WAIT_EDGE() のエッジ */
+#define PT_EDGE_FALLING 0
+#define PT_EDGE_RISING  1
+#define PT_EDGE_BOTH    2
+
+/**
+ * プロトスレッドの状態 (再開する位置)
+ */
+typedef struct pt {
+    uintptr_t lc;                       /* ラベルのアドレス (0 なら先頭から) */
+} pt_t;
+
+/**
+ * PT_DELAY_MS() などのタイマ (DWT のサイクルカウンタで測る)
+ */
+typedef struct pt_timer {
+    uint32_t t0;                        /* 開始時の CYCCNT */
+    uint32_t cycles;                    /* 長さ */
+} pt_timer_t;
+
+/**
+ * プロトスレッドの関数
+ */
+typedef int8_t (* pt_func_t)(pt_t *pt, void *arg);
+
+/**
+ * pt_sched_poll() で再開するタスク (呼ぶ側が用意する)
+ */
+typedef struct pt_task {
+    pt_t pt;
+    pt_func_t fn;
+    void *arg;
+    struct pt_task *next;
+} pt_task_t;
+
+void pt_sched_add(pt_task_t *task, pt_func_t fn, void *arg);
+uint32_t pt_sched_poll(void);
+void pt_timer_set_ms(pt_timer_t *t, uint32_t ms);
+void pt_timer_set_us(pt_timer_t *t, uint32_t us);
+void pt_edge_arm(uint8_t pno, uint8_t nthbit, uint8_t edge);
+uint8_t pt_edge_seen(uint8_t pno, uint8_t nthbit);
+void pt_edge_disarm(uint8_t pno);
+
+/**
+ * @brief タイマが満了したかどうかを返す
+ * @param[in] t タイマ
+ * @return 1: 満了した, 0: まだ
+ */
+static inline uint8_t pt_timer_expired(const pt_timer_t *t)
+{
+    return (dwt_cyccnt() - t->t0) >= t->cycles;
+}
+
+#define __PT_CAT2(a, b) a ## b
+#define __PT_CAT(a, b) __PT_CAT2(a, b)
+
+/**
+ * @def __PT_SET(pt)
+ * 再開する位置をここにする (この行のラベル)。
+ */
+#define __PT_SET(pt) \
+    do { __PT_CAT(__pt_lc_, __LINE__): (pt)->lc = (uintptr_t)&&__PT_CAT(__pt_lc_, __LINE__); } while (0)
+
+/**
+ * @def PT_INIT(pt)
+ * 次に呼ばれたとき先頭から始めるようにする。
+ */
+#define PT_INIT(pt) ((pt)->lc = 0)
+
+/**
+ * @def PT_BEGIN(pt)
+ * プロトスレッドの本体の始まり。前回待った位置があればそこへ飛ぶ。
+ */
+#define PT_BEGIN(pt) \
+    { \
+        uint8_t __pt_yielded = 1; \
+        (void)__pt_yielded; \
+        if ((pt)->lc) goto *(void *)(pt)->lc
+
+/**
+ * @def PT_END(pt)
+ * プロトスレッドの本体の終わり。PT_ENDED を返し、次は先頭から始める。
+ */
+#define PT_END(pt) \
+        PT_INIT(pt); \
+        return PT_ENDED; \
+    }
+
+/**
+ * @def PT_WAIT_UNTIL(pt, cond)
+ * cond が真になるまで待つ (偽なら PT_WAITING で戻り、次に呼ばれたときに cond から評価し直す)。
+ */
+#define PT_WAIT_UNTIL(pt, cond) \
+    do { \
+        __PT_SET(pt); \
+        if (!(cond)) return PT_WAITING; \
+    } while (0)
+
+/**
+ * @def PT_WAIT_WHILE(pt, cond)
+ * cond が真の間待つ。
+ */
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL(pt, !(cond))
+
+/**
+ * @def PT_YIELD(pt)
+ * 1 回だけ他のタスクに譲る。
+ */
+#define PT_YIELD(pt) \
+    do { \
+        __pt_yielded = 0; \
+        __PT_SET(pt); \
+        if (!__pt_yielded) return PT_YIELDED; \
+    } while (0)
+
+/**
+ * @def PT_EXIT(pt)
+ * ここで終わる (PT_EXITED を返し、次は先頭から始める)。
+ */
+#define PT_EXIT(pt) \
+    do { \
+        PT_INIT(pt); \
+        return PT_EXITED; \
+    } while (0)
+
+/**
+ * @def PT_SPAWN(pt, child, call)
+ * 子のプロトスレッド child を先頭から始め、call (child を渡す呼び出し) が終わるまで待つ。
+ */
+#define PT_SPAWN(pt, child, call) \
+    do { \
+        PT_INIT(child); \
+        PT_WAIT_UNTIL(pt, (call) >= PT_EXITED); \
+    } while (0)
+
+/**
+ * @def PT_DELAY_MS(pt, t, ms)
+ * ms ミリ秒待つ (t は待ちをまたいで保持される pt_timer_t)。
+ */
+#define PT_DELAY_MS(pt, t, ms) \
+    do { \
+        pt_timer_set_ms(t, ms); \
+        PT_WAIT_UNTIL(pt, pt_timer_expired(t)); \
+    } while (0)
+
+/**
+ * @def PT_DELAY_US(pt, t, us)
+ * us マイクロ秒待つ (再開の間隔より短い時間は、その間隔に丸められる)。
+ */
+#define PT_DELAY_US(pt, t, us) \
+    do { \
+        pt_timer_set_us(t, us); \
+        PT_WAIT_UNTIL(pt, pt_timer_expired(t)); \
+    } while (0)
+
+/**
+ * @def PT_WAIT_BITS(pt, addr, mask, val)
+ * レジスタ addr の mask のビットが val になるまで待つ。
+ */
+#define PT_WAIT_BITS(pt, addr, mask, val) PT_WAIT_UNTIL(pt, (reg_read(addr) & (mask)) == (val))
+
+/**
+ * @def PT_WAIT_EDGE(pt, pno, nthbit, edge)
+ * GPIO のピンにエッジ (PT_EDGE_RISING など) が来るまで待つ。
+ * エッジは GPIO の割込み検出で捕まえるので、再開の間隔より短いパルスも逃さない。
+ */
+#define PT_WAIT_EDGE(pt, pno, nthbit, edge) \
+    do { \
+        pt_edge_arm(pno, nthbit, edge); \
+        PT_WAIT_UNTIL(pt, pt_edge_seen(pno, nthbit)); \
+        pt_edge_disarm(pno); \
+    } while (0)
+
+#endif
@@ -0,0 +1,43 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file retain.h
+ * @brief リセットをまたいで保持するアプリケーション状態ブロックに関する定義・宣言
+ * @details 使い方:
+ * @code
+ * struct app_state {
+ *     retain_hdr_t hdr;    // 先頭に置くこと
+ *     uint32_t count;
+ * };
+ * static struct app_state s_st __noinit;
+ *
+ * if (!retain_valid(&s_st.hdr, sizeof(s_st))) {
+ *     s_st.count = 0;      // コールドスタートまたは内容が壊れている
+ * }
+ * s_st.count++;
+ * retain_seal(&s_st.hdr, sizeof(s_st));    // 更新したら封をし直す
+ * @endcode
+ */
+
+#ifndef __RETAIN_H__
+#define __RETAIN_H__
+
+#include <stdint.h>
+#include "system.h"
+
+#define RETAIN_MAGIC 0x52544E42    /* "BNTR" */
+
+/**
+ * 保持ブロックのヘッダ。保持したい構造体の先頭に置く。
+ */
+typedef struct retain_hdr {
+    uint32_t magic;    /* RETAIN_MAGIC */
+    uint32_t size;     /* ヘッダを含むブロック全体のバイト数 */
+    uint32_t sum;      /* ヘッダ以降のデータのチェックサム */
+} retain_hdr_t;
+
+void retain_seal(retain_hdr_t *hdr, uint32_t size);
+uint8_t retain_valid(const retain_hdr_t *hdr, uint32_t size);
+void retain_invalidate(retain_hdr_t *hdr);
+
+#endif
@@ -0,0 +1,51 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file softbus.h
+ * @brief ソフトウェア SPI/I2C (ビットバング) に関する定義・宣言
+ * @details どちらもクロックをマスタが作る同期式なので割込みは禁止しない。
+ *          割込みが入るとクロックが伸びるだけで、通信は壊れない。
+ */
+
+#ifndef __SOFTBUS_H__
+#define __SOFTBUS_H__
+
+#include <stdint.h>
+#include "bitbang.h"
+
+#ifndef BB_I2C_STRETCH_US
+  #define BB_I2C_STRETCH_US 1000        /* クロックストレッチを待つ上限 */
+#endif
+
+/**
+ * ソフトウェア SPI (モード 0: CPOL = 0, CPHA = 0, MSB から)
+ */
+typedef struct bb_spi {
+    bb_pin_t sck, mosi, miso;
+    uint8_t has_miso;                   /* 0 なら送信のみ */
+    uint32_t half;                      /* 半周期のループ回数 */
+} bb_spi_t;
+
+/**
+ * ソフトウェア I2C マスタ (7 ビットアドレス)
+ */
+typedef struct bb_i2c {
+    bb_pin_t scl, sda;
+    uint32_t half;                      /* 半周期のループ回数 */
+    uint32_t stretch;                   /* クロックストレッチを待つ回数 */
+} bb_i2c_t;
+
+int8_t bb_spi_init(bb_spi_t *spi, uint8_t sck, uint8_t mosi, uint8_t miso, uint32_t hz);
+void bb_spi_deinit(bb_spi_t *spi);
+uint8_t bb_spi_xfer(bb_spi_t *spi, uint8_t tx);
+void bb_spi_transfer(bb_spi_t *spi, const uint8_t *tx, uint8_t *rx, uint16_t n);
+
+int8_t bb_i2c_init(bb_i2c_t *i2c, uint8_t scl, uint8_t sda, uint32_t hz);
+void bb_i2c_deinit(bb_i2c_t *i2c);
+int8_t bb_i2c_start(bb_i2c_t *i2c);
+void bb_i2c_stop(bb_i2c_t *i2c);
+int8_t bb_i2c_write(bb_i2c_t *i2c, uint8_t v);
+uint8_t bb_i2c_read(bb_i2c_t *i2c, uint8_t ack);
+int8_t bb_i2c_xfer(bb_i2c_t *i2c, uint8_t addr, const uint8_t *tx, uint16_t ntx, uint8_t *rx, uint16_t nrx);
+
+#endif
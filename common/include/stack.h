@@ -0,0 +1,22 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file stack.h
+ * @brief メインスタックの使用量 (最高水位) の計測に関する定義・宣言
+ * @details スタートアップルーチンがスタック領域を STACK_PAINT で塗っておき、
+ *          塗られたまま残っている部分から最大使用量を求める。
+ *          ビルド時の静的な見積もりは tools/stackcheck.sh で行う。
+ */
+
+#ifndef __STACK_H__
+#define __STACK_H__
+
+#include <stdint.h>
+
+#define STACK_PAINT 0xCCCCCCCC    /* 未使用のスタックを塗る値 */
+
+uint32_t stack_size(void);
+uint32_t stack_used_max(void);
+uint32_t stack_free_min(void);
+
+#endif
@@ -11,10 +11,45 @@
 #include "lpc1343.h"
 #include "gpio.h"
 #include "timer32.h"
+#include "clkplan.h"
 
-#define __XTAL 12000000UL    /* 外部水晶の発振周波数 */
+/**
+ * @def __noinit
+ * 変数を .noinit セクションに配置する。この領域はスタートアップルーチンで
+ * 初期化されないため、電源断を伴わないリセットの前後で内容が保持される。
+ */
+#define __noinit __attribute__ ((section(".noinit")))
+
+/**
+ * @def __ramfunc
+ * 関数を .ramfunc セクションに配置する。このセクションは .data と一緒にスタートアップ
+ * ルーチンで RAM にコピーされ、フラッシュのウェイトに左右されない時間で実行される。
+ * フラッシュとの距離が BL 命令の届く範囲を超えるので long_call で呼び出す。
+ * 宣言と定義の両方に付けること。
+ */
+#define __ramfunc __attribute__ ((section(".ramfunc"), long_call, noinline))
+
+/* リセット要因 (SYSRESSTAT のビット) [3.5.10] */
+#define RST_POR    (1 << 0)    /* パワーオンリセット */
+#define RST_EXTRST (1 << 1)    /* 外部リセット端子 */
+#define RST_WDT    (1 << 2)    /* ウォッチドッグリセット */
+#define RST_BOD    (1 << 3)    /* ブラウンアウト検出リセット */
+#define RST_SYSRST (1 << 4)    /* ソフトウェアリセット (AIRCR SYSRESETREQ) */
+
+#define SYS_CLOCK_HOOKS 6      /* sys_clock_hook() で登録できる関数の数 */
+
+/**
+ * システムクロックの周波数が変わったときに呼ばれる関数。hz は新しい周波数
+ */
+typedef void (* sys_clock_hook_t)(uint32_t hz);
 
+void sys_capture_reset(void);
 void sys_init(void);
 uint32_t sys_clock(void);
+void sys_set_clock(uint32_t hz);
+int8_t sys_clock_hook(sys_clock_hook_t fn);
+uint32_t sys_reset_cause(void);
+uint8_t sys_warm_start(void);
+void sys_reset(void) __attribute__ ((noreturn));
 
 #endif
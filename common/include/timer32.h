@@ -10,8 +10,14 @@
 
 #include <stdint.h>
 
+typedef void (* tmr32_wait_hook_t)(uint8_t enter);
+
 void tmr32_init(uint8_t tno);
+void tmr32_deinit(uint8_t tno);
 void tmr32_delay_ms(uint8_t tno, uint32_t ms);
 void tmr32_delay_us(uint8_t tno, uint32_t us);
+uint32_t tmr32_to_ticks(uint32_t t, uint32_t per);
+void tmr32_start(uint8_t tno, uint32_t t);
+void tmr32_wait_hook(tmr32_wait_hook_t fn);
 
 #endif
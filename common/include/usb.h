@@ -0,0 +1,103 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file usb.h
+ * @brief USB デバイスのコントロール転送とディスクリプタ処理に関する定義・宣言
+ * @details ハードウェアには usbhw.h の関数でしかアクセスしないので、
+ *          この部分はホスト上でもコンパイル・テストできる。
+ */
+
+#ifndef __USB_H__
+#define __USB_H__
+
+#include <stdint.h>
+
+/* bmRequestType [USB 2.0 9.3] */
+#define USB_REQ_DIR_IN     0x80
+#define USB_REQ_TYPE_MASK  0x60
+#define USB_REQ_STANDARD   0x00
+#define USB_REQ_CLASS      0x20
+#define USB_REQ_VENDOR     0x40
+#define USB_REQ_RCPT_MASK  0x1F
+#define USB_REQ_DEVICE     0x00
+#define USB_REQ_INTERFACE  0x01
+#define USB_REQ_ENDPOINT   0x02
+
+/* 標準リクエスト [USB 2.0 9.4] */
+#define USB_GET_STATUS        0x00
+#define USB_CLEAR_FEATURE     0x01
+#define USB_SET_FEATURE       0x03
+#define USB_SET_ADDRESS       0x05
+#define USB_GET_DESCRIPTOR    0x06
+#define USB_SET_DESCRIPTOR    0x07
+#define USB_GET_CONFIGURATION 0x08
+#define USB_SET_CONFIGURATION 0x09
+#define USB_GET_INTERFACE     0x0A
+#define USB_SET_INTERFACE     0x0B
+
+#define USB_FEATURE_ENDPOINT_HALT 0x00
+
+/* ディスクリプタタイプ */
+#define USB_DESC_DEVICE        0x01
+#define USB_DESC_CONFIGURATION 0x02
+#define USB_DESC_STRING        0x03
+#define USB_DESC_INTERFACE     0x04
+#define USB_DESC_ENDPOINT      0x05
+#define USB_DESC_CS_INTERFACE  0x24
+
+/* エンドポイント属性 */
+#define USB_EP_CONTROL   0x00
+#define USB_EP_ISO       0x01
+#define USB_EP_BULK      0x02
+#define USB_EP_INTERRUPT 0x03
+
+/* ディスクリプタを配列で書くためのマクロ */
+#define USB_W(v)   ((v) & 0xFF), (((v) >> 8) & 0xFF)
+
+/**
+ * SETUP パケット
+ */
+typedef struct usb_setup {
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} usb_setup_t;
+
+/**
+ * USB クラス (デバイスの機能) の定義。usb_init() に渡す。
+ */
+typedef struct usb_class {
+    const uint8_t *dev_desc;                /* デバイスディスクリプタ */
+    const uint8_t *cfg_desc;                /* コンフィギュレーションディスクリプタ (wTotalLength 分) */
+    const uint8_t * const *str_desc;        /* ストリングディスクリプタの配列 (0 番は言語 ID) */
+    uint8_t num_str;                        /* str_desc の要素数 */
+
+    /*
+     * クラス/ベンダリクエストの処理。
+     * IN 方向なら *data, *len に返すデータを、OUT 方向なら *data に受信先 (wLength 以上) を設定する。
+     * 戻り値 0: 受理, -1: 未対応 (ストールする)
+     */
+    int8_t (*request)(const usb_setup_t *req, uint8_t **data, uint16_t *len);
+
+    /* OUT 方向のデータステージを受信し終えた */
+    void (*request_done)(const usb_setup_t *req);
+
+    /* SET_CONFIGURATION を受けた (0 はコンフィギュレーション解除) */
+    void (*configured)(uint8_t cfg);
+
+    /* EP0 以外のエンドポイントのイベント (ep は論理アドレス、IN は 0x80 付き) */
+    void (*ep_event)(uint8_t ep);
+} usb_class_t;
+
+void usb_init(const usb_class_t *cls);
+uint8_t usb_configuration(void);
+
+/* usbhw から呼ばれるイベント */
+void usb_on_reset(void);
+void usb_on_setup(void);
+void usb_on_ep0(uint8_t ep);
+void usb_on_ep(uint8_t ep);
+
+#endif
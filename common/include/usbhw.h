@@ -0,0 +1,48 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file usbhw.h
+ * @brief USB デバイスコントローラ (ハードウェア依存部) に関する定義・宣言
+ * @details usb.c (コントロール転送) と cdc.c (クラス) はこのインタフェースだけを通して
+ *          コントローラを操作し、コントローラからのイベントは usb.h の usb_on_*() で受け取る。
+ *          ホスト上でテストする場合は usbhw.c の代わりに同じ関数を持つ
+ *          ソフトウェアモデル (test/usbmodel.c) をリンクする。
+ */
+
+#ifndef __USBHW_H__
+#define __USBHW_H__
+
+#include <stdint.h>
+
+#ifndef USB_IRQ_PRIO
+  #define USB_IRQ_PRIO 4    /* USB_IRQ (コントロール転送、バス状態) の優先度 */
+#endif
+#ifndef USB_FIQ_PRIO
+  #define USB_FIQ_PRIO 1    /* USB_FIQ (バルク転送) の優先度 */
+#endif
+
+#define USB_EP0_SIZE  64    /* コントロールエンドポイントの最大パケットサイズ */
+#define USB_BULK_SIZE 64    /* バルクエンドポイント (論理 EP3) の最大パケットサイズ */
+
+/* usbhw_ep_status() の戻り値 (SIE Select Endpoint コマンドの応答) [UM10375 10.10.4] */
+#define USB_EPSTAT_FE  (1 << 0)    /* OUT: データあり, IN: 全バッファ使用中 */
+#define USB_EPSTAT_ST  (1 << 1)    /* ストール中 */
+#define USB_EPSTAT_STP (1 << 2)    /* SETUP パケットを受信した */
+#define USB_EPSTAT_PO  (1 << 3)    /* SETUP パケットで上書きされた */
+#define USB_EPSTAT_EPN (1 << 4)    /* NAK を送った */
+#define USB_EPSTAT_B1  (1 << 5)    /* バッファ 1 使用中 */
+#define USB_EPSTAT_B2  (1 << 6)    /* バッファ 2 使用中 */
+
+void usbhw_init(void);
+void usbhw_connect(uint8_t on);
+void usbhw_set_address(uint8_t addr);
+void usbhw_configure(uint8_t on);
+uint16_t usbhw_read_ep(uint8_t ep, uint32_t *buf);
+void usbhw_write_ep(uint8_t ep, const uint32_t *buf, uint16_t len);
+void usbhw_stall_ep(uint8_t ep, uint8_t stall);
+uint8_t usbhw_ep_status(uint8_t ep);
+void usbhw_kick_ep(uint8_t ep);
+uint32_t usbhw_lock(void);
+void usbhw_unlock(uint32_t old);
+
+#endif
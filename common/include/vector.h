@@ -0,0 +1,29 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file vector.h
+ * @brief RAM 上のベクタテーブル (VTOR による再配置) に関する定義・宣言
+ * @details フラッシュ ROM 上のベクタテーブル (startup.c の vectors[]) を RAM にコピーし、
+ *          VTOR を切り替えることで、実行時にハンドラを差し替えられるようにする。
+ *          ハンドラはベクタから直接呼ばれるので、ディスパッチ用の間接呼び出しは生じない。\n
+ *          元のハンドラを包んで呼ぶ計測用の関数 (cpuload.h, isrtrace.h) は vector_add_wrapper() で登録する。
+ *          包む側は、自分が包んだあとに別の計測用の関数に包まれたエントリを包み直さないようにする
+ *          (互いに呼び合って戻らなくなるため)。
+ */
+
+#ifndef __VECTOR_H__
+#define __VECTOR_H__
+
+#include "lpc1343.h"
+
+#define VECTOR_WRAPPERS 4      /* vector_add_wrapper() で登録できる関数の数 */
+
+typedef void (* vector_entry)(void);
+
+void vector_relocate(void);
+void vector_install(irq_t n, vector_entry handler);
+vector_entry vector_get(irq_t n);
+int8_t vector_add_wrapper(vector_entry w);
+uint8_t vector_is_wrapper(vector_entry h);
+
+#endif
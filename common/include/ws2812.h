@@ -0,0 +1,51 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file ws2812.h
+ * @brief WS2812 (シリアル LED) をビットバングで駆動するための定義・宣言
+ * @details 1 ビットは H パルスの幅で 0/1 を表す (約 1.25us 周期)。H の幅は
+ *          bb_pulse() で正確に作り、許容範囲の広い L の幅に残りの処理時間を回す。
+ *          DWT があれば送信ごとに 1 ビットの周期を測り、ずれた分を次の送信の L の幅で補正する。
+ *          割込みは 1 ピクセル (24 ビット) ごとに禁止/許可するので、割込みの遅延は
+ *          最大で約 30us 増える。ピクセル間で割込みが WS2812_RESET_NS より長く続くと
+ *          LED はそこで送信が終わったとみなすので、長い割込みハンドラがあるときは注意する。
+ */
+
+#ifndef __WS2812_H__
+#define __WS2812_H__
+
+#include <stdint.h>
+#include "bitbang.h"
+
+#ifndef WS2812_T0H_NS
+  #define WS2812_T0H_NS 400             /* 0 の H 幅 */
+#endif
+#ifndef WS2812_T1H_NS
+  #define WS2812_T1H_NS 800             /* 1 の H 幅 */
+#endif
+#ifndef WS2812_T0L_NS
+  #define WS2812_T0L_NS 850             /* 0 の L 幅 */
+#endif
+#ifndef WS2812_T1L_NS
+  #define WS2812_T1L_NS 450             /* 1 の L 幅 */
+#endif
+#ifndef WS2812_RESET_NS
+  #define WS2812_RESET_NS 300000        /* ラッチに必要な L の時間 (WS2812B は 280us 以上) */
+#endif
+
+/**
+ * WS2812 のストリング
+ */
+typedef struct ws2812 {
+    bb_pin_t pin;
+    uint32_t t0h, t1h, t0l, t1l;        /* 各区間のループ回数 */
+    uint32_t treset;                    /* ラッチ時間のループ回数 */
+    uint32_t period;                    /* 1 ビットの目標サイクル数 */
+    uint32_t bit_cycles;                /* 直前の送信で測った 1 ビットあたりのサイクル数 (DWT がなければ 0) */
+} ws2812_t;
+
+int8_t ws2812_init(ws2812_t *ws, uint8_t spec);
+void ws2812_deinit(ws2812_t *ws);
+void ws2812_write(ws2812_t *ws, const uint8_t *grb, uint16_t npixel) __ramfunc;
+
+#endif
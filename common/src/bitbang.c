@@ -0,0 +1,170 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file bitbang.c
+ * @brief GPIO ビットバングの基本部品 (ピンの準備, 待ち時間の較正と換算)
+ */
+
+#include "system.h"
+#include "bitbang.h"
+#include "clkgate.h"
+
+#define NUM_PORT 4
+
+/**
+ * 較正結果。bb_init() で設定する
+ */
+bb_cal_t g_bb_cal = { 0, BB_LOOP_CYCLES << 8, 0 };
+
+static uint32_t measure(uint32_t n) __ramfunc;
+static void clock_changed(uint32_t hz);
+
+/**
+ * @brief 待ちループを較正する
+ * @return なし
+ * @note sys_init() のあと、クロックの設定を変えたらそのたびに呼ぶこと。
+ *       sys_set_clock() で周波数だけが測り直されたときは、換算に使う周波数を自動で更新する。
+ *       DWT のサイクルカウンタがなければ BB_LOOP_CYCLES を仮定する。
+ */
+void bb_init(void)
+{
+    g_bb_cal.khz = sys_clock() / 1000;
+    sys_clock_hook(clock_changed);
+    g_bb_cal.loop_q8 = BB_LOOP_CYCLES << 8;
+    g_bb_cal.dwt = dwt_cyccnt_start();
+    if (!g_bb_cal.dwt) return;
+
+    /* 回数を変えて 2 回測り、差をとって呼び出しと CYCCNT の読み出しにかかる分を消す */
+    measure(1);                                         /* 1 回目はウォームアップ */
+    uint32_t c = measure(BB_CAL_LOOPS + 1) - measure(1);
+    g_bb_cal.loop_q8 = (c << 8) / BB_CAL_LOOPS;
+}
+
+/**
+ * @brief ビットバングに使うピンを準備する
+ * @param[out] pin ピン
+ * @param[in] spec BB_PIN(pno, nthbit)
+ * @param[in] mode BB_PUSHPULL: 出力にして L にする, BB_OPENDRAIN: 入力 (開放) にする
+ * @return 0: 成功, -1: 失敗
+ * @note IOCON でピンを GPIO 機能にしておくこと (リセット時に GPIO でないピンもある)。
+ *       オープンドレインでは DATA を 0 にしておき、DIR の切り替えだけで L/開放を作る。
+ *       GPIO のクロックを得るので、使い終わったら bb_pin_deinit() で返す。
+ */
+int8_t bb_pin_init(bb_pin_t *pin, uint8_t spec, uint8_t mode)
+{
+    uint8_t pno = spec >> 4;
+    uint8_t nthbit = spec & 0x0F;
+
+    if (pno >= NUM_PORT || nthbit > 11) return -1;
+    if (clkgate_acquire(CLKGATE_GPIO) < 0) return -1;
+
+    pin->mask = 1 << nthbit;
+    pin->data = (volatile uint32_t *)GPIOnDATA(pno, pin->mask);
+    pin->dir = (volatile uint32_t *)GPIOn(pno, DIR);
+
+    *pin->data = 0;
+    __reg_write_bit(GPIOn(pno, DIR), nthbit, mode == BB_PUSHPULL);
+    return 0;
+}
+
+/**
+ * @brief ビットバングに使ったピンを入力に戻し、GPIO のクロックを返す
+ * @param[in] pin bb_pin_init() で準備したピン
+ * @return なし
+ */
+void bb_pin_deinit(bb_pin_t *pin)
+{
+    *pin->dir &= ~pin->mask;
+    clkgate_release(CLKGATE_GPIO);
+}
+
+/**
+ * @brief 時間をコアクロックのサイクル数に換算する
+ * @param[in] ns 時間 [ns]
+ * @return サイクル数
+ */
+uint32_t bb_cycles(uint32_t ns)
+{
+    uint32_t khz = g_bb_cal.khz;
+
+    /* 72MHz で ns * khz は 60us を超えるとあふれるので、us と端数に分ける */
+    return (ns / 1000) * khz / 1000 + (ns % 1000) * khz / 1000000;
+}
+
+/**
+ * @brief 時間を待ちループの回数に換算する
+ * @param[in] ns 時間 [ns]
+ * @return ループ回数 (1 以上。ループの粒度より短い時間は 1 回になる)
+ */
+uint32_t bb_loops(uint32_t ns)
+{
+    uint32_t c = bb_cycles(ns);
+    uint32_t q = g_bb_cal.loop_q8;
+    uint32_t n = (c < (1 << 24)) ? (c << 8) / q : c / (q >> 8);
+    return n ? n : 1;
+}
+
+/**
+ * @brief ns 単位で待つ
+ * @param[in] ns 時間 [ns]
+ * @return なし
+ * @note 割込みは禁止しないので、割込みが入ればその分だけ長くなる。
+ */
+void bb_delay_ns(uint32_t ns)
+{
+    bb_delay(bb_loops(ns));
+}
+
+/**
+ * @brief 待ちループを n 回まわす
+ * @param[in] n ループ回数 (1 以上)
+ * @return なし
+ * @note フラッシュのウェイトに左右されないよう RAM で実行する。
+ */
+void bb_delay(uint32_t n)
+{
+    bb_spin(n);
+}
+
+/**
+ * @brief 待ち時間の精度を DWT のサイクルカウンタで確かめる
+ * @param[in] ns 時間 [ns]
+ * @return bb_loops(ns) 回の待ちに実際にかかったサイクル数 - bb_cycles(ns)。
+ *         DWT がなければ INT32_MIN
+ * @note 換算の切り捨てにより、誤差は 0 からループ 1 回分のマイナスまでが正常。
+ */
+int32_t bb_verify(uint32_t ns)
+{
+    if (!g_bb_cal.dwt) return INT32_MIN;
+
+    uint32_t n = bb_loops(ns);
+    uint32_t overhead = measure(1) - (g_bb_cal.loop_q8 >> 8);
+    uint32_t c = measure(n) - overhead;
+    return (int32_t)(c - bb_cycles(ns));
+}
+
+/**
+ * @brief システムクロックの周波数が変わったら換算に使う値を更新する (sys_clock_hook())
+ * @return なし
+ * @note ループ 1 回のサイクル数はクロックによらないので測り直さない。
+ */
+static void clock_changed(uint32_t hz)
+{
+    g_bb_cal.khz = hz / 1000;
+}
+
+/**
+ * @brief 割込みを禁止して待ちループを n 回まわし、かかったサイクル数を測る
+ * @param[in] n ループ回数 (1 以上)
+ * @return サイクル数 (DWT がなければ不定)
+ */
+static uint32_t measure(uint32_t n)
+{
+    volatile uint32_t *cyccnt = (volatile uint32_t *)DWT(CYCCNT);
+    uint32_t v = irq_save();
+    uint32_t t = *cyccnt;
+    bb_spin(n);
+    t = *cyccnt - t;
+    irq_restore(v);
+    return t;
+}
@@ -0,0 +1,302 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file cdc.c
+ * @brief USB CDC-ACM (仮想 COM ポート)
+ * @noop コメント内の [x.x] は USB CDC 1.2 / PSTN 1.2 仕様書の章節番号を示す。
+ * @details 受信/送信のパケットバッファはそれぞれリングになっていて、
+ *          書き込み位置は片方 (受信は USB_FIQ、送信はスレッド)、読み出し位置はもう片方だけが
+ *          更新するので、ロックなしでやり取りできる。
+ *          受信リングが満杯のときはパケットをエンドポイントに残しておき、ホストには NAK を返させる。
+ */
+
+#include "usb.h"
+#include "usbhw.h"
+#include "cdc.h"
+
+/* クラスリクエスト [PSTN 6.3] */
+#define CDC_SET_LINE_CODING        0x20
+#define CDC_GET_LINE_CODING        0x21
+#define CDC_SET_CONTROL_LINE_STATE 0x22
+#define CDC_SEND_BREAK             0x23
+
+#define LINE_CODING_SIZE 7
+
+#define CFG_DESC_SIZE (9 + 9 + 5 + 5 + 4 + 5 + 7 + 9 + 7 + 7)
+
+/**
+ * パケットバッファ
+ */
+typedef struct pkt {
+    uint32_t data[CDC_PKT_SIZE / 4];    /* usbhw はワード単位で読み書きするので uint32_t で持つ */
+    uint16_t len;
+} pkt_t;
+
+static const uint8_t s_dev_desc[] = {
+    18, USB_DESC_DEVICE, USB_W(0x0200),
+    0x02, 0x00, 0x00,                   /* bDeviceClass: CDC */
+    USB_EP0_SIZE,
+    USB_W(CDC_VID), USB_W(CDC_PID), USB_W(0x0100),
+    1, 2, 3,                            /* iManufacturer, iProduct, iSerialNumber */
+    1,                                  /* bNumConfigurations */
+};
+
+static const uint8_t s_cfg_desc[CFG_DESC_SIZE] = {
+    9, USB_DESC_CONFIGURATION, USB_W(CFG_DESC_SIZE),
+    2, 1, 0,                            /* bNumInterfaces, bConfigurationValue, iConfiguration */
+    0x80, 50,                           /* バスパワー, 100 mA */
+
+    /* インタフェース 0: Communications Class [CDC 5.1.3] */
+    9, USB_DESC_INTERFACE, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+    5, USB_DESC_CS_INTERFACE, 0x00, USB_W(0x0120),    /* Header */
+    5, USB_DESC_CS_INTERFACE, 0x01, 0x00, 1,          /* Call Management: データインタフェースは 1 */
+    4, USB_DESC_CS_INTERFACE, 0x02, 0x02,             /* ACM: Set/Get_Line_Coding, Set_Control_Line_State */
+    5, USB_DESC_CS_INTERFACE, 0x06, 0, 1,             /* Union: 0 が制御, 1 がデータ */
+    7, USB_DESC_ENDPOINT, CDC_EP_NOTIFY, USB_EP_INTERRUPT, USB_W(16), 32,
+
+    /* インタフェース 1: Data Class */
+    9, USB_DESC_INTERFACE, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+    7, USB_DESC_ENDPOINT, CDC_EP_OUT, USB_EP_BULK, USB_W(CDC_PKT_SIZE), 0,
+    7, USB_DESC_ENDPOINT, CDC_EP_IN, USB_EP_BULK, USB_W(CDC_PKT_SIZE), 0,
+};
+
+static const uint8_t s_str_lang[] = { 4, USB_DESC_STRING, USB_W(0x0409) };
+static const uint8_t s_str_manuf[] = {
+    2 + 2 * 3, USB_DESC_STRING, 'N', 0, 'X', 0, 'P', 0,
+};
+static const uint8_t s_str_product[] = {
+    2 + 2 * 11, USB_DESC_STRING,
+    'L', 0, 'P', 0, 'C', 0, '1', 0, '3', 0, '4', 0, '3', 0, ' ', 0, 'V', 0, 'C', 0, 'P', 0,
+};
+static const uint8_t s_str_serial[] = {
+    2 + 2 * 4, USB_DESC_STRING, '0', 0, '0', 0, '0', 0, '1', 0,
+};
+static const uint8_t * const s_str_desc[] = { s_str_lang, s_str_manuf, s_str_product, s_str_serial };
+
+static int8_t cdc_request(const usb_setup_t *req, uint8_t **data, uint16_t *len);
+static void cdc_configured(uint8_t cfg);
+static void cdc_ep_event(uint8_t ep);
+static void rx_pump(void);
+static void tx_pump(void);
+
+static const usb_class_t s_cdc_class = {
+    s_dev_desc,
+    s_cfg_desc,
+    s_str_desc,
+    sizeof(s_str_desc) / sizeof(s_str_desc[0]),
+    cdc_request,
+    0,
+    cdc_configured,
+    cdc_ep_event,
+};
+
+/* dwDTERate (115200), bCharFormat (1 stop), bParityType (none), bDataBits (8) [PSTN 6.3.11] */
+static uint8_t s_line_coding[LINE_CODING_SIZE] = { 0x00, 0xC2, 0x01, 0x00, 0, 0, 8 };
+static volatile uint8_t s_line_state;
+
+static pkt_t s_rx[CDC_RX_NPKT];
+static volatile uint8_t s_rx_wr;        /* USB_FIQ が更新する */
+static volatile uint8_t s_rx_rd;        /* スレッドが更新する */
+static pkt_t s_tx[CDC_TX_NPKT];
+static volatile uint8_t s_tx_wr;        /* スレッドが更新する */
+static volatile uint8_t s_tx_rd;        /* USB_FIQ が更新する */
+static uint8_t s_tx_zlp;                /* 最後に送ったパケットが満杯だった (転送の区切りに ZLP が必要) */
+
+/**
+ * @brief CDC-ACM デバイスとして USB を初期化する
+ * @return なし
+ */
+void cdc_init(void)
+{
+    usb_init(&s_cdc_class);
+}
+
+/**
+ * @brief ホストが設定した制御線の状態を返す
+ * @return CDC_LINE_DTR, CDC_LINE_RTS の論理和
+ * @note DTR が立っていれば、ホスト側で端末が開かれていると考えてよい。
+ */
+uint8_t cdc_line_state(void)
+{
+    return s_line_state;
+}
+
+/**
+ * @brief ホストが設定したボーレートを返す
+ * @return ボーレート [bps] (USB 上の転送速度には関係しない)
+ */
+uint32_t cdc_baudrate(void)
+{
+    return s_line_coding[0] | (s_line_coding[1] << 8) | (s_line_coding[2] << 16) | ((uint32_t)s_line_coding[3] << 24);
+}
+
+/**
+ * @brief 受信済みの最も古いパケットを返す (取り出さない)
+ * @param[out] len パケットのバイト数
+ * @return パケットの先頭, 受信パケットが無ければ 0
+ */
+const uint8_t *cdc_rx_peek(uint16_t *len)
+{
+    pkt_t *p;
+
+    if (s_rx_rd == s_rx_wr) return 0;
+    p = &s_rx[s_rx_rd & (CDC_RX_NPKT - 1)];
+    *len = p->len;
+    return (const uint8_t *)p->data;
+}
+
+/**
+ * @brief cdc_rx_peek() で得たパケットを解放する
+ * @return なし
+ */
+void cdc_rx_release(void)
+{
+    if (s_rx_rd == s_rx_wr) return;
+    s_rx_rd++;
+    usbhw_kick_ep(CDC_EP_OUT);    /* エンドポイントに残したパケットがあれば読ませる */
+}
+
+/**
+ * @brief 送信パケットのバッファを借りる
+ * @return CDC_PKT_SIZE バイトのバッファ, 空きが無ければ 0
+ * @note 書き終えたら cdc_tx_commit() で送信キューに積むこと。
+ */
+uint8_t *cdc_tx_alloc(void)
+{
+    if ((uint8_t)(s_tx_wr - s_tx_rd) >= CDC_TX_NPKT) return 0;
+    return (uint8_t *)s_tx[s_tx_wr & (CDC_TX_NPKT - 1)].data;
+}
+
+/**
+ * @brief cdc_tx_alloc() で借りたバッファを送信キューに積む
+ * @param[in] len バイト数 (1..CDC_PKT_SIZE)
+ * @return なし
+ */
+void cdc_tx_commit(uint16_t len)
+{
+    s_tx[s_tx_wr & (CDC_TX_NPKT - 1)].len = len;
+    s_tx_wr++;
+    usbhw_kick_ep(CDC_EP_IN);
+}
+
+/**
+ * @brief データをコピーして送信キューに積む
+ * @param[in] p データ
+ * @param[in] n バイト数
+ * @return 積めたバイト数 (キューが満杯ならそれ以上は積まない; ブロックしない)
+ */
+uint16_t cdc_write(const uint8_t *p, uint16_t n)
+{
+    uint16_t done = 0;
+    uint8_t *buf;
+
+    while (done < n && (buf = cdc_tx_alloc()) != 0) {
+        uint16_t i, len = ((n - done) < CDC_PKT_SIZE) ? (n - done) : CDC_PKT_SIZE;
+        for (i = 0; i < len; i++) {
+            buf[i] = p[done + i];
+        }
+        cdc_tx_commit(len);
+        done += len;
+    }
+    return done;
+}
+
+/**
+ * @brief クラスリクエストの処理 [PSTN 6.3]
+ * @param[in] req SETUP パケット
+ * @param[out] data データステージのデータ
+ * @param[out] len IN データステージで返すバイト数
+ * @return 0: 受理, -1: 未対応
+ */
+static int8_t cdc_request(const usb_setup_t *req, uint8_t **data, uint16_t *len)
+{
+    if ((req->bmRequestType & USB_REQ_RCPT_MASK) != USB_REQ_INTERFACE) return -1;
+
+    switch (req->bRequest) {
+    case CDC_SET_LINE_CODING:
+        if (req->wLength > LINE_CODING_SIZE) return -1;
+        *data = s_line_coding;
+        return 0;
+    case CDC_GET_LINE_CODING:
+        *data = s_line_coding;
+        *len = LINE_CODING_SIZE;
+        return 0;
+    case CDC_SET_CONTROL_LINE_STATE:
+        s_line_state = req->wValue & (CDC_LINE_DTR | CDC_LINE_RTS);
+        return 0;
+    case CDC_SEND_BREAK:
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief コンフィギュレーションの変化 (バスリセットを含む)
+ * @param[in] cfg コンフィギュレーション値
+ * @return なし
+ * @note 送受信途中のパケットは捨てる。各リングの位置はそれぞれ割込み側が持つ方だけを動かす。\n
+ *       それらは USB_FIQ が更新するので、USB_IRQ から書き換える間は USB_FIQ をマスクする。
+ */
+static void cdc_configured(uint8_t cfg)
+{
+    uint32_t c = usbhw_lock();
+
+    s_rx_wr = s_rx_rd;
+    s_tx_rd = s_tx_wr;
+    s_tx_zlp = 0;
+    usbhw_unlock(c);
+    if (cfg == 0) {
+        s_line_state = 0;
+    }
+}
+
+/**
+ * @brief バルクエンドポイントのイベント (USB_FIQ から呼ばれる)
+ * @param[in] ep 論理エンドポイントアドレス
+ * @return なし
+ */
+static void cdc_ep_event(uint8_t ep)
+{
+    if (ep == CDC_EP_OUT) {
+        rx_pump();
+    } else if (ep == CDC_EP_IN) {
+        tx_pump();
+    }
+}
+
+/**
+ * @brief 受信リングに空きがある限りエンドポイントからパケットを読む
+ * @return なし
+ * @note ダブルバッファなので 1 回の割込みで 2 パケット溜まっていることがある。
+ */
+static void rx_pump(void)
+{
+    while ((uint8_t)(s_rx_wr - s_rx_rd) < CDC_RX_NPKT && (usbhw_ep_status(CDC_EP_OUT) & USB_EPSTAT_FE)) {
+        pkt_t *p = &s_rx[s_rx_wr & (CDC_RX_NPKT - 1)];
+        p->len = usbhw_read_ep(CDC_EP_OUT, p->data);
+        if (p->len) {
+            s_rx_wr++;
+        }
+    }
+}
+
+/**
+ * @brief エンドポイントのバッファに空きがある限り送信リングからパケットを書く
+ * @return なし
+ */
+static void tx_pump(void)
+{
+    while (!(usbhw_ep_status(CDC_EP_IN) & USB_EPSTAT_FE)) {
+        if (s_tx_rd != s_tx_wr) {
+            pkt_t *p = &s_tx[s_tx_rd & (CDC_TX_NPKT - 1)];
+            usbhw_write_ep(CDC_EP_IN, p->data, p->len);
+            s_tx_zlp = (p->len == CDC_PKT_SIZE);
+            s_tx_rd++;
+        } else if (s_tx_zlp) {
+            usbhw_write_ep(CDC_EP_IN, s_tx[0].data, 0);    /* 長さ 0 なのでデータは読まれない */
+            s_tx_zlp = 0;
+        } else {
+            break;
+        }
+    }
+}
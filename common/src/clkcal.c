@@ -0,0 +1,286 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file clkcal.c
+ * @brief クロックの検証と較正
+ */
+
+#include "system.h"
+#include "clkcal.h"
+#include "clkgate.h"
+
+#define IOCON_CLKOUT 0x01               /* PIO0_1: CLKOUT */
+#if (CLKCAL_TMR == 0)
+  #define CAP_PIN  PIO1_5
+  #define IOCON_CAP 0x02                /* PIO1_5: CT32B0_CAP0 */
+#else
+  #define CAP_PIN  R_PIO1_0
+  #define IOCON_CAP 0x83                /* R_PIO1_0: CT32B1_CAP0, デジタル */
+#endif
+#define CTCR_CAP0_RISE 0x01             /* カウンタモード, CAP0 の立ち上がりを数える */
+#define MAX_MS 10000                    /* 測定時間の上限 (サイクル数があふれない範囲) */
+
+static int8_t next_edge(ct32b_regs_t *tmr, uint32_t start, uint32_t limit, uint32_t *t, uint32_t *n);
+static uint8_t irc_is_source(void);
+static uint32_t muldiv(uint32_t a, uint32_t b, uint32_t c);
+static uint32_t absdiff(uint32_t a, uint32_t b);
+static void update_enable(volatile uint32_t *uen);
+
+/**
+ * @brief クロックの設定レジスタから、システムクロックの公称の周波数を求める
+ * @return 周波数 [Hz], 0: 求められない (WDT オシレータ, クロック停止)
+ */
+uint32_t clkcal_nominal(void)
+{
+    syscon_regs_t *const syscon = LPC_SYSCON;
+    uint32_t in = ((syscon->SYSPLLCLKSEL & 3) == 1) ? __XTAL : CLKCAL_IRC_HZ;
+    uint32_t main;
+
+    switch (syscon->MAINCLKSEL & 3) {
+    case 0: main = CLKCAL_IRC_HZ; break;
+    case 1: main = in; break;
+    case 3: main = in * ((syscon->SYSPLLCTRL & 0x1F) + 1); break;
+    default: return 0;
+    }
+    return syscon->SYSAHBCLKDIV ? main / syscon->SYSAHBCLKDIV : 0;
+}
+
+/**
+ * @brief システムクロック (コアクロック) の周波数を測る
+ * @param[in] ref 基準 (CLKCAL_SYSOSC, CLKCAL_IRC, CLKCAL_EXT)
+ * @param[in] ref_hz 基準の周波数 [Hz] (CLKOUT から出す基準なら分周前の値)
+ * @param[in] ms 測定時間 [ms] (1..MAX_MS)。100 ms で分解能はおよそ 1 ppm
+ * @param[out] hz 測った周波数 [Hz]
+ * @return 0: 成功, -1: 失敗 (DWT がない, 基準が止まっている, エッジが来ない)
+ * @details 割込みを禁止するのは、最初と最後のエッジを待つ間 (エッジ 1 周期分) だけ。
+ *          使ったピンとタイマは元に戻す。
+ */
+int8_t clkcal_measure(uint8_t ref, uint32_t ref_hz, uint32_t ms, uint32_t *hz)
+{
+    syscon_regs_t *const syscon = LPC_SYSCON;
+    ct32b_regs_t *const tmr = LPC_CT32Bn(CLKCAL_TMR);
+    volatile uint32_t *cyccnt = (volatile uint32_t *)DWT(CYCCNT);
+    uint32_t iocon_out, iocon_cap;
+    uint32_t div = (ref == CLKCAL_EXT) ? 1 : CLKCAL_DIV;
+    uint32_t edges = (ref_hz / div / 1000) * ms;
+    uint32_t limit = (sys_clock() / 1000) * ms * 2;        /* 公称の 2 倍待っても終わらなければ失敗 */
+    uint32_t start, t0, n0, t1, n1;
+    int8_t ret = -1;
+
+    if (ms == 0 || ms > MAX_MS || edges < 2 || !dwt_cyccnt_start()) return -1;
+    if (ref == CLKCAL_SYSOSC && (syscon->PDRUNCFG & SYSCON_PDRUNCFG_SYSOSC_PD_Msk)) return -1;
+    if (ref != CLKCAL_EXT && clkgate_div_acquire(CLKGATE_DIV_CLKOUT, CLKCAL_DIV) < 0) return -1;
+    clkgate_acquire(CLKGATE_IOCON);
+    clkgate_acquire(CLKGATE_CT32B0 + CLKCAL_TMR);
+    iocon_out = LPC_IOCON->PIO0_1;
+    iocon_cap = LPC_IOCON->CAP_PIN;
+
+    /* 基準を CLKOUT に出す */
+    if (ref != CLKCAL_EXT) {
+        syscon->CLKOUTCLKSEL = (ref == CLKCAL_SYSOSC) ? 1 : 0;
+        update_enable(&syscon->CLKOUTUEN);
+        LPC_IOCON->PIO0_1 = IOCON_CLKOUT;
+    }
+
+    /* タイマをカウンタモードにして、キャプチャ入力のエッジを数える */
+    LPC_IOCON->CAP_PIN = IOCON_CAP;
+    tmr->TCR = CT32B_TCR_CRST_Msk;
+    tmr->CTCR = CTCR_CAP0_RISE;
+    tmr->PR = 0;
+    tmr->MCR = 0;
+    tmr->CCR = 0;
+    tmr->TCR = CT32B_TCR_CEN_Msk;
+
+    start = *cyccnt;
+    if (next_edge(tmr, start, limit, &t0, &n0) < 0) goto end;
+    while (tmr->TC - n0 < edges - 1) {
+        if (*cyccnt - start > limit) goto end;
+    }
+    if (next_edge(tmr, start, limit, &t1, &n1) < 0) goto end;
+
+    *hz = muldiv(t1 - t0, ref_hz, (n1 - n0) * div);
+    ret = 0;
+
+end:
+    tmr->TCR = 0;
+    tmr->CTCR = 0;
+    LPC_IOCON->CAP_PIN = iocon_cap;
+    if (ref != CLKCAL_EXT) {
+        LPC_IOCON->PIO0_1 = iocon_out;
+        clkgate_div_release(CLKGATE_DIV_CLKOUT);
+    }
+    clkgate_release(CLKGATE_CT32B0 + CLKCAL_TMR);
+    clkgate_release(CLKGATE_IOCON);
+    return ret;
+}
+
+/**
+ * @brief システムクロックが設定どおりの周波数で動いているかを水晶発振と比べて確かめる
+ * @param[in] tol_ppm 許容誤差 [ppm]
+ * @param[out] err_ppm 公称の周波数との差 [ppm]
+ * @return 0: 許容誤差内, -1: 外れている (PLL がロックしていない, 測れない)
+ * @note PLL の入力が水晶なら、水晶自体の誤差は打ち消し合うので、PLL の逓倍が設定どおりかを見ることになる。
+ */
+int8_t clkcal_verify(uint32_t tol_ppm, int32_t *err_ppm)
+{
+    syscon_regs_t *const syscon = LPC_SYSCON;
+    uint32_t nom = clkcal_nominal();
+    uint32_t hz, e;
+
+    if (!nom) return -1;
+    if ((syscon->MAINCLKSEL & 3) == 3 && !(syscon->SYSPLLSTAT & SYSCON_SYSPLLSTAT_LOCK_Msk)) return -1;
+    if (clkcal_measure(CLKCAL_SYSOSC, __XTAL, 100, &hz) < 0) return -1;
+
+    e = muldiv(absdiff(hz, nom), 1000000, nom);
+    *err_ppm = (hz < nom) ? -(int32_t)e : (int32_t)e;
+    return (e <= tol_ppm) ? 0 : -1;
+}
+
+/**
+ * @brief システムクロックの周波数を測って sys_clock() に反映する
+ * @param[in] ref, ref_hz, ms clkcal_measure() と同じ
+ * @return 0: 成功, -1: 失敗 (sys_clock() は変えない)
+ */
+int8_t clkcal_calibrate(uint8_t ref, uint32_t ref_hz, uint32_t ms)
+{
+    uint32_t hz;
+
+    if (clkcal_measure(ref, ref_hz, ms, &hz) < 0) return -1;
+    sys_set_clock(hz);
+    return 0;
+}
+
+/**
+ * @brief IRC のトリム (IRCCTRL) を合わせて、システムクロックを公称の周波数に近づける
+ * @param[in] ref 基準 (CLKCAL_SYSOSC または CLKCAL_EXT)
+ * @param[in] ref_hz, ms clkcal_measure() と同じ
+ * @return 設定したトリムの値, -1: 失敗 (システムクロックが IRC からでない, 測れない)
+ * @details トリムを 1 ずつ動かし、誤差が小さくならなくなったところで止める。
+ *          最後に測った周波数を sys_set_clock() に渡す。トリムは電源を切ると工場出荷値に
+ *          戻るので、残すなら kvs.h などに保存して起動時に IRCCTRL へ書き戻す。
+ */
+int16_t clkcal_trim_irc(uint8_t ref, uint32_t ref_hz, uint32_t ms)
+{
+    syscon_regs_t *const syscon = LPC_SYSCON;
+    uint32_t nom = clkcal_nominal();
+    uint32_t hz, best_hz, best_err, e;
+    int16_t best, t, dir;
+    uint8_t i;
+
+    if (ref == CLKCAL_IRC || !nom || !irc_is_source()) return -1;
+
+    best = syscon->IRCCTRL & 0xFF;
+    if (clkcal_measure(ref, ref_hz, ms, &best_hz) < 0) return -1;
+    best_err = absdiff(best_hz, nom);
+    dir = (best_hz < nom) ? 1 : -1;    /* トリムを増やすと速くなると仮定し、外れたら 1 回だけ反転する */
+
+    for (i = 0; i < 64; i++) {
+        t = best + dir;
+        if (t < 0 || t > 0xFF) break;
+        syscon->IRCCTRL = t;
+        if (clkcal_measure(ref, ref_hz, ms, &hz) < 0) {
+            syscon->IRCCTRL = best;
+            return -1;
+        }
+        e = absdiff(hz, nom);
+        if (e >= best_err) {
+            if (i == 0) {
+                dir = -dir;
+                continue;
+            }
+            break;
+        }
+        best = t;
+        best_hz = hz;
+        best_err = e;
+    }
+
+    syscon->IRCCTRL = best;
+    sys_set_clock(best_hz);
+    return best;
+}
+
+/**
+ * @brief 最初のエッジを待って、そのときのサイクルカウンタとエッジの数を読む
+ * @param[in] start, limit タイムアウトの起点とサイクル数
+ * @param[out] t サイクルカウンタ
+ * @param[out] n エッジの数 (タイマカウンタ)
+ * @return 0: 成功, -1: タイムアウト
+ * @note エッジの検出から読み出しまでの遅れは毎回同じなので、2 回の差をとれば消える。
+ */
+static int8_t next_edge(ct32b_regs_t *tmr, uint32_t start, uint32_t limit, uint32_t *t, uint32_t *n)
+{
+    volatile uint32_t *cyccnt = (volatile uint32_t *)DWT(CYCCNT);
+    uint32_t v = irq_save();
+    uint32_t k = tmr->TC;
+
+    while (tmr->TC == k) {
+        if (*cyccnt - start > limit) {
+            irq_restore(v);
+            return -1;
+        }
+    }
+    *t = *cyccnt;
+    *n = tmr->TC;
+    irq_restore(v);
+    return 0;
+}
+
+/**
+ * @brief システムクロックが IRC から作られているかを判定する
+ * @return !0: 是, 0: 否
+ */
+static uint8_t irc_is_source(void)
+{
+    syscon_regs_t *const syscon = LPC_SYSCON;
+    uint32_t sel = syscon->MAINCLKSEL & 3;
+
+    return sel == 0 || ((sel == 1 || sel == 3) && (syscon->SYSPLLCLKSEL & 3) == 0);
+}
+
+/**
+ * @brief a * b / c を 64 ビットの途中結果で計算する (-nostdlib なので 64 ビットの除算は使えない)
+ * @return 商 (32 ビットに収まること)
+ */
+static uint32_t muldiv(uint32_t a, uint32_t b, uint32_t c)
+{
+    uint64_t n = (uint64_t)a * b;
+    uint32_t hi = n >> 32;
+    uint32_t lo = (uint32_t)n;
+    uint32_t q = 0;
+    uint8_t i;
+
+    for (i = 0; i < 32; i++) {
+        uint32_t carry = hi >> 31;
+        hi = (hi << 1) | (lo >> 31);
+        lo <<= 1;
+        q <<= 1;
+        if (carry || hi >= c) {
+            hi -= c;
+            q |= 1;
+        }
+    }
+    return q;
+}
+
+/**
+ * @brief |a - b|
+ * @return 差の絶対値
+ */
+static uint32_t absdiff(uint32_t a, uint32_t b)
+{
+    return (a > b) ? a - b : b - a;
+}
+
+/**
+ * @brief クロックアップデート待ち
+ * @param[in] uen *CLKUEN レジスタ (ビット 0 だけが有効)
+ * @return なし
+ */
+static void update_enable(volatile uint32_t *uen)
+{
+    *uen = 1;
+    *uen = 0;
+    *uen = 1;
+    while (!(*uen & 1));
+}
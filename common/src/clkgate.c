@@ -0,0 +1,186 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file clkgate.c
+ * @brief ペリフェラルのクロックの参照カウントによる管理
+ */
+
+#include "system.h"
+#include "clkgate.h"
+
+static uint8_t s_ref[CLKGATE_NUM];
+static uint8_t s_div_ref[CLKGATE_DIV_NUM];
+
+/* 分周器のレジスタ */
+static volatile uint32_t *const s_div_reg[CLKGATE_DIV_NUM] = {
+    &LPC_SYSCON->SSP0CLKDIV,
+    &LPC_SYSCON->UARTCLKDIV,
+    &LPC_SYSCON->SSP1CLKDIV,
+    &LPC_SYSCON->TRACECLKDIV,
+    &LPC_SYSCON->SYSTICKCLKDIV,
+    &LPC_SYSCON->USBCLKDIV,
+    &LPC_SYSCON->WDTCLKDIV,
+    &LPC_SYSCON->CLKOUTDIV,
+};
+
+/*
+ * クロックを点けたときに増える電流の見積もり [uA/MHz]。
+ * データシートのブロックごとの典型値 (数 MHz から 72 MHz) を 1 MHz あたりに丸めた概算で、
+ * ペリフェラルが動いていない (クロックだけ入っている) ときの値。
+ * 0 は止めないクロックか、測れるほどの差がないもの。
+ */
+static const uint8_t s_ua_mhz[CLKGATE_NUM] = {
+    [CLKGATE_I2C]     = 3,
+    [CLKGATE_GPIO]    = 3,
+    [CLKGATE_CT16B0]  = 2,
+    [CLKGATE_CT16B1]  = 2,
+    [CLKGATE_CT32B0]  = 3,
+    [CLKGATE_CT32B1]  = 3,
+    [CLKGATE_SSP0]    = 8,
+    [CLKGATE_UART]    = 5,
+    [CLKGATE_ADC]     = 5,
+    [CLKGATE_USB_REG] = 20,
+    [CLKGATE_WDT]     = 1,
+    [CLKGATE_IOCON]   = 1,
+    [CLKGATE_SSP1]    = 8,
+};
+
+/**
+ * @brief ペリフェラルのクロックを得る (参照が 0 から 1 になったら点ける)
+ * @param[in] gate CLKGATE_I2C など
+ * @return 0: 成功, -1: gate が不正, または参照が多すぎる
+ */
+int8_t clkgate_acquire(uint8_t gate)
+{
+    uint32_t v;
+
+    if (gate >= CLKGATE_NUM || gate == 17) return -1;    /* ビット 17 は予約 */
+
+    v = irq_save();
+    if (s_ref[gate] == 0xFF) {
+        irq_restore(v);
+        return -1;
+    }
+    if (s_ref[gate]++ == 0) {
+        LPC_SYSCON->SYSAHBCLKCTRL |= 1UL << gate;
+    }
+    irq_restore(v);
+    return 0;
+}
+
+/**
+ * @brief ペリフェラルのクロックを返す (参照が 0 になったら止める)
+ * @param[in] gate clkgate_acquire() に渡した値
+ * @return なし
+ */
+void clkgate_release(uint8_t gate)
+{
+    uint32_t v;
+
+    if (gate >= CLKGATE_NUM) return;
+
+    v = irq_save();
+    if (s_ref[gate] && --s_ref[gate] == 0 && !(CLKGATE_PINNED & (1UL << gate))) {
+        LPC_SYSCON->SYSAHBCLKCTRL &= ~(1UL << gate);
+    }
+    irq_restore(v);
+}
+
+/**
+ * @brief ペリフェラルのクロック分周器を得る (参照が 0 から 1 になったら分周比を書く)
+ * @param[in] div CLKGATE_DIV_SSP0 など
+ * @param[in] val 分周比 (1..255)
+ * @return 0: 成功, -1: 不正な値, または他で別の分周比で使っている
+ */
+int8_t clkgate_div_acquire(uint8_t div, uint8_t val)
+{
+    uint32_t v;
+    int8_t ret = 0;
+
+    if (div >= CLKGATE_DIV_NUM || !val) return -1;
+
+    v = irq_save();
+    if (!s_div_ref[div]) {
+        *s_div_reg[div] = val;
+        s_div_ref[div] = 1;
+    } else if (*s_div_reg[div] != val || s_div_ref[div] == 0xFF) {
+        ret = -1;
+    } else {
+        s_div_ref[div]++;
+    }
+    irq_restore(v);
+    return ret;
+}
+
+/**
+ * @brief ペリフェラルのクロック分周器を返す (参照が 0 になったら 0 を書いて止める)
+ * @param[in] div clkgate_div_acquire() に渡した値
+ * @return なし
+ */
+void clkgate_div_release(uint8_t div)
+{
+    uint32_t v;
+
+    if (div >= CLKGATE_DIV_NUM) return;
+
+    v = irq_save();
+    if (s_div_ref[div] && --s_div_ref[div] == 0) {
+        *s_div_reg[div] = 0;
+    }
+    irq_restore(v);
+}
+
+/**
+ * @brief 参照のないクロックをすべて止める
+ * @return なし
+ * @note 参照のない分周器は、リセット後の値のまま使っているドライバがあるかもしれないので触らない。
+ */
+void clkgate_trim(void)
+{
+    uint32_t v = irq_save();
+    LPC_SYSCON->SYSAHBCLKCTRL = clkgate_mask();
+    irq_restore(v);
+}
+
+/**
+ * @brief アイドル時の処理 (参照のないクロックを止めてから WFI で眠る)
+ * @return なし
+ * @note カーネルのアイドルタスクで使うなら kern_idle_hook(clkgate_idle) とする。
+ */
+void clkgate_idle(void)
+{
+    clkgate_trim();
+    __asm volatile ("wfi");
+}
+
+/**
+ * @brief 参照のあるクロックと止めないクロックのマスクを返す
+ * @return SYSAHBCLKCTRL に書くべき値
+ */
+uint32_t clkgate_mask(void)
+{
+    uint32_t m = CLKGATE_PINNED;
+    uint8_t i;
+
+    for (i = 0; i < CLKGATE_NUM; i++) {
+        if (s_ref[i]) m |= 1UL << i;
+    }
+    return m;
+}
+
+/**
+ * @brief クロックの組み合わせで増える電流を見積もる
+ * @param[in] mask SYSAHBCLKCTRL の値 (clkgate_mask() や現在のレジスタの値)
+ * @return すべて止めたときからの増分 [uA] (今のシステムクロックでの概算)
+ */
+uint32_t clkgate_estimate_ua(uint32_t mask)
+{
+    uint32_t mhz = sys_clock() / 1000000;
+    uint32_t ua = 0;
+    uint8_t i;
+
+    for (i = 0; i < CLKGATE_NUM; i++) {
+        if (mask & (1UL << i)) ua += s_ua_mhz[i] * mhz;
+    }
+    return ua;
+}
@@ -0,0 +1,212 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file cpuload.c
+ * @brief CPU 負荷と割込みごとの実行時間の計測
+ */
+
+#include "system.h"
+#include "vector.h"
+#include "cpuload.h"
+
+#define NO_SLOT 0xFF
+
+extern void irq_handler(void);
+
+volatile cpuload_t g_cpuload;
+
+static vector_entry s_orig[CPULOAD_SOURCES];         /* 元のハンドラ */
+static uint8_t s_slot[NUM_VECTORS];                  /* 例外番号 -> s_orig[] の添字 */
+static uint32_t s_cycles[CPULOAD_SOURCES];           /* 集計中の窓での実行時間 */
+static uint32_t s_count[CPULOAD_SOURCES];            /* 集計中の窓での実行回数 */
+static volatile uint32_t s_nest;                     /* 今のレベルでネストした割込みの時間の合計 */
+static volatile uint8_t s_depth;                     /* 計測中の割込みのネストの深さ */
+static uint32_t s_idle;                              /* 集計中の窓でのアイドル時間 */
+static uint32_t s_win0;                              /* 集計中の窓の始まり */
+static uint32_t s_wait_t0, s_wait_n0;                /* cpuload_wait() の始まり */
+static volatile uint8_t s_waiting;
+static uint8_t s_run;
+
+static void wrap(void);
+static void roll(void);
+static void clock_changed(uint32_t hz);
+
+/**
+ * @brief 計測を始める
+ * @return 0: 成功, -1: DWT がない, または CPULOAD_SOURCES が足りない (入りきらない割込みは計測しない)
+ * @note 計測中に呼ぶと、その後に登録されたハンドラも計測の対象にする。
+ */
+int8_t cpuload_start(void)
+{
+    uint32_t vec, slot;
+    vector_entry h;
+    int8_t ret = 0;
+
+    if (!dwt_cyccnt_start()) return -1;
+
+    if (!s_run) {
+        for (vec = 0; vec < NUM_VECTORS; vec++) s_slot[vec] = NO_SLOT;
+        g_cpuload.window = (sys_clock() / 1000) * CPULOAD_WINDOW_MS;
+        sys_clock_hook(clock_changed);
+        vector_add_wrapper(wrap);
+        s_win0 = dwt_cyccnt();
+        s_run = 1;
+        tmr32_wait_hook(cpuload_wait);
+    }
+
+    for (vec = 16 + EX_SYSTICK; vec < NUM_VECTORS; vec++) {
+        h = vector_get((irq_t)(vec - 16));
+        if (h == wrap || h == irq_handler) continue;
+
+        slot = s_slot[vec];
+        if (slot != NO_SLOT && vector_is_wrapper(h)) continue;    /* こちらを包んだ他の計測用の関数 */
+        if (slot == NO_SLOT) {
+            if (g_cpuload.nsrc >= CPULOAD_SOURCES) {
+                ret = -1;
+                continue;
+            }
+            slot = g_cpuload.nsrc;
+            g_cpuload.src[slot].vec = vec;
+            s_slot[vec] = slot;
+            g_cpuload.nsrc = slot + 1;
+        }
+        s_orig[slot] = h;
+        vector_install((irq_t)(vec - 16), wrap);
+    }
+    return ret;
+}
+
+/**
+ * @brief 割込みが保留されるまでアイドルとして待つ (カーネルのアイドルタスク用)
+ * @return なし
+ * @details 割込みを禁止したまま待ち、その時間をアイドルに足してから許可する。
+ *          保留された割込みはその後に実行されるので、アイドルには含まれない。
+ *          WFI で眠るとサイクルカウンタも止まるので、計測中は眠らずに ICSR を見て待つ。
+ *          計測を始める前は WFI で眠る。
+ */
+void cpuload_idle(void)
+{
+    uint32_t v, t0;
+
+    if (!s_run) {
+        __asm volatile ("wfi");
+        return;
+    }
+    v = irq_save();
+    t0 = dwt_cyccnt();
+    while (!(reg_read(SCB(ICSR)) & ICSR_VECTPENDING));
+    s_idle += dwt_cyccnt() - t0;
+    irq_restore(v);
+    roll();
+}
+
+/**
+ * @brief スレッドモードでの待ちの出入りを知らせる (tmr32_delay_ms() などのフック)
+ * @param[in] enter 1: 待ちに入る, 0: 待ちから出る
+ * @return なし
+ * @note 待ちの間に割込まれた時間はアイドルから除く。窓が待ちの途中で閉じたら、
+ *       そこまでの分をその窓のアイドルに入れる。
+ */
+void cpuload_wait(uint8_t enter)
+{
+    uint32_t v = irq_save();
+
+    if (enter) {
+        s_wait_n0 = s_nest;
+        s_wait_t0 = dwt_cyccnt();
+        s_waiting = 1;
+        irq_restore(v);
+    } else {
+        s_idle += (dwt_cyccnt() - s_wait_t0) - (s_nest - s_wait_n0);
+        s_waiting = 0;
+        irq_restore(v);
+        roll();
+    }
+}
+
+/**
+ * @brief 計測用の割込みハンドラ
+ * @return なし
+ * @details IPSR から例外番号を読んで元のハンドラを呼ぶ。通常の関数なので LR (EXC_RETURN) は
+ *          スタックに退避され、最後の pop {..., pc} で例外から戻る。
+ *          s_nest はネストの出入りでスタックのように退避/復帰するので、排他は要らない。
+ */
+static void wrap(void)
+{
+    uint32_t vec, slot, prev, t0, dt, self;
+
+    __asm volatile ("mrs %0, ipsr" : "=r" (vec));
+    slot = s_slot[vec & 0x1FF];
+
+    prev = s_nest;
+    s_nest = 0;
+    s_depth++;
+    t0 = dwt_cyccnt();
+    s_orig[slot]();
+    dt = dwt_cyccnt() - t0;
+    s_depth--;
+
+    self = dt - s_nest;
+    s_cycles[slot] += self;
+    s_count[slot]++;
+    if (self > g_cpuload.src[slot].max) g_cpuload.src[slot].max = self;
+    s_nest = prev + dt;
+
+    if (!s_depth) roll();
+}
+
+/**
+ * @brief 窓が過ぎていれば集計して g_cpuload に書き出す
+ * @return なし
+ * @note 割込みから戻るときと待ちの終わりに呼ぶので、どちらもない間は窓が延びる。
+ */
+static void roll(void)
+{
+    uint32_t v = irq_save();
+    uint32_t now = dwt_cyccnt();
+    uint32_t win = now - s_win0;
+    uint32_t irq = 0, busy, load, i;
+
+    if (win < g_cpuload.window || win < 1000) {
+        irq_restore(v);
+        return;
+    }
+    if (s_waiting) {
+        s_idle += (now - s_wait_t0) - (s_nest - s_wait_n0);
+        s_wait_t0 = now;
+        s_wait_n0 = s_nest;
+    }
+
+    for (i = 0; i < g_cpuload.nsrc; i++) {
+        g_cpuload.src[i].cycles = s_cycles[i];
+        g_cpuload.src[i].count = s_count[i];
+        irq += s_cycles[i];
+        s_cycles[i] = 0;
+        s_count[i] = 0;
+    }
+    if (s_idle > win) s_idle = win;
+    busy = win - s_idle;
+    load = busy / (win / 1000);
+    if (load > 1000) load = 1000;
+
+    g_cpuload.irq = irq;
+    g_cpuload.idle = s_idle;
+    g_cpuload.thread = (busy > irq) ? busy - irq : 0;
+    g_cpuload.load = load;
+    g_cpuload.avg = g_cpuload.windows ? (g_cpuload.avg * 7 + load) / 8 : load;
+    if (load > g_cpuload.peak) g_cpuload.peak = load;
+    g_cpuload.windows++;
+
+    s_idle = 0;
+    s_win0 = now;
+    irq_restore(v);
+}
+
+/**
+ * @brief システムクロックの周波数が変わったら窓の長さを合わせ直す (sys_clock_hook())
+ * @return なし
+ */
+static void clock_changed(uint32_t hz)
+{
+    g_cpuload.window = (hz / 1000) * CPULOAD_WINDOW_MS;
+}
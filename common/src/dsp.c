@@ -0,0 +1,486 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file dsp.c
+ * @brief 固定小数点の信号処理
+ */
+
+#include "dsp.h"
+
+static inline q15_t fir_q15_dot(const q15_t *h, const q15_t *x, uint16_t n);
+static inline q31_t fir_q31_dot(const q31_t *h, const q31_t *x, uint16_t n);
+static inline int32_t sat32(int64_t v);
+
+/**
+ * @brief FIR フィルタ (Q15) の初期化
+ * @param[out] f フィルタ
+ * @param[in] coef 係数 (ntaps 個; 絶対値の和が 2.0 未満)
+ * @param[in] state 作業領域 (2 * ntaps 個)
+ * @param[in] ntaps タップ数 (1 以上)
+ * @return なし
+ */
+void dsp_fir_q15_init(dsp_fir_q15_t *f, const q15_t *coef, q15_t *state, uint16_t ntaps)
+{
+    uint32_t i;
+
+    f->coef = coef;
+    f->state = state;
+    f->ntaps = ntaps;
+    f->pos = 0;
+    for (i = 0; i < 2UL * ntaps; i++) state[i] = 0;
+}
+
+/**
+ * @brief FIR フィルタ (Q15) をかける
+ * @param[in,out] f フィルタ
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (n 個; in と同じでもよい)
+ * @param[in] n サンプル数
+ * @return なし
+ */
+void dsp_fir_q15(dsp_fir_q15_t *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    q15_t *st = f->state;
+    uint16_t nt = f->ntaps;
+    uint16_t pos = f->pos;
+
+    while (n--) {
+        pos = pos ? pos - 1 : nt - 1;
+        st[pos] = st[pos + nt] = *in++;
+        *out++ = fir_q15_dot(f->coef, &st[pos], nt);
+    }
+    f->pos = pos;
+}
+
+/**
+ * @brief FIR フィルタ (Q31) の初期化
+ * @param[out] f フィルタ
+ * @param[in] coef 係数 (ntaps 個)
+ * @param[in] state 作業領域 (2 * ntaps 個)
+ * @param[in] ntaps タップ数 (1 以上)
+ * @return なし
+ */
+void dsp_fir_q31_init(dsp_fir_q31_t *f, const q31_t *coef, q31_t *state, uint16_t ntaps)
+{
+    uint32_t i;
+
+    f->coef = coef;
+    f->state = state;
+    f->ntaps = ntaps;
+    f->pos = 0;
+    for (i = 0; i < 2UL * ntaps; i++) state[i] = 0;
+}
+
+/**
+ * @brief FIR フィルタ (Q31) をかける
+ * @param[in,out] f フィルタ
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (n 個; in と同じでもよい)
+ * @param[in] n サンプル数
+ * @return なし
+ */
+void dsp_fir_q31(dsp_fir_q31_t *f, const q31_t *in, q31_t *out, uint32_t n)
+{
+    q31_t *st = f->state;
+    uint16_t nt = f->ntaps;
+    uint16_t pos = f->pos;
+
+    while (n--) {
+        pos = pos ? pos - 1 : nt - 1;
+        st[pos] = st[pos + nt] = *in++;
+        *out++ = fir_q31_dot(f->coef, &st[pos], nt);
+    }
+    f->pos = pos;
+}
+
+/**
+ * @brief 双二次 IIR フィルタ (Q15) の初期化
+ * @param[out] f フィルタ
+ * @param[in] coef 係数 (5 * nstages 個, Q14)
+ * @param[in] state 状態 (4 * nstages 個)
+ * @param[in] nstages 段数
+ * @return なし
+ */
+void dsp_biquad_q15_init(dsp_biquad_q15_t *f, const q15_t *coef, q15_t *state, uint8_t nstages)
+{
+    uint32_t i;
+
+    f->coef = coef;
+    f->state = state;
+    f->nstages = nstages;
+    for (i = 0; i < 4UL * nstages; i++) state[i] = 0;
+}
+
+/**
+ * @brief 双二次 IIR フィルタ (Q15) をかける
+ * @param[in,out] f フィルタ
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (n 個; in と同じでもよい)
+ * @param[in] n サンプル数
+ * @return なし
+ * @details 段ごとにブロック全体を処理し、2 段目からは out をその場で書き換える。
+ *          係数と状態はブロックの間レジスタに置く。
+ */
+void dsp_biquad_q15(dsp_biquad_q15_t *f, const q15_t *in, q15_t *out, uint32_t n)
+{
+    const q15_t *c = f->coef;
+    q15_t *st = f->state;
+    const q15_t *src = in;
+    uint8_t s;
+
+    for (s = 0; s < f->nstages; s++, c += 5, st += 4) {
+        int32_t b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        int32_t x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3];
+        uint32_t i;
+
+        for (i = 0; i < n; i++) {
+            int32_t x0 = src[i];
+            int64_t acc = 1 << 13;     /* 丸め */
+            acc = dsp_smlal(acc, b0, x0);
+            acc = dsp_smlal(acc, b1, x1);
+            acc = dsp_smlal(acc, b2, x2);
+            acc = dsp_smlal(acc, a1, y1);
+            acc = dsp_smlal(acc, a2, y2);
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = dsp_ssat((int32_t)(acc >> 14), 16);
+            out[i] = y1;
+        }
+        st[0] = x1;
+        st[1] = x2;
+        st[2] = y1;
+        st[3] = y2;
+        src = out;
+    }
+}
+
+/**
+ * @brief 双二次 IIR フィルタ (Q31) の初期化
+ * @param[out] f フィルタ
+ * @param[in] coef 係数 (5 * nstages 個, Q30)
+ * @param[in] state 状態 (4 * nstages 個)
+ * @param[in] nstages 段数
+ * @return なし
+ */
+void dsp_biquad_q31_init(dsp_biquad_q31_t *f, const q31_t *coef, q31_t *state, uint8_t nstages)
+{
+    uint32_t i;
+
+    f->coef = coef;
+    f->state = state;
+    f->nstages = nstages;
+    for (i = 0; i < 4UL * nstages; i++) state[i] = 0;
+}
+
+/**
+ * @brief 双二次 IIR フィルタ (Q31) をかける
+ * @param[in,out] f フィルタ
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (n 個; in と同じでもよい)
+ * @param[in] n サンプル数
+ * @return なし
+ */
+void dsp_biquad_q31(dsp_biquad_q31_t *f, const q31_t *in, q31_t *out, uint32_t n)
+{
+    const q31_t *c = f->coef;
+    q31_t *st = f->state;
+    const q31_t *src = in;
+    uint8_t s;
+
+    for (s = 0; s < f->nstages; s++, c += 5, st += 4) {
+        int32_t b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+        int32_t x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3];
+        uint32_t i;
+
+        for (i = 0; i < n; i++) {
+            int32_t x0 = src[i];
+            int64_t acc = 1 << 29;     /* 丸め */
+            acc = dsp_smlal(acc, b0, x0);
+            acc = dsp_smlal(acc, b1, x1);
+            acc = dsp_smlal(acc, b2, x2);
+            acc = dsp_smlal(acc, a1, y1);
+            acc = dsp_smlal(acc, a2, y2);
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = sat32(acc >> 30);
+            out[i] = y1;
+        }
+        st[0] = x1;
+        st[1] = x2;
+        st[2] = y1;
+        st[3] = y2;
+        src = out;
+    }
+}
+
+/**
+ * @brief 移動平均の初期化
+ * @param[out] m 移動平均
+ * @param[in] buf 作業領域 (len 個)
+ * @param[in] len 窓の長さ (1..65535)
+ * @return なし
+ */
+void dsp_mavg_init(dsp_mavg_t *m, q15_t *buf, uint16_t len)
+{
+    uint32_t i;
+
+    m->buf = buf;
+    m->sum = 0;
+    m->len = len;
+    m->pos = 0;
+    m->shift = (len & (len - 1)) ? 0xFF : 31 - __builtin_clz(len);
+    for (i = 0; i < len; i++) buf[i] = 0;
+}
+
+/**
+ * @brief 移動平均をとる
+ * @param[in,out] m 移動平均
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (n 個; in と同じでもよい)
+ * @param[in] n サンプル数
+ * @return なし
+ * @note 平均は負の無限大の方向に切り捨てる。窓が 2 のべきなら除算の代わりにシフトする。
+ */
+void dsp_mavg(dsp_mavg_t *m, const q15_t *in, q15_t *out, uint32_t n)
+{
+    int32_t sum = m->sum;
+    uint16_t pos = m->pos;
+
+    while (n--) {
+        q15_t x = *in++;
+        sum += x - m->buf[pos];
+        m->buf[pos] = x;
+        if (++pos == m->len) pos = 0;
+        if (m->shift != 0xFF) {
+            *out++ = sum >> m->shift;
+        } else {
+            int32_t q = sum / m->len;
+            *out++ = (q * m->len > sum) ? q - 1 : q;
+        }
+    }
+    m->sum = sum;
+    m->pos = pos;
+}
+
+/**
+ * @brief メディアンフィルタの初期化
+ * @param[out] m メディアンフィルタ
+ * @param[in] hist, sorted 作業領域 (それぞれ len 個)
+ * @param[in] len 窓の長さ (奇数)
+ * @return 0: 成功, -1: len が偶数
+ */
+int8_t dsp_median_init(dsp_median_t *m, q15_t *hist, q15_t *sorted, uint8_t len)
+{
+    uint32_t i;
+
+    if (!(len & 1)) return -1;
+    m->hist = hist;
+    m->sorted = sorted;
+    m->len = len;
+    m->pos = 0;
+    for (i = 0; i < len; i++) hist[i] = sorted[i] = 0;
+    return 0;
+}
+
+/**
+ * @brief メディアンフィルタをかける
+ * @param[in,out] m メディアンフィルタ
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (n 個; in と同じでもよい)
+ * @param[in] n サンプル数
+ * @return なし
+ * @details 並べ替えた窓から一番古い値を抜き、新しい値を挿入する位置までの間だけを 1 つずらす
+ *          (1 サンプルあたり窓の長さに比例)。
+ */
+void dsp_median(dsp_median_t *m, const q15_t *in, q15_t *out, uint32_t n)
+{
+    q15_t *sorted = m->sorted;
+    uint8_t len = m->len;
+
+    while (n--) {
+        q15_t x = *in++;
+        q15_t old = m->hist[m->pos];
+        uint8_t i = 0;
+
+        m->hist[m->pos] = x;
+        if (++m->pos == len) m->pos = 0;
+
+        while (sorted[i] != old) i++;
+        if (x > old) {
+            while (i + 1 < len && sorted[i + 1] < x) {
+                sorted[i] = sorted[i + 1];
+                i++;
+            }
+        } else {
+            while (i > 0 && sorted[i - 1] > x) {
+                sorted[i] = sorted[i - 1];
+                i--;
+            }
+        }
+        sorted[i] = x;
+        *out++ = sorted[len >> 1];
+    }
+}
+
+/**
+ * @brief 間引きの初期化
+ * @param[out] d 間引き
+ * @param[in] coef 前置フィルタの係数 (ntaps 個; 遮断周波数は出力のナイキスト周波数以下にする)
+ * @param[in] state 作業領域 (2 * ntaps 個)
+ * @param[in] ntaps タップ数
+ * @param[in] m 間引き率 (1 以上)
+ * @return なし
+ */
+void dsp_decim_q15_init(dsp_decim_q15_t *d, const q15_t *coef, q15_t *state, uint16_t ntaps, uint8_t m)
+{
+    dsp_fir_q15_init(&d->fir, coef, state, ntaps);
+    d->m = m;
+    d->phase = 0;
+}
+
+/**
+ * @brief 間引く
+ * @param[in,out] d 間引き
+ * @param[in] in 入力 (n 個)
+ * @param[out] out 出力 (最大 n / m + 1 個; in と同じでもよい)
+ * @param[in] n 入力のサンプル数
+ * @return 出力したサンプル数
+ */
+uint32_t dsp_decim_q15(dsp_decim_q15_t *d, const q15_t *in, q15_t *out, uint32_t n)
+{
+    q15_t *st = d->fir.state;
+    uint16_t nt = d->fir.ntaps;
+    uint16_t pos = d->fir.pos;
+    uint32_t k = 0;
+
+    while (n--) {
+        pos = pos ? pos - 1 : nt - 1;
+        st[pos] = st[pos + nt] = *in++;
+        if (++d->phase == d->m) {
+            d->phase = 0;
+            out[k++] = fir_q15_dot(d->fir.coef, &st[pos], nt);
+        }
+    }
+    d->fir.pos = pos;
+    return k;
+}
+
+/**
+ * @brief 整数の平方根
+ * @param[in] x 値
+ * @return floor(sqrt(x))
+ * @details 1 ビットずつ決める方法。CLZ で x の最上位ビットから始めるので、小さい値ほど速い。
+ */
+uint16_t dsp_isqrt32(uint32_t x)
+{
+    uint32_t r = 0, b;
+
+    if (!x) return 0;
+    b = 1UL << ((31 - __builtin_clz(x)) & ~1);    /* x 以下で最大の 4 のべき */
+    while (b) {
+        if (x >= r + b) {
+            x -= r + b;
+            r = (r >> 1) + b;
+        } else {
+            r >>= 1;
+        }
+        b >>= 2;
+    }
+    return r;
+}
+
+/**
+ * @brief 逆正接 atan2(y, x)
+ * @param[in] y, x 座標 (同じ符号付きの尺度; |値| < 2^16)
+ * @return 角度 (Q15, -32768..32767 が -pi..pi に対応する)
+ * @details 八分円に折り返し、z = min / max (0..1) について
+ *          atan(z) = pi/4 z + z (1 - z) (0.2447 + 0.0663 z) で近似する。最大誤差は約 0.1 度。
+ */
+q15_t dsp_atan2_q15(int32_t y, int32_t x)
+{
+    uint32_t ax = (x < 0) ? -x : x;
+    uint32_t ay = (y < 0) ? -y : y;
+    uint32_t mn, mx;
+    int32_t z, a;
+
+    if (!ax && !ay) return 0;
+    if (ay > ax) {
+        mn = ax;
+        mx = ay;
+    } else {
+        mn = ay;
+        mx = ax;
+    }
+    z = (mn << 15) / mx;
+    a = ((z * 8192) >> 15) + (((((uint32_t)z * (32768 - z)) >> 15) * (2552 + ((692 * z) >> 15))) >> 15);
+    if (ay > ax) a = 16384 - a;
+    if (x < 0) a = 32768 - a;
+    if (y < 0) a = -a;
+    return (q15_t)a;
+}
+
+/**
+ * @brief FIR の積和 (Q15, 32 ビット累算, 4 タップずつ展開)
+ * @param[in] h 係数
+ * @param[in] x 入力 (最新から古い順)
+ * @param[in] n タップ数
+ * @return 出力
+ */
+static inline q15_t fir_q15_dot(const q15_t *h, const q15_t *x, uint16_t n)
+{
+    int32_t acc = 1 << 14;             /* 丸め */
+    uint16_t k;
+
+    for (k = n >> 2; k; k--) {
+        acc += h[0] * x[0];
+        acc += h[1] * x[1];
+        acc += h[2] * x[2];
+        acc += h[3] * x[3];
+        h += 4;
+        x += 4;
+    }
+    for (k = n & 3; k; k--) {
+        acc += *h++ * *x++;
+    }
+    return dsp_ssat(acc >> 15, 16);
+}
+
+/**
+ * @brief FIR の積和 (Q31, 64 ビット累算, 4 タップずつ展開)
+ * @param[in] h 係数
+ * @param[in] x 入力 (最新から古い順)
+ * @param[in] n タップ数
+ * @return 出力
+ */
+static inline q31_t fir_q31_dot(const q31_t *h, const q31_t *x, uint16_t n)
+{
+    int64_t acc = 1 << 30;             /* 丸め */
+    uint16_t k;
+
+    for (k = n >> 2; k; k--) {
+        acc = dsp_smlal(acc, h[0], x[0]);
+        acc = dsp_smlal(acc, h[1], x[1]);
+        acc = dsp_smlal(acc, h[2], x[2]);
+        acc = dsp_smlal(acc, h[3], x[3]);
+        h += 4;
+        x += 4;
+    }
+    for (k = n & 3; k; k--) {
+        acc = dsp_smlal(acc, *h++, *x++);
+    }
+    return sat32(acc >> 31);
+}
+
+/**
+ * @brief 64 ビットの値を 32 ビットに飽和させる
+ * @param[in] v 値
+ * @return 飽和させた値
+ */
+static inline int32_t sat32(int64_t v)
+{
+    if (v > 0x7FFFFFFF) return 0x7FFFFFFF;
+    if (v < -0x7FFFFFFF - 1) return -0x7FFFFFFF - 1;
+    return (int32_t)v;
+}
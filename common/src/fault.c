@@ -0,0 +1,121 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file fault.c
+ * @brief フォルト/想定外割込み発生時のクラッシュレコード採取
+ */
+
+#include "system.h"
+#include "fault.h"
+
+#define FRAME_WORDS 8    /* ハードウェアがスタックする例外フレームのワード数 (r0-r3, r12, lr, pc, xpsr) */
+
+fault_record_t g_fault_record __noinit;    /* デバッガ/ツールから参照するので static にしない */
+
+static inline uint8_t in_sram(const uint32_t *p, uint32_t nwords);
+
+/**
+ * @brief フォルト関連の例外を有効にする
+ * @return なし
+ * @note MemManage/BusFault/UsageFault を個別に許可しておくと、HardFault に
+ *       エスカレートせずに要因別の例外番号がレコードに残る。
+ */
+void fault_init(void)
+{
+    reg_write(SCB(SHCSR), reg_read(SCB(SHCSR)) | SHCSR_MEMFAULTENA | SHCSR_BUSFAULTENA | SHCSR_USGFAULTENA);
+    reg_write(SCB(CCR), reg_read(SCB(CCR)) | CCR_DIV_0_TRP);
+}
+
+/**
+ * @brief 直前のリセット前に採取されたクラッシュレコードを返す
+ * @return クラッシュレコード, 無ければ 0
+ */
+const fault_record_t *fault_record(void)
+{
+    if (!sys_warm_start() || g_fault_record.magic != FAULT_MAGIC) return 0;
+    return &g_fault_record;
+}
+
+/**
+ * @brief クラッシュレコードを消去する
+ * @return なし
+ */
+void fault_clear(void)
+{
+    g_fault_record.magic = 0;
+}
+
+/**
+ * @brief クラッシュレコードを採取してリセットする
+ * @param[in] frame ハードウェアがスタックした例外フレーム
+ * @param[in] r4_r11 ハンドラ入口で退避した r4..r11
+ * @param[in] exc_return 例外復帰値 (ハンドラ入口の LR)
+ * @return なし (戻らない)
+ * @note startup.c の ex_handler/irq_handler から分岐してくる。\n
+ *       スタックオーバフローで frame が RAM 外を指していることもあるので、
+ *       読む前に範囲を確認する。
+ */
+void fault_capture(const uint32_t *frame, const uint32_t *r4_r11, uint32_t exc_return)
+{
+    fault_record_t *rec = &g_fault_record;
+    uint32_t ipsr;
+    uint8_t i;
+
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+
+    rec->magic = 0;
+    rec->vector = ipsr & 0x1FF;
+    rec->exc_return = exc_return;
+    rec->sp = (uint32_t)(frame + FRAME_WORDS);
+
+    for (i = 0; i < 8; i++) {
+        rec->r[4 + i] = r4_r11[i];
+    }
+
+    if (in_sram(frame, FRAME_WORDS)) {
+        for (i = 0; i < 4; i++) {
+            rec->r[i] = frame[i];
+        }
+        rec->r[12] = frame[4];
+        rec->lr = frame[5];
+        rec->pc = frame[6];
+        rec->xpsr = frame[7];
+        if (rec->xpsr & (1 << 9)) {
+            rec->sp += 4;    /* 8 バイト境界に揃えるためのパディングが入っている */
+        }
+    } else {
+        for (i = 0; i < 4; i++) {
+            rec->r[i] = 0;
+        }
+        rec->r[12] = rec->lr = rec->pc = rec->xpsr = 0;
+    }
+
+    for (i = 0; i < FAULT_STACK_WORDS; i++) {
+        const uint32_t *p = (const uint32_t *)rec->sp + i;
+        rec->stack[i] = in_sram(p, 1) ? *p : 0;
+    }
+
+    rec->cfsr = reg_read(SCB(CFSR));
+    rec->hfsr = reg_read(SCB(HFSR));
+    rec->mmfar = reg_read(SCB(MMFAR));
+    rec->bfar = reg_read(SCB(BFAR));
+    rec->magic = FAULT_MAGIC;
+
+    /* デバッガ接続中はその場で止め、そうでなければリセットして復帰する */
+    if (reg_read(DCB(DHCSR)) & DHCSR_C_DEBUGEN) {
+        __asm volatile ("bkpt #0");
+    }
+    sys_reset();
+}
+
+/**
+ * @brief p から nwords ワードが SRAM に収まっているかを判定する
+ * @param[in] p 先頭アドレス
+ * @param[in] nwords ワード数
+ * @return !0: 是, 0: 否
+ */
+static inline uint8_t in_sram(const uint32_t *p, uint32_t nwords)
+{
+    uint32_t a = (uint32_t)p;
+    return ((a & 3) == 0) && (SRAM_BASE <= a) && (a + (nwords << 2) <= SRAM_BASE + SRAM_SIZE);
+}
@@ -7,6 +7,7 @@
 
 #include "lpc1343.h"
 #include "gpio.h"
+#include "clkgate.h"
 
 #define NUM_PORT 4
 
@@ -16,7 +17,7 @@
  */
 void gpio_init(void)
 {
-    reg_set_bit(SYSCON(SYSAHBCLKCTRL), 6);
+    clkgate_acquire(CLKGATE_GPIO);
 
     nvic_enable_irq(IRQ_PIO0);
     nvic_enable_irq(IRQ_PIO1);
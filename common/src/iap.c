@@ -0,0 +1,109 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file iap.c
+ * @brief ROM の In-Application Programming (IAP) ルーチンの呼び出し
+ */
+
+#include "system.h"
+#include "iap.h"
+
+typedef void (* iap_entry_t)(uint32_t *cmd, uint32_t *res);
+
+static uint32_t call(uint32_t *cmd, uint32_t *res);
+
+/**
+ * @brief セクタを消去する
+ * @param[in] start 先頭のセクタ番号
+ * @param[in] end 最後のセクタ番号 (start 以上)
+ * @return ステータスコード (IAP_CMD_SUCCESS なら成功)
+ */
+uint32_t iap_erase(uint32_t start, uint32_t end)
+{
+    uint32_t cmd[5];
+    uint32_t res[4];
+
+    cmd[0] = IAP_PREPARE;
+    cmd[1] = start;
+    cmd[2] = end;
+    if (call(cmd, res) != IAP_CMD_SUCCESS) return res[0];
+
+    cmd[0] = IAP_ERASE;
+    cmd[1] = start;
+    cmd[2] = end;
+    cmd[3] = sys_clock() / 1000;
+    return call(cmd, res);
+}
+
+/**
+ * @brief RAM の内容をフラッシュに書き込む
+ * @param[in] dst 書き込み先 (IAP_PAGE_SIZE の境界, 1 つのセクタに収まること)
+ * @param[in] src 書き込むデータ (RAM 上, ワード境界)
+ * @param[in] n バイト数 (256, 512, 1024, 4096 のいずれか)
+ * @return ステータスコード (IAP_CMD_SUCCESS なら成功)
+ * @note 書き込みは 0 のビットを増やすことしかできない。消去済みでない場所に書くときは、
+ *       変えないバイトに現在の内容 (または 0xFF) を入れておくこと。
+ */
+uint32_t iap_write(uint32_t dst, const uint32_t *src, uint32_t n)
+{
+    uint32_t cmd[5];
+    uint32_t res[4];
+    uint32_t sector = dst / IAP_SECTOR_SIZE;
+
+    cmd[0] = IAP_PREPARE;
+    cmd[1] = sector;
+    cmd[2] = sector;
+    if (call(cmd, res) != IAP_CMD_SUCCESS) return res[0];
+
+    cmd[0] = IAP_COPY;
+    cmd[1] = dst;
+    cmd[2] = (uint32_t)src;
+    cmd[3] = n;
+    cmd[4] = sys_clock() / 1000;
+    return call(cmd, res);
+}
+
+/**
+ * @brief セクタが消去済みかを調べる
+ * @param[in] start 先頭のセクタ番号
+ * @param[in] end 最後のセクタ番号
+ * @return IAP_CMD_SUCCESS: 消去済み, IAP_SECTOR_NOT_BLANK: 消去されていない
+ */
+uint32_t iap_blank_check(uint32_t start, uint32_t end)
+{
+    uint32_t cmd[5];
+    uint32_t res[4];
+
+    cmd[0] = IAP_BLANK_CHECK;
+    cmd[1] = start;
+    cmd[2] = end;
+    return call(cmd, res);
+}
+
+/**
+ * @brief パーツ ID を読み出す
+ * @return パーツ ID (LPC1343 は 0x3D00002B)
+ */
+uint32_t iap_part_id(void)
+{
+    uint32_t cmd[5];
+    uint32_t res[4];
+
+    cmd[0] = IAP_PART_ID;
+    call(cmd, res);
+    return res[1];
+}
+
+/**
+ * @brief 割込みを禁止して IAP を呼ぶ
+ * @param[in] cmd コマンドとパラメータ
+ * @param[out] res ステータスコードと結果
+ * @return ステータスコード
+ */
+static uint32_t call(uint32_t *cmd, uint32_t *res)
+{
+    uint32_t v = irq_save();
+    ((iap_entry_t)IAP_ENTRY)(cmd, res);
+    irq_restore(v);
+    return res[0];
+}
@@ -0,0 +1,49 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file initseq.c
+ * @brief レジスタの初期化シーケンスのインタプリタ
+ */
+
+#include "initseq.h"
+
+/**
+ * @brief 初期化の手順を順に実行する
+ * @param[in] seq 手順の配列
+ * @param[in] n 手順の数
+ * @return なし
+ * @note .data/.bss の初期化より前 (sys_init()) にも呼ばれるので、スタック以外の RAM を使わない。
+ */
+void initseq_run(const initseq_t *seq, uint32_t n)
+{
+    uint32_t mask = 0;
+
+    for (; n > 0; n--, seq++) {
+        volatile uint32_t *reg = (volatile uint32_t *)(seq->op & ~INITSEQ_OP_Msk);
+        uint32_t v = seq->val;
+
+        switch (seq->op & INITSEQ_OP_Msk) {
+        case INITSEQ_OP_WRITE:
+            if (reg) {
+                *reg = v;
+            } else {
+                for (; v > 0; v--) { __asm volatile ("nop"); }
+            }
+            break;
+        case INITSEQ_OP_SET:
+            *reg = (*reg & ~mask) | v;
+            mask = 0;
+            break;
+        case INITSEQ_OP_CLR:
+            if (reg) {
+                *reg &= ~v;
+            } else {
+                mask = v;
+            }
+            break;
+        default:
+            while ((*reg & v) != v);
+            break;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file isrtrace.c
+ * @brief 割込みの出入りのトレース
+ */
+
+#include "system.h"
+#include "isrtrace.h"
+
+#define BUF_MASK (ISRTRACE_WORDS - 1)
+
+#if (ISRTRACE_WORDS & BUF_MASK)
+  #error "ISRTRACE_WORDS must be a power of 2."
+#endif
+
+extern void irq_handler(void);
+
+isrtrace_t g_isrtrace;
+
+static uint32_t s_epoch;                /* 最後に書いた CYCCNT の上位 8 ビット */
+
+static void wrap(void);
+static inline void put(uint32_t kind);
+static void clock_changed(uint32_t hz);
+
+/**
+ * @brief 記録を始める
+ * @return 0: 成功, -1: DWT がない
+ * @note 記録中に呼ぶと、その後に登録されたハンドラも記録の対象にする。バッファはそのまま。
+ */
+int8_t isrtrace_start(void)
+{
+    uint32_t vec;
+    vector_entry h;
+
+    if (!dwt_cyccnt_start()) return -1;
+
+    if (g_isrtrace.magic != ISRTRACE_MAGIC) {
+        g_isrtrace.size = ISRTRACE_WORDS;
+        g_isrtrace.wr = 0;
+        g_isrtrace.hz = sys_clock();
+        s_epoch = 0xFFFFFFFF;           /* 最初のレコードの前に上位ビットを書かせる */
+        sys_clock_hook(clock_changed);
+        vector_add_wrapper(wrap);
+        g_isrtrace.magic = ISRTRACE_MAGIC;
+    }
+
+    for (vec = 16 + EX_SYSTICK; vec < NUM_VECTORS; vec++) {
+        h = vector_get((irq_t)(vec - 16));
+        if (h == wrap || h == irq_handler) continue;
+        if (g_isrtrace.handler[vec] && vector_is_wrapper(h)) continue;    /* こちらを包んだ他の計測用の関数 */
+
+        g_isrtrace.handler[vec] = h;
+        vector_install((irq_t)(vec - 16), wrap);
+    }
+    g_isrtrace.run = 1;
+    return 0;
+}
+
+/**
+ * @brief 記録を止める (ハンドラは差し替えたまま)
+ * @return なし
+ * @note 吸い出す間にバッファが上書きされないように止めておく。isrtrace_start() で再開する。
+ */
+void isrtrace_stop(void)
+{
+    g_isrtrace.run = 0;
+}
+
+/**
+ * @brief 記録用の割込みハンドラ
+ * @return なし
+ * @details IPSR から例外番号を読んで元のハンドラを呼ぶ。通常の関数なので LR (EXC_RETURN) は
+ *          スタックに退避され、最後の pop {..., pc} で例外から戻る。
+ */
+static void wrap(void)
+{
+    uint32_t vec;
+
+    __asm volatile ("mrs %0, ipsr" : "=r" (vec));
+    vec &= 0x1FF;
+
+    if (g_isrtrace.run) put(vec);
+    g_isrtrace.handler[vec]();
+    if (g_isrtrace.run) put(vec | ISRTRACE_EXIT);
+}
+
+/**
+ * @brief レコードを 1 つ書く
+ * @param[in] kind 例外番号 (| ISRTRACE_EXIT)
+ * @return なし
+ * @note 時刻の読み出しから書き込みまでを割込み禁止にして、バッファ上の順序と時刻の順序を揃える。
+ */
+static inline __attribute__ ((always_inline)) void put(uint32_t kind)
+{
+    uint32_t v = irq_save();
+    uint32_t t = dwt_cyccnt();
+    uint32_t wr = g_isrtrace.wr;
+
+    if ((t >> 24) != s_epoch) {
+        s_epoch = t >> 24;
+        g_isrtrace.buf[wr++ & BUF_MASK] = (s_epoch << 8) | ISRTRACE_EPOCH;
+    }
+    g_isrtrace.buf[wr++ & BUF_MASK] = (t << 8) | kind;
+    g_isrtrace.wr = wr;
+    irq_restore(v);
+}
+
+/**
+ * @brief システムクロックの周波数が変わったら時刻の換算に使う値を更新する (sys_clock_hook())
+ * @return なし
+ * @note バッファに残っている変更前のレコードも新しい周波数で換算される。
+ */
+static void clock_changed(uint32_t hz)
+{
+    g_isrtrace.hz = hz;
+}
@@ -0,0 +1,763 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file kernel.c
+ * @brief 固定優先度のプリエンプティブなタスクカーネル
+ * @details カーネルのデータ (実行可能リスト, 待ち行列, タイマリスト) を触るのは
+ *          KERN_IRQ_PRIO で動く SVCall/SysTick と、crit_enter(KERN_IRQ_PRIO) の中だけ。
+ *          PendSV は最低の優先度で動き、コンテキストの退避/復帰と次のタスクの選択だけを行う。
+ */
+
+#include "system.h"
+#include "vector.h"
+#include "stack.h"
+#include "kernel.h"
+
+#define IDLE_PRIO   KERN_NPRIO          /* アイドルタスクの優先度 (タスクより低い) */
+#define FRAME_WORDS 16                  /* 初期フレーム: r4..r11 + ハードウェアが積む 8 ワード */
+#define XPSR_T      (1 << 24)           /* Thumb ステート */
+#define PENDING     (-128)              /* 待ちに入った (戻り値は起こすときに書く) */
+
+#define __STR(x) #x
+#define STR(x)   __STR(x)
+
+/* SVC 番号 */
+#define SVC_START      0
+#define SVC_YIELD      1
+#define SVC_DELAY      2
+#define SVC_SEM_WAIT   3
+#define SVC_QUEUE_SEND 4
+#define SVC_QUEUE_RECV 5
+#define SVC_EXIT       6
+
+/**
+ * @def SVC(n, a0, a1, a2)
+ * SVC 命令でカーネルに入る。引数は r0..r2 で渡し、戻り値は積まれたフレームの r0 で返る。
+ */
+#define SVC(n, a0, a1, a2) __extension__ ({ \
+    register uint32_t __r0 __asm ("r0") = (uint32_t)(a0); \
+    register uint32_t __r1 __asm ("r1") = (uint32_t)(a1); \
+    register uint32_t __r2 __asm ("r2") = (uint32_t)(a2); \
+    __asm volatile ("svc %1" : "+r" (__r0) : "I" (n), "r" (__r1), "r" (__r2) : "memory"); \
+    (int32_t)__r0; })
+
+extern uint32_t _main_sp;
+
+volatile kern_stat_t g_kern_stat;
+
+static kern_task_t *s_cur;                          /* 実行中のタスク */
+static kern_task_t *s_ready[IDLE_PRIO + 1];         /* 優先度ごとの実行可能リスト (先頭が実行中/次に実行) */
+static kern_task_t *s_ready_tail[IDLE_PRIO + 1];
+static uint32_t s_ready_map;                        /* 実行可能なタスクがある優先度のビットマップ */
+static kern_task_t *s_timers;                       /* タイムアウトの早い順 */
+static kern_task_t s_idle;
+static uint32_t s_idle_stack[KERN_IDLE_WORDS] __attribute__ ((aligned(8)));
+static void (* volatile s_idle_fn)(void);   /* アイドルタスクが呼ぶ関数 (なければ WFI) */
+
+uint32_t *kern_switch(uint32_t *sp, uint32_t t0);
+uint32_t *kern_svc(uint32_t *frame);
+static void pendsv_entry(void) __attribute__ ((naked));
+static void svcall_entry(void) __attribute__ ((naked));
+static void tick(void);
+static void clock_changed(uint32_t hz);
+static void idle(void *arg);
+static void task_init(kern_task_t *t, void (*entry)(void *), void *arg,
+                      uint32_t *stack, uint32_t words, uint8_t prio, const char *name);
+static int32_t sem_wait(kern_sem_t *sem, uint32_t timeout, uint32_t *frame);
+static int32_t queue_send(kern_queue_t *q, const void *item, uint32_t timeout, uint32_t *frame);
+static int32_t queue_recv(kern_queue_t *q, void *item, uint32_t timeout, uint32_t *frame);
+static void ready_push(kern_task_t *t);
+static void ready_remove(kern_task_t *t);
+static void ready_rotate(uint8_t prio);
+static void wait_insert(kern_wait_t *wq, kern_task_t *t);
+static void wait_remove(kern_wait_t *wq, kern_task_t *t);
+static void timer_insert(kern_task_t *t);
+static void timer_remove(kern_task_t *t);
+static void block(kern_wait_t *wq, uint32_t timeout, uint32_t *frame);
+static void wake(kern_task_t *t, int32_t result);
+static void resched(void);
+static void copy(void *dst, const void *src, uint16_t n);
+static inline uint8_t in_isr(void);
+
+/**
+ * @brief タスクを生成して実行可能にする
+ * @param[out] t タスク制御ブロック
+ * @param[in] entry タスクの関数 (戻ると kern_exit() したことになる)
+ * @param[in] arg entry に渡す引数
+ * @param[in] stack スタック領域
+ * @param[in] words スタック領域のワード数 (例外フレームとカーネルの退避分 16 ワード + タスクの使用量)
+ * @param[in] prio 優先度 (0..KERN_NPRIO - 1, 0 が最高)
+ * @param[in] name 名前 (デバッグ用)
+ * @return 0: 成功, -1: 引数が不正
+ * @note kern_start() の前でも、タスクからでも呼べる。
+ */
+int8_t kern_task_create(kern_task_t *t, void (*entry)(void *), void *arg,
+                        uint32_t *stack, uint32_t words, uint8_t prio, const char *name)
+{
+    if (prio >= KERN_NPRIO || words < FRAME_WORDS + 8) return -1;
+
+    task_init(t, entry, arg, stack, words, prio, name);
+
+    crit_t c = crit_enter(KERN_IRQ_PRIO);
+    ready_push(t);
+    resched();
+    crit_exit(c);
+    return 0;
+}
+
+/**
+ * @brief カーネルを起動し、最も優先度の高いタスクに切り替える
+ * @return なし (戻らない)
+ * @note main() から、タスクを 1 つ以上生成してから呼ぶ。main() のスタックは捨て、
+ *       以後メインスタック (MSP) は割込み専用になる。SysTick はカーネルが使う。
+ */
+void kern_start(void)
+{
+    task_init(&s_idle, idle, 0, s_idle_stack, KERN_IDLE_WORDS, IDLE_PRIO, "idle");
+    ready_push(&s_idle);
+
+    nvic_set_priority(EX_SVCALL, KERN_IRQ_PRIO);
+    nvic_set_priority(EX_SYSTICK, KERN_IRQ_PRIO);
+    nvic_set_priority(EX_PENDSV, (1 << __NVIC_PRIO_BITS) - 1);
+    vector_install(EX_SVCALL, svcall_entry);
+    vector_install(EX_PENDSV, pendsv_entry);
+    vector_install(EX_SYSTICK, tick);
+
+    dwt_cyccnt_start();
+    g_kern_stat.sw_min = 0xFFFFFFFF;
+
+    reg_write(SYST(RVR), sys_clock() / KERN_TICK_HZ - 1);
+    sys_clock_hook(clock_changed);
+    reg_write(SYST(CVR), 0);
+    reg_write(SYST(CSR), SYST_CSR_CLKSOURCE | SYST_CSR_TICKINT | SYST_CSR_ENABLE);
+
+    s_cur = s_ready[__builtin_ctz(s_ready_map)];
+
+    /* MSP をスタックの先頭に戻してから最初のタスクへ */
+    __asm volatile (
+        "msr    msp, %0         \n"
+        "isb                    \n"
+        "cpsie  i               \n"
+        "svc    %1              \n"
+        :: "r" (&_main_sp), "I" (SVC_START) : "memory");
+    while (1);
+}
+
+/**
+ * @brief 実行中のタスクを返す
+ * @return タスク制御ブロック
+ */
+kern_task_t *kern_self(void)
+{
+    return s_cur;
+}
+
+/**
+ * @brief 起動からのティック数を返す
+ * @return ティック数
+ */
+uint32_t kern_ticks(void)
+{
+    return g_kern_stat.ticks;
+}
+
+/**
+ * @brief タスクのスタックの最小の空き (これまでに一度も使われていない量) を返す
+ * @param[in] t タスク
+ * @return バイト数
+ */
+uint32_t kern_stack_free(const kern_task_t *t)
+{
+    uint32_t i = 0;
+
+    while (i < t->words && t->stack[i] == STACK_PAINT) i++;
+    return i * 4;
+}
+
+/**
+ * @brief アイドルタスクが WFI の代わりに繰り返し呼ぶ関数を登録する
+ * @param[in] fn 関数 (0 なら WFI に戻す)。ブロックする操作は呼べない
+ * @return なし
+ * @note CPU 負荷の計測 (cpuload.h) では kern_idle_hook(cpuload_idle) とする。
+ */
+void kern_idle_hook(void (*fn)(void))
+{
+    s_idle_fn = fn;
+}
+
+/**
+ * @brief 同じ優先度の次のタスクに実行を譲る
+ * @return なし
+ */
+void kern_yield(void)
+{
+    SVC(SVC_YIELD, 0, 0, 0);
+}
+
+/**
+ * @brief 指定したティック数だけ待つ
+ * @param[in] ticks ティック数 (0 なら kern_yield() と同じ)
+ * @return なし
+ */
+void kern_delay(uint32_t ticks)
+{
+    if (ticks == 0) {
+        kern_yield();
+    } else {
+        SVC(SVC_DELAY, ticks, 0, 0);
+    }
+}
+
+/**
+ * @brief 実行中のタスクを終了する
+ * @return なし (戻らない)
+ */
+void kern_exit(void)
+{
+    SVC(SVC_EXIT, 0, 0, 0);
+    while (1);
+}
+
+/**
+ * @brief セマフォを初期化する
+ * @param[out] sem セマフォ
+ * @param[in] count 初期値
+ * @return なし
+ */
+void kern_sem_init(kern_sem_t *sem, uint32_t count)
+{
+    sem->count = count;
+    sem->waiters.head = 0;
+}
+
+/**
+ * @brief セマフォを獲得する
+ * @param[in] sem セマフォ
+ * @param[in] timeout 待つティック数 (0: 待たない, KERN_FOREVER: 無限)
+ * @return KERN_OK: 獲得した, KERN_TIMEOUT: 獲得できなかった
+ * @note 割込みハンドラからは待たずに試すだけになる。
+ */
+int8_t kern_sem_wait(kern_sem_t *sem, uint32_t timeout)
+{
+    if (in_isr()) {
+        crit_t c = crit_enter(KERN_IRQ_PRIO);
+        int32_t r = sem_wait(sem, 0, 0);
+        crit_exit(c);
+        return r;
+    }
+    return SVC(SVC_SEM_WAIT, sem, timeout, 0);
+}
+
+/**
+ * @brief セマフォを返却する (待っているタスクがあれば最も優先度の高いものを起こす)
+ * @param[in] sem セマフォ
+ * @return なし
+ * @note タスクからも割込みハンドラからも呼べる。
+ */
+void kern_sem_post(kern_sem_t *sem)
+{
+    crit_t c = crit_enter(KERN_IRQ_PRIO);
+    if (sem->waiters.head) {
+        wake(sem->waiters.head, KERN_OK);
+    } else {
+        sem->count++;
+    }
+    crit_exit(c);
+}
+
+/**
+ * @brief メッセージキューを初期化する
+ * @param[out] q キュー
+ * @param[in] buf item * len バイトの領域
+ * @param[in] item 要素のバイト数
+ * @param[in] len 要素の数 (1 以上)
+ * @return なし
+ */
+void kern_queue_init(kern_queue_t *q, void *buf, uint16_t item, uint16_t len)
+{
+    q->buf = buf;
+    q->item = item;
+    q->len = len;
+    q->head = 0;
+    q->count = 0;
+    q->senders.head = 0;
+    q->receivers.head = 0;
+}
+
+/**
+ * @brief キューに要素を送る (受信を待っているタスクがあれば直接渡す)
+ * @param[in] q キュー
+ * @param[in] item 要素
+ * @param[in] timeout 満杯のとき待つティック数 (0: 待たない, KERN_FOREVER: 無限)
+ * @return KERN_OK: 送った, KERN_TIMEOUT: 満杯のままだった
+ * @note 割込みハンドラからは待たずに試すだけになる。
+ */
+int8_t kern_queue_send(kern_queue_t *q, const void *item, uint32_t timeout)
+{
+    if (in_isr()) {
+        crit_t c = crit_enter(KERN_IRQ_PRIO);
+        int32_t r = queue_send(q, item, 0, 0);
+        crit_exit(c);
+        return r;
+    }
+    return SVC(SVC_QUEUE_SEND, q, item, timeout);
+}
+
+/**
+ * @brief キューから要素を受け取る
+ * @param[in] q キュー
+ * @param[out] item 要素の格納先
+ * @param[in] timeout 空のとき待つティック数 (0: 待たない, KERN_FOREVER: 無限)
+ * @return KERN_OK: 受け取った, KERN_TIMEOUT: 空のままだった
+ * @note 割込みハンドラからは待たずに試すだけになる。
+ */
+int8_t kern_queue_recv(kern_queue_t *q, void *item, uint32_t timeout)
+{
+    if (in_isr()) {
+        crit_t c = crit_enter(KERN_IRQ_PRIO);
+        int32_t r = queue_recv(q, item, 0, 0);
+        crit_exit(c);
+        return r;
+    }
+    return SVC(SVC_QUEUE_RECV, q, item, timeout);
+}
+
+/**
+ * @brief 次に実行するタスクを選ぶ (PendSV から呼ばれる)
+ * @param[in] sp 実行中だったタスクの PSP (r4..r11 を積んだ後)
+ * @param[in] t0 PendSV の入口で読んだ CYCCNT
+ * @return 次のタスクの PSP
+ */
+uint32_t *kern_switch(uint32_t *sp, uint32_t t0)
+{
+    crit_t c = crit_enter(KERN_IRQ_PRIO);
+    s_cur->sp = sp;
+    s_cur = s_ready[__builtin_ctz(s_ready_map)];
+    crit_exit(c);
+
+    uint32_t cycles = dwt_cyccnt() - t0;
+    g_kern_stat.switches++;
+    g_kern_stat.sw_last = cycles;
+    if (cycles < g_kern_stat.sw_min) g_kern_stat.sw_min = cycles;
+    if (cycles > g_kern_stat.sw_max) g_kern_stat.sw_max = cycles;
+    return s_cur->sp;
+}
+
+/**
+ * @brief SVC の処理 (SVCall から呼ばれる)
+ * @param[in] frame SVC 命令を実行したときに積まれた例外フレーム
+ * @return 最初のタスクの PSP (SVC_START のとき), それ以外は 0
+ */
+uint32_t *kern_svc(uint32_t *frame)
+{
+    uint8_t n = ((const uint8_t *)frame[6])[-2];        /* SVC 命令の即値 */
+    int32_t r = KERN_OK;
+
+    switch (n) {
+    case SVC_START:
+        return s_cur->sp;
+    case SVC_YIELD:
+        ready_rotate(s_cur->prio);
+        resched();
+        break;
+    case SVC_DELAY:
+        block(0, frame[0], frame);
+        r = PENDING;
+        break;
+    case SVC_SEM_WAIT:
+        r = sem_wait((kern_sem_t *)frame[0], frame[1], frame);
+        break;
+    case SVC_QUEUE_SEND:
+        r = queue_send((kern_queue_t *)frame[0], (const void *)frame[1], frame[2], frame);
+        break;
+    case SVC_QUEUE_RECV:
+        r = queue_recv((kern_queue_t *)frame[0], (void *)frame[1], frame[2], frame);
+        break;
+    case SVC_EXIT:
+        ready_remove(s_cur);
+        s_cur->state = KERN_DORMANT;
+        resched();
+        r = PENDING;
+        break;
+    }
+
+    if (r != PENDING) frame[0] = r;
+    return 0;
+}
+
+/**
+ * @brief PendSV ハンドラ (コンテキストスイッチ)
+ * @return なし
+ * @details r4..r11 を PSP に積み、kern_switch() で次のタスクを選んで、その r4..r11 を戻す。
+ *          残りのレジスタは例外の出入りでハードウェアが退避/復帰する。
+ */
+static void pendsv_entry(void)
+{
+    __asm volatile (
+        "movw   r3, #:lower16:" STR(DWT(CYCCNT)) "\n"
+        "movt   r3, #:upper16:" STR(DWT(CYCCNT)) "\n"
+        "ldr    r1, [r3]        \n"
+        "mrs    r0, psp         \n"
+        "stmdb  r0!, {r4-r11}   \n"
+        "push   {r3, lr}        \n"
+        "bl     kern_switch     \n"
+        "pop    {r3, lr}        \n"
+        "ldmia  r0!, {r4-r11}   \n"
+        "msr    psp, r0         \n"
+        "bx     lr              \n"
+    );
+}
+
+/**
+ * @brief SVCall ハンドラ
+ * @return なし
+ * @details 例外フレームを積んだスタック (MSP/PSP) を EXC_RETURN のビット 2 で選んで kern_svc() に渡す。
+ *          kern_svc() が PSP を返したら (起動時), そのタスクの r4..r11 を戻してスレッドモード/PSP で復帰する。
+ */
+static void svcall_entry(void)
+{
+    __asm volatile (
+        "tst    lr, #4          \n"
+        "ite    eq              \n"
+        "mrseq  r0, msp         \n"
+        "mrsne  r0, psp         \n"
+        "push   {r4, lr}        \n"
+        "bl     kern_svc        \n"
+        "pop    {r4, lr}        \n"
+        "cbz    r0, 1f          \n"
+        "ldmia  r0!, {r4-r11}   \n"
+        "msr    psp, r0         \n"
+        "mvn    lr, #2          \n"     /* EXC_RETURN = 0xFFFFFFFD */
+        "1:                     \n"
+        "bx     lr              \n"
+    );
+}
+
+/**
+ * @brief SysTick ハンドラ (ティック)
+ * @return なし
+ * @details タイムアウトしたタスクを起こし、同じ優先度のタスクを順に回す。
+ */
+static void tick(void)
+{
+    uint32_t now = ++g_kern_stat.ticks;
+
+    while (s_timers && (int32_t)(now - s_timers->wake) >= 0) {
+        kern_task_t *t = s_timers;
+        wake(t, t->wq ? KERN_TIMEOUT : KERN_OK);
+    }
+    if (s_cur->state == KERN_READY) ready_rotate(s_cur->prio);
+    resched();
+}
+
+/**
+ * @brief システムクロックの周波数が変わったらティックの周期を合わせ直す (sys_clock_hook())
+ * @return なし
+ * @note 次の再ロードから効く。
+ */
+static void clock_changed(uint32_t hz)
+{
+    reg_write(SYST(RVR), hz / KERN_TICK_HZ - 1);
+}
+
+/**
+ * @brief アイドルタスク
+ * @param[in] arg 未使用
+ * @return なし
+ */
+static void idle(void *arg)
+{
+    while (1) {
+        if (s_idle_fn) {
+            s_idle_fn();
+        } else {
+            __asm volatile ("wfi");
+        }
+    }
+}
+
+/**
+ * @brief タスク制御ブロックとスタックを初期化する
+ * @return なし
+ * @details スタックを STACK_PAINT で塗り (kern_stack_free() 用), 先頭に例外から復帰した
+ *          ときと同じ形のフレームを作る。PC = entry, r0 = arg, LR = kern_exit。
+ */
+static void task_init(kern_task_t *t, void (*entry)(void *), void *arg,
+                      uint32_t *stack, uint32_t words, uint8_t prio, const char *name)
+{
+    uint32_t i;
+    uint32_t *sp = (uint32_t *)((uint32_t)(stack + words) & ~7);
+
+    for (i = 0; i < words; i++) {
+        stack[i] = STACK_PAINT;
+    }
+    sp -= FRAME_WORDS;
+    for (i = 0; i < FRAME_WORDS; i++) {
+        sp[i] = 0;
+    }
+    sp[8] = (uint32_t)arg;                              /* r0 */
+    sp[13] = (uint32_t)kern_exit;                       /* lr */
+    sp[14] = (uint32_t)entry & ~1;                      /* pc */
+    sp[15] = XPSR_T;                                    /* xpsr */
+
+    t->sp = sp;
+    t->next = 0;
+    t->tnext = 0;
+    t->wq = 0;
+    t->frame = 0;
+    t->msg = 0;
+    t->stack = stack;
+    t->words = words;
+    t->name = name;
+    t->prio = prio;
+    t->state = KERN_DORMANT;
+}
+
+/**
+ * @brief セマフォを獲得する (カーネル内部)
+ * @param[in] frame 待ちに入るときの例外フレーム (0 なら待たない)
+ * @return KERN_OK, KERN_TIMEOUT, PENDING (待ちに入った)
+ */
+static int32_t sem_wait(kern_sem_t *sem, uint32_t timeout, uint32_t *frame)
+{
+    if (sem->count > 0) {
+        sem->count--;
+        return KERN_OK;
+    }
+    if (timeout == 0 || !frame) return KERN_TIMEOUT;
+    block(&sem->waiters, timeout, frame);
+    return PENDING;
+}
+
+/**
+ * @brief キューに送る (カーネル内部)
+ * @param[in] frame 待ちに入るときの例外フレーム (0 なら待たない)
+ * @return KERN_OK, KERN_TIMEOUT, PENDING (待ちに入った)
+ */
+static int32_t queue_send(kern_queue_t *q, const void *item, uint32_t timeout, uint32_t *frame)
+{
+    kern_task_t *r = q->receivers.head;
+
+    if (r) {
+        copy(r->msg, item, q->item);
+        wake(r, KERN_OK);
+        return KERN_OK;
+    }
+    if (q->count < q->len) {
+        copy(q->buf + ((q->head + q->count) % q->len) * q->item, item, q->item);
+        q->count++;
+        return KERN_OK;
+    }
+    if (timeout == 0 || !frame) return KERN_TIMEOUT;
+    s_cur->msg = (void *)item;
+    block(&q->senders, timeout, frame);
+    return PENDING;
+}
+
+/**
+ * @brief キューから受け取る (カーネル内部)
+ * @param[in] frame 待ちに入るときの例外フレーム (0 なら待たない)
+ * @return KERN_OK, KERN_TIMEOUT, PENDING (待ちに入った)
+ */
+static int32_t queue_recv(kern_queue_t *q, void *item, uint32_t timeout, uint32_t *frame)
+{
+    if (q->count > 0) {
+        copy(item, q->buf + q->head * q->item, q->item);
+        q->head = (q->head + 1) % q->len;
+        q->count--;
+
+        /* 満杯で待っていた送信側の要素を 1 つ入れる */
+        kern_task_t *s = q->senders.head;
+        if (s) {
+            copy(q->buf + ((q->head + q->count) % q->len) * q->item, s->msg, q->item);
+            q->count++;
+            wake(s, KERN_OK);
+        }
+        return KERN_OK;
+    }
+    if (timeout == 0 || !frame) return KERN_TIMEOUT;
+    s_cur->msg = item;
+    block(&q->receivers, timeout, frame);
+    return PENDING;
+}
+
+/**
+ * @brief タスクを実行可能リストの末尾に入れる
+ * @return なし
+ */
+static void ready_push(kern_task_t *t)
+{
+    uint8_t p = t->prio;
+
+    t->next = 0;
+    t->state = KERN_READY;
+    if (s_ready[p]) {
+        s_ready_tail[p]->next = t;
+    } else {
+        s_ready[p] = t;
+    }
+    s_ready_tail[p] = t;
+    s_ready_map |= 1 << p;
+}
+
+/**
+ * @brief タスクを実行可能リストから外す
+ * @return なし
+ */
+static void ready_remove(kern_task_t *t)
+{
+    uint8_t p = t->prio;
+    kern_task_t **pp = &s_ready[p];
+    kern_task_t *prev = 0;
+
+    while (*pp && *pp != t) {
+        prev = *pp;
+        pp = &(*pp)->next;
+    }
+    if (!*pp) return;
+    *pp = t->next;
+    if (s_ready_tail[p] == t) s_ready_tail[p] = prev;
+    if (!s_ready[p]) s_ready_map &= ~(1 << p);
+    t->next = 0;
+}
+
+/**
+ * @brief 優先度 prio の実行可能リストの先頭を末尾に回す
+ * @return なし
+ */
+static void ready_rotate(uint8_t prio)
+{
+    kern_task_t *t = s_ready[prio];
+
+    if (!t || !t->next) return;
+    s_ready[prio] = t->next;
+    t->next = 0;
+    s_ready_tail[prio]->next = t;
+    s_ready_tail[prio] = t;
+}
+
+/**
+ * @brief 待ち行列に優先度順で入れる (同じ優先度なら後ろに)
+ * @return なし
+ */
+static void wait_insert(kern_wait_t *wq, kern_task_t *t)
+{
+    kern_task_t **pp = &wq->head;
+
+    while (*pp && (*pp)->prio <= t->prio) pp = &(*pp)->next;
+    t->next = *pp;
+    *pp = t;
+}
+
+/**
+ * @brief 待ち行列から外す
+ * @return なし
+ */
+static void wait_remove(kern_wait_t *wq, kern_task_t *t)
+{
+    kern_task_t **pp = &wq->head;
+
+    while (*pp && *pp != t) pp = &(*pp)->next;
+    if (*pp) *pp = t->next;
+    t->next = 0;
+}
+
+/**
+ * @brief タイマリストにタイムアウトの早い順で入れる
+ * @return なし
+ */
+static void timer_insert(kern_task_t *t)
+{
+    kern_task_t **pp = &s_timers;
+
+    while (*pp && (int32_t)((*pp)->wake - t->wake) <= 0) pp = &(*pp)->tnext;
+    t->tnext = *pp;
+    *pp = t;
+}
+
+/**
+ * @brief タイマリストから外す (入っていなければ何もしない)
+ * @return なし
+ */
+static void timer_remove(kern_task_t *t)
+{
+    kern_task_t **pp = &s_timers;
+
+    while (*pp && *pp != t) pp = &(*pp)->tnext;
+    if (*pp) *pp = t->tnext;
+    t->tnext = 0;
+}
+
+/**
+ * @brief 実行中のタスクを待ちに入れる
+ * @param[in] wq 待ち行列 (0 なら時間待ちだけ)
+ * @param[in] timeout 待つティック数 (KERN_FOREVER なら無限)
+ * @param[in] frame SVC の例外フレーム (起こすときに戻り値を書く)
+ * @return なし
+ */
+static void block(kern_wait_t *wq, uint32_t timeout, uint32_t *frame)
+{
+    kern_task_t *t = s_cur;
+
+    ready_remove(t);
+    t->state = KERN_BLOCKED;
+    t->frame = frame;
+    t->wq = wq;
+    if (wq) wait_insert(wq, t);
+    if (timeout != KERN_FOREVER) {
+        t->wake = g_kern_stat.ticks + timeout;
+        timer_insert(t);
+    }
+    resched();
+}
+
+/**
+ * @brief 待ちのタスクを実行可能にする
+ * @param[in] t タスク
+ * @param[in] result 待ちの操作の戻り値 (SVC のフレームの r0 に書く)
+ * @return なし
+ */
+static void wake(kern_task_t *t, int32_t result)
+{
+    if (t->wq) wait_remove(t->wq, t);
+    t->wq = 0;
+    timer_remove(t);
+    t->frame[0] = result;
+    ready_push(t);
+    resched();
+}
+
+/**
+ * @brief 最も優先度の高いタスクが実行中のタスクでなければ PendSV を保留する
+ * @return なし
+ */
+static void resched(void)
+{
+    if (!s_cur) return;
+    if (s_ready[__builtin_ctz(s_ready_map)] != s_cur) {
+        reg_write(SCB(ICSR), ICSR_PENDSVSET);
+    }
+}
+
+/**
+ * @brief n バイトをコピーする
+ * @return なし
+ */
+static void copy(void *dst, const void *src, uint16_t n)
+{
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    while (n--) *d++ = *s++;
+}
+
+/**
+ * @brief 割込みハンドラの中かを判定する
+ * @return !0: 是, 0: 否
+ */
+static inline uint8_t in_isr(void)
+{
+    uint32_t ipsr;
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return (ipsr & 0x1FF) != 0;
+}
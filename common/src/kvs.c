@@ -0,0 +1,467 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file kvs.c
+ * @brief フラッシュ上のログ構造のキーバリューストア
+ * @details セクタの形式: ヘッダ (KVS_MAGIC, 通し番号) のあとにレコードを隙間なく並べる。
+ *          レコード: キー (16 ビット), 長さ (16 ビット, 0 なら削除), CRC-32, 値 (4 バイト境界まで 0xFF で埋める)。
+ *          セクタはリング状に使い、書き込み中のセクタの次は常に消去済みにしておく。
+ *          したがってリングを head の次から一周すれば、古い順にレコードを読める。
+ */
+
+#include <stdint.h>
+#include "kvs.h"
+
+#define HDR_SIZE 8                                      /* セクタヘッダのバイト数 */
+#define REC_SIZE(len) (sizeof(rec_t) + (((len) + 3) & ~3))
+
+/**
+ * レコードのヘッダ
+ */
+typedef struct rec {
+    uint16_t key;
+    uint16_t len;
+    uint32_t crc;                                       /* キー, 長さ, 値の CRC-32 */
+} rec_t;
+
+static int8_t put(kvs_t *kv, uint16_t key, const void *val, uint16_t len);
+static int8_t append(kvs_t *kv, uint16_t key, const uint8_t *val, uint16_t len);
+static int8_t advance(kvs_t *kv, uint32_t need);
+static int8_t collect(kvs_t *kv, uint8_t s);
+static int8_t move(kvs_t *kv, uint8_t s);
+static uint32_t scan(kvs_t *kv, uint8_t s);
+static uint32_t live(kvs_t *kv, uint8_t s);
+static int8_t put_header(kvs_t *kv, uint8_t s, uint32_t seq);
+static int8_t erase(kvs_t *kv, uint8_t s);
+static int8_t write(kvs_t *kv, uint32_t off, const uint8_t *p, uint32_t n);
+static uint8_t blank(kvs_t *kv, uint8_t s);
+static kvs_entry_t *lookup(kvs_t *kv, uint16_t key, uint8_t create);
+static uint32_t rec_crc(uint16_t key, uint16_t len, const uint8_t *val);
+static uint32_t crc32(uint32_t crc, const uint8_t *p, uint32_t n);
+static void copy(uint8_t *dst, const uint8_t *src, uint32_t n);
+static uint8_t equal(const uint8_t *a, const uint8_t *b, uint32_t n);
+
+/**
+ * @brief フラッシュからストアを読み込む (必要なら初期化する)
+ * @param[out] kv ストア
+ * @param[in] flash フラッシュ
+ * @return 0: 成功, -1: 失敗 (フラッシュの書き込みエラー, 有効なデータが多すぎる)
+ * @details 有効なセクタが 1 つもなければ初期化する。壊れたヘッダのセクタは消去し、
+ *          ガベージコレクションの途中で止まっていたら続きを行う。
+ */
+int8_t kvs_mount(kvs_t *kv, const kvs_flash_t *flash)
+{
+    uint8_t n = flash->nsectors;
+    uint8_t found = 0;
+    uint8_t i, s;
+
+    if (n < 2 || n * flash->sector_size > 0x10000) return -1;     /* 位置は 16 ビットで持つ */
+
+    kv->flash = flash;
+    kv->erases = 0;
+    kv->nkeys = 0;
+    for (i = 0; i < KVS_INDEX_SIZE; i++) kv->index[i].key = KVS_NOKEY;
+
+    /* 書き込み中のセクタ (通し番号が最も新しいもの) を探す */
+    for (s = 0; s < n; s++) {
+        const uint32_t *h = (const uint32_t *)(flash->base + s * flash->sector_size);
+        if (h[0] == KVS_MAGIC) {
+            if (!found || (int32_t)(h[1] - kv->seq) > 0) {
+                kv->head = s;
+                kv->seq = h[1];
+                found = 1;
+            }
+        } else if (!blank(kv, s)) {
+            if (erase(kv, s) < 0) return -1;
+        }
+    }
+    if (!found) return kvs_format(kv);
+
+    /* 古い順に読む (最後が head) */
+    for (i = 1; i <= n; i++) {
+        s = (kv->head + i) % n;
+        if (*(const uint32_t *)(flash->base + s * flash->sector_size) == KVS_MAGIC) {
+            kv->wr = scan(kv, s);
+        }
+    }
+
+    /* head の次が消去済みでなければ、ガベージコレクションの途中だった */
+    return collect(kv, (kv->head + 1) % n);
+}
+
+/**
+ * @brief ストアを空にする (全セクタを消去する)
+ * @param[in] kv ストア (flash を設定してあること)
+ * @return 0: 成功, -1: 失敗
+ */
+int8_t kvs_format(kvs_t *kv)
+{
+    uint8_t i;
+
+    for (i = 0; i < kv->flash->nsectors; i++) {
+        if (!blank(kv, i) && erase(kv, i) < 0) return -1;
+    }
+    kv->nkeys = 0;
+    for (i = 0; i < KVS_INDEX_SIZE; i++) kv->index[i].key = KVS_NOKEY;
+    kv->head = 0;
+    kv->seq = 1;
+    kv->wr = HDR_SIZE;
+    return put_header(kv, 0, kv->seq);
+}
+
+/**
+ * @brief 値を読み出す
+ * @param[in] kv ストア
+ * @param[in] key キー
+ * @param[out] buf 値の格納先
+ * @param[in] size buf のバイト数 (値が長ければ size バイトまで格納する)
+ * @return 値のバイト数, -1: キーがない
+ */
+int16_t kvs_get(kvs_t *kv, uint16_t key, void *buf, uint16_t size)
+{
+    kvs_entry_t *e = lookup(kv, key, 0);
+
+    if (!e || !e->off) return -1;
+
+    const rec_t *r = (const rec_t *)(kv->flash->base + e->off);
+    copy(buf, (const uint8_t *)(r + 1), (r->len < size) ? r->len : size);
+    return r->len;
+}
+
+/**
+ * @brief 値を書き込む
+ * @param[in] kv ストア
+ * @param[in] key キー (KVS_NOKEY 以外)
+ * @param[in] val 値
+ * @param[in] len 値のバイト数 (1..KVS_MAX_VALUE)
+ * @return 0: 成功, -1: 失敗
+ * @note 値が変わらなければ書き込まない。
+ */
+int8_t kvs_set(kvs_t *kv, uint16_t key, const void *val, uint16_t len)
+{
+    if (key == KVS_NOKEY || len == 0 || len > KVS_MAX_VALUE) return -1;
+    return put(kv, key, val, len);
+}
+
+/**
+ * @brief キーを削除する
+ * @param[in] kv ストア
+ * @param[in] key キー
+ * @return 0: 成功 (キーがなかった場合も含む), -1: 失敗
+ */
+int8_t kvs_delete(kvs_t *kv, uint16_t key)
+{
+    kvs_entry_t *e = lookup(kv, key, 0);
+
+    if (!e || !e->off) return 0;
+    return put(kv, key, 0, 0);
+}
+
+/**
+ * @brief レコードを追記する (セクタが足りなければ次のセクタへ進む)
+ * @param[in] len 値のバイト数 (0 なら削除)
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t put(kvs_t *kv, uint16_t key, const void *val, uint16_t len)
+{
+    kvs_entry_t *e = lookup(kv, key, 1);
+    uint32_t size = REC_SIZE(len);
+
+    if (!e) return -1;
+    if (e->off && len) {
+        const rec_t *r = (const rec_t *)(kv->flash->base + e->off);
+        if (r->len == len && equal((const uint8_t *)(r + 1), val, len)) return 0;
+    }
+
+    if (kv->wr + size > kv->flash->sector_size && advance(kv, size) < 0) return -1;
+    if (kv->wr + size > kv->flash->sector_size) return -1;
+    return append(kv, key, val, len);
+}
+
+/**
+ * @brief 書き込み中のセクタの末尾にレコードを書き、ハッシュ表を更新する
+ * @return 0: 成功, -1: 失敗
+ * @note 空きがあることは呼び出し側で確かめておく。
+ */
+static int8_t append(kvs_t *kv, uint16_t key, const uint8_t *val, uint16_t len)
+{
+    uint32_t buf[(sizeof(rec_t) + KVS_MAX_VALUE + 3) / 4];
+    rec_t *r = (rec_t *)buf;
+    uint8_t *p = (uint8_t *)(r + 1);
+    uint32_t size = REC_SIZE(len);
+    uint32_t off = kv->head * kv->flash->sector_size + kv->wr;
+    uint32_t i;
+
+    r->key = key;
+    r->len = len;
+    r->crc = rec_crc(key, len, val);
+    copy(p, val, len);
+    for (i = len; i < size - sizeof(rec_t); i++) p[i] = 0xFF;
+
+    /*
+     * 失敗したらこのセクタにはもう書かない。書きかけのレコードは CRC で捨てられるが、
+     * 先頭が消去状態のまま残っていると、読み出し (scan()) はそこで止まってしまう
+     */
+    if (write(kv, off, (const uint8_t *)buf, size) < 0) {
+        kv->wr = kv->flash->sector_size;
+        return -1;
+    }
+    kv->wr += size;
+
+    kvs_entry_t *e = lookup(kv, key, 1);
+    if (e) e->off = len ? off : 0;
+    return 0;
+}
+
+/**
+ * @brief 次のセクタに進み、その次 (最も古いセクタ) を空ける
+ * @param[in] need 進んだあとに書くレコードのバイト数
+ * @return 0: 成功, -1: 失敗
+ * @details 移すレコードと need バイトが次のセクタに入らなければ、head を動かさずに失敗する。\n
+ *          レコードを移す途中で書き込みに失敗したら、次のセクタを消去して読み直し、
+ *          呼ばれる前の状態に戻す。head を進めたままにすると、移しきれなかったレコードの
+ *          残るセクタが head の次になり、次にセクタを進めるときに消されてしまう。
+ */
+static int8_t advance(kvs_t *kv, uint32_t need)
+{
+    uint8_t n = kv->flash->nsectors;
+    uint8_t next = (kv->head + 1) % n;
+    uint8_t old = (next + 1) % n;
+    uint32_t erases;
+
+    if (collect(kv, next) < 0) return -1;               /* 消去済みのはずだが、書きかけのヘッダなどを消す */
+    if (HDR_SIZE + live(kv, old) + need > kv->flash->sector_size) return -1;
+    if (put_header(kv, next, kv->seq + 1) < 0) return -1;
+    kv->head = next;
+    kv->seq++;
+    kv->wr = HDR_SIZE;
+
+    if (move(kv, old) < 0) {
+        erases = kv->erases;
+        erase(kv, next);                                /* 失敗しても kvs_mount() が消す */
+        kvs_mount(kv, kv->flash);
+        kv->erases += erases;
+        return -1;
+    }
+    return erase(kv, old);
+}
+
+/**
+ * @brief セクタ s の有効なレコードを書き込み中のセクタへ移し、s を消去する
+ * @return 0: 成功, -1: 失敗 (移しきれない)
+ * @note 途中で電源が切れても、移したレコードの方が新しいので kvs_mount() で正しく読める。
+ */
+static int8_t collect(kvs_t *kv, uint8_t s)
+{
+    if (blank(kv, s)) return 0;
+    if (move(kv, s) < 0) return -1;
+    return erase(kv, s);
+}
+
+/**
+ * @brief セクタ s の有効なレコードを書き込み中のセクタへ移す
+ * @return 0: 成功, -1: 失敗 (移しきれない, 書き込みエラー)
+ */
+static int8_t move(kvs_t *kv, uint8_t s)
+{
+    uint32_t lo = s * kv->flash->sector_size;
+    uint32_t hi = lo + kv->flash->sector_size;
+    uint16_t i;
+
+    for (i = 0; i < KVS_INDEX_SIZE; i++) {
+        kvs_entry_t *e = &kv->index[i];
+        if (e->key == KVS_NOKEY || !e->off || e->off < lo || e->off >= hi) continue;
+
+        const rec_t *r = (const rec_t *)(kv->flash->base + e->off);
+        if (kv->wr + REC_SIZE(r->len) > kv->flash->sector_size) return -1;
+        if (append(kv, r->key, (const uint8_t *)(r + 1), r->len) < 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief セクタ s にある有効なレコードのバイト数を返す
+ * @return バイト数
+ */
+static uint32_t live(kvs_t *kv, uint8_t s)
+{
+    uint32_t lo = s * kv->flash->sector_size;
+    uint32_t hi = lo + kv->flash->sector_size;
+    uint32_t sum = 0;
+    uint16_t i;
+
+    for (i = 0; i < KVS_INDEX_SIZE; i++) {
+        kvs_entry_t *e = &kv->index[i];
+        if (e->key == KVS_NOKEY || !e->off || e->off < lo || e->off >= hi) continue;
+        sum += REC_SIZE(((const rec_t *)(kv->flash->base + e->off))->len);
+    }
+    return sum;
+}
+
+/**
+ * @brief セクタ s のレコードを読んでハッシュ表に反映する
+ * @return 最後のレコードの次の位置 (セクタ内のオフセット)
+ * @details CRC の合わないレコードは読み飛ばす。長さが壊れていて先に進めなければ
+ *          セクタの終わりを返し、そのセクタにはそれ以上書かない。
+ */
+static uint32_t scan(kvs_t *kv, uint8_t s)
+{
+    uint32_t size = kv->flash->sector_size;
+    uint32_t base = s * size;
+    uint32_t off = HDR_SIZE;
+
+    while (off + sizeof(rec_t) <= size) {
+        const rec_t *r = (const rec_t *)(kv->flash->base + base + off);
+        if (r->key == KVS_NOKEY) break;
+        if (r->len > KVS_MAX_VALUE || off + REC_SIZE(r->len) > size) return size;
+
+        if (r->crc == rec_crc(r->key, r->len, (const uint8_t *)(r + 1))) {
+            kvs_entry_t *e = lookup(kv, r->key, 1);
+            if (e) e->off = r->len ? base + off : 0;
+        }
+        off += REC_SIZE(r->len);
+    }
+    return off;
+}
+
+/**
+ * @brief セクタヘッダを書く
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t put_header(kvs_t *kv, uint8_t s, uint32_t seq)
+{
+    uint32_t h[2];
+
+    h[0] = KVS_MAGIC;
+    h[1] = seq;
+    return write(kv, s * kv->flash->sector_size, (const uint8_t *)h, sizeof(h));
+}
+
+/**
+ * @brief セクタを消去して、消去できたことを確かめる
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t erase(kvs_t *kv, uint8_t s)
+{
+    kv->erases++;
+    if (kv->flash->erase(kv->flash, s) < 0) return -1;
+    return blank(kv, s) ? 0 : -1;
+}
+
+/**
+ * @brief n バイトを書き込んで、書けたことを確かめる
+ * @param[in] off 書き込み先 (base から)
+ * @return 0: 成功, -1: 失敗
+ * @details ページ単位で書くので、ページの他の部分には現在の内容をそのまま書き戻す。
+ */
+static int8_t write(kvs_t *kv, uint32_t off, const uint8_t *p, uint32_t n)
+{
+    const kvs_flash_t *f = kv->flash;
+    uint8_t *page = (uint8_t *)kv->page;
+
+    while (n > 0) {
+        uint32_t po = off & ~(uint32_t)(KVS_PAGE - 1);
+        uint32_t i = off - po;
+        uint32_t k = (KVS_PAGE - i < n) ? KVS_PAGE - i : n;
+
+        copy(page, f->base + po, KVS_PAGE);
+        copy(page + i, p, k);
+        if (f->program(f, po, kv->page) < 0) return -1;
+        if (!equal(f->base + off, p, k)) return -1;
+
+        off += k;
+        p += k;
+        n -= k;
+    }
+    return 0;
+}
+
+/**
+ * @brief セクタが消去済み (全バイト 0xFF) かを判定する
+ * @return !0: 是, 0: 否
+ */
+static uint8_t blank(kvs_t *kv, uint8_t s)
+{
+    const uint32_t *p = (const uint32_t *)(kv->flash->base + s * kv->flash->sector_size);
+    uint32_t i;
+
+    for (i = 0; i < kv->flash->sector_size / 4; i++) {
+        if (p[i] != 0xFFFFFFFF) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief ハッシュ表からキーを探す (オープンアドレス法)
+ * @param[in] create !0 ならなければ追加する
+ * @return 要素, 0: ない (または表が一杯)
+ */
+static kvs_entry_t *lookup(kvs_t *kv, uint16_t key, uint8_t create)
+{
+    uint32_t i = ((uint32_t)key * 40503) >> 8;         /* 40503 = 2^16 / 黄金比 */
+    uint32_t n;
+
+    for (n = 0; n < KVS_INDEX_SIZE; n++, i++) {
+        kvs_entry_t *e = &kv->index[i & (KVS_INDEX_SIZE - 1)];
+        if (e->key == key) return e;
+        if (e->key == KVS_NOKEY) {
+            if (!create || kv->nkeys >= KVS_MAX_KEYS) return 0;
+            e->key = key;
+            e->off = 0;
+            kv->nkeys++;
+            return e;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief レコードの CRC を計算する
+ * @return CRC-32
+ */
+static uint32_t rec_crc(uint16_t key, uint16_t len, const uint8_t *val)
+{
+    uint8_t h[4];
+
+    h[0] = key;
+    h[1] = key >> 8;
+    h[2] = len;
+    h[3] = len >> 8;
+    return ~crc32(crc32(0xFFFFFFFF, h, 4), val, len);
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3, ビット反転) を更新する
+ * @return 更新した CRC
+ */
+static uint32_t crc32(uint32_t crc, const uint8_t *p, uint32_t n)
+{
+    uint8_t i;
+
+    while (n--) {
+        crc ^= *p++;
+        for (i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+    return crc;
+}
+
+/**
+ * @brief n バイトをコピーする
+ * @return なし
+ */
+static void copy(uint8_t *dst, const uint8_t *src, uint32_t n)
+{
+    while (n--) *dst++ = *src++;
+}
+
+/**
+ * @brief n バイトを比較する
+ * @return !0: 等しい, 0: 異なる
+ */
+static uint8_t equal(const uint8_t *a, const uint8_t *b, uint32_t n)
+{
+    while (n--) {
+        if (*a++ != *b++) return 0;
+    }
+    return 1;
+}
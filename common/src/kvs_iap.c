@@ -0,0 +1,60 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file kvs_iap.c
+ * @brief キーバリューストアを内蔵フラッシュ上に置くためのフラッシュ操作 (IAP)
+ * @details リンカスクリプトの kvs 領域 (_kvs_start 〜 _kvs_end) を使う。
+ */
+
+#include "system.h"
+#include "iap.h"
+#include "kvs.h"
+
+#if KVS_PAGE != 256 && KVS_PAGE != 512 && KVS_PAGE != 1024 && KVS_PAGE != 4096
+  #error "KVS_PAGE must be one of 256, 512, 1024 or 4096 for IAP."
+#endif
+
+extern uint8_t _kvs_start[];
+extern uint8_t _kvs_end[];
+
+static int8_t erase(const kvs_flash_t *f, uint8_t sector);
+static int8_t program(const kvs_flash_t *f, uint32_t off, const uint32_t *page);
+
+static kvs_flash_t s_flash;
+
+/**
+ * @brief 内蔵フラッシュの kvs 領域を返す
+ * @return kvs_mount() に渡すフラッシュ
+ */
+const kvs_flash_t *kvs_iap(void)
+{
+    s_flash.base = _kvs_start;
+    s_flash.sector_size = IAP_SECTOR_SIZE;
+    s_flash.nsectors = (_kvs_end - _kvs_start) / IAP_SECTOR_SIZE;
+    s_flash.erase = erase;
+    s_flash.program = program;
+    return &s_flash;
+}
+
+/**
+ * @brief セクタを消去する
+ * @param[in] sector kvs 領域の中のセクタ番号
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t erase(const kvs_flash_t *f, uint8_t sector)
+{
+    uint32_t s = (uint32_t)f->base / IAP_SECTOR_SIZE + sector;
+
+    return (iap_erase(s, s) == IAP_CMD_SUCCESS) ? 0 : -1;
+}
+
+/**
+ * @brief 1 ページを書き込む
+ * @param[in] off 書き込み先 (base から, KVS_PAGE の境界)
+ * @param[in] page 書き込むデータ (KVS_PAGE バイト)
+ * @return 0: 成功, -1: 失敗
+ */
+static int8_t program(const kvs_flash_t *f, uint32_t off, const uint32_t *page)
+{
+    return (iap_write((uint32_t)f->base + off, page, KVS_PAGE) == IAP_CMD_SUCCESS) ? 0 : -1;
+}
@@ -0,0 +1,240 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file la.c
+ * @brief ロジックアナライザ (GPIO ポートのサンプリング)
+ */
+
+#include <stddef.h>
+#include "system.h"
+#include "la.h"
+#include "clkgate.h"
+
+#define __STR(x) #x
+#define STR(x)   __STR(x)
+
+#define NUM_PORT 4
+#define RUN_ONE  (1UL << 12)            /* レコードのサンプル数の 1 */
+
+/**
+ * サンプリングのループ (sample()) とやりとりする状態。オフセットはアセンブリに直書きしている
+ */
+typedef struct la_run {
+    volatile uint32_t *ir;              /* タイマの IR */
+    volatile uint32_t *data;            /* マスク付きの GPIOnDATA */
+    uint32_t *buf;
+    uint32_t wr;                        /* 次に書くレコードの番号 */
+    uint32_t prev;                      /* 直前の値 */
+    uint32_t run;                       /* 直前の値が続いたサンプル数 << 12 */
+    uint32_t left;                      /* 残りのサンプル数 (トリガ前はタイムアウトまで, 後は post まで) */
+    uint32_t tchg;                      /* LA_TRIG_CHANGE で見るピン */
+    uint32_t tmask;                     /* LA_TRIG_PATTERN で見るピン */
+    uint32_t tmatch;                    /* LA_TRIG_PATTERN の値 (使わないときは mask の外の値) */
+    uint32_t arm;                       /* left がこれ以下になったらトリガを受け付ける */
+    uint32_t post;
+    uint32_t trig;                      /* トリガのレコードの番号 (LA_NO_TRIGGER: まだ) */
+} la_run_t;
+
+_Static_assert(offsetof(la_run_t, tmatch) == 36 && offsetof(la_run_t, trig) == 48, "la_run_t layout");
+
+la_capture_t g_la;
+
+static void sample(la_run_t *r) __ramfunc __attribute__ ((naked));
+
+/**
+ * @brief キャプチャする (終わるまで戻らない)
+ * @param[in] cfg 設定
+ * @return 0: 成功 (g_la.status を見る), -1: 設定が不正, またはサンプリング周波数が高すぎる
+ * @details サンプリングの間は割込みを禁止する。タイマの割込みは止めてから戻す。
+ *          ピンの IOCON と方向は変えない (出力のピンも、そのレベルが読める)。
+ */
+int8_t la_capture(const la_config_t *cfg)
+{
+    ct32b_regs_t *const tmr = LPC_CT32Bn(LA_TMR);
+    irq_t irq = (irq_t)(IRQ_TIMER32_0 + LA_TMR);
+    uint32_t pclk = sys_clock();
+    uint32_t period, v;
+    uint8_t irq_on;
+    la_run_t r;
+
+    if (cfg->port >= NUM_PORT || !(cfg->mask & 0x0FFF) || !cfg->rate || !cfg->post) return -1;
+    if (cfg->trig != LA_TRIG_NONE && (!cfg->timeout || cfg->pre >= cfg->timeout)) return -1;
+    period = pclk / cfg->rate;
+    if (period < LA_MIN_CYCLES) return -1;
+
+    g_la.magic = 0;
+    g_la.size = LA_WORDS;
+    g_la.mask = cfg->mask & 0x0FFF;
+    g_la.port = cfg->port;
+    g_la.rate = pclk / period;
+    g_la.status = LA_IDLE;
+
+    r.ir = &tmr->IR;
+    r.data = (volatile uint32_t *)GPIOnDATA(cfg->port, g_la.mask);
+    r.buf = g_la.buf;
+    r.wr = 0;
+    r.left = (cfg->trig == LA_TRIG_NONE) ? 0 : cfg->timeout;
+    r.tchg = (cfg->trig == LA_TRIG_CHANGE) ? cfg->trig_mask : 0;
+    r.tmask = (cfg->trig == LA_TRIG_PATTERN) ? cfg->trig_mask : 0;
+    r.tmatch = (cfg->trig == LA_TRIG_PATTERN) ? (cfg->trig_match & cfg->trig_mask) : 1;
+    r.arm = cfg->timeout - cfg->pre;
+    r.post = cfg->post;
+    r.trig = (cfg->trig == LA_TRIG_NONE) ? 0 : LA_NO_TRIGGER;
+
+    clkgate_acquire(CLKGATE_GPIO);
+    clkgate_acquire(CLKGATE_CT32B0 + LA_TMR);
+    irq_on = nvic_is_enabled(irq);
+    nvic_disable_irq(irq);
+
+    tmr->TCR = CT32B_TCR_CRST_Msk;
+    tmr->PR = 0;
+    tmr->MR0 = period - 1;
+    tmr->IR = 0xFF;
+    tmr->MCR = CT32B_MCR_MR0I_Msk | CT32B_MCR_MR0R_Msk;    /* 一致でフラグを立ててカウンタを 0 に戻す */
+
+    v = irq_save();
+    tmr->TCR = CT32B_TCR_CEN_Msk;
+    r.prev = *r.data;                   /* 最初のサンプル */
+    r.run = RUN_ONE;
+    if (r.trig != LA_NO_TRIGGER) r.left = r.post;
+    if (r.left > 1) {
+        r.left--;
+        sample(&r);
+    }
+    g_la.buf[r.wr++ & (LA_WORDS - 1)] = r.run | r.prev;    /* 最後の値 */
+    irq_restore(v);
+
+    tmr->TCR = 0;
+    tmr->MCR = 0;
+    tmr->IR = 0xFF;
+    nvic_clear_pending(irq);
+    if (irq_on) nvic_enable_irq(irq);
+    clkgate_release(CLKGATE_CT32B0 + LA_TMR);
+    clkgate_release(CLKGATE_GPIO);
+
+    g_la.wr = r.wr;
+    g_la.trig = r.trig;
+    if (r.trig == LA_NO_TRIGGER) {
+        g_la.status = LA_TIMEOUT;
+    } else {
+        g_la.status = r.left ? LA_FULL : LA_DONE;
+    }
+    g_la.magic = LA_MAGIC;
+    return 0;
+}
+
+/**
+ * @brief サンプリングのループ (割込み禁止で呼ぶ)
+ * @param[in,out] r 状態
+ * @return なし
+ * @details r0: 状態, r1: IR, r2: DATA, r3: buf, r4: wr, r5: prev, r6: run, r7: left,
+ *          r8: tchg (トリガ後は trig - 1), r9: tmask, r10: tmatch, r11: 今のサンプル, r12/lr: 作業用。\n
+ *          MR0 のフラグを待ってクリアし、DATA を読む。値が変わらなければ run を数えるだけ。
+ *          変わったら直前の値のレコードを書き、トリガ前ならトリガの条件を見る。
+ *          トリガの後は、次のレコードでトリガのレコードを上書きすることになったら (最後の値を書く 1 つを残して) 止める。
+ *          RAM に置くのはフラッシュのウェイトで間隔が揺れないようにするため。
+ */
+static void sample(la_run_t *r)
+{
+    __asm volatile (
+        "push   {r4-r11, lr}            \n"
+        "ldmia  r0, {r1-r10}            \n"     /* ir, data, buf, wr, prev, run, left, tchg, tmask, tmatch */
+        "ldr    r12, [r0, #48]          \n"
+        "cmn    r12, #1                 \n"
+        "bne    20f                     \n"     /* LA_TRIG_NONE: トリガ済みで始める */
+
+        /* トリガ前 */
+        "1:                             \n"
+        "ldr    r12, [r1]               \n"
+        "tst    r12, #1                 \n"
+        "beq    1b                      \n"
+        "str    r12, [r1]               \n"     /* MR0 のフラグをクリア */
+        "ldr    r11, [r2]               \n"
+        "cmp    r11, r5                 \n"
+        "bne    3f                      \n"
+        "adds   r6, r6, #4096           \n"
+        "bcs    4f                      \n"
+        "2:                             \n"
+        "subs   r7, r7, #1              \n"
+        "bne    1b                      \n"
+        "b      9f                      \n"
+        "4:                             \n"     /* 2^20 - 1 サンプル続いた */
+        "sub    r12, r6, #4096          \n"
+        "mov    r6, #4096               \n"
+        "orr    r12, r12, r5            \n"
+        "ubfx   lr, r4, #0, #" STR(LA_WORDS_LOG2) "\n"
+        "str    r12, [r3, lr, lsl #2]   \n"
+        "adds   r4, r4, #1              \n"
+        "b      2b                      \n"
+        "3:                             \n"     /* 変わった */
+        "orr    r12, r6, r5             \n"
+        "ubfx   lr, r4, #0, #" STR(LA_WORDS_LOG2) "\n"
+        "str    r12, [r3, lr, lsl #2]   \n"
+        "adds   r4, r4, #1              \n"
+        "mov    r6, #4096               \n"
+        "eor    r12, r11, r5            \n"
+        "tst    r12, r8                 \n"
+        "bne    5f                      \n"     /* LA_TRIG_CHANGE */
+        "and    r12, r5, r9             \n"
+        "cmp    r12, r10                \n"
+        "beq    6f                      \n"     /* 前から一致していた */
+        "and    r12, r11, r9            \n"
+        "cmp    r12, r10                \n"
+        "beq    5f                      \n"     /* LA_TRIG_PATTERN */
+        "6:                             \n"
+        "mov    r5, r11                 \n"
+        "b      2b                      \n"
+        "5:                             \n"
+        "ldr    r12, [r0, #40]          \n"
+        "cmp    r7, r12                 \n"
+        "bhi    6b                      \n"     /* pre サンプルをまだ取っていない */
+        "mov    r5, r11                 \n"
+        "str    r4, [r0, #48]           \n"     /* トリガのレコード */
+        "ldr    r7, [r0, #44]           \n"     /* 残りは post (このサンプルを含む) */
+        "sub    r8, r4, #1              \n"
+        "b      12f                     \n"
+
+        /* LA_TRIG_NONE */
+        "20:                            \n"
+        "sub    r8, r12, #1             \n"
+
+        /* トリガ後 */
+        "11:                            \n"
+        "ldr    r12, [r1]               \n"
+        "tst    r12, #1                 \n"
+        "beq    11b                     \n"
+        "str    r12, [r1]               \n"
+        "ldr    r11, [r2]               \n"
+        "cmp    r11, r5                 \n"
+        "bne    13f                     \n"
+        "adds   r6, r6, #4096           \n"
+        "bcs    14f                     \n"
+        "12:                            \n"
+        "subs   r7, r7, #1              \n"
+        "bne    11b                     \n"
+        "b      9f                      \n"
+        "13:                            \n"
+        "mov    r12, r6                 \n"
+        "mov    r6, #4096               \n"
+        "b      15f                     \n"
+        "14:                            \n"
+        "sub    r12, r6, #4096          \n"
+        "mov    r6, #4096               \n"
+        "15:                            \n"
+        "orr    r12, r12, r5            \n"
+        "mov    r5, r11                 \n"
+        "ubfx   lr, r4, #0, #" STR(LA_WORDS_LOG2) "\n"
+        "str    r12, [r3, lr, lsl #2]   \n"
+        "adds   r4, r4, #1              \n"
+        "sub    r12, r4, r8             \n"
+        "cmp    r12, #" STR(LA_WORDS) "\n"
+        "blo    12b                     \n"     /* 次で一杯になるなら止める */
+
+        "9:                             \n"
+        "str    r4, [r0, #12]           \n"
+        "str    r5, [r0, #16]           \n"
+        "str    r6, [r0, #20]           \n"
+        "str    r7, [r0, #24]           \n"
+        "pop    {r4-r11, pc}            \n"
+    );
+}
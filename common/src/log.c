@@ -0,0 +1,167 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file log.c
+ * @brief 遅延フォーマットのバイナリログ
+ * @details レコードはリングバッファの領域を LDREX/STREX で予約してから書くので、割込みを禁止せずに
+ *          割込みハンドラとメインが同時にログを出してもレコードが混ざらない。
+ *          書き終えた領域は、最も外側の (ネストした割込みに割り込まれていた) log_emit() が
+ *          まとめて wr に反映する。\n
+ *          LOG_TRANSPORT_ITM のときもリングバッファを送信待ちのキューとして使い、
+ *          ITM の FIFO が空くのを割込みを許可したまま待つ。FIFO が詰まっていれば
+ *          リングが満杯になった時点でレコードを捨てる (割込みの遅延は増えない)。
+ */
+
+#include "system.h"
+#include "log.h"
+#include "clkgate.h"
+
+#define RING_MASK (LOG_RING_WORDS - 1)
+
+#if (LOG_RING_WORDS & RING_MASK)
+  #error "LOG_RING_WORDS must be a power of 2."
+#endif
+
+/**
+ * リングバッファ。リセットをまたいで保持するので、クラッシュ直前のログも後から読める
+ */
+log_ring_t g_log_ring __noinit;
+
+static volatile uint32_t s_resv;        /* 予約済みの位置 (wr 以上) */
+static volatile uint32_t s_writers;     /* log_emit() の中にいる数 (ネストした割込みを含む) */
+
+#if (LOG_TRANSPORT == LOG_TRANSPORT_ITM)
+static volatile uint32_t s_sending;     /* ITM へ送っている文脈がある */
+
+static void itm_send(void);
+static inline void itm_put(uint32_t v);
+#endif
+
+/**
+ * @brief ログの出力先を初期化する
+ * @return なし
+ * @note LOG_TRANSPORT_RING のときはウォームスタートなら読み残しのログを引き継ぐ。
+ *       LOG_TRANSPORT_ITM のときは SWO ピン (PIO0_9) とトレースクロックを設定する。
+ *       ITM 自体の許可はデバッガが行う。
+ */
+void log_init(void)
+{
+    #if (LOG_TRANSPORT == LOG_TRANSPORT_ITM)
+        clkgate_acquire(CLKGATE_IOCON);
+        reg_write(IOCON(PIO0_9), 0x02);                 /* PIO0_9: SWO (FUNC = 2; 3 は予約) */
+        clkgate_div_acquire(CLKGATE_DIV_TRACE, 1);
+        g_log_ring.magic = 0;                           /* 送信待ちのキューは引き継がない */
+    #endif
+    if (!sys_warm_start() || g_log_ring.magic != LOG_RING_MAGIC || g_log_ring.size != LOG_RING_WORDS
+        || g_log_ring.wr - g_log_ring.rd > LOG_RING_WORDS) {
+        g_log_ring.size = LOG_RING_WORDS;
+        g_log_ring.wr = g_log_ring.rd = 0;
+        g_log_ring.dropped = 0;
+        g_log_ring.magic = LOG_RING_MAGIC;
+    }
+    s_resv = g_log_ring.wr;
+}
+
+/**
+ * @brief 1 レコードを出力する (LOG() から呼ばれる)
+ * @param[in] hdr 引数の数 << 28 | 書式 ID
+ * @param[in] a0 引数 0
+ * @param[in] a1 引数 1
+ * @param[in] a2 引数 2
+ * @param[in] a3 引数 3
+ * @return なし
+ * @note 割込みは禁止しない。リングが満杯ならレコードを捨てて dropped を数える。
+ */
+void log_emit(uint32_t hdr, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    log_ring_t *r = &g_log_ring;
+    uint32_t n = hdr >> 28;
+    uint32_t wr;
+    uint8_t ok = 1;
+
+    #if (LOG_TRANSPORT == LOG_TRANSPORT_ITM)
+        /* ITM が許可されていなければ FIFO が空かないので何もしない */
+        if (!(reg_read(ITM(TCR)) & ITM_TCR_ITMENA) || !(reg_read(ITM(TER)) & (1 << LOG_ITM_PORT))) return;
+    #endif
+
+    atomic_add(&s_writers, 1);
+
+    /* n + 1 ワードを予約する (LDREX から STREX の間に割り込まれたら STREX が失敗してやり直す) */
+    do {
+        wr = __ldrex(&s_resv);
+        if (LOG_RING_WORDS - (wr - r->rd) <= n) {
+            __clrex();
+            ok = 0;
+            break;
+        }
+    } while (__strex(wr + n + 1, &s_resv));
+
+    if (ok) {
+        r->buf[wr++ & RING_MASK] = hdr;
+        if (n > 0) r->buf[wr++ & RING_MASK] = a0;
+        if (n > 1) r->buf[wr++ & RING_MASK] = a1;
+        if (n > 2) r->buf[wr++ & RING_MASK] = a2;
+        if (n > 3) r->buf[wr++ & RING_MASK] = a3;
+    } else {
+        atomic_add(&r->dropped, 1);
+    }
+
+    /*
+     * 最も外側の書き手だけが、予約済みの位置までを公開する。ネストした割込みは
+     * 外側より先に終わるので、その時点で s_resv までのレコードはすべて書き終えている。
+     * wr を書いてから s_writers を 0 に戻すまでに割り込まれたら、新しい s_resv を公開し直す
+     * (LDREX と STREX の間ではストアしない)
+     */
+    if (s_writers > 1) {
+        atomic_add(&s_writers, -1);
+    } else {
+        for (;;) {
+            wr = s_resv;
+            r->wr = wr;
+            __ldrex(&s_writers);
+            if (s_resv != wr) {
+                __clrex();
+                continue;
+            }
+            if (!__strex(0, &s_writers)) break;
+        }
+    }
+
+    #if (LOG_TRANSPORT == LOG_TRANSPORT_ITM)
+        itm_send();
+    #endif
+}
+
+#if (LOG_TRANSPORT == LOG_TRANSPORT_ITM)
+/**
+ * @brief リングの公開済みのレコードを ITM に送る
+ * @return なし
+ * @details 送るのは 1 つの文脈だけで、送信中に割り込んだ log_emit() はキューに積むだけで戻る。
+ *          積まれたレコードは送信中の文脈がまとめて送る。s_sending を戻してから
+ *          もう一度確かめるので、戻す直前に積まれたレコードも取り残さない。
+ */
+static void itm_send(void)
+{
+    log_ring_t *r = &g_log_ring;
+
+    while (r->rd != r->wr) {
+        if (!atomic_cas(&s_sending, 0, 1)) return;
+        while (r->rd != r->wr) {
+            itm_put(r->buf[r->rd & RING_MASK]);
+            r->rd++;
+        }
+        s_sending = 0;
+    }
+}
+
+/**
+ * @brief スティミュラスポートに 1 ワード書く
+ * @param[in] v 値
+ * @return なし
+ */
+static inline void itm_put(uint32_t v)
+{
+    while (!(reg_read(ITM_STIM(LOG_ITM_PORT)) & 1));  /* FIFO が空くのを待つ (割込みは許可したまま) */
+    reg_write(ITM_STIM(LOG_ITM_PORT), v);
+}
+#endif
@@ -0,0 +1,159 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file onewire.c
+ * @brief 1-Wire バス (標準速度) のビットバング
+ */
+
+#include "system.h"
+#include "onewire.h"
+
+static int8_t presence(onewire_t *ow) __ramfunc;
+
+/**
+ * @brief 1-Wire バスを準備する
+ * @param[out] ow バス
+ * @param[in] spec データ線のピン BB_PIN(pno, nthbit)
+ * @return 0: 成功, -1: 失敗
+ * @note bb_init() のあとで呼ぶこと。
+ */
+int8_t ow_init(onewire_t *ow, uint8_t spec)
+{
+    if (bb_pin_init(&ow->pin, spec, BB_OPENDRAIN) < 0) return -1;
+
+    ow->a = bb_loops(6000);
+    ow->b = bb_loops(64000);
+    ow->c = bb_loops(60000);
+    ow->d = bb_loops(10000);
+    ow->e = bb_loops(9000);
+    ow->f = bb_loops(55000);
+    ow->h = bb_loops(480000);
+    ow->i = bb_loops(70000);
+    ow->j = bb_loops(410000);
+    return 0;
+}
+
+/**
+ * @brief ow_init() で準備したピンを返す
+ * @param[in] ow バス
+ * @return なし
+ */
+void ow_deinit(onewire_t *ow)
+{
+    bb_pin_deinit(&ow->pin);
+}
+
+/**
+ * @brief リセットパルスを送り、プレゼンスパルスを確かめる
+ * @param[in] ow バス
+ * @return 1: デバイスあり, 0: デバイスなし, -1: バスが L に張り付いている
+ */
+int8_t ow_reset(onewire_t *ow)
+{
+    if (!bb_get(&ow->pin)) return -1;
+
+    uint32_t v = irq_save();
+    bb_drive_low(&ow->pin);
+    irq_restore(v);
+    bb_delay(ow->h);                                    /* 延びてもよい */
+
+    int8_t r = presence(ow);
+    bb_delay(ow->j);
+    return r;
+}
+
+/**
+ * @brief 1 ビット送る
+ * @param[in] ow バス
+ * @param[in] bit 0 または 1
+ * @return なし
+ */
+void ow_write_bit(onewire_t *ow, uint8_t bit)
+{
+    uint32_t v = irq_save();
+    bb_drive_low(&ow->pin);
+    bb_spin(bit ? ow->a : ow->c);
+    bb_release(&ow->pin);
+    irq_restore(v);
+    bb_spin(bit ? ow->b : ow->d);
+}
+
+/**
+ * @brief 1 ビット受け取る
+ * @param[in] ow バス
+ * @return 0 または 1
+ */
+uint8_t ow_read_bit(onewire_t *ow)
+{
+    uint32_t v = irq_save();
+    bb_drive_low(&ow->pin);
+    bb_spin(ow->a);
+    bb_release(&ow->pin);
+    bb_spin(ow->e);
+    uint8_t bit = bb_get(&ow->pin);
+    irq_restore(v);
+    bb_spin(ow->f);
+    return bit;
+}
+
+/**
+ * @brief 1 バイト送る (LSB から)
+ * @param[in] ow バス
+ * @param[in] v 値
+ * @return なし
+ */
+void ow_write(onewire_t *ow, uint8_t v)
+{
+    for (uint8_t i = 0; i < 8; i++) {
+        ow_write_bit(ow, v & 1);
+        v >>= 1;
+    }
+}
+
+/**
+ * @brief 1 バイト受け取る (LSB から)
+ * @param[in] ow バス
+ * @return 値
+ */
+uint8_t ow_read(onewire_t *ow)
+{
+    uint8_t v = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        v >>= 1;
+        if (ow_read_bit(ow)) v |= 0x80;
+    }
+    return v;
+}
+
+/**
+ * @brief 1-Wire の CRC-8 (X^8 + X^5 + X^4 + 1) を計算する
+ * @param[in] p データ
+ * @param[in] n バイト数
+ * @return CRC。ROM コードやスクラッチパッドを CRC まで含めて計算すると 0 になる
+ */
+uint8_t ow_crc8(const uint8_t *p, uint16_t n)
+{
+    uint8_t crc = 0;
+
+    while (n--) {
+        crc ^= *p++;
+        for (uint8_t i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0x8C : crc >> 1;
+    }
+    return crc;
+}
+
+/**
+ * @brief バスを開放してプレゼンスパルスを標本化する
+ * @param[in] ow バス
+ * @return 1: デバイスあり, 0: デバイスなし
+ */
+static int8_t presence(onewire_t *ow)
+{
+    uint32_t v = irq_save();
+    bb_release(&ow->pin);
+    bb_spin(ow->i);
+    int8_t r = !bb_get(&ow->pin);
+    irq_restore(v);
+    return r;
+}
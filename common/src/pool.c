@@ -0,0 +1,200 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file pool.c
+ * @brief 固定長ブロックのプールアロケータ
+ * @details 空きブロックは先頭ワードに次の空きブロックのアドレスを持つ単方向リスト (侵入型) で
+ *          管理する。要求サイズから CLZ 1 命令でクラスが決まり、そのクラスが空なら
+ *          上のクラスから取る (高々 POOL_NCLASS 回)。解放時はアドレス範囲からクラスを決める。\n
+ *          POOL_ISR_SAFE が 1 のときリストの先頭と統計を LDREX/STREX で更新する。
+ *          Cortex-M3 では例外の出入りで排他モニタがクリアされるので、
+ *          先頭を読んでから書き換えるまでに割込みが入ればやり直しになり、ABA 問題も起きない。
+ */
+
+#include "system.h"
+#include "pool.h"
+
+/* リンカスクリプトのロケーションカウンタを参照する */
+extern uint32_t _end;
+extern uint32_t _stack_bottom;
+
+/**
+ * サイズクラス
+ */
+typedef struct pool_class {
+    volatile uint32_t head;             /* 空きリストの先頭 (0 なら空) */
+    uint32_t start;                     /* 領域の先頭 */
+    uint32_t end;                       /* 領域の終端 */
+    uint16_t total;
+    volatile uint32_t used;
+    volatile uint32_t peak;
+    volatile uint32_t fails;
+} pool_class_t;
+
+static pool_class_t s_cls[POOL_NCLASS];
+static const uint8_t s_shares[POOL_NCLASS] = { POOL_SHARES };
+
+static inline uint32_t pop(pool_class_t *c);
+static inline void push(pool_class_t *c, uint32_t blk);
+static inline void count(pool_class_t *c, int32_t d);
+
+/**
+ * @brief 空き RAM をサイズクラスごとに切り分ける
+ * @return なし
+ * @note 呼ぶ前に確保したブロックはすべて無効になる。
+ */
+void pool_init(void)
+{
+    uint32_t base = ((uint32_t)&_end + 3) & ~3;
+    uint32_t avail = (uint32_t)&_stack_bottom - base;
+    uint8_t i;
+
+    for (i = 0; i < POOL_NCLASS; i++) {
+        pool_class_t *c = &s_cls[i];
+        uint32_t size = POOL_MIN_SIZE << i;
+        uint32_t n = (avail / 100 * s_shares[i]) / size;
+        uint32_t blk;
+
+        c->start = base;
+        c->end = base + n * size;
+        c->total = n;
+        c->used = c->peak = c->fails = 0;
+        c->head = 0;
+
+        /* 後ろから積んで、先頭のブロックから払い出されるようにする */
+        for (blk = c->end; blk > c->start;) {
+            blk -= size;
+            *(uint32_t *)blk = c->head;
+            c->head = blk;
+        }
+        base = c->end;
+    }
+}
+
+/**
+ * @brief size バイト以上のブロックを確保する
+ * @param[in] size バイト数
+ * @return ブロックの先頭 (4 バイト境界), 確保できなければ 0
+ */
+void *pool_alloc(uint32_t size)
+{
+    uint32_t cls = (size <= POOL_MIN_SIZE) ? 0 : 32 - __builtin_clz(size - 1) - 4;  /* log2(16) = 4 */
+    uint32_t i;
+
+    for (i = cls; i < POOL_NCLASS; i++) {
+        uint32_t blk = pop(&s_cls[i]);
+        if (blk) {
+            count(&s_cls[i], 1);
+            return (void *)blk;
+        }
+    }
+
+    /* 失敗は要求サイズのクラス (大きすぎる要求は最大のクラス) に数える */
+    if (cls >= POOL_NCLASS) cls = POOL_NCLASS - 1;
+    #if (POOL_ISR_SAFE)
+        atomic_add(&s_cls[cls].fails, 1);
+    #else
+        s_cls[cls].fails++;
+    #endif
+    return 0;
+}
+
+/**
+ * @brief pool_alloc() で確保したブロックを解放する
+ * @param[in] p ブロックの先頭
+ * @return 0: 成功, -1: プールのブロックではない
+ */
+int8_t pool_free(void *p)
+{
+    uint32_t a = (uint32_t)p;
+    uint8_t i;
+
+    for (i = 0; i < POOL_NCLASS; i++) {
+        pool_class_t *c = &s_cls[i];
+        if (c->start <= a && a < c->end) {
+            if ((a - c->start) & ((POOL_MIN_SIZE << i) - 1)) return -1;    /* ブロックの先頭ではない */
+            push(c, a);
+            count(c, -1);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief サイズクラスの統計を返す
+ * @param[in] cls クラス番号 (0..POOL_NCLASS - 1)
+ * @param[out] st 統計
+ * @return なし
+ */
+void pool_stat(uint8_t cls, pool_stat_t *st)
+{
+    const pool_class_t *c = &s_cls[cls];
+
+    st->size = POOL_MIN_SIZE << cls;
+    st->total = c->total;
+    st->used = c->used;
+    st->peak = c->peak;
+    st->fails = c->fails;
+}
+
+/**
+ * @brief 空きリストの先頭からブロックを取り出す
+ * @param[in,out] c サイズクラス
+ * @return ブロックのアドレス, 空なら 0
+ */
+static inline uint32_t pop(pool_class_t *c)
+{
+    uint32_t blk;
+
+    #if (POOL_ISR_SAFE)
+        do {
+            blk = __ldrex(&c->head);
+            if (blk == 0) {
+                __clrex();
+                return 0;
+            }
+        } while (__strex(*(uint32_t *)blk, &c->head));
+    #else
+        blk = c->head;
+        if (blk) c->head = *(uint32_t *)blk;
+    #endif
+    return blk;
+}
+
+/**
+ * @brief 空きリストの先頭にブロックを戻す
+ * @param[in,out] c サイズクラス
+ * @param[in] blk ブロックのアドレス
+ * @return なし
+ */
+static inline void push(pool_class_t *c, uint32_t blk)
+{
+    #if (POOL_ISR_SAFE)
+        do {
+            *(uint32_t *)blk = __ldrex(&c->head);
+        } while (__strex(blk, &c->head));
+    #else
+        *(uint32_t *)blk = c->head;
+        c->head = blk;
+    #endif
+}
+
+/**
+ * @brief 使用中のブロック数と最大値を更新する
+ * @param[in,out] c サイズクラス
+ * @param[in] d 増減 (+1 または -1)
+ * @return なし
+ */
+static inline void count(pool_class_t *c, int32_t d)
+{
+    #if (POOL_ISR_SAFE)
+        uint32_t used = atomic_add(&c->used, d);
+        uint32_t peak;
+
+        while (used > (peak = c->peak) && !atomic_cas(&c->peak, peak, used));
+    #else
+        c->used += d;
+        if (c->used > c->peak) c->peak = c->used;
+    #endif
+}
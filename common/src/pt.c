@@ -0,0 +1,128 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file pt.c
+ * @brief スタックを持たないコルーチン (プロトスレッド) の協調スケジューラと待ちの条件
+ */
+
+#include "system.h"
+#include "pt.h"
+#include "clkgate.h"
+
+#define NUM_PORT 4
+
+static pt_task_t *s_tasks;              /* 登録されたタスク (新しい順) */
+
+/**
+ * @brief タスクを登録する
+ * @param[out] task タスク (終わるまで保持すること)
+ * @param[in] fn プロトスレッドの関数
+ * @param[in] arg fn に渡す引数
+ * @return なし
+ * @note タスクの中から呼んでもよい。登録したタスクは次の pt_sched_poll() から再開される。
+ */
+void pt_sched_add(pt_task_t *task, pt_func_t fn, void *arg)
+{
+    PT_INIT(&task->pt);
+    task->fn = fn;
+    task->arg = arg;
+    task->next = s_tasks;
+    s_tasks = task;
+}
+
+/**
+ * @brief 登録されたタスクを 1 回ずつ再開する
+ * @return 残っているタスクの数
+ * @details 終わった (PT_EXITED, PT_ENDED) タスクは登録から外す。\n
+ *          眠らずに戻るので、呼ぶ側は while (pt_sched_poll()); のように回し続ける
+ *          (WFI で眠ると、タイマに使っているサイクルカウンタも止まる)。
+ */
+uint32_t pt_sched_poll(void)
+{
+    pt_task_t **p = &s_tasks;
+    uint32_t n = 0;
+
+    while (*p) {
+        pt_task_t *t = *p;
+        if (t->fn(&t->pt, t->arg) >= PT_EXITED) {
+            *p = t->next;
+        } else {
+            p = &t->next;
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief タイマを ms ミリ秒にして始める
+ * @param[out] t タイマ
+ * @param[in] ms 長さ [ms] (CYCCNT の一周より短いこと; 72 MHz で約 59 秒)
+ * @return なし
+ */
+void pt_timer_set_ms(pt_timer_t *t, uint32_t ms)
+{
+    dwt_cyccnt_start();
+    t->cycles = (sys_clock() / 1000) * ms;
+    t->t0 = dwt_cyccnt();
+}
+
+/**
+ * @brief タイマを us マイクロ秒にして始める
+ * @param[out] t タイマ
+ * @param[in] us 長さ [us]
+ * @return なし
+ */
+void pt_timer_set_us(pt_timer_t *t, uint32_t us)
+{
+    dwt_cyccnt_start();
+    t->cycles = (sys_clock() / 1000000) * us;
+    t->t0 = dwt_cyccnt();
+}
+
+/**
+ * @brief GPIO のピンのエッジの検出を始める
+ * @param[in] pno ポート番号 (0..3)
+ * @param[in] nthbit ピン番号に対応するビット位置 (0..11)
+ * @param[in] edge PT_EDGE_FALLING, PT_EDGE_RISING, PT_EDGE_BOTH
+ * @return なし
+ * @details エッジ検出に設定して、それまでの検出をクリアする。割込みのマスク (IE) は変えないので、
+ *          割込みを許可していなければ RIS に残ったエッジを pt_edge_seen() で見る。
+ *          同じピンで割込みを使うハンドラがクリアすると、エッジを見逃す。\n
+ *          GPIO のクロックを得るので、待ち終わったら pt_edge_disarm() で返す。
+ */
+void pt_edge_arm(uint8_t pno, uint8_t nthbit, uint8_t edge)
+{
+    if (pno >= NUM_PORT) return;
+    clkgate_acquire(CLKGATE_GPIO);
+    __reg_write_bit(GPIOn(pno, IS), nthbit, 0);
+    __reg_write_bit(GPIOn(pno, IBE), nthbit, edge == PT_EDGE_BOTH);
+    __reg_write_bit(GPIOn(pno, IEV), nthbit, edge == PT_EDGE_RISING);
+    reg_write(GPIOn(pno, IC), 1UL << nthbit);
+}
+
+/**
+ * @brief pt_edge_arm() の後にエッジが来たかどうかを返す (来ていたらクリアする)
+ * @param[in] pno ポート番号 (0..3)
+ * @param[in] nthbit ピン番号に対応するビット位置 (0..11)
+ * @return 1: 来た, 0: まだ
+ */
+uint8_t pt_edge_seen(uint8_t pno, uint8_t nthbit)
+{
+    if (pno >= NUM_PORT) return 0;
+    if (!(reg_read(GPIOn(pno, RIS)) & (1UL << nthbit))) return 0;
+    reg_write(GPIOn(pno, IC), 1UL << nthbit);
+    return 1;
+}
+
+/**
+ * @brief pt_edge_arm() で得た GPIO のクロックを返す
+ * @param[in] pno ポート番号 (0..3)
+ * @return なし
+ * @note pt_edge_arm() 1 回につき 1 回呼ぶこと (PT_WAIT_EDGE() は待ち終わったら呼ぶ)。
+ */
+void pt_edge_disarm(uint8_t pno)
+{
+    if (pno >= NUM_PORT) return;
+    clkgate_release(CLKGATE_GPIO);
+}
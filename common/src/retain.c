@@ -0,0 +1,66 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file retain.c
+ * @brief リセットをまたいで保持するアプリケーション状態ブロック
+ * @note ブロック自体は __noinit を付けて .noinit セクションに置くこと。
+ */
+
+#include "retain.h"
+
+static uint32_t calc_sum(const retain_hdr_t *hdr, uint32_t size);
+
+/**
+ * @brief 保持ブロックに封をする (ヘッダを更新する)
+ * @param[in,out] hdr 保持ブロックの先頭
+ * @param[in] size ヘッダを含むブロック全体のバイト数
+ * @return なし
+ */
+void retain_seal(retain_hdr_t *hdr, uint32_t size)
+{
+    hdr->size = size;
+    hdr->sum = calc_sum(hdr, size);
+    hdr->magic = RETAIN_MAGIC;
+}
+
+/**
+ * @brief 保持ブロックの内容が有効かを判定する
+ * @param[in] hdr 保持ブロックの先頭
+ * @param[in] size ヘッダを含むブロック全体のバイト数
+ * @return 1: 有効, 0: 無効 (コールドスタート、サイズ不一致、チェックサム不一致)
+ */
+uint8_t retain_valid(const retain_hdr_t *hdr, uint32_t size)
+{
+    if (!sys_warm_start()) return 0;
+    if (hdr->magic != RETAIN_MAGIC || hdr->size != size) return 0;
+    return hdr->sum == calc_sum(hdr, size);
+}
+
+/**
+ * @brief 保持ブロックを無効にする
+ * @param[out] hdr 保持ブロックの先頭
+ * @return なし
+ */
+void retain_invalidate(retain_hdr_t *hdr)
+{
+    hdr->magic = 0;
+}
+
+/**
+ * @brief ヘッダ以降のデータのチェックサムを計算する
+ * @param[in] hdr 保持ブロックの先頭
+ * @param[in] size ヘッダを含むブロック全体のバイト数
+ * @return チェックサム
+ * @note 1 ビット回転と XOR による簡易なもの。端数バイトも計算対象に含める。
+ */
+static uint32_t calc_sum(const retain_hdr_t *hdr, uint32_t size)
+{
+    const uint8_t *p = (const uint8_t *)(hdr + 1);
+    const uint8_t *end = (const uint8_t *)hdr + size;
+    uint32_t sum = RETAIN_MAGIC ^ size;
+
+    for (; p < end; p++) {
+        sum = ((sum << 1) | (sum >> 31)) ^ *p;
+    }
+    return sum;
+}
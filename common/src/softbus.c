@@ -0,0 +1,252 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file softbus.c
+ * @brief ソフトウェア SPI/I2C (ビットバング)
+ */
+
+#include "system.h"
+#include "softbus.h"
+
+static int8_t scl_high(bb_i2c_t *i2c);
+
+/**
+ * @brief ソフトウェア SPI を準備する
+ * @param[out] spi バス
+ * @param[in] sck SCK のピン BB_PIN(pno, nthbit)
+ * @param[in] mosi MOSI のピン
+ * @param[in] miso MISO のピン (BB_NC なら送信のみ)
+ * @param[in] hz クロック周波数 (上限は CPU クロックとループの粒度で決まる)
+ * @return 0: 成功, -1: 失敗
+ * @note bb_init() のあとで呼ぶこと。チップセレクトは呼び出し側で操作する。
+ */
+int8_t bb_spi_init(bb_spi_t *spi, uint8_t sck, uint8_t mosi, uint8_t miso, uint32_t hz)
+{
+    if (hz == 0) return -1;
+    if (bb_pin_init(&spi->sck, sck, BB_PUSHPULL) < 0) return -1;
+    if (bb_pin_init(&spi->mosi, mosi, BB_PUSHPULL) < 0) {
+        bb_pin_deinit(&spi->sck);
+        return -1;
+    }
+    spi->has_miso = (miso != BB_NC);
+    if (spi->has_miso && bb_pin_init(&spi->miso, miso, BB_OPENDRAIN) < 0) {
+        bb_pin_deinit(&spi->mosi);
+        bb_pin_deinit(&spi->sck);
+        return -1;
+    }
+
+    spi->half = bb_loops(500000000 / hz);
+    return 0;
+}
+
+/**
+ * @brief bb_spi_init() で準備したピンを返す
+ * @param[in] spi バス
+ * @return なし
+ */
+void bb_spi_deinit(bb_spi_t *spi)
+{
+    if (spi->has_miso) bb_pin_deinit(&spi->miso);
+    bb_pin_deinit(&spi->mosi);
+    bb_pin_deinit(&spi->sck);
+}
+
+/**
+ * @brief 1 バイト送受信する
+ * @param[in] spi バス
+ * @param[in] tx 送るデータ
+ * @return 受け取ったデータ (送信のみのときは 0)
+ */
+uint8_t bb_spi_xfer(bb_spi_t *spi, uint8_t tx)
+{
+    uint8_t rx = 0;
+
+    for (uint8_t m = 0x80; m; m >>= 1) {
+        if (tx & m) bb_high(&spi->mosi); else bb_low(&spi->mosi);
+        bb_delay(spi->half);
+        bb_high(&spi->sck);
+        if (spi->has_miso && bb_get(&spi->miso)) rx |= m;
+        bb_delay(spi->half);
+        bb_low(&spi->sck);
+    }
+    return rx;
+}
+
+/**
+ * @brief n バイト送受信する
+ * @param[in] spi バス
+ * @param[in] tx 送るデータ (NULL なら 0xFF を送る)
+ * @param[out] rx 受け取ったデータ (NULL なら捨てる)
+ * @param[in] n バイト数
+ * @return なし
+ */
+void bb_spi_transfer(bb_spi_t *spi, const uint8_t *tx, uint8_t *rx, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        uint8_t v = bb_spi_xfer(spi, tx ? tx[i] : 0xFF);
+        if (rx) rx[i] = v;
+    }
+}
+
+/**
+ * @brief ソフトウェア I2C を準備する
+ * @param[out] i2c バス
+ * @param[in] scl SCL のピン BB_PIN(pno, nthbit)
+ * @param[in] sda SDA のピン
+ * @param[in] hz クロック周波数 (100000 や 400000)
+ * @return 0: 成功, -1: 失敗
+ * @note bb_init() のあとで呼ぶこと。SCL, SDA とも外部のプルアップが必要。
+ */
+int8_t bb_i2c_init(bb_i2c_t *i2c, uint8_t scl, uint8_t sda, uint32_t hz)
+{
+    if (hz == 0) return -1;
+    if (bb_pin_init(&i2c->scl, scl, BB_OPENDRAIN) < 0) return -1;
+    if (bb_pin_init(&i2c->sda, sda, BB_OPENDRAIN) < 0) {
+        bb_pin_deinit(&i2c->scl);
+        return -1;
+    }
+
+    i2c->half = bb_loops(500000000 / hz);
+    i2c->stretch = (uint32_t)BB_I2C_STRETCH_US * 2 * (hz / 1000) / 1000 + 1;
+    return 0;
+}
+
+/**
+ * @brief bb_i2c_init() で準備したピンを返す
+ * @param[in] i2c バス
+ * @return なし
+ */
+void bb_i2c_deinit(bb_i2c_t *i2c)
+{
+    bb_pin_deinit(&i2c->sda);
+    bb_pin_deinit(&i2c->scl);
+}
+
+/**
+ * @brief スタートコンディション (またはリピーテッドスタート) を送る
+ * @param[in] i2c バス
+ * @return 0: 成功, -1: バスが開放されていない
+ */
+int8_t bb_i2c_start(bb_i2c_t *i2c)
+{
+    bb_release(&i2c->sda);
+    bb_delay(i2c->half);
+    if (scl_high(i2c) < 0) return -1;
+    if (!bb_get(&i2c->sda)) return -1;
+    bb_drive_low(&i2c->sda);
+    bb_delay(i2c->half);
+    bb_drive_low(&i2c->scl);
+    return 0;
+}
+
+/**
+ * @brief ストップコンディションを送る
+ * @param[in] i2c バス
+ * @return なし
+ */
+void bb_i2c_stop(bb_i2c_t *i2c)
+{
+    bb_drive_low(&i2c->sda);
+    bb_delay(i2c->half);
+    scl_high(i2c);
+    bb_delay(i2c->half);
+    bb_release(&i2c->sda);
+    bb_delay(i2c->half);
+}
+
+/**
+ * @brief 1 バイト送り、ACK を受け取る
+ * @param[in] i2c バス
+ * @param[in] v 送るデータ
+ * @return 0: ACK, -1: NACK またはクロックストレッチのタイムアウト
+ */
+int8_t bb_i2c_write(bb_i2c_t *i2c, uint8_t v)
+{
+    for (uint8_t m = 0x80; m; m >>= 1) {
+        if (v & m) bb_release(&i2c->sda); else bb_drive_low(&i2c->sda);
+        bb_delay(i2c->half);
+        if (scl_high(i2c) < 0) return -1;
+        bb_delay(i2c->half);
+        bb_drive_low(&i2c->scl);
+    }
+
+    bb_release(&i2c->sda);
+    bb_delay(i2c->half);
+    if (scl_high(i2c) < 0) return -1;
+    uint8_t nack = bb_get(&i2c->sda);
+    bb_delay(i2c->half);
+    bb_drive_low(&i2c->scl);
+    return nack ? -1 : 0;
+}
+
+/**
+ * @brief 1 バイト受け取り、ACK/NACK を返す
+ * @param[in] i2c バス
+ * @param[in] ack 1 なら ACK (続けて読む), 0 なら NACK (最後のバイト)
+ * @return 受け取ったデータ
+ */
+uint8_t bb_i2c_read(bb_i2c_t *i2c, uint8_t ack)
+{
+    uint8_t v = 0;
+
+    bb_release(&i2c->sda);
+    for (uint8_t m = 0x80; m; m >>= 1) {
+        bb_delay(i2c->half);
+        scl_high(i2c);
+        if (bb_get(&i2c->sda)) v |= m;
+        bb_delay(i2c->half);
+        bb_drive_low(&i2c->scl);
+    }
+
+    if (ack) bb_drive_low(&i2c->sda);
+    bb_delay(i2c->half);
+    scl_high(i2c);
+    bb_delay(i2c->half);
+    bb_drive_low(&i2c->scl);
+    bb_release(&i2c->sda);
+    return v;
+}
+
+/**
+ * @brief 書き込みと読み出しをまとめて行う
+ * @param[in] i2c バス
+ * @param[in] addr 7 ビットのスレーブアドレス
+ * @param[in] tx 書き込むデータ
+ * @param[in] ntx 書き込むバイト数 (0 なら書き込まない)
+ * @param[out] rx 読み出したデータ
+ * @param[in] nrx 読み出すバイト数 (0 なら読み出さない)
+ * @return 0: 成功, -1: 失敗 (NACK やバスエラー)
+ * @note 書き込みのあとはリピーテッドスタートで読み出しに移る。
+ */
+int8_t bb_i2c_xfer(bb_i2c_t *i2c, uint8_t addr, const uint8_t *tx, uint16_t ntx, uint8_t *rx, uint16_t nrx)
+{
+    int8_t r = 0;
+
+    if (ntx > 0) {
+        if (bb_i2c_start(i2c) < 0) return -1;
+        r = bb_i2c_write(i2c, addr << 1);
+        for (uint16_t i = 0; r == 0 && i < ntx; i++) r = bb_i2c_write(i2c, tx[i]);
+    }
+    if (r == 0 && nrx > 0) {
+        if (bb_i2c_start(i2c) < 0) return -1;
+        r = bb_i2c_write(i2c, (addr << 1) | 1);
+        for (uint16_t i = 0; r == 0 && i < nrx; i++) rx[i] = bb_i2c_read(i2c, i + 1 < nrx);
+    }
+    bb_i2c_stop(i2c);
+    return r;
+}
+
+/**
+ * @brief SCL を開放し、スレーブがクロックストレッチをやめるまで待つ
+ * @param[in] i2c バス
+ * @return 0: SCL が H になった, -1: タイムアウト
+ */
+static int8_t scl_high(bb_i2c_t *i2c)
+{
+    bb_release(&i2c->scl);
+    for (uint32_t n = i2c->stretch; !bb_get(&i2c->scl); n--) {
+        if (n == 0) return -1;
+        bb_delay(i2c->half);
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file stack.c
+ * @brief メインスタックの使用量 (最高水位) の計測
+ */
+
+#include "stack.h"
+
+/* リンカスクリプトのロケーションカウンタを参照する */
+extern uint32_t _stack_bottom;
+extern uint32_t _main_sp;
+
+/**
+ * @brief メインスタック領域のサイズを返す
+ * @return バイト数
+ */
+uint32_t stack_size(void)
+{
+    return (uint32_t)&_main_sp - (uint32_t)&_stack_bottom;
+}
+
+/**
+ * @brief リセット以降のメインスタックの最大使用量を返す
+ * @return バイト数
+ * @note 領域の底から、塗った値が残っているワードを数える。
+ *       たまたま STACK_PAINT と同じ値が積まれていると少なめに出ることがある。
+ */
+uint32_t stack_used_max(void)
+{
+    return stack_size() - stack_free_min();
+}
+
+/**
+ * @brief リセット以降のメインスタックの最小残量を返す
+ * @return バイト数 (0 ならあふれた可能性が高い)
+ */
+uint32_t stack_free_min(void)
+{
+    const uint32_t *p = &_stack_bottom;
+
+    while (p < &_main_sp && *p == STACK_PAINT) {
+        p++;
+    }
+    return (uint32_t)p - (uint32_t)&_stack_bottom;
+}
@@ -5,10 +5,14 @@
  * @brief ベクタテーブル, スタートアップルーチン
  */
 
+#include "stack.h"
+
+extern void sys_capture_reset(void);
 extern void sys_init(void);
 extern void main(void);
 
 /* リンカスクリプトのロケーションカウンタを参照する */
+extern unsigned long _stack_bottom;
 extern unsigned long _main_sp;
 extern unsigned long _data_org;
 extern unsigned long _sdata;
@@ -153,7 +157,23 @@ void reset_handler(void) __attribute__ ((section(".reset")));
  */
 void reset_handler(void)
 {
-    unsigned long *src, *dst;
+    unsigned long *src, *dst, *sp;
+
+    /* スタック領域の未使用部分を塗っておく (最大使用量の計測用; stack.c を参照) */
+    __asm volatile ("mov %0, sp" : "=r" (sp));
+    for (dst = &_stack_bottom; dst < sp;) {
+        *dst++ = STACK_PAINT;
+    }
+
+    /*
+     * リセット要因を保存してから、先にクロックを立ち上げる。
+     * sys_init() は初期化済みの RAM を使わないので、ここで呼んでおけば
+     * 後続の DATA/BSS 初期化は IRC (12 MHz) ではなく PLL のクロックで走る。
+     * .noinit セクションには手を付けないので、ウォームスタート時は
+     * アプリケーションの保持データがそのまま残る (retain.h を参照)。
+     */
+    sys_capture_reset();
+    sys_init();
 
     /* RAM の DATA 領域を初期化 (初期値を ROM からコピーする) */
     src = &_data_org;
@@ -166,26 +186,42 @@ void reset_handler(void)
         *dst++ = 0;
     }
 
-    sys_init();
     main();
 
     while (1);
 }
 
+void ex_handler(void) __attribute__ ((naked));
+void irq_handler(void) __attribute__ ((naked));
+
 /**
- * @brief システム例外のデフォルトハンドラ
- * @return なし
+ * @brief システム例外 (フォルトを含む) のデフォルトハンドラ
+ * @return なし (戻らない)
+ * @details 例外フレームを積んだスタック (MSP/PSP) を EXC_RETURN のビット 2 で選び、
+ *          r4..r11 を退避してから fault_capture() に渡す。
+ *          どのベクタから来たかは fault_capture() が IPSR から読み取る。
  */
 void ex_handler(void)
 {
-    while (1);
+    __asm volatile (
+        "tst    lr, #4          \n"
+        "ite    eq              \n"
+        "mrseq  r0, msp         \n"
+        "mrsne  r0, psp         \n"
+        "push   {r4-r11}        \n"
+        "mov    r1, sp          \n"
+        "mov    r2, lr          \n"
+        "b      fault_capture   \n"
+    );
 }
 
 /**
  * @brief IRQ (外部割込み) のデフォルトハンドラ
- * @return なし
+ * @return なし (戻らない)
+ * @details ハンドラが登録されていない IRQ が発生したということなので、
+ *          フォルトと同様にクラッシュレコードを残す。IRQ 番号は IPSR - 16 として残る。
  */
 void irq_handler(void)
 {
-    while (1);
+    __asm volatile ("b ex_handler");
 }
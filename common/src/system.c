@@ -9,18 +9,18 @@
 
 #include <stdint.h>
 #include "system.h"
+#include "fault.h"
+#include "initseq.h"
 
 #define CLOCK_SETUP  1
 #define SYSCLK_SETUP 1
-#define SYSOSC_SETUP 1
+#define SYSOSC_SETUP (CLKPLAN_SRC || CLKPLAN_USB)
 #define WDTOSC_SETUP 0
-#define SYSPLL_SETUP 1
+#define SYSPLL_SETUP (CLKPLAN_PLL)
 #define USBCLK_SETUP 1
-#define USBPLL_SETUP 1
+#define USBPLL_SETUP (CLKPLAN_USB)
 
 #define __SYS_OSC_CLK (__XTAL)        /* システムオシレータ sys_osc_clk */
-#define __IRC_OSC_CLK 12000000UL      /* IRC (Internal Resonant Crystal) オシレータ irc_osc_clk */
-#define __WDT_OSC_CLK 0               /* ウォッチドッグオシレータ wdt_osc_clk */
 
 #define SYSOSCCTRL_BYPASS 0
 #if (__SYS_OSC_CLK > 20000000UL)
@@ -30,48 +30,96 @@
 #endif
 #define SYSOSCCTRL_VAL       ((SYSOSCCTRL_FRANGE << 1) | SYSOSCCTRL_BYPASS)    /* [3.5.7] */
 #define WDTOSCCTRL_VAL       0x000000A0    /* [3.5.8] */
-#define SYSPLLCTRL_VAL       0x00000025    /* [3.5.3][3.11.4] */
-#define USBPLLCTRL_VAL       0x00000003    /* [3.5.5] */
-#define SYSAHBCLKCTRL_VAL    0x0001005F    /* [3.5.18] */
-#define SYSAHBCLKDIV_VAL     0x00000001    /* [3.5.17] */
-
-#define SYSPLLCLKSEL_VAL     0x00000001    /* [3.5.11] */
-#define MAINCLKSEL_VAL       0x00000003    /* [3.5.15] */
-#define USBPLLCLKSEL_VAL     0x00000001    /* [3.5.13] */
-
-/* sys_pllclkin [3.5.11] */
-#if ((SYSPLLCLKSEL_VAL & 3) == 1)
-  #define __SYS_PLLCLKIN (__SYS_OSC_CLK)
-#else
-  #define __SYS_PLLCLKIN (__IRC_OSC_CLK)
-#endif
 
-/* sys_pllclkout [3.5.7][3.5.3] */
-#if (SYSOSCCTRL_BYPASS == 0)
-  #define __SYS_PLLCLKOUT (__SYS_PLLCLKIN * ((SYSPLLCTRL_VAL & 0x1f) + 1))
-#else
-  #define __SYS_PLLCLKOUT (__SYS_OSC_CLK)
-#endif
+/* PLL の設定とシステムクロックは clkplan.h で決める */
+#define SYSPLLCTRL_VAL       CLKPLAN_SYSPLLCTRL      /* [3.5.3][3.11.4] */
+#define USBPLLCTRL_VAL       CLKPLAN_USBPLLCTRL      /* [3.5.5] */
+#define SYSAHBCLKDIV_VAL     CLKPLAN_AHBDIV          /* [3.5.17] */
+#define SYSPLLCLKSEL_VAL     CLKPLAN_SYSPLLCLKSEL    /* [3.5.11] */
+#define MAINCLKSEL_VAL       CLKPLAN_MAINCLKSEL      /* [3.5.15] */
+#define USBPLLCLKSEL_VAL     0x00000001              /* [3.5.13] */
 
-/* main_clk [3.5.15] */
-#if ((MAINCLKSEL_VAL & 3) == 1)
-  #define __MAIN_CLOCK (__SYS_PLLCLKIN)
-#elif ((MAINCLKSEL_VAL & 3) == 2)
-  #define __MAIN_CLOCK (__WDT_OSC_CLK)
-#elif ((MAINCLKSEL_VAL & 3) == 3)
-  #define __MAIN_CLOCK (__SYS_PLLCLKOUT)
-#else
-  #define __MAIN_CLOCK (__IRC_OSC_CLK)
+/* system_clk */
+#define __SYSTEM_CLOCK  (CLKPLAN_HZ)
+
+#if (SYSCLK_SETUP)
+/**
+ * システムクロックの初期設定
+ */
+static const initseq_t initseq_sysclk[] = {
+    #if (SYSOSC_SETUP)
+        INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_SYSOSC_PD_Msk),       /* システムオシレータ パワーダウン解除 [3.5.47] */
+        INITSEQ_WRITE(SYSCON(SYSOSCCTRL), SYSOSCCTRL_VAL),                  /* システムオシレータ 設定 [3.5.7] */
+        INITSEQ_DELAY(200),
+    #endif
+
+    #if (MAINCLKSEL_VAL != 0)
+        INITSEQ_WRITE(SYSCON(SYSPLLCLKSEL), SYSPLLCLKSEL_VAL),              /* システム PLL クロックソース選択 [3.5.11] */
+        INITSEQ_UPDATE(SYSCON(SYSPLLCLKUEN)),                               /* システム PLL クロックアップデート待ち [3.5.12] */
+    #endif
+
+    #if (SYSPLL_SETUP)
+        INITSEQ_WRITE(SYSCON(SYSPLLCTRL), SYSPLLCTRL_VAL),                  /* システム PLL 設定 [3.5.3] */
+        INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_SYSPLL_PD_Msk),       /* システム PLL パワーダウン解除 [3.5.47] */
+        INITSEQ_POLL(SYSCON(SYSPLLSTAT), SYSCON_SYSPLLSTAT_LOCK_Msk),       /* システム PLL ロック待ち [3.5.4] */
+    #endif
+
+    #if (WDTOSC_SETUP)
+        INITSEQ_WRITE(SYSCON(WDTOSCCTRL), WDTOSCCTRL_VAL),                  /* ウォッチドッグオシレータ 設定 [3.5.8] */
+        INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_WDTOSC_PD_Msk),       /* ウォッチドッグオシレータ パワーダウン解除 [3.5.47] */
+    #endif
+
+    /*
+     * ここまでは IRC (12 MHz) で動いているので、どのアクセス時間でも足りる。
+     * 切り替える前に、新しいクロックに合わせたアクセス時間と分周比にしておく。
+     * FLASHCFG の FLASHTIM 以外のビットは予約で変えてはならないので、読んだ値のまま書き戻す。
+     */
+    INITSEQ_MODIFY((uint32_t)&LPC_FMC->FLASHCFG, FMC_FLASHCFG_FLASHTIM_Msk, CLKPLAN_FLASHTIM),
+    INITSEQ_WRITE(SYSCON(SYSAHBCLKDIV), SYSAHBCLKDIV_VAL),                  /* システムクロック分周 [3.5.17] */
+
+    INITSEQ_WRITE(SYSCON(MAINCLKSEL), MAINCLKSEL_VAL),                      /* メインクロック クロックソース選択 [3.5.15] */
+    INITSEQ_UPDATE(SYSCON(MAINCLKUEN)),                                     /* メインクロックアップデート待ち [3.5.16] */
+};
 #endif
 
-/* system_clk */
-#define __SYSTEM_CLOCK  (__MAIN_CLOCK / SYSAHBCLKDIV_VAL)
+/**
+ * USB クロックの初期設定
+ */
+static const initseq_t initseq_usbclk[] = {
+    #if (USBCLK_SETUP)
+        INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_USBPAD_PD_Msk),       /* USB PHY チップ パワーダウン解除 [3.5.47] */
+
+        #if (USBPLL_SETUP)
+            INITSEQ_CLR(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_USBPLL_PD_Msk),   /* USB PLL パワーダウン解除 [3.5.47] */
+            INITSEQ_WRITE(SYSCON(USBPLLCLKSEL), USBPLLCLKSEL_VAL),          /* USB PLL クロックソース選択 [3.5.13] */
+            INITSEQ_UPDATE(SYSCON(USBPLLCLKUEN)),                           /* USB PLL クロックアップデート待ち [3.5.14] */
+            INITSEQ_WRITE(SYSCON(USBPLLCTRL), USBPLLCTRL_VAL),              /* USB PLL 設定 [3.5.5] */
+            INITSEQ_POLL(SYSCON(USBPLLSTAT), SYSCON_USBPLLSTAT_LOCK_Msk),   /* USB PLL ロック待ち [3.5.6] */
+            INITSEQ_WRITE(SYSCON(USBCLKSEL), 0),                            /* USB クロック選択; USB PLL out [3.5.24] */
+        #else
+            INITSEQ_WRITE(SYSCON(USBCLKSEL), 1),                            /* USB クロック選択; メインクロック [3.5.24] */
+        #endif
+    #else
+        INITSEQ_SET(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_USBPAD_PD_Msk),       /* USB PHY チップ パワーダウン有効 [3.5.47] */
+        INITSEQ_SET(SYSCON(PDRUNCFG), SYSCON_PDRUNCFG_USBPLL_PD_Msk),       /* USB PLL パワーダウン有効 [3.5.47] */
+    #endif
+};
 
-static void init_sysclk(void);
-static void init_usbclk(void);
-static inline void update_enable(uint32_t regaddr);
-static inline void nop(int n);
-static uint32_t s_sysclk;
+static uint32_t s_sysclk = __SYSTEM_CLOCK;    /* sys_init() は RAM 初期化前に呼ばれるので .data に置く */
+static uint32_t s_rstcause __noinit;
+static sys_clock_hook_t s_hooks[SYS_CLOCK_HOOKS];
+
+/**
+ * @brief リセット要因を読み出して保存し、SYSRESSTAT をクリアする
+ * @return なし
+ * @note .data/.bss の初期化より前にスタートアップルーチンから呼ばれる。\n
+ *       SYSRESSTAT はクリアするまで要因が積み重なるので、読んだらすぐクリアする。
+ */
+void sys_capture_reset(void)
+{
+    s_rstcause = LPC_SYSCON->SYSRESSTAT & 0x1F;
+    LPC_SYSCON->SYSRESSTAT = s_rstcause;    /* 1 を書いたビットがクリアされる [3.5.10] */
+}
 
 /**
  * @brief ターゲットシステムの初期化
@@ -79,15 +127,16 @@ static uint32_t s_sysclk;
  */
 void sys_init(void)
 {
+    fault_init();
+
     #if (CLOCK_SETUP)
-        init_sysclk();
-        init_usbclk();
+        #if (SYSCLK_SETUP)
+            INITSEQ_RUN(initseq_sysclk);
+        #endif
+        INITSEQ_RUN(initseq_usbclk);
     #else
-        reg_write(SYSCON(SYSAHBCLKDIV), SYSAHBCLKDIV_VAL);
-        reg_write(SYSCON(SYSAHBCLKCTRL), SYSAHBCLKCTRL_VAL);
+        LPC_SYSCON->SYSAHBCLKDIV = SYSAHBCLKDIV_VAL;    /* ペリフェラルのクロックは各ドライバが clkgate.h で点ける */
     #endif
-
-    s_sysclk = __SYSTEM_CLOCK;
 }
 
 /**
@@ -100,79 +149,65 @@ uint32_t sys_clock(void)
 }
 
 /**
- * @brief システムクロックの初期設定
+ * @brief システムクロックの周波数を設定し直す
+ * @param[in] hz 周波数 (clkcal.h で測った値など)
  * @return なし
+ * @details クロックの設定は変えず、sys_clock() の返す値だけを変える。
+ *          そのあと sys_clock_hook() で登録した関数を呼んで、派生した定数を計算し直させる。
  */
-static void init_sysclk(void)
+void sys_set_clock(uint32_t hz)
 {
-    #if (SYSCLK_SETUP)
-        #if (SYSOSC_SETUP)
-            __bb_clr_bit(SYSCON(PDRUNCFG), 5);                         /* システムオシレータ パワーダウン解除 [3.5.47] */
-            reg_write(SYSCON(SYSOSCCTRL), SYSOSCCTRL_VAL);           /* システムオシレータ 設定 [3.5.7] */
-            nop(200);
-
-            reg_write(SYSCON(SYSPLLCLKSEL), SYSPLLCLKSEL_VAL);       /* システム PLL クロックソース選択 [3.5.11] */
-            update_enable(SYSCON(SYSPLLCLKUEN));                     /* システム PLL クロックアップデート待ち [3.5.12] */
-
-            #if (SYSPLL_SETUP)
-                reg_write(SYSCON(SYSPLLCTRL), SYSPLLCTRL_VAL);       /* システム PLL 設定 [3.5.3] */
-                __bb_clr_bit(SYSCON(PDRUNCFG), 7);                     /* システム PLL パワーダウン解除 [3.5.47] */
-                while (__bb_read_bit(SYSCON(SYSPLLSTAT), 0) == 0);     /* システム PLL ロック待ち [3.5.4] */
-            #endif
-        #endif
+    uint8_t i;
 
-        #if (WDTOSC_SETUP)
-            reg_write(SYSCON(WDTOSCCTRL), WDTOSCCTRL_VAL);           /* ウォッチドッグオシレータ 設定 [3.5.8] */
-            __bb_clr_bit(SYSCON(PDRUNCFG), 6);                         /* ウォッチドッグオシレータ パワーダウン解除 [3.5.47] */
-        #endif
-
-        reg_write(SYSCON(MAINCLKSEL), MAINCLKSEL_VAL);               /* メインクロック クロックソース選択 [3.5.15] */
-        update_enable(SYSCON(MAINCLKUEN));                           /* メインクロックアップデート待ち [3.5.16] */
-    #endif
+    s_sysclk = hz;
+    for (i = 0; i < SYS_CLOCK_HOOKS && s_hooks[i]; i++) {
+        s_hooks[i](hz);
+    }
 }
 
 /**
- * @brief USB クロックの初期設定
- * @return なし
+ * @brief システムクロックの周波数が変わったときに呼ぶ関数を登録する
+ * @param[in] fn 関数 (同じ関数を 2 回登録しても 1 回しか呼ばない)
+ * @return 0: 成功, -1: 登録できる数を超えた
  */
-static void init_usbclk(void)
+int8_t sys_clock_hook(sys_clock_hook_t fn)
 {
-    #if (USBCLK_SETUP)
-        __bb_clr_bit(SYSCON(PDRUNCFG), 10);                          /* USB PHY チップ パワーダウン解除 [3.5.47] */
+    uint8_t i;
+
+    for (i = 0; i < SYS_CLOCK_HOOKS; i++) {
+        if (s_hooks[i] == fn) return 0;
+        if (!s_hooks[i]) {
+            s_hooks[i] = fn;
+            return 0;
+        }
+    }
+    return -1;
+}
 
-        #if (USBPLL_SETUP)
-            __bb_clr_bit(SYSCON(PDRUNCFG), 8);                       /* USB PLL パワーダウン解除 [3.5.47] */
-            reg_write(SYSCON(USBPLLCLKSEL), USBPLLCLKSEL_VAL);     /* USB PLL クロックソース選択 [3.5.13] */
-            update_enable(SYSCON(USBPLLCLKUEN));                   /* USB PLL クロックアップデート待ち [3.5.14] */
-            reg_write(SYSCON(USBPLLCTRL), USBPLLCTRL_VAL);         /* USB PLL 設定 [3.5.5] */
-            while (__bb_read_bit(SYSCON(USBPLLSTAT), 0) == 0);       /* USB PLL ロック待ち [3.5.6] */
-            reg_write(SYSCON(USBCLKSEL), 0);                       /* USB クロック選択; USB PLL out [3.5.24] */
-        #else
-            reg_write(SYSCON(USBCLKSEL), 1);                       /* USB クロック選択; メインクロック [3.5.24] */
-        #endif
-    #else
-        __bb_set_bit(SYSCON(PDRUNCFG), 10);                          /* USB PHY チップ パワーダウン有効 [3.5.47] */
-        __bb_set_bit(SYSCON(PDRUNCFG), 8);                           /* USB PLL パワーダウン有効 [3.5.47] */
-    #endif
+/**
+ * @brief 直前のリセット要因を返す
+ * @return RST_POR, RST_EXTRST, RST_WDT, RST_BOD, RST_SYSRST の論理和
+ */
+uint32_t sys_reset_cause(void)
+{
+    return s_rstcause;
 }
 
 /**
- * @brief クロックアップデート待ち
- * @return なし
+ * @brief ウォームスタート (RAM の内容が保持されているリセット) かを判定する
+ * @return 1: ウォームスタート, 0: コールドスタート
+ * @note パワーオンとブラウンアウトのときは RAM の内容が保証されないのでコールドとみなす。
  */
-static inline void update_enable(uint32_t regaddr)
+uint8_t sys_warm_start(void)
 {
-    __bb_write_bit(regaddr, 0, 1);
-    __bb_write_bit(regaddr, 0, 0);
-    __bb_write_bit(regaddr, 0, 1);
-    while (__bb_read_bit(regaddr, 0) == 0);
+    return (s_rstcause & (RST_POR | RST_BOD)) == 0;
 }
 
 /**
- * @brief nop を n 回実行する
- * @return なし
+ * @brief ソフトウェアリセットを発生させる
+ * @return なし (戻らない)
  */
-static inline void nop(int n)
+void sys_reset(void)
 {
-    for (; n > 0; n--) {  __asm("nop"); }
+    scb_sys_reset();
 }
@@ -7,9 +7,12 @@
 
 #include "system.h"
 #include "timer32.h"
+#include "clkgate.h"
 
 #define NUM_TIMER32 2
 
+static tmr32_wait_hook_t s_wait;       /* 待ちの出入りで呼ぶ関数 (cpuload.h) */
+
 /**
  * @brief タイマ初期化
  * @param[in] tno タイマ番号 (0 または 1)
@@ -18,10 +21,56 @@
 void tmr32_init(uint8_t tno)
 {
     if (tno >= NUM_TIMER32) return;
-    reg_set_bit(SYSCON(SYSAHBCLKCTRL), 9);
+    clkgate_acquire(CLKGATE_CT32B0 + tno);
     nvic_enable_irq(IRQ_TIMER32_0 + tno);
 }
 
+/**
+ * @brief タイマを止めてクロックを返す
+ * @param[in] tno タイマ番号 (0 または 1)
+ * @return なし
+ */
+void tmr32_deinit(uint8_t tno)
+{
+    if (tno >= NUM_TIMER32) return;
+    nvic_disable_irq(IRQ_TIMER32_0 + tno);
+    LPC_CT32Bn(tno)->TCR = 0;
+    clkgate_release(CLKGATE_CT32B0 + tno);
+}
+
+/**
+ * @brief 時間をタイマのクロックカウント値に換算する
+ * @param[in] t 時間 (単位は 1 / per 秒)
+ * @param[in] per 1 秒あたりの単位数 (ms なら 1000, us なら 1000000)
+ * @return クロックカウント値
+ */
+uint32_t tmr32_to_ticks(uint32_t t, uint32_t per)
+{
+    return t * ((sys_clock() / LPC_SYSCON->SYSAHBCLKDIV) / per);
+}
+
+/**
+ * @brief 指定したクロックカウント後に止まるようにタイマを開始する
+ * @param[in] tno タイマ番号 (0 または 1)
+ * @param[in] t クロックカウント値
+ * @return なし
+ * @note 止まったかどうかは TCR の CEN ビットでわかる。
+ */
+void tmr32_start(uint8_t tno, uint32_t t)
+{
+    ct32b_regs_t *tmr;
+
+    if (tno >= NUM_TIMER32) return;
+    tmr = LPC_CT32Bn(tno);
+
+    tmr->TCR = CT32B_TCR_CRST_Msk;         /* タイマカウンタリセット */
+    tmr->PR = 0;                           /* プリスケーラは使用しない */
+    tmr->MR0 = t;                          /* タイマカウンタとの比較値をセット */
+    tmr->IR = 0xFF;                        /* すべての割り込みをリセットする */
+    tmr->MCR = CT32B_MCR_MR0S_Msk;         /* MR0 の値に一致したらタイマを止める */
+    tmr->TCR = CT32B_TCR_CEN_Msk;          /* タイマ開始 */
+}
+
 /**
  * @brief ミリ秒単位で遅延を発生させる
  * @param[in] tno タイマ番号 (0 または 1)
@@ -32,16 +81,10 @@ void tmr32_delay_ms(uint8_t tno, uint32_t t)
 {
     if (tno >= NUM_TIMER32) return;
 
-    t *= ((sys_clock() / reg_read(SYSCON(SYSAHBCLKDIV))) / 1000);    /* 遅延時間をクロックカウント値に換算 */
-
-    reg_write(TMR32Bn(tno, TCR), 0x02);    /* タイマカウンタリセット */
-    reg_write(TMR32Bn(tno, PR), 0x00);     /* プリスケーラは使用しない */
-    reg_write(TMR32Bn(tno, MR0), t);       /* タイマカウンタとの比較値をセット */
-    reg_write(TMR32Bn(tno, IR), 0xFF);     /* すべての割り込みをリセットする */
-    reg_write(TMR32Bn(tno, MCR), 0x04);    /* MR0 の値に一致したらタイマを止める */
-    reg_write(TMR32Bn(tno, TCR), 0x01);    /* タイマ開始 */
-
-    while (reg_read_bit(TMR32Bn(tno, TCR), 0));
+    tmr32_start(tno, tmr32_to_ticks(t, 1000));
+    if (s_wait) s_wait(1);
+    while (LPC_CT32Bn(tno)->TCR & CT32B_TCR_CEN_Msk);
+    if (s_wait) s_wait(0);
 }
 
 /**
@@ -54,14 +97,18 @@ void tmr32_delay_us(uint8_t tno, uint32_t t)
 {
     if (tno >= NUM_TIMER32) return;
 
-    t *= ((sys_clock() / reg_read(SYSCON(SYSAHBCLKDIV))) / 1000000);    /* 遅延時間をクロックカウント値に換算 */
-
-    reg_write(TMR32Bn(tno, TCR), 0x02);    /* タイマカウンタリセット */
-    reg_write(TMR32Bn(tno, PR), 0x00);     /* プリスケーラは使用しない */
-    reg_write(TMR32Bn(tno, MR0), t);       /* タイマカウンタとの比較値をセット */
-    reg_write(TMR32Bn(tno, IR), 0xFF);     /* すべての割り込みをリセットする */
-    reg_write(TMR32Bn(tno, MCR), 0x04);    /* MR0 の値に一致したらタイマを止める */
-    reg_write(TMR32Bn(tno, TCR), 0x01);    /* タイマ開始 */
+    tmr32_start(tno, tmr32_to_ticks(t, 1000000));
+    if (s_wait) s_wait(1);
+    while (LPC_CT32Bn(tno)->TCR & CT32B_TCR_CEN_Msk);
+    if (s_wait) s_wait(0);
+}
 
-    while (reg_read_bit(TMR32Bn(tno, TCR), 0));
+/**
+ * @brief 遅延の待ちに入るときと出るときに呼ぶ関数を登録する
+ * @param[in] fn 関数 (引数は 1: 入る, 0: 出る), 0 なら登録を外す
+ * @return なし
+ */
+void tmr32_wait_hook(tmr32_wait_hook_t fn)
+{
+    s_wait = fn;
 }
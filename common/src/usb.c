@@ -0,0 +1,310 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file usb.c
+ * @brief USB デバイスのコントロール転送 (EP0) とディスクリプタ処理
+ * @note コメント内の [x.x] は USB 2.0 仕様書の章節番号を示す。
+ */
+
+#include "usb.h"
+#include "usbhw.h"
+
+/* コントロール転送のステージ [8.5.3] */
+#define CTRL_IDLE       0    /* SETUP 待ち */
+#define CTRL_DATA_IN    1    /* IN データステージ送信中 */
+#define CTRL_DATA_OUT   2    /* OUT データステージ受信中 */
+#define CTRL_STATUS_IN  3    /* ステータスステージの ZLP 送信中 */
+#define CTRL_STATUS_OUT 4    /* ホストからのステータスステージ ZLP 待ち */
+
+#define ADDR_PENDING 0x80    /* SET_ADDRESS を受けてステータスステージの完了待ち */
+
+/**
+ * コントロール転送の状態
+ */
+typedef struct ctrl {
+    union {
+        usb_setup_t req;
+        uint32_t w[2];                  /* usbhw_read_ep() はワード単位で読むので */
+    } setup;
+    const uint8_t *in_ptr;              /* IN データステージの残りデータ */
+    uint8_t *out_ptr;                   /* OUT データステージの格納先 */
+    uint16_t remain;                    /* データステージの残りバイト数 */
+    uint8_t zlp;                        /* IN データステージの最後に ZLP を送る */
+    uint8_t stage;                      /* CTRL_* */
+    uint8_t addr;                       /* 保留中のデバイスアドレス (ADDR_PENDING 付き) */
+    uint8_t config;                     /* 現在のコンフィギュレーション値 */
+} ctrl_t;
+
+static const usb_class_t *s_cls;
+static ctrl_t s_ctrl;
+static uint32_t s_ep0buf[USB_EP0_SIZE / 4];
+static uint8_t s_reply[2];
+
+static int8_t std_request(const usb_setup_t *req, uint8_t **data, uint16_t *len);
+static void send_in(void);
+static void status_in(void);
+static void stall_ep0(void);
+
+/**
+ * @brief USB デバイスを初期化してバスに接続する
+ * @param[in] cls USB クラスの定義
+ * @return なし
+ */
+void usb_init(const usb_class_t *cls)
+{
+    s_cls = cls;
+    s_ctrl.stage = CTRL_IDLE;
+    s_ctrl.addr = 0;
+    s_ctrl.config = 0;
+
+    usbhw_init();
+    usbhw_connect(1);
+}
+
+/**
+ * @brief 現在のコンフィギュレーション値を返す
+ * @return コンフィギュレーション値 (0 なら未コンフィギュレーション)
+ */
+uint8_t usb_configuration(void)
+{
+    return s_ctrl.config;
+}
+
+/**
+ * @brief バスリセットの処理
+ * @return なし
+ */
+void usb_on_reset(void)
+{
+    s_ctrl.stage = CTRL_IDLE;
+    s_ctrl.addr = 0;
+    if (s_ctrl.config) {
+        s_ctrl.config = 0;
+        if (s_cls->configured) s_cls->configured(0);
+    }
+}
+
+/**
+ * @brief SETUP パケットの処理 [9.3]
+ * @return なし
+ */
+void usb_on_setup(void)
+{
+    const usb_setup_t *req = &s_ctrl.setup.req;
+    uint8_t *data = 0;
+    uint16_t len = 0;
+    int8_t r = -1;
+
+    usbhw_read_ep(0x00, s_ctrl.setup.w);
+
+    switch (req->bmRequestType & USB_REQ_TYPE_MASK) {
+    case USB_REQ_STANDARD:
+        r = std_request(req, &data, &len);
+        break;
+    case USB_REQ_CLASS:
+    case USB_REQ_VENDOR:
+        if (s_cls->request) r = s_cls->request(req, &data, &len);
+        break;
+    }
+
+    if (r < 0) {
+        stall_ep0();
+        return;
+    }
+
+    if (req->wLength == 0) {
+        status_in();
+    } else if (req->bmRequestType & USB_REQ_DIR_IN) {
+        if (len > req->wLength) len = req->wLength;
+        s_ctrl.in_ptr = data;
+        s_ctrl.remain = len;
+        s_ctrl.zlp = (len < req->wLength);    /* 要求より短く、最後が満杯のパケットなら ZLP で終端する */
+        s_ctrl.stage = CTRL_DATA_IN;
+        send_in();
+    } else {
+        s_ctrl.out_ptr = data;
+        s_ctrl.remain = req->wLength;
+        s_ctrl.stage = CTRL_DATA_OUT;
+    }
+}
+
+/**
+ * @brief EP0 のイベント処理
+ * @param[in] ep 0x00: OUT パケットを受信した, 0x80: IN パケットの送信が完了した
+ * @return なし
+ */
+void usb_on_ep0(uint8_t ep)
+{
+    if (ep & 0x80) {
+        if (s_ctrl.stage == CTRL_DATA_IN) {
+            if (s_ctrl.remain > 0 || s_ctrl.zlp) {
+                send_in();
+            } else {
+                s_ctrl.stage = CTRL_STATUS_OUT;
+            }
+        } else if (s_ctrl.stage == CTRL_STATUS_IN) {
+            if (s_ctrl.addr & ADDR_PENDING) {
+                s_ctrl.addr &= ~ADDR_PENDING;
+                usbhw_set_address(s_ctrl.addr);    /* アドレスはステータスステージの完了後に切り替える [9.4.6] */
+            }
+            s_ctrl.stage = CTRL_IDLE;
+        }
+        return;
+    }
+
+    uint16_t n = usbhw_read_ep(0x00, s_ep0buf);
+
+    if (s_ctrl.stage == CTRL_DATA_OUT) {
+        const uint8_t *src = (const uint8_t *)s_ep0buf;
+        uint16_t i;
+
+        if (n > s_ctrl.remain) n = s_ctrl.remain;
+        for (i = 0; i < n; i++) {
+            *s_ctrl.out_ptr++ = src[i];
+        }
+        s_ctrl.remain -= n;
+
+        if (s_ctrl.remain == 0 || n < USB_EP0_SIZE) {
+            if (s_cls->request_done) s_cls->request_done(&s_ctrl.setup.req);
+            status_in();
+        }
+    } else {
+        s_ctrl.stage = CTRL_IDLE;    /* ステータスステージの ZLP、またはホストによる中断 */
+    }
+}
+
+/**
+ * @brief EP0 以外のエンドポイントのイベント処理
+ * @param[in] ep 論理エンドポイントアドレス (IN は 0x80 付き)
+ * @return なし
+ */
+void usb_on_ep(uint8_t ep)
+{
+    if (s_ctrl.config && s_cls->ep_event) {
+        s_cls->ep_event(ep);
+    }
+}
+
+/**
+ * @brief 標準リクエストの処理 [9.4]
+ * @param[in] req SETUP パケット
+ * @param[out] data IN データステージで返すデータ
+ * @param[out] len IN データステージで返すデータのバイト数
+ * @return 0: 受理, -1: 未対応
+ */
+static int8_t std_request(const usb_setup_t *req, uint8_t **data, uint16_t *len)
+{
+    uint8_t rcpt = req->bmRequestType & USB_REQ_RCPT_MASK;
+    uint8_t idx = req->wValue & 0xFF;
+
+    switch (req->bRequest) {
+    case USB_GET_STATUS:
+        s_reply[0] = 0;
+        s_reply[1] = 0;
+        if (rcpt == USB_REQ_ENDPOINT && (req->wIndex & 0x0F) != 0) {
+            s_reply[0] = (usbhw_ep_status(req->wIndex & 0x8F) & USB_EPSTAT_ST) ? 1 : 0;
+        }
+        *data = s_reply;
+        *len = 2;
+        return 0;
+
+    case USB_CLEAR_FEATURE:
+    case USB_SET_FEATURE:
+        if (rcpt != USB_REQ_ENDPOINT || req->wValue != USB_FEATURE_ENDPOINT_HALT) return -1;
+        if ((req->wIndex & 0x0F) != 0) {
+            usbhw_stall_ep(req->wIndex & 0x8F, req->bRequest == USB_SET_FEATURE);
+        }
+        return 0;
+
+    case USB_SET_ADDRESS:
+        s_ctrl.addr = ADDR_PENDING | (req->wValue & 0x7F);
+        return 0;
+
+    case USB_GET_DESCRIPTOR:
+        switch (req->wValue >> 8) {
+        case USB_DESC_DEVICE:
+            *data = (uint8_t *)s_cls->dev_desc;
+            *len = s_cls->dev_desc[0];
+            return 0;
+        case USB_DESC_CONFIGURATION:
+            if (idx != 0) return -1;
+            *data = (uint8_t *)s_cls->cfg_desc;
+            *len = s_cls->cfg_desc[2] | (s_cls->cfg_desc[3] << 8);    /* wTotalLength */
+            return 0;
+        case USB_DESC_STRING:
+            if (idx >= s_cls->num_str) return -1;
+            *data = (uint8_t *)s_cls->str_desc[idx];
+            *len = s_cls->str_desc[idx][0];
+            return 0;
+        }
+        return -1;    /* DEVICE_QUALIFIER などはフルスピード専用デバイスなのでストールする [9.6.2] */
+
+    case USB_GET_CONFIGURATION:
+        s_reply[0] = s_ctrl.config;
+        *data = s_reply;
+        *len = 1;
+        return 0;
+
+    case USB_SET_CONFIGURATION:
+        if (idx != 0 && idx != s_cls->cfg_desc[5]) return -1;    /* bConfigurationValue */
+        usbhw_configure(idx != 0);
+        s_ctrl.config = idx;
+        if (s_cls->configured) s_cls->configured(idx);
+        return 0;
+
+    case USB_GET_INTERFACE:
+        s_reply[0] = 0;
+        *data = s_reply;
+        *len = 1;
+        return 0;
+
+    case USB_SET_INTERFACE:
+        return (req->wValue == 0) ? 0 : -1;    /* 代替設定は持たない */
+    }
+
+    return -1;
+}
+
+/**
+ * @brief IN データステージの次のパケットを送る
+ * @return なし
+ * @note usbhw_write_ep() はワード単位で書くので、いったん EP0 バッファにコピーする。
+ */
+static void send_in(void)
+{
+    uint8_t *dst = (uint8_t *)s_ep0buf;
+    uint16_t n = (s_ctrl.remain < USB_EP0_SIZE) ? s_ctrl.remain : USB_EP0_SIZE;
+    uint16_t i;
+
+    for (i = 0; i < n; i++) {
+        dst[i] = s_ctrl.in_ptr[i];
+    }
+    usbhw_write_ep(0x80, s_ep0buf, n);
+
+    s_ctrl.in_ptr += n;
+    s_ctrl.remain -= n;
+    if (n < USB_EP0_SIZE) {
+        s_ctrl.zlp = 0;    /* 短パケットで終端したので ZLP は不要 */
+    }
+}
+
+/**
+ * @brief ステータスステージ (IN 方向の ZLP) を送る
+ * @return なし
+ */
+static void status_in(void)
+{
+    usbhw_write_ep(0x80, s_ep0buf, 0);
+    s_ctrl.stage = CTRL_STATUS_IN;
+}
+
+/**
+ * @brief リクエストを拒否する (EP0 をストールする)
+ * @return なし
+ * @note 次の SETUP パケットで自動的に解除される。
+ */
+static void stall_ep0(void)
+{
+    usbhw_stall_ep(0x80, 1);
+    s_ctrl.stage = CTRL_IDLE;
+}
@@ -0,0 +1,367 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file usbhw.c
+ * @brief LPC1343 USB デバイスコントローラのドライバ
+ * @noop コメント内の [x.x.x] は LPC13xx ユーザマニュアル (UM10375) の章節番号を示す。
+ * @details 論理 EP3 (物理 EP6/EP7) のダブルバッファのバルクエンドポイントを
+ *          USB_FIQ に振り分け、コントロール転送を扱う USB_IRQ より高い優先度で処理する。
+ *          SIE コマンドと Ctrl レジスタの操作は割込みをまたいで分断されると壊れるので、
+ *          crit_enter(USB_FIQ_PRIO) で USB_FIQ をマスクしてから行う。
+ */
+
+#include "system.h"
+#include "vector.h"
+#include "clkgate.h"
+#include "usb.h"
+#include "usbhw.h"
+
+/* USBDevIntSt のビット [10.10.3] */
+#define DEVINT_FRAME    (1 << 0)
+#define DEVINT_EP(phy)  (1 << (1 + (phy)))
+#define DEVINT_DEV_STAT (1 << 9)
+#define DEVINT_CC_EMPTY (1 << 10)
+#define DEVINT_CD_FULL  (1 << 11)
+
+/* USBDevFIQSel のビット [10.10.5] */
+#define FIQSEL_BULKOUT  (1 << 1)
+#define FIQSEL_BULKIN   (1 << 2)
+
+/* USBCtrl, USBRxPLen のビット [10.10.8][10.10.9] */
+#define CTRL_RD_EN      (1 << 0)
+#define CTRL_WR_EN      (1 << 1)
+#define RXPLEN_DV       (1 << 10)
+#define RXPLEN_PKT_RDY  (1 << 11)
+
+/* SIE コマンド [10.10.4] */
+#define CMD_PHASE_WRITE   0x0100
+#define CMD_PHASE_READ    0x0200
+#define CMD_PHASE_COMMAND 0x0500
+#define SIE_SET_ADDRESS   0xD0
+#define SIE_CONFIGURE     0xD8
+#define SIE_SET_MODE      0xF3
+#define SIE_SET_DEV_STAT  0xFE
+#define SIE_GET_DEV_STAT  0xFE
+#define SIE_SELECT_EP     0x00
+#define SIE_SELECT_EP_CLR 0x40
+#define SIE_SET_EP_STAT   0x40
+#define SIE_CLEAR_BUFFER  0xF2
+#define SIE_VALIDATE_BUF  0xFA
+
+#define DEV_STAT_CON      (1 << 0)
+#define DEV_STAT_RST      (1 << 4)
+#define DEV_EN            (1 << 7)
+#define EP_STAT_ST        (1 << 0)    /* ストール */
+#define EP_STAT_CND_ST    (1 << 7)    /* EP0: 次の SETUP まで両方向ストール */
+
+#define BULK_EP           3                               /* ダブルバッファのバルクエンドポイント */
+#define FIQ_EPS           (DEVINT_EP(BULK_EP << 1) | DEVINT_EP((BULK_EP << 1) | 1))
+#define IRQ_EPS           ((0xFF << 1) & ~FIQ_EPS)
+
+static void usbhw_irq_handler(void);
+static void usbhw_fiq_handler(void);
+static void dispatch_ep(uint32_t st);
+static void sie_command(uint8_t code);
+static void sie_write(uint8_t code, uint8_t data);
+static uint8_t sie_read(uint8_t code);
+
+/**
+ * @brief 論理エンドポイントアドレスを物理エンドポイント番号に変換する
+ * @param[in] ep 論理エンドポイントアドレス (IN は 0x80 付き)
+ * @return 物理エンドポイント番号 (0..7)
+ */
+static inline uint8_t phy_ep(uint8_t ep)
+{
+    return ((ep & 0x0F) << 1) | (ep >> 7);
+}
+
+/**
+ * @brief USB デバイスコントローラの初期化
+ * @return なし
+ * @note USB クロック (48 MHz) は sys_init() の初期化シーケンス (initseq_usbclk) で立ち上げ済みであること。
+ */
+void usbhw_init(void)
+{
+    clkgate_acquire(CLKGATE_USB_REG);                /* USB_REG クロック有効 [3.5.18] */
+    clkgate_acquire(CLKGATE_IOCON);                  /* IOCON クロック有効 [3.5.18] */
+    reg_write(IOCON(PIO0_3), 0x01);                  /* PIO0_3: USB_VBUS [7.4.9] */
+    reg_write(IOCON(PIO0_6), 0x01);                  /* PIO0_6: USB_CONNECT [7.4.18] */
+
+    reg_write(USB(DevIntClr), 0xFFFFFFFF);
+    reg_write(USB(DevFIQSel), FIQSEL_BULKOUT | FIQSEL_BULKIN);
+    reg_write(USB(DevIntEn), DEVINT_DEV_STAT | IRQ_EPS | FIQ_EPS);
+    sie_write(SIE_SET_MODE, 0x01);                   /* AP_CLK: サスペンド中もクロックを止めない */
+
+    vector_install(IRQ_USBIRQ, usbhw_irq_handler);
+    vector_install(IRQ_USBFIQ, usbhw_fiq_handler);
+    nvic_set_priority(IRQ_USBIRQ, USB_IRQ_PRIO);
+    nvic_set_priority(IRQ_USBFIQ, USB_FIQ_PRIO);
+    nvic_enable_irq(IRQ_USBIRQ);
+    nvic_enable_irq(IRQ_USBFIQ);
+}
+
+/**
+ * @brief バスへの接続/切断 (USB_CONNECT によるプルアップの制御)
+ * @param[in] on 1: 接続, 0: 切断
+ * @return なし
+ */
+void usbhw_connect(uint8_t on)
+{
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+    sie_write(SIE_SET_DEV_STAT, on ? DEV_STAT_CON : 0);
+    crit_exit(c);
+}
+
+/**
+ * @brief デバイスアドレスを設定する
+ * @param[in] addr デバイスアドレス (0..127)
+ * @return なし
+ * @note SIE は 2 回書かれてはじめてアドレスを切り替える [10.10.4.1]
+ */
+void usbhw_set_address(uint8_t addr)
+{
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+    sie_write(SIE_SET_ADDRESS, DEV_EN | addr);
+    sie_write(SIE_SET_ADDRESS, DEV_EN | addr);
+    crit_exit(c);
+}
+
+/**
+ * @brief デバイスのコンフィギュレーション状態を設定する
+ * @param[in] on 1: コンフィギュレーション済み, 0: 解除
+ * @return なし
+ * @note コンフィギュレーションしたときはバルク/インタラプトエンドポイントのストールも解除する。
+ */
+void usbhw_configure(uint8_t on)
+{
+    uint8_t phy;
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+
+    sie_write(SIE_CONFIGURE, on ? 1 : 0);
+    if (on) {
+        for (phy = 2; phy < 8; phy++) {
+            sie_write(SIE_SET_EP_STAT + phy, 0);
+        }
+    }
+    crit_exit(c);
+}
+
+/**
+ * @brief OUT エンドポイントから 1 パケットを読み出す
+ * @param[in] ep 論理エンドポイントアドレス
+ * @param[out] buf 格納先 (ワード境界に揃っていること; 最大パケットサイズ分の領域が必要)
+ * @return 受信したバイト数
+ * @note RxData はワード単位でしか読めないので、端数のバイトを含むワードも丸ごと書く。
+ */
+uint16_t usbhw_read_ep(uint8_t ep, uint32_t *buf)
+{
+    uint32_t len, i;
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+
+    reg_write(USB(Ctrl), ((ep & 0x0F) << 2) | CTRL_RD_EN);
+    do {
+        len = reg_read(USB(RxPLen));
+    } while (!(len & RXPLEN_PKT_RDY));
+    len &= 0x3FF;
+
+    for (i = 0; i < len; i += 4) {
+        *buf++ = reg_read(USB(RxData));
+    }
+    reg_write(USB(Ctrl), 0);
+
+    sie_command(SIE_SELECT_EP + phy_ep(ep));
+    sie_command(SIE_CLEAR_BUFFER);                   /* バッファを解放して次のパケットを受けられるようにする */
+    crit_exit(c);
+
+    return len;
+}
+
+/**
+ * @brief IN エンドポイントに 1 パケットを書き込んで送信可能にする
+ * @param[in] ep 論理エンドポイントアドレス (0x80 付き)
+ * @param[in] buf 送信データ (ワード境界に揃っていること)
+ * @param[in] len バイト数 (0 なら ZLP)
+ * @return なし
+ */
+void usbhw_write_ep(uint8_t ep, const uint32_t *buf, uint16_t len)
+{
+    uint32_t i;
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+
+    reg_write(USB(Ctrl), ((ep & 0x0F) << 2) | CTRL_WR_EN);
+    reg_write(USB(TxPLen), len);
+    for (i = 0; i < len; i += 4) {
+        reg_write(USB(TxData), *buf++);
+    }
+    reg_write(USB(Ctrl), 0);
+
+    sie_command(SIE_SELECT_EP + phy_ep(ep));
+    sie_command(SIE_VALIDATE_BUF);
+    crit_exit(c);
+}
+
+/**
+ * @brief エンドポイントをストール/ストール解除する
+ * @param[in] ep 論理エンドポイントアドレス (IN は 0x80 付き)
+ * @param[in] stall 1: ストール, 0: 解除
+ * @return なし
+ * @note EP0 は条件付きストールとし、次の SETUP パケットで解除されるようにする。
+ */
+void usbhw_stall_ep(uint8_t ep, uint8_t stall)
+{
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+
+    if ((ep & 0x0F) == 0) {
+        sie_write(SIE_SET_EP_STAT, stall ? EP_STAT_CND_ST : 0);
+    } else {
+        sie_write(SIE_SET_EP_STAT + phy_ep(ep), stall ? EP_STAT_ST : 0);
+    }
+    crit_exit(c);
+}
+
+/**
+ * @brief エンドポイントの状態を返す (割込みフラグは変えない)
+ * @param[in] ep 論理エンドポイントアドレス (IN は 0x80 付き)
+ * @return USB_EPSTAT_* の論理和
+ */
+uint8_t usbhw_ep_status(uint8_t ep)
+{
+    crit_t c = crit_enter(USB_FIQ_PRIO);
+    uint8_t st = sie_read(SIE_SELECT_EP + phy_ep(ep));
+    crit_exit(c);
+    return st;
+}
+
+/**
+ * @brief エンドポイントの割込みをソフトウェアで発生させる
+ * @param[in] ep 論理エンドポイントアドレス (IN は 0x80 付き)
+ * @return なし
+ * @details スレッドから送信キューに積んだときや受信バッファを空けたときに呼び、
+ *          エンドポイントの処理を割込みハンドラ側で再開させる。レジスタへの 1 回の書き込みで済む。
+ */
+void usbhw_kick_ep(uint8_t ep)
+{
+    reg_write(USB(DevIntSet), DEVINT_EP(phy_ep(ep)));
+}
+
+/**
+ * @brief USB_FIQ をマスクする
+ * @return usbhw_unlock() に渡す値
+ * @note 上位層が USB_FIQ と共有する変数を USB_IRQ やスレッドから書き換えるときに使う。
+ */
+uint32_t usbhw_lock(void)
+{
+    return crit_enter(USB_FIQ_PRIO);
+}
+
+/**
+ * @brief usbhw_lock() でマスクした USB_FIQ を元に戻す
+ * @param[in] old usbhw_lock() が返した値
+ * @return なし
+ */
+void usbhw_unlock(uint32_t old)
+{
+    crit_exit(old);
+}
+
+/**
+ * @brief USB_IRQ ハンドラ: バス状態の変化とコントロール転送
+ * @return なし
+ */
+static void usbhw_irq_handler(void)
+{
+    uint32_t st = reg_read(USB(DevIntSt)) & reg_read(USB(DevIntEn)) & ~FIQ_EPS;
+
+    if (st & DEVINT_DEV_STAT) {
+        crit_t c = crit_enter(USB_FIQ_PRIO);
+        uint8_t ds;
+
+        reg_write(USB(DevIntClr), DEVINT_DEV_STAT);
+        ds = sie_read(SIE_GET_DEV_STAT);
+        crit_exit(c);
+        if (ds & DEV_STAT_RST) {
+            usb_on_reset();
+        }
+    }
+
+    dispatch_ep(st & IRQ_EPS);
+}
+
+/**
+ * @brief USB_FIQ ハンドラ: バルクエンドポイント
+ * @return なし
+ */
+static void usbhw_fiq_handler(void)
+{
+    dispatch_ep(reg_read(USB(DevIntSt)) & FIQ_EPS);
+}
+
+/**
+ * @brief エンドポイントの割込みを上位層に通知する
+ * @param[in] st USBDevIntSt のエンドポイントのビット
+ * @return なし
+ */
+static void dispatch_ep(uint32_t st)
+{
+    uint8_t phy;
+
+    for (phy = 0; st; phy++) {
+        if (!(st & DEVINT_EP(phy))) continue;
+        st &= ~DEVINT_EP(phy);
+
+        crit_t c = crit_enter(USB_FIQ_PRIO);
+        reg_write(USB(DevIntClr), DEVINT_EP(phy));
+        uint8_t es = sie_read(SIE_SELECT_EP_CLR + phy);    /* SIE 側の割込みもクリアする */
+        crit_exit(c);
+
+        uint8_t ep = ((phy & 1) << 7) | (phy >> 1);
+        if (phy == 0 && (es & USB_EPSTAT_STP)) {
+            usb_on_setup();
+        } else if (phy < 2) {
+            usb_on_ep0(ep);
+        } else {
+            usb_on_ep(ep);
+        }
+    }
+}
+
+/**
+ * @brief SIE にコマンドを送る
+ * @param[in] code コマンドコード
+ * @return なし
+ */
+static void sie_command(uint8_t code)
+{
+    reg_write(USB(DevIntClr), DEVINT_CC_EMPTY | DEVINT_CD_FULL);
+    reg_write(USB(CmdCode), CMD_PHASE_COMMAND | ((uint32_t)code << 16));
+    while (!(reg_read(USB(DevIntSt)) & DEVINT_CC_EMPTY));
+    reg_write(USB(DevIntClr), DEVINT_CC_EMPTY);
+}
+
+/**
+ * @brief SIE にデータ付きのコマンドを送る
+ * @param[in] code コマンドコード
+ * @param[in] data 書き込むデータ
+ * @return なし
+ */
+static void sie_write(uint8_t code, uint8_t data)
+{
+    sie_command(code);
+    reg_write(USB(CmdCode), CMD_PHASE_WRITE | ((uint32_t)data << 16));
+    while (!(reg_read(USB(DevIntSt)) & DEVINT_CC_EMPTY));
+    reg_write(USB(DevIntClr), DEVINT_CC_EMPTY);
+}
+
+/**
+ * @brief SIE にコマンドを送って応答を読み出す
+ * @param[in] code コマンドコード
+ * @return 応答データ
+ */
+static uint8_t sie_read(uint8_t code)
+{
+    sie_command(code);
+    reg_write(USB(CmdCode), CMD_PHASE_READ | ((uint32_t)code << 16));
+    while (!(reg_read(USB(DevIntSt)) & DEVINT_CD_FULL));
+    reg_write(USB(DevIntClr), DEVINT_CD_FULL);
+    return reg_read(USB(CmdData)) & 0xFF;
+}
@@ -0,0 +1,100 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file vector.c
+ * @brief RAM 上のベクタテーブル (VTOR による再配置)
+ */
+
+#include "vector.h"
+
+extern const vector_entry vectors[];
+
+/*
+ * RAM 上のベクタテーブル。
+ * VTOR にはテーブルサイズを 2 のべき乗に切り上げた境界 (ここでは 512 バイト) が必要なので、
+ * リンカスクリプトで RAM の先頭 (.ramvector セクション) に配置する。
+ * vector_relocate() を呼ばないプログラムでは --gc-sections で取り除かれる。
+ */
+__attribute__ ((section(".ramvector"), aligned(512)))
+static vector_entry s_ramvec[NUM_VECTORS];
+
+static vector_entry s_wrappers[VECTOR_WRAPPERS];
+
+/**
+ * @brief ベクタテーブルを RAM にコピーして VTOR を切り替える
+ * @return なし
+ * @note 既に切り替え済みなら何もしない。VTOR の書き換えは 1 回のストアなので、
+ *       割込み許可中に呼んでもよい。
+ */
+void vector_relocate(void)
+{
+    uint32_t i;
+
+    if (reg_read(SCB(VTOR)) == (uint32_t)s_ramvec) return;
+
+    for (i = 0; i < NUM_VECTORS; i++) {
+        s_ramvec[i] = vectors[i];
+    }
+    __asm volatile ("dsb" ::: "memory");
+    reg_write(SCB(VTOR), (uint32_t)s_ramvec);
+    __asm volatile ("dsb\n isb" ::: "memory");
+}
+
+/**
+ * @brief 割込み (またはシステム例外) のハンドラを実行時に登録する
+ * @param[in] n 割込みの番号 (システム例外は負の値; EX_PENDSV など)
+ * @param[in] handler ハンドラ
+ * @return なし
+ * @note 必要ならまず vector_relocate() で RAM のテーブルに切り替える。
+ */
+void vector_install(irq_t n, vector_entry handler)
+{
+    vector_relocate();
+    s_ramvec[16 + n] = handler;
+    __asm volatile ("dsb" ::: "memory");
+}
+
+/**
+ * @brief 現在有効なベクタテーブルから割込みのハンドラを返す
+ * @param[in] n 割込みの番号 (システム例外は負の値)
+ * @return ハンドラ
+ */
+vector_entry vector_get(irq_t n)
+{
+    const vector_entry *tbl = (const vector_entry *)reg_read(SCB(VTOR));
+    return tbl[16 + n];
+}
+
+/**
+ * @brief 元のハンドラを包んで呼ぶ関数を登録する
+ * @param[in] w 計測用の関数など
+ * @return 0: 成功 (登録済みを含む), -1: 登録できる数を超えた
+ */
+int8_t vector_add_wrapper(vector_entry w)
+{
+    uint8_t i;
+
+    for (i = 0; i < VECTOR_WRAPPERS; i++) {
+        if (s_wrappers[i] == w) return 0;
+        if (!s_wrappers[i]) {
+            s_wrappers[i] = w;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief ハンドラが vector_add_wrapper() で登録された関数かどうかを返す
+ * @param[in] h ハンドラ
+ * @return 1: 登録された関数, 0: それ以外
+ */
+uint8_t vector_is_wrapper(vector_entry h)
+{
+    uint8_t i;
+
+    for (i = 0; i < VECTOR_WRAPPERS && s_wrappers[i]; i++) {
+        if (s_wrappers[i] == h) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file ws2812.c
+ * @brief WS2812 (シリアル LED) のビットバング送信
+ */
+
+#include "system.h"
+#include "ws2812.h"
+
+static uint32_t adjust(uint32_t n, int32_t delta) __ramfunc;
+
+/**
+ * @brief WS2812 のストリングを準備する
+ * @param[out] ws ストリング
+ * @param[in] spec データ線のピン BB_PIN(pno, nthbit)
+ * @return 0: 成功, -1: 失敗
+ * @note bb_init() のあとで呼ぶこと。クロックを変えたら bb_init() とあわせて呼び直す。
+ */
+int8_t ws2812_init(ws2812_t *ws, uint8_t spec)
+{
+    if (bb_pin_init(&ws->pin, spec, BB_PUSHPULL) < 0) return -1;
+
+    ws->t0h = bb_loops(WS2812_T0H_NS);
+    ws->t1h = bb_loops(WS2812_T1H_NS);
+    ws->t0l = bb_loops(WS2812_T0L_NS);
+    ws->t1l = bb_loops(WS2812_T1L_NS);
+    ws->treset = bb_loops(WS2812_RESET_NS);
+    ws->period = bb_cycles(WS2812_T0H_NS + WS2812_T0L_NS);
+    ws->bit_cycles = 0;
+    return 0;
+}
+
+/**
+ * @brief ws2812_init() で準備したピンを返す
+ * @param[in] ws ストリング
+ * @return なし
+ */
+void ws2812_deinit(ws2812_t *ws)
+{
+    bb_pin_deinit(&ws->pin);
+}
+
+/**
+ * @brief ピクセルデータを送ってラッチさせる
+ * @param[in] ws ストリング
+ * @param[in] grb ピクセルデータ (1 ピクセル 3 バイト, G, R, B の順, MSB から送る)
+ * @param[in] npixel ピクセル数
+ * @return なし
+ * @note 戻るまでに WS2812_RESET_NS だけ待つ。
+ */
+void ws2812_write(ws2812_t *ws, const uint8_t *grb, uint16_t npixel)
+{
+    volatile uint32_t *cyccnt = (volatile uint32_t *)DWT(CYCCNT);
+    const bb_pin_t *pin = &ws->pin;
+    uint32_t t = 0;
+
+    for (uint16_t i = 0; i < npixel; i++) {
+        uint32_t v = irq_save();
+        if (i == 0) t = *cyccnt;
+        for (uint8_t k = 0; k < 3; k++) {
+            uint8_t b = *grb++;
+            for (uint8_t m = 0x80; m; m >>= 1) {
+                if (b & m) {
+                    bb_pulse(pin, ws->t1h);
+                    bb_spin(ws->t1l);
+                } else {
+                    bb_pulse(pin, ws->t0h);
+                    bb_spin(ws->t0l);
+                }
+            }
+        }
+        if (i == 0) t = *cyccnt - t;
+        irq_restore(v);
+    }
+
+    /* 最初のピクセルで測った周期のずれを次の送信の L の幅で補正する */
+    if (g_bb_cal.dwt && npixel > 0) {
+        ws->bit_cycles = t / 24;
+        int32_t delta = ((int32_t)ws->period - (int32_t)ws->bit_cycles) * 256 / (int32_t)g_bb_cal.loop_q8;
+        ws->t0l = adjust(ws->t0l, delta);
+        ws->t1l = adjust(ws->t1l, delta);
+    }
+
+    bb_delay(ws->treset);
+}
+
+/**
+ * @brief ループ回数を delta だけ増減する (1 回未満にはしない)
+ * @param[in] n ループ回数
+ * @param[in] delta 増減
+ * @return 補正したループ回数
+ */
+static uint32_t adjust(uint32_t n, int32_t delta)
+{
+    int32_t r = (int32_t)n + delta;
+    return (r < 1) ? 1 : (uint32_t)r;
+}
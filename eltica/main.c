@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 #include "system.h"
+#include "cpuload.h"
+#include "isrtrace.h"
 
 #define TMRNO 0    /* タイマ番号 (0 または 1) */
 
@@ -23,6 +25,10 @@ int main(void)
     gpio_write(3, 0, led);
 
     tmr32_init(TMRNO);
+    cpuload_start();    /* 負荷は g_cpuload にある (デバッガで読む) */
+    #if (ISRTRACE_ENABLE)
+        isrtrace_start();    /* tools/isrtrace.sh で吸い出す */
+    #endif
 
     /* 1000 ms 間隔で LED 出力を反転させる */
     while (1) {
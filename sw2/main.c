@@ -7,6 +7,9 @@
 
 #include <stdint.h>
 #include "system.h"
+#include "cpuload.h"
+#include "clkgate.h"
+#include "isrtrace.h"
 
 #define TMRNO 0    /* タイマ番号 (0 または 1) */
 
@@ -16,6 +19,7 @@
  */
 int main(void)
 {
+    clkgate_acquire(CLKGATE_IOCON);
     reg_write(IOCON(PIO0_1), 0xD0);    /* PIO0_1: Pull-up */
 
     gpio_init();
@@ -23,6 +27,10 @@ int main(void)
     gpio_set_dir(0, 7, 1);             /* GPIO0_7: LED 出力 */
 
     tmr32_init(TMRNO);
+    cpuload_start();                   /* 負荷は g_cpuload にある (デバッガで読む) */
+    #if (ISRTRACE_ENABLE)
+        isrtrace_start();              /* tools/isrtrace.sh で吸い出す */
+    #endif
 
     gpio_write(0, 1, 0);
     gpio_write(0, 7, 0);
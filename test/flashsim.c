@@ -0,0 +1,81 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file flashsim.c
+ * @brief 内蔵フラッシュのモデル (ホスト上のテスト用)
+ */
+
+#include <string.h>
+#include "flashsim.h"
+
+static int8_t erase(const kvs_flash_t *f, uint8_t sector);
+static int8_t program(const kvs_flash_t *f, uint32_t off, const uint32_t *page);
+
+/**
+ * @brief 消去済みのフラッシュを作る
+ * @param[out] fs モデル
+ * @param[in] sector_size セクタのバイト数 (KVS_PAGE の倍数)
+ * @param[in] nsectors セクタ数
+ * @return なし
+ */
+void flashsim_init(flashsim_t *fs, uint32_t sector_size, uint8_t nsectors)
+{
+    memset(fs, 0, sizeof(*fs));
+    memset(fs->mem, 0xFF, sizeof(fs->mem));
+    fs->flash.base = (const uint8_t *)fs->mem;
+    fs->flash.sector_size = sector_size;
+    fs->flash.nsectors = nsectors;
+    fs->flash.erase = erase;
+    fs->flash.program = program;
+}
+
+/**
+ * @brief 今回の操作を失敗させるかを判定する
+ * @return !0: 失敗させる
+ */
+static uint8_t failing(flashsim_t *fs)
+{
+    fs->ops++;
+    if (fs->fail_at && fs->ops == fs->fail_at) {
+        fs->failed++;
+        return 1;
+    }
+    return 0;
+}
+
+static int8_t erase(const kvs_flash_t *f, uint8_t sector)
+{
+    flashsim_t *fs = (flashsim_t *)f;
+    uint8_t *p = (uint8_t *)fs->mem + sector * f->sector_size;
+    uint32_t n = f->sector_size;
+
+    if (sector >= f->nsectors) {
+        fs->misaligned++;
+        return -1;
+    }
+    if (failing(fs)) n = fs->tear ? fs->tear % n : n / 2;
+    memset(p, 0xFF, n);
+    if (n < f->sector_size) return -1;
+    fs->erase_count[sector]++;
+    return 0;
+}
+
+static int8_t program(const kvs_flash_t *f, uint32_t off, const uint32_t *page)
+{
+    flashsim_t *fs = (flashsim_t *)f;
+    uint8_t *p = (uint8_t *)fs->mem + off;
+    const uint8_t *src = (const uint8_t *)page;
+    uint32_t i, n = KVS_PAGE;
+
+    if (off % KVS_PAGE != 0 || off + KVS_PAGE > f->sector_size * f->nsectors) {
+        fs->misaligned++;
+        return -1;
+    }
+    if (failing(fs)) n = fs->tear ? fs->tear % n : n / 2;
+    for (i = 0; i < n; i++) {
+        if (src[i] & ~p[i]) fs->raise++;
+        p[i] &= src[i];
+    }
+    fs->programs++;
+    return (n < KVS_PAGE) ? -1 : 0;
+}
@@ -0,0 +1,41 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file flashsim.h
+ * @brief 内蔵フラッシュのモデル (ホスト上のテスト用)
+ * @details kvs_flash_t の erase()/program() を実装する。実機のフラッシュと同じく
+ *          - 書き込みはビットを 1 から 0 にしか変えない (0 を 1 に戻そうとしたら raise を数える)
+ *          - 消去はセクタ単位で全ビットを 1 にする
+ *          - 書き込みは KVS_PAGE バイトのページ単位で、境界に揃っていなければ拒否する (misaligned を数える)
+ *          とする。fail_at を設定すると、その回数目の消去/書き込みを途中で止めて失敗を返す
+ *          (電源断の模擬。消去はセクタの、書き込みはページの先頭 tear バイトだけ行う)。
+ */
+
+#ifndef __FLASHSIM_H__
+#define __FLASHSIM_H__
+
+#include <stdint.h>
+#include "kvs.h"
+
+#define FLASHSIM_MAX_BYTES 0x4000
+#define FLASHSIM_MAX_SECTORS 16
+
+/**
+ * フラッシュのモデル
+ */
+typedef struct flashsim {
+    kvs_flash_t flash;                  /* kvs_mount() に渡す (先頭に置くこと) */
+    uint32_t mem[FLASHSIM_MAX_BYTES / 4];
+    uint32_t ops;                       /* 消去と書き込みの回数 */
+    uint32_t fail_at;                   /* この回数目の操作を失敗させる (0 なら失敗させない) */
+    uint32_t tear;                      /* 失敗させた操作が済ませるバイト数 (0 ならセクタ/ページの半分) */
+    uint32_t failed;                    /* 失敗させた回数 */
+    uint32_t programs;
+    uint32_t erase_count[FLASHSIM_MAX_SECTORS];
+    uint32_t misaligned;                /* 境界に揃っていない, 範囲外の書き込み/消去 */
+    uint32_t raise;                     /* 0 のビットを 1 にしようとした書き込み */
+} flashsim_t;
+
+void flashsim_init(flashsim_t *fs, uint32_t sector_size, uint8_t nsectors);
+
+#endif
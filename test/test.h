@@ -0,0 +1,51 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file test.h
+ * @brief ホスト上のテストの判定と結果表示
+ * @details 1 つのテストプログラムは 1 つの .c ファイルの main() で、CHECK() を並べて
+ *          最後に TEST_END() の値を返す。失敗した CHECK() はその場で表示し、続きも実行する。
+ */
+
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdio.h>
+
+static int s_test_total;
+static int s_test_fail;
+
+/**
+ * @def CHECK(cond)
+ * cond が成り立たなければ失敗として表示する。
+ */
+#define CHECK(cond) do { \
+    s_test_total++; \
+    if (!(cond)) { \
+        s_test_fail++; \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+/**
+ * @def CHECK_EQ(a, b)
+ * a == b でなければ両方の値とともに失敗として表示する。
+ */
+#define CHECK_EQ(a, b) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    s_test_total++; \
+    if (a_ != b_) { \
+        s_test_fail++; \
+        fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", \
+                __FILE__, __LINE__, #a, #b, a_, b_); \
+    } \
+} while (0)
+
+/**
+ * @def TEST_END()
+ * 結果を表示し、main() の戻り値 (0: すべて成功, 1: 失敗あり) を返す。
+ */
+#define TEST_END() \
+    (printf("%s: %d/%d passed\n", __FILE__, s_test_total - s_test_fail, s_test_total), s_test_fail ? 1 : 0)
+
+#endif
@@ -0,0 +1,386 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file test_dsp.c
+ * @brief dsp.c (固定小数点の信号処理) のテスト
+ * @details ホストでは dsp.h の ARM 以外の式 (SSAT, SMLAL と同じ結果) でコンパイルされる。
+ *          1 サンプルずつ素直に 64 ビットで計算する参照実装と、出力がビット単位で一致することを
+ *          乱数の入力と飽和する入力 (最大振幅の矩形波, 利得の大きい係数) で確かめる。
+ *          ブロックの切れ目でも状態が正しく引き継がれるよう、長さを変えながら処理する。
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "dsp.h"
+#include "test.h"
+
+#define LEN    1024                     /* 入力の長さ */
+#define MAXTAP 40                       /* FIR のタップ数の上限 */
+#define NINPUT 3                        /* 入力の種類 */
+
+static q15_t s_in15[NINPUT][LEN];
+static q31_t s_in31[NINPUT][LEN];
+static q15_t s_out15[LEN];
+static q31_t s_out31[LEN];
+static q15_t s_st15[MAXTAP * 2];
+static q31_t s_st31[MAXTAP * 2];
+static uint32_t s_seed = 1;
+
+/**
+ * @brief 乱数 (xorshift32)
+ */
+static uint32_t rnd(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+/**
+ * @brief 次のブロックの長さ (0 も含めて不規則に変える)
+ */
+static uint32_t chunk(uint32_t i)
+{
+    uint32_t n = rnd() % 40;
+    return (i + n > LEN) ? LEN - i : n;
+}
+
+static int64_t clamp(int64_t v, int64_t lo, int64_t hi)
+{
+    return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+/**
+ * @brief 入力を作る
+ * @details 0: 乱数 (全範囲), 1: 最大振幅の矩形波 (周期を変えながら), 2: 小さな値と最大値の混在
+ */
+static void make_inputs(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < LEN; i++) {
+        uint32_t r = rnd();
+        s_in15[0][i] = (q15_t)r;
+        s_in31[0][i] = (q31_t)rnd();
+        s_in15[1][i] = ((i / (1 + i / 128)) & 8) ? -32768 : 32767;
+        s_in31[1][i] = ((i / (1 + i / 128)) & 8) ? -0x7FFFFFFF - 1 : 0x7FFFFFFF;
+        s_in15[2][i] = (r & 0x300) ? (q15_t)((int32_t)(r >> 16) % 64) : ((r & 1) ? -32768 : 32767);
+        s_in31[2][i] = (r & 0x300) ? (int32_t)(r >> 16) % 64 : ((r & 1) ? -0x7FFFFFFF - 1 : 0x7FFFFFFF);
+    }
+}
+
+/**
+ * @brief FIR の係数を作る
+ * @param[in] sat !0 なら全部同じ符号にして、矩形波で飽和させる
+ * @details Q15 は絶対値の和を 2.0 未満にする (dsp.h の条件)。Q31 は同じ値を 65536 倍する。
+ */
+static void make_fir(q15_t *h15, q31_t *h31, uint32_t ntaps, uint8_t sat)
+{
+    uint32_t k, lim = 65535 / ntaps;
+
+    for (k = 0; k < ntaps; k++) {
+        h15[k] = sat ? (q15_t)lim : (q15_t)((int32_t)(rnd() % (2 * lim + 1)) - (int32_t)lim);
+        h31[k] = h15[k] * 65536;
+    }
+}
+
+/**
+ * @brief FIR (Q15, Q31)
+ */
+static void test_fir(void)
+{
+    static const uint16_t taps[] = { 1, 2, 3, 4, 5, 7, 16, 33, MAXTAP };
+    q15_t h15[MAXTAP];
+    q31_t h31[MAXTAP];
+    uint32_t t, in, sat, i, k, n, bad15, bad31;
+
+    for (t = 0; t < sizeof(taps) / sizeof(taps[0]); t++) {
+        for (sat = 0; sat < 2; sat++) {
+            make_fir(h15, h31, taps[t], sat);
+            for (in = 0; in < NINPUT; in++) {
+                const q15_t *x15 = s_in15[in];
+                const q31_t *x31 = s_in31[in];
+                dsp_fir_q15_t f15;
+                dsp_fir_q31_t f31;
+
+                dsp_fir_q15_init(&f15, h15, s_st15, taps[t]);
+                dsp_fir_q31_init(&f31, h31, s_st31, taps[t]);
+                for (i = 0; i < LEN; i += n) {
+                    n = chunk(i);
+                    dsp_fir_q15(&f15, &x15[i], &s_out15[i], n);
+                    dsp_fir_q31(&f31, &x31[i], &s_out31[i], n);
+                }
+
+                for (i = bad15 = bad31 = 0; i < LEN; i++) {
+                    int64_t a15 = 0x4000, a31 = 1LL << 30;
+                    for (k = 0; k < taps[t] && k <= i; k++) {
+                        a15 += (int64_t)h15[k] * x15[i - k];
+                        a31 += (int64_t)h31[k] * x31[i - k];
+                    }
+                    if (s_out15[i] != clamp(a15 >> 15, -32768, 32767)) bad15++;
+                    if (s_out31[i] != clamp(a31 >> 31, -0x7FFFFFFFLL - 1, 0x7FFFFFFF)) bad31++;
+                }
+                CHECK_EQ(bad15, 0);
+                CHECK_EQ(bad31, 0);
+            }
+        }
+    }
+
+    /* その場で処理する (in == out) */
+    make_fir(h15, h31, 16, 0);
+    {
+        dsp_fir_q15_t f15, g15;
+        q15_t buf[LEN];
+
+        memcpy(buf, s_in15[0], sizeof(buf));
+        dsp_fir_q15_init(&f15, h15, s_st15, 16);
+        dsp_fir_q15(&f15, buf, buf, LEN);
+        dsp_fir_q15_init(&g15, h15, s_st15, 16);
+        dsp_fir_q15(&g15, s_in15[0], s_out15, LEN);
+        CHECK(memcmp(buf, s_out15, sizeof(buf)) == 0);
+    }
+}
+
+/**
+ * @brief 双二次 IIR の縦続接続 (Q15, Q31)
+ */
+static void test_biquad(void)
+{
+    /* 2 段の低域通過と、利得が大きく飽和する 3 段 (Q14; a1, a2 は符号を反転したもの) */
+    static const q15_t lp15[10] = {
+        1024, 2048, 1024, 21000, -8900,
+        4096, -8192, 4096, 24000, -11000,
+    };
+    static const q15_t hot15[15] = {
+        32767, 32767, 32767, 30000, -14000,
+        -32768, 16384, 32767, -16000, -15000,
+        32767, -32768, 32767, 0, 16000,
+    };
+    const q15_t *coefs[2] = { lp15, hot15 };
+    const uint8_t stages[2] = { 2, 3 };
+    q31_t c31[15];
+    uint32_t set, in, i, s, n, bad15, bad31;
+
+    for (set = 0; set < 2; set++) {
+        const q15_t *c15 = coefs[set];
+
+        /* Q30: 係数の絶対値の和が 4.0 未満なら 64 ビットの累算で桁あふれしない */
+        for (i = 0; i < stages[set] * 5U; i++) c31[i] = (c15[i] * 65536) / 2;
+        for (in = 0; in < NINPUT; in++) {
+            const q15_t *x15 = s_in15[in];
+            const q31_t *x31 = s_in31[in];
+            int64_t z15[3][4], z31[3][4];
+            dsp_biquad_q15_t b15;
+            dsp_biquad_q31_t b31;
+
+            dsp_biquad_q15_init(&b15, c15, s_st15, stages[set]);
+            dsp_biquad_q31_init(&b31, c31, s_st31, stages[set]);
+            for (i = 0; i < LEN; i += n) {
+                n = chunk(i);
+                dsp_biquad_q15(&b15, &x15[i], &s_out15[i], n);
+                dsp_biquad_q31(&b31, &x31[i], &s_out31[i], n);
+            }
+
+            memset(z15, 0, sizeof(z15));
+            memset(z31, 0, sizeof(z31));
+            for (i = bad15 = bad31 = 0; i < LEN; i++) {
+                int64_t y15 = x15[i], y31 = x31[i];
+                for (s = 0; s < stages[set]; s++) {
+                    const q15_t *c = &c15[s * 5];
+                    const q31_t *d = &c31[s * 5];
+                    int64_t a15 = (1 << 13) + c[0] * y15 + c[1] * z15[s][0] + c[2] * z15[s][1]
+                                  + c[3] * z15[s][2] + c[4] * z15[s][3];
+                    int64_t a31 = (1 << 29) + d[0] * y31 + d[1] * z31[s][0] + d[2] * z31[s][1]
+                                  + d[3] * z31[s][2] + d[4] * z31[s][3];
+                    z15[s][1] = z15[s][0];
+                    z15[s][0] = y15;
+                    z15[s][3] = z15[s][2];
+                    /* Q15 は (int32_t) に切り詰めてから飽和させる (dsp.c と同じ) */
+                    z15[s][2] = y15 = clamp((int32_t)(a15 >> 14), -32768, 32767);
+                    z31[s][1] = z31[s][0];
+                    z31[s][0] = y31;
+                    z31[s][3] = z31[s][2];
+                    z31[s][2] = y31 = clamp(a31 >> 30, -0x7FFFFFFFLL - 1, 0x7FFFFFFF);
+                }
+                if (s_out15[i] != y15) bad15++;
+                if (s_out31[i] != y31) bad31++;
+            }
+            CHECK_EQ(bad15, 0);
+            CHECK_EQ(bad31, 0);
+        }
+    }
+}
+
+/**
+ * @brief 移動平均 (2 のべきはシフト, それ以外は除算; 負の無限大の方向に切り捨てる)
+ */
+static void test_mavg(void)
+{
+    static const uint16_t lens[] = { 1, 2, 3, 15, 16, 17, 64, 100, 256 };
+    static q15_t buf[256];
+    uint32_t l, in, i, k, n, bad;
+
+    for (l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        for (in = 0; in < NINPUT; in++) {
+            const q15_t *x = s_in15[in];
+            dsp_mavg_t ma;
+
+            dsp_mavg_init(&ma, buf, lens[l]);
+            for (i = 0; i < LEN; i += n) {
+                n = chunk(i);
+                dsp_mavg(&ma, &x[i], &s_out15[i], n);
+            }
+            for (i = bad = 0; i < LEN; i++) {
+                int64_t sum = 0;
+                for (k = 0; k < lens[l] && k <= i; k++) sum += x[i - k];
+                if (s_out15[i] != (q15_t)floor((double)sum / lens[l])) bad++;
+            }
+            CHECK_EQ(bad, 0);
+        }
+    }
+}
+
+static int cmp15(const void *a, const void *b)
+{
+    return *(const q15_t *)a - *(const q15_t *)b;
+}
+
+/**
+ * @brief メディアン (窓を毎回並べ替える参照実装と比べる)
+ */
+static void test_median(void)
+{
+    static const uint8_t lens[] = { 1, 3, 5, 9, 31, 255 };
+    static q15_t hist[255], sorted[255], w[255];
+    q15_t dup[LEN];
+    uint32_t l, in, i, j, n, bad;
+    dsp_median_t md;
+
+    CHECK_EQ(dsp_median_init(&md, hist, sorted, 8), -1);
+
+    /* 同じ値が多い入力 (窓から抜く値の探索を試す) */
+    for (i = 0; i < LEN; i++) dup[i] = (rnd() % 5) * 8000 - 16000;
+
+    for (l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        for (in = 0; in <= NINPUT; in++) {
+            const q15_t *x = (in < NINPUT) ? s_in15[in] : dup;
+
+            CHECK_EQ(dsp_median_init(&md, hist, sorted, lens[l]), 0);
+            for (i = 0; i < LEN; i += n) {
+                n = chunk(i);
+                dsp_median(&md, &x[i], &s_out15[i], n);
+            }
+            for (i = bad = 0; i < LEN; i++) {
+                for (j = 0; j < lens[l]; j++) w[j] = (i + j >= lens[l] - 1U) ? x[i + j + 1 - lens[l]] : 0;
+                qsort(w, lens[l], sizeof(w[0]), cmp15);
+                if (s_out15[i] != w[lens[l] / 2]) bad++;
+            }
+            CHECK_EQ(bad, 0);
+        }
+    }
+}
+
+/**
+ * @brief 間引き (同じ係数の FIR の出力の m 個に 1 個と一致すること)
+ */
+static void test_decim(void)
+{
+    q15_t h15[MAXTAP];
+    q31_t h31[MAXTAP];
+    uint32_t m, in, sat, i, k, n, cnt, bad;
+
+    for (m = 1; m <= 5; m++) {
+        for (sat = 0; sat < 2; sat++) {
+            make_fir(h15, h31, 16 + m, sat);
+            for (in = 0; in < NINPUT; in++) {
+                const q15_t *x = s_in15[in];
+                dsp_decim_q15_t dc;
+
+                dsp_decim_q15_init(&dc, h15, s_st15, 16 + m, m);
+                for (i = cnt = 0; i < LEN; i += n) {
+                    n = chunk(i);
+                    k = dsp_decim_q15(&dc, &x[i], &s_out15[cnt], n);
+                    CHECK(k <= n / m + 1);
+                    cnt += k;
+                }
+                CHECK_EQ(cnt, LEN / m);
+                for (i = bad = 0; i < cnt; i++) {
+                    uint32_t t = i * m + m - 1;
+                    int64_t acc = 0x4000;
+                    for (k = 0; k < 16 + m && k <= t; k++) acc += (int64_t)h15[k] * x[t - k];
+                    if (s_out15[i] != clamp(acc >> 15, -32768, 32767)) bad++;
+                }
+                CHECK_EQ(bad, 0);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 整数の平方根 (r^2 <= x < (r + 1)^2)
+ */
+static void test_isqrt(void)
+{
+    uint32_t i, bad = 0;
+
+    for (i = 0; i < 200000; i++) {
+        uint32_t x = (i < 65536) ? i : (i < 131072) ? (i - 65536) * (i - 65536) - (i & 1) : rnd();
+        uint64_t r = dsp_isqrt32(x);
+        if (r * r > x || (r + 1) * (r + 1) <= x) bad++;
+    }
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(dsp_isqrt32(0xFFFFFFFF), 0xFFFF);
+    CHECK_EQ(dsp_isqrt32(0xFFFE0001), 0xFFFF);
+    CHECK_EQ(dsp_isqrt32(0xFFFE0000), 0xFFFE);
+}
+
+/**
+ * @brief atan2 (libm と比べて約 0.1 度以内, 軸と対角線は正確)
+ */
+static void test_atan2(void)
+{
+    uint32_t i, bad = 0;
+    int32_t worst = 0;
+
+    CHECK_EQ(dsp_atan2_q15(0, 0), 0);
+    CHECK_EQ(dsp_atan2_q15(0, 100), 0);
+    CHECK_EQ(dsp_atan2_q15(100, 0), 16384);
+    CHECK_EQ(dsp_atan2_q15(0, -100), -32768);
+    CHECK_EQ(dsp_atan2_q15(-100, 0), -16384);
+    CHECK_EQ(dsp_atan2_q15(100, 100), 8192);
+    CHECK_EQ(dsp_atan2_q15(-100, -100), -24576);
+    CHECK_EQ(dsp_atan2_q15(65535, 65535), 8192);
+
+    for (i = 0; i < 200000; i++) {
+        /* |値| < 2^16 (大きさもまちまちにする) */
+        int32_t sh = rnd() % 16;
+        int32_t y = ((int32_t)(rnd() % 131071) - 65535) >> sh;
+        int32_t x = ((int32_t)(rnd() % 131071) - 65535) >> sh;
+        int32_t ref, err;
+
+        if (!x && !y) continue;
+        ref = (int32_t)lrint(atan2(y, x) * 32768 / M_PI);
+        err = (int16_t)(dsp_atan2_q15(y, x) - ref);     /* pi と -pi は同じ */
+        if (err < 0) err = -err;
+        if (err > worst) worst = err;
+        if (err > 19) bad++;                            /* 0.1 度 = 18.2 */
+    }
+    CHECK_EQ(bad, 0);
+    printf("atan2_q15: max error %d (%.3f deg)\n", worst, worst * 180.0 / 32768);
+}
+
+int main(void)
+{
+    make_inputs();
+    test_fir();
+    test_biquad();
+    test_mavg();
+    test_median();
+    test_decim();
+    test_isqrt();
+    test_atan2();
+
+    return TEST_END();
+}
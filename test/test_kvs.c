@@ -0,0 +1,372 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file test_kvs.c
+ * @brief kvs.c (フラッシュ上のキーバリューストア) のテスト
+ * @details flashsim.c のフラッシュの上で動かし、書き込み単位の違反が無いこと、消去が
+ *          セクタに均等に分散すること、消去/書き込みの途中で電源が切れても
+ *          再マウント後に各キーが直前の値か書こうとした値のどちらかを返すことを確かめる。
+ */
+
+#include <string.h>
+#include "kvs.h"
+#include "flashsim.h"
+#include "test.h"
+
+#define NKEYS 8                         /* 電源断のテストで書き換え続けるキーの数 */
+#define NFIXED 4                        /* 最初に書いたきり変えないキーの数 (GC で運ばれる) */
+
+/**
+ * キーごとの期待値
+ */
+typedef struct ref {
+    uint8_t val[KVS_MAX_VALUE];
+    int16_t len;                        /* -1 なら無い */
+} ref_t;
+
+static flashsim_t s_fs;
+static kvs_t s_kv;
+
+/**
+ * @brief 操作 i で書く値を作る
+ * @return 値のバイト数 (0 なら削除)
+ */
+static uint16_t make_value(uint32_t i, uint8_t *val)
+{
+    uint16_t len = 1 + (i * 7) % 40, k;
+
+    if (i % 7 == 6) return 0;
+    for (k = 0; k < len; k++) val[k] = (uint8_t)(i * 31 + k);
+    return len;
+}
+
+/**
+ * @brief キーの値が期待値と同じか
+ */
+static int same(kvs_t *kv, uint16_t key, const ref_t *r)
+{
+    uint8_t buf[KVS_MAX_VALUE];
+    int16_t len = kvs_get(kv, key, buf, sizeof(buf));
+
+    if (len != r->len) return 0;
+    return len < 0 || memcmp(buf, r->val, len) == 0;
+}
+
+/**
+ * @brief 基本操作
+ */
+static void test_basic(void)
+{
+    uint8_t buf[KVS_MAX_VALUE + 1];
+    uint32_t programs;
+    uint16_t k;
+
+    flashsim_init(&s_fs, 1024, 3);
+    CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+    CHECK_EQ(kvs_get(&s_kv, 1, buf, sizeof(buf)), -1);
+
+    CHECK_EQ(kvs_set(&s_kv, 1, "hello", 5), 0);
+    CHECK_EQ(kvs_set(&s_kv, 2, "abc", 3), 0);
+    CHECK_EQ(kvs_get(&s_kv, 1, buf, sizeof(buf)), 5);
+    CHECK(memcmp(buf, "hello", 5) == 0);
+    CHECK_EQ(kvs_get(&s_kv, 1, buf, 2), 5);             /* バッファが短くても長さは返す */
+
+    programs = s_fs.programs;
+    CHECK_EQ(kvs_set(&s_kv, 1, "hello", 5), 0);         /* 同じ値なら書かない */
+    CHECK_EQ(s_fs.programs, programs);
+
+    CHECK_EQ(kvs_set(&s_kv, 1, "world!", 6), 0);
+    CHECK_EQ(kvs_delete(&s_kv, 2), 0);
+    CHECK_EQ(kvs_delete(&s_kv, 3), 0);                  /* 無いキー */
+    CHECK_EQ(kvs_get(&s_kv, 2, buf, sizeof(buf)), -1);
+
+    CHECK_EQ(kvs_set(&s_kv, KVS_NOKEY, "x", 1), -1);
+    CHECK_EQ(kvs_set(&s_kv, 4, buf, KVS_MAX_VALUE + 1), -1);
+    CHECK_EQ(kvs_set(&s_kv, 4, buf, 0), -1);
+
+    /* 再マウントしても同じ内容 */
+    CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+    CHECK_EQ(kvs_get(&s_kv, 1, buf, sizeof(buf)), 6);
+    CHECK(memcmp(buf, "world!", 6) == 0);
+    CHECK_EQ(kvs_get(&s_kv, 2, buf, sizeof(buf)), -1);
+
+    /* キーの数の上限 */
+    for (k = 100; k < 100 + KVS_MAX_KEYS; k++) {
+        if (kvs_set(&s_kv, k, &k, sizeof(k)) < 0) break;
+    }
+    CHECK_EQ(k, 100 + KVS_MAX_KEYS - 2);                /* キー 1, 2 (削除済み) も数に入る */
+
+    CHECK_EQ(s_fs.misaligned, 0);
+    CHECK_EQ(s_fs.raise, 0);
+}
+
+/**
+ * @brief フラッシュのモデル自体が単位の違反を拒否すること
+ */
+static void test_model(void)
+{
+    uint32_t page[KVS_PAGE / 4];
+
+    flashsim_init(&s_fs, 1024, 2);
+    memset(page, 0, sizeof(page));
+    CHECK_EQ(s_fs.flash.program(&s_fs.flash, 4, page), -1);
+    CHECK_EQ(s_fs.flash.program(&s_fs.flash, 2048, page), -1);
+    CHECK_EQ(s_fs.flash.erase(&s_fs.flash, 2), -1);
+    CHECK_EQ(s_fs.misaligned, 3);
+
+    CHECK_EQ(s_fs.flash.program(&s_fs.flash, 0, page), 0);
+    memset(page, 0xFF, sizeof(page));
+    CHECK_EQ(s_fs.flash.program(&s_fs.flash, 0, page), 0);
+    CHECK_EQ(s_fs.mem[0], 0);                           /* 書き込みでは 1 に戻らない */
+    CHECK_EQ(s_fs.raise, KVS_PAGE);
+    CHECK_EQ(s_fs.flash.erase(&s_fs.flash, 0), 0);
+    CHECK_EQ(s_fs.mem[0], 0xFFFFFFFF);
+}
+
+/**
+ * @brief 更新を繰り返すと消去がセクタに均等に分散する
+ * @param[in] sector_size セクタのバイト数
+ * @param[in] n セクタ数
+ */
+static void test_wear(uint32_t sector_size, uint8_t n)
+{
+    uint8_t val[KVS_MAX_VALUE];
+    uint32_t i, lo = ~0U, hi = 0;
+
+    flashsim_init(&s_fs, sector_size, n);
+    CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+    CHECK_EQ(kvs_set(&s_kv, 7, "constant", 8), 0);     /* 書き換えないキーも運ばれ続ける */
+    for (i = 0; i < 5000; i++) {
+        memset(val, i, sizeof(val));
+        val[0] = i >> 8;
+        if (kvs_set(&s_kv, 1 + i % 3, val, 16 + i % 32) < 0) break;
+    }
+    CHECK_EQ(i, 5000);
+
+    for (i = 0; i < n; i++) {
+        if (s_fs.erase_count[i] < lo) lo = s_fs.erase_count[i];
+        if (s_fs.erase_count[i] > hi) hi = s_fs.erase_count[i];
+    }
+    CHECK(lo > 0);
+    CHECK(hi - lo <= 1);
+
+    CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+    CHECK_EQ(kvs_get(&s_kv, 7, val, sizeof(val)), 8);
+    CHECK(memcmp(val, "constant", 8) == 0);
+    CHECK_EQ(s_fs.misaligned, 0);
+    CHECK_EQ(s_fs.raise, 0);
+}
+
+/**
+ * @brief 有効なデータがセクタに収まらなくなったとき
+ * @param[in] sector_size セクタのバイト数
+ * @param[in] n セクタ数
+ * @details 書き込みを断られるまでキーを増やし、その後も新しいキーと既存のキーの書き換えを
+ *          続ける。断られた書き込みでも head の次のセクタは消去済みのままで、
+ *          それまでに書けたキーは (再マウント後も) 失われないことを確かめる。
+ */
+static void test_full(uint32_t sector_size, uint8_t n)
+{
+    ref_t ref[KVS_MAX_KEYS];
+    uint8_t val[KVS_MAX_VALUE];
+    uint32_t i, fails = 0, nblank = 0;
+    uint16_t key, len;
+    int bad = 0;
+
+    flashsim_init(&s_fs, sector_size, n);
+    CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+    for (i = 0; i < KVS_MAX_KEYS; i++) ref[i].len = -1;
+
+    for (i = 0; i < 200 && !bad; i++) {
+        key = (i < 40) ? i % KVS_MAX_KEYS : i % 7;      /* 増やしてから、既存のキーを書き換える */
+        len = 24 + (i * 13) % (KVS_MAX_VALUE - 23);
+        memset(val, i, len);
+        if (kvs_set(&s_kv, key, val, len) < 0) {
+            fails++;
+        } else {
+            ref[key].len = len;
+            memcpy(ref[key].val, val, len);
+        }
+
+        uint32_t next = (s_kv.head + 1) % n, w;
+        for (w = 0; w < sector_size / 4; w++) {
+            if (s_fs.mem[next * sector_size / 4 + w] != 0xFFFFFFFF) break;
+        }
+        if (w == sector_size / 4) nblank++;
+        for (key = 0; key < KVS_MAX_KEYS && !bad; key++) {
+            if (!same(&s_kv, key, &ref[key])) {
+                fprintf(stderr, "key %u lost after op %u: sector %u x %u\n", key, i, sector_size, n);
+                bad = 1;
+            }
+        }
+    }
+    CHECK(!bad);
+    CHECK(fails > 0);                                   /* 満杯になるところまで試した */
+    CHECK_EQ(nblank, i);
+
+    CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+    for (key = 0; key < KVS_MAX_KEYS; key++) CHECK(same(&s_kv, key, &ref[key]));
+    CHECK_EQ(s_fs.misaligned, 0);
+    CHECK_EQ(s_fs.raise, 0);
+}
+
+/**
+ * @brief 再マウントしないまま書き込みが失敗したとき
+ * @param[in] sector_size セクタのバイト数
+ * @param[in] n セクタ数
+ * @details k 回目のフラッシュ操作だけを失敗させ、再マウントせずに更新を続ける。
+ *          ガベージコレクションの途中で失敗すると、移しきれなかったレコードが
+ *          head の次のセクタに残る。次にセクタを進めるときにそれを消さないことを確かめる。
+ */
+static void test_write_error(uint32_t sector_size, uint8_t n)
+{
+    static const uint32_t nops = 120;
+    ref_t ref[NKEYS + NFIXED], pend;
+    uint8_t val[KVS_MAX_VALUE];
+    uint32_t k, i, ops;
+    uint16_t key, len, pend_key = KVS_NOKEY;
+    int bad = 0;
+
+    for (k = 1; !bad; k++) {
+        flashsim_init(&s_fs, sector_size, n);
+        CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+        for (i = 0; i < NKEYS; i++) ref[i].len = -1;
+        for (; i < NKEYS + NFIXED; i++) {
+            ref[i].len = make_value(i * 7 + 1, ref[i].val);
+            CHECK_EQ(kvs_set(&s_kv, i, ref[i].val, ref[i].len), 0);
+        }
+
+        s_fs.fail_at = s_fs.ops + k;
+        for (i = 0; i < nops; i++) {
+            key = i % NKEYS;
+            len = make_value(i, val);
+            ops = s_fs.ops;
+            if ((len ? kvs_set(&s_kv, key, val, len) : kvs_delete(&s_kv, key)) < 0) {
+                if (ops < s_fs.fail_at && s_fs.ops >= s_fs.fail_at) {
+                    pend_key = key;                     /* フラッシュが失敗した書き込み */
+                    pend.len = len ? len : -1;
+                    memcpy(pend.val, val, len);
+                }
+                continue;                               /* 失敗した書き込みは前の値のまま */
+            }
+            ref[key].len = len ? len : -1;
+            memcpy(ref[key].val, val, len);
+            if (key == pend_key) pend_key = KVS_NOKEY;
+        }
+        for (i = 0; i < NKEYS + NFIXED && !bad; i++) {
+            if (!same(&s_kv, i, &ref[i])) {
+                fprintf(stderr, "key %u lost: sector %u x %u, op %u\n", i, sector_size, n, k);
+                bad = 1;
+            }
+        }
+        if (s_fs.failed == 0) break;                    /* 失敗させる前に全部終わった */
+
+        /* 書きかけのレコードが全部書けていれば、再マウント後はそちらが読める */
+        CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+        for (i = 0; i < NKEYS + NFIXED && !bad; i++) {
+            if (!same(&s_kv, i, &ref[i]) && !(i == pend_key && same(&s_kv, i, &pend))) {
+                fprintf(stderr, "key %u lost after remount: sector %u x %u, op %u\n", i, sector_size, n, k);
+                bad = 1;
+            }
+        }
+        CHECK(!bad);
+        CHECK_EQ(s_fs.misaligned, 0);
+        CHECK_EQ(s_fs.raise, 0);
+    }
+    CHECK(k > 10);
+}
+
+/**
+ * @brief 消去/書き込みの途中の電源断
+ * @param[in] sector_size セクタのバイト数
+ * @param[in] n セクタ数
+ * @param[in] tear 失敗した操作が済ませるバイト数 (flashsim_t の tear)
+ * @details 同じ更新の列を、k 回目のフラッシュ操作で止めることを k = 1, 2, ... について行い、
+ *          毎回再マウントして内容を確かめる。最後まで止まらなくなったら終わる。
+ */
+static void test_power_loss(uint32_t sector_size, uint8_t n, uint32_t tear)
+{
+    static const uint32_t nops = 150;
+    ref_t ref[NKEYS + NFIXED], pend;
+    uint8_t val[KVS_MAX_VALUE];
+    uint32_t k, i;
+    int bad = 0;
+
+    for (k = 1; !bad; k++) {
+        uint16_t key = 0, len = 0;
+
+        flashsim_init(&s_fs, sector_size, n);
+        s_fs.tear = tear;
+        CHECK_EQ(kvs_mount(&s_kv, &s_fs.flash), 0);
+        for (i = 0; i < NKEYS; i++) ref[i].len = -1;
+        for (; i < NKEYS + NFIXED; i++) {
+            ref[i].len = make_value(i * 7 + 1, ref[i].val);
+            CHECK_EQ(kvs_set(&s_kv, i, ref[i].val, ref[i].len), 0);
+        }
+
+        s_fs.fail_at = s_fs.ops + k;
+        for (i = 0; i < nops; i++) {
+            key = i % NKEYS;
+            len = make_value(i, val);
+            if ((len ? kvs_set(&s_kv, key, val, len) : kvs_delete(&s_kv, key)) < 0) break;
+            ref[key].len = len ? len : -1;
+            memcpy(ref[key].val, val, len);
+        }
+        if (i == nops) {
+            CHECK_EQ(s_fs.failed, 0);                   /* 止める前に全部終わった */
+            break;
+        }
+        CHECK_EQ(s_fs.failed, 1);                       /* 失敗したのはフラッシュを止めたときだけ */
+        pend.len = len ? len : -1;
+        memcpy(pend.val, val, len);
+
+        /* 電源を入れ直す */
+        s_fs.fail_at = 0;
+        if (kvs_mount(&s_kv, &s_fs.flash) < 0) {
+            fprintf(stderr, "mount failed: sector %u x %u, tear %u, op %u\n", sector_size, n, tear, k);
+            bad = 1;
+        }
+        for (i = 0; i < NKEYS + NFIXED && !bad; i++) {
+            if (!same(&s_kv, i, &ref[i]) && !(i == key && same(&s_kv, i, &pend))) {
+                fprintf(stderr, "key %u lost: sector %u x %u, tear %u, op %u\n", i, sector_size, n, tear, k);
+                bad = 1;
+            }
+        }
+
+        /* その後も使い続けられる (セクタを何周かして、止まったときのセクタも再利用される) */
+        for (i = 0; i < nops && !bad; i++) {
+            key = i % NKEYS;
+            len = make_value(i + 3, val);
+            if ((len ? kvs_set(&s_kv, key, val, len) : kvs_delete(&s_kv, key)) < 0) bad = 1;
+            ref[key].len = len ? len : -1;
+            memcpy(ref[key].val, val, len);
+        }
+        if (!bad && kvs_mount(&s_kv, &s_fs.flash) < 0) bad = 1;
+        for (i = 0; i < NKEYS + NFIXED && !bad; i++) {
+            if (!same(&s_kv, i, &ref[i])) bad = 1;
+        }
+        CHECK(!bad);
+        CHECK_EQ(s_fs.misaligned, 0);
+        CHECK_EQ(s_fs.raise, 0);
+    }
+    CHECK(k > 10);
+}
+
+int main(void)
+{
+    test_model();
+    test_basic();
+    test_wear(1024, 3);
+    test_wear(4096, 2);                                 /* ターゲットと同じ (セクタ 6, 7) */
+    test_full(256, 3);
+    test_full(512, 2);
+    test_write_error(256, 3);
+    test_write_error(512, 2);
+    test_power_loss(1024, 3, 0);
+    test_power_loss(1024, 3, 4);                        /* ヘッダやレコードの途中で止まる */
+    test_power_loss(1024, 3, 100);
+    test_power_loss(4096, 2, 0);
+    test_power_loss(4096, 2, 12);
+
+    return TEST_END();
+}
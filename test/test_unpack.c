@@ -0,0 +1,353 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file test_unpack.c
+ * @brief boot/unpack.c (更新ストリームの展開) のテスト
+ * @details boot/main.c の get(), peek(), old(), put(), flush() と同じ規則で、フラッシュの上に
+ *          上書きしながら展開する。main.c の put() は書き込み先の範囲を確かめないので、
+ *          途切れた, 大きすぎる, 参照が不正なストリームでも put() が h->size バイトを超えて
+ *          呼ばれないこと (記述子のページと kvs 領域に触れないこと) を確かめる。
+ */
+
+#include <string.h>
+#include "boot.h"
+#include "unpack.h"
+#include "test.h"
+
+#define FLASH_SIZE (0x8000 - BOOT_APP_BASE)     /* アプリケーション領域から kvs 領域の終わりまで */
+#define PAGE_SIZE  256
+#define MAX_STREAM 0x8000
+
+/**
+ * ブートローダの展開の状態と模擬フラッシュ
+ */
+typedef struct boot {
+    uint8_t in[MAX_STREAM];             /* ペイロード */
+    uint32_t in_len;
+    uint32_t in_pos;
+    uint8_t flash[FLASH_SIZE];          /* BOOT_APP_BASE からのフラッシュ */
+    uint8_t page[PAGE_SIZE];
+    uint8_t oldsec[FWP_SECTOR];
+    uint32_t pos;
+    uint32_t flushed;
+    int32_t erased;
+    uint8_t saved;
+    uint32_t base_size;
+    uint32_t puts;                      /* put() を呼ばれた回数 */
+    uint32_t outside;                   /* 記述子のページ以降を書いた, kvs 領域を消去した回数 */
+} boot_t;
+
+static boot_t s_b;
+static uint8_t s_img[BOOT_APP_MAX];
+static uint8_t s_base[BOOT_APP_MAX];
+
+static int16_t get(void *ctx)
+{
+    boot_t *b = ctx;
+    return (b->in_pos < b->in_len) ? b->in[b->in_pos++] : -1;
+}
+
+static int16_t peek(void *ctx, uint32_t pos)
+{
+    boot_t *b = ctx;
+    return (pos < b->flushed) ? b->flash[pos] : b->page[pos - b->flushed];
+}
+
+static int16_t old(void *ctx, uint32_t pos)
+{
+    boot_t *b = ctx;
+    int32_t sec = pos / FWP_SECTOR;
+
+    if (sec == b->erased && b->saved) return b->oldsec[pos % FWP_SECTOR];
+    if (sec <= b->erased) return -1;
+    return b->flash[pos];
+}
+
+static void flush(boot_t *b)
+{
+    int32_t sec = b->flushed / FWP_SECTOR;
+    uint32_t i;
+
+    for (i = b->pos - b->flushed; i < PAGE_SIZE; i++) b->page[i] = 0xFF;
+    if (sec > b->erased) {
+        b->saved = b->base_size > (uint32_t)sec * FWP_SECTOR;
+        if (b->saved) memcpy(b->oldsec, b->flash + sec * FWP_SECTOR, FWP_SECTOR);
+        if (sec * FWP_SECTOR >= BOOT_APP_END - BOOT_APP_BASE) b->outside++;      /* kvs 領域 */
+        memset(b->flash + sec * FWP_SECTOR, 0xFF, FWP_SECTOR);
+        b->erased = sec;
+    }
+    if (b->flushed + PAGE_SIZE > BOOT_APP_MAX) b->outside++;
+    for (i = 0; i < PAGE_SIZE; i++) b->flash[b->flushed + i] &= b->page[i];
+    b->flushed += PAGE_SIZE;
+}
+
+static int8_t put(void *ctx, uint8_t c)
+{
+    boot_t *b = ctx;
+
+    b->puts++;
+    if (b->flushed + PAGE_SIZE > FLASH_SIZE) return -1;     /* ここまで来たらテストの失敗 */
+    b->page[b->pos++ - b->flushed] = c;
+    if (b->pos - b->flushed == PAGE_SIZE) flush(b);
+    return 0;
+}
+
+static const fwp_io_t s_io = { get, peek, old, put, &s_b };
+
+/**
+ * @brief 空のストリームを用意する (フラッシュには古いイメージを置く)
+ * @param[in] base_size 古いイメージのバイト数 (0 なら差分でない)
+ */
+static void begin(uint32_t base_size)
+{
+    memset(s_b.flash, 0xFF, sizeof(s_b.flash));
+    memcpy(s_b.flash, s_base, base_size);
+    s_b.in_len = 0;
+    s_b.base_size = base_size;
+}
+
+static void emit(uint8_t c)
+{
+    s_b.in[s_b.in_len++] = c;
+}
+
+/**
+ * @brief リテラルの命令を追加する
+ */
+static void lit(const uint8_t *p, uint32_t n)
+{
+    while (n > 0) {
+        uint32_t k = (n > 128) ? 128 : n;
+        emit(k - 1);
+        while (k--) {
+            emit(*p++);
+            n--;
+        }
+    }
+}
+
+/**
+ * @brief コピーの命令を追加する (FWP_MAX_MATCH より長ければ分ける)
+ * @param[in] kind 0x80: 新しいイメージから (a は距離 - 1), 0xC0: 古いイメージから (a は位置)
+ */
+static void copy(uint8_t kind, uint32_t a, uint32_t n)
+{
+    while (n > 0) {
+        uint32_t k = (n > FWP_MAX_MATCH) ? FWP_MAX_MATCH : n;
+        uint32_t m = k - FWP_MIN_MATCH;
+
+        if (m < 63) {
+            emit(kind | m);
+        } else {
+            emit(kind | 63);
+            emit(m - 63);
+        }
+        emit(a);
+        emit(a >> 8);
+        if (kind == 0xC0) a += k;
+        n -= k;
+    }
+}
+
+/**
+ * @brief 展開する
+ * @param[in] size ヘッダのイメージのバイト数
+ * @return fwp_unpack() の戻り値
+ */
+static int8_t run(uint32_t size)
+{
+    fwp_hdr_t h;
+    int8_t ret;
+
+    memset(&h, 0, sizeof(h));
+    h.magic = FWP_MAGIC;
+    h.size = size;
+    h.base_size = s_b.base_size;
+    s_b.in_pos = 0;
+    s_b.pos = 0;
+    s_b.flushed = 0;
+    s_b.erased = -1;
+    s_b.saved = 0;
+    s_b.puts = 0;
+    s_b.outside = 0;
+
+    ret = fwp_unpack(&s_io, &h);
+    if (ret == 0 && s_b.pos > s_b.flushed) flush(&s_b);
+    return ret;
+}
+
+/**
+ * @brief 正しいストリーム (リテラル, 新しいイメージからのコピー, 古いイメージからのコピー)
+ */
+static void test_valid(void)
+{
+    uint32_t size = BOOT_APP_MAX, pos, i;
+
+    /* 最大のイメージ: リテラルと最長のコピーの繰り返し */
+    begin(0);
+    for (pos = 0; pos < size;) {
+        uint32_t n = (size - pos < 200) ? size - pos : 200;
+        lit(s_img + pos, n);
+        pos += n;
+        if (pos + FWP_MAX_MATCH <= size && pos >= 200) {
+            for (i = 0; i < FWP_MAX_MATCH; i++) s_img[pos + i] = s_img[pos + i - 200];
+            copy(0x80, 200 - 1, FWP_MAX_MATCH);
+            pos += FWP_MAX_MATCH;
+        }
+    }
+    CHECK_EQ(run(size), 0);
+    CHECK_EQ(s_b.in_pos, s_b.in_len);
+    CHECK_EQ(s_b.puts, size);
+    CHECK_EQ(s_b.outside, 0);
+    CHECK(memcmp(s_b.flash, s_img, size) == 0);
+
+    /* 差分: 古いイメージの同じセクタからのコピー (セクタの先頭を書くときに退避されている) */
+    begin(3 * FWP_SECTOR);
+    lit(s_base, 16);
+    copy(0xC0, 16, FWP_SECTOR - 16);                                    /* セクタ 0 の残り */
+    lit(s_base, 300);                                                   /* セクタ 1 の最初のページを書く */
+    copy(0xC0, FWP_SECTOR + 300, FWP_MAX_MATCH);                        /* セクタ 1 の退避した内容 */
+    copy(0xC0, 2 * FWP_SECTOR, FWP_MAX_MATCH);                          /* まだ消していないセクタ 2 */
+    size = FWP_SECTOR + 300 + 2 * FWP_MAX_MATCH;
+    CHECK_EQ(run(size), 0);
+    CHECK(memcmp(s_b.flash, s_base, FWP_SECTOR) == 0);
+    CHECK(memcmp(s_b.flash + FWP_SECTOR, s_base, 300) == 0);
+    CHECK(memcmp(s_b.flash + FWP_SECTOR + 300, s_base + FWP_SECTOR + 300, FWP_MAX_MATCH) == 0);
+    CHECK(memcmp(s_b.flash + FWP_SECTOR + 300 + FWP_MAX_MATCH, s_base + 2 * FWP_SECTOR, FWP_MAX_MATCH) == 0);
+}
+
+/**
+ * @brief 途中で途切れたストリーム
+ */
+static void test_truncated(void)
+{
+    uint32_t len, n, fails = 0, over = 0;
+
+    begin(2 * FWP_SECTOR);
+    lit(s_img, 100);
+    copy(0x80, 99, 70);                 /* 長さが 1 バイトの命令 */
+    copy(0x80, 9, FWP_MAX_MATCH);       /* 長さが 2 バイトの命令 */
+    copy(0xC0, FWP_SECTOR, 40);
+    lit(s_img, 5);
+    len = s_b.in_len;
+
+    for (n = 0; n < len; n++) {
+        s_b.in_len = n;
+        if (run(100 + 70 + FWP_MAX_MATCH + 40 + 5) < 0) fails++;
+        if (s_b.puts > 100 + 70 + FWP_MAX_MATCH + 40 + 5) over++;
+    }
+    CHECK_EQ(fails, len);
+    CHECK_EQ(over, 0);
+
+    s_b.in_len = len;
+    CHECK_EQ(run(100 + 70 + FWP_MAX_MATCH + 40 + 5), 0);
+}
+
+/**
+ * @brief ヘッダの大きさより多く出力するストリーム
+ */
+static void test_oversized(void)
+{
+    uint32_t size = BOOT_APP_MAX;
+
+    /* 最大のイメージの終わりを 1 バイトだけ越えるリテラル */
+    begin(0);
+    lit(s_img, size - 127);
+    lit(s_img, 128);
+    CHECK_EQ(run(size), -1);
+    CHECK(s_b.puts <= size);
+    CHECK_EQ(s_b.outside, 0);
+
+    /* 最大のイメージの終わりを越える最長のコピー (以前は 320 バイト書き過ぎて記述子と kvs に触れた) */
+    begin(0);
+    lit(s_img, size - 1);
+    copy(0x80, 0, FWP_MAX_MATCH);
+    CHECK_EQ(run(size), -1);
+    CHECK(s_b.puts <= size);
+    CHECK_EQ(s_b.outside, 0);
+
+    /* 古いイメージからのコピーでも同じ */
+    begin(size);
+    lit(s_img, size - 10);
+    copy(0xC0, FWP_SECTOR * 4, FWP_MAX_MATCH);
+    CHECK_EQ(run(size), -1);
+    CHECK(s_b.puts <= size);
+    CHECK_EQ(s_b.outside, 0);
+
+    /* 小さなイメージでもヘッダの大きさまでで止まる */
+    begin(0);
+    lit(s_img, 64);
+    copy(0x80, 63, 64);
+    CHECK_EQ(run(100), -1);
+    CHECK(s_b.puts <= 100);
+
+    /* ちょうど収まれば成功する */
+    begin(0);
+    lit(s_img, 64);
+    copy(0x80, 63, 36);
+    CHECK_EQ(run(100), 0);
+    CHECK_EQ(s_b.puts, 100);
+}
+
+/**
+ * @brief 参照が不正なストリーム
+ */
+static void test_bad_reference(void)
+{
+    /* 新しいイメージのまだ出力していない位置 */
+    begin(0);
+    lit(s_img, 10);
+    copy(0x80, 10, 5);
+    CHECK_EQ(run(15), -1);
+    begin(0);
+    lit(s_img, 10);
+    copy(0x80, 9, 5);                   /* 先頭はよい */
+    CHECK_EQ(run(15), 0);
+    begin(0);
+    copy(0x80, 0, 5);                   /* 何も出力していない */
+    CHECK_EQ(run(5), -1);
+    CHECK_EQ(s_b.puts, 0);
+
+    /* 差分でないのに古いイメージ */
+    begin(0);
+    copy(0xC0, 0, 5);
+    CHECK_EQ(run(5), -1);
+    CHECK_EQ(s_b.puts, 0);
+
+    /* 古いイメージの終わりを越える */
+    begin(1000);
+    copy(0xC0, 990, 11);
+    CHECK_EQ(run(11), -1);
+    CHECK_EQ(s_b.puts, 0);
+    begin(1000);
+    copy(0xC0, 990, 10);
+    CHECK_EQ(run(10), 0);
+
+    /* 既に消去したセクタ (出力位置のセクタより前) */
+    begin(3 * FWP_SECTOR);
+    lit(s_img, 100);
+    copy(0xC0, 0, FWP_SECTOR - 100);
+    lit(s_img, PAGE_SIZE);              /* セクタ 1 の最初のページでセクタ 1 を消去する */
+    copy(0xC0, FWP_SECTOR - 10, 5);
+    CHECK_EQ(run(FWP_SECTOR + PAGE_SIZE + 5), -1);
+    CHECK_EQ(s_b.puts, FWP_SECTOR + PAGE_SIZE);
+    CHECK_EQ(s_b.erased, 1);
+}
+
+int main(void)
+{
+    uint32_t i, x = 1;
+
+    for (i = 0; i < BOOT_APP_MAX; i++) {
+        x = x * 1103515245 + 12345;
+        s_img[i] = x >> 16;
+        s_base[i] = x >> 24;
+    }
+
+    test_valid();
+    test_truncated();
+    test_oversized();
+    test_bad_reference();
+
+    return TEST_END();
+}
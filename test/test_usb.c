@@ -0,0 +1,375 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file test_usb.c
+ * @brief usb.c (コントロール転送, ディスクリプタ) と cdc.c (クラスリクエスト, バルク転送) のテスト
+ * @details usbhw.c の代わりに usbmodel.c をリンクし、ホストの立場でリクエストを送って応答を確かめる。
+ */
+
+#include <string.h>
+#include "usb.h"
+#include "cdc.h"
+#include "usbmodel.h"
+#include "test.h"
+
+#define VENDOR_ECHO 0x01                /* テスト用クラスのベンダリクエスト (OUT で受けたデータを覚える) */
+
+/* テスト用クラス: 64 バイトちょうどのストリングディスクリプタで ZLP の終端を確かめる */
+static const uint8_t s_dev[18] = {
+    18, USB_DESC_DEVICE, USB_W(0x0200), 0xFF, 0, 0, USB_EP0_SIZE,
+    USB_W(0x1234), USB_W(0x5678), USB_W(0x0100), 0, 1, 0, 1,
+};
+static const uint8_t s_cfg[9 + 9] = {
+    9, USB_DESC_CONFIGURATION, USB_W(18), 1, 1, 0, 0x80, 50,
+    9, USB_DESC_INTERFACE, 0, 0, 0, 0xFF, 0, 0, 0,
+};
+static const uint8_t s_lang[] = { 4, USB_DESC_STRING, USB_W(0x0409) };
+static uint8_t s_str64[64];
+static uint8_t s_str130[130];
+static const uint8_t *s_strs[] = { s_lang, s_str64, s_str130 };
+
+static uint8_t s_echo[16];
+static uint8_t s_echo_done;
+static uint8_t s_cfg_value = 0xFF;
+
+static int8_t test_request(const usb_setup_t *req, uint8_t **data, uint16_t *len)
+{
+    if ((req->bmRequestType & USB_REQ_TYPE_MASK) != USB_REQ_VENDOR || req->bRequest != VENDOR_ECHO) return -1;
+    if (req->wLength > sizeof(s_echo)) return -1;
+    *data = s_echo;
+    *len = sizeof(s_echo);
+    return 0;
+}
+
+static void test_request_done(const usb_setup_t *req)
+{
+    s_echo_done++;
+}
+
+static void test_configured(uint8_t cfg)
+{
+    s_cfg_value = cfg;
+}
+
+static const usb_class_t s_test_class = {
+    s_dev, s_cfg, s_strs, 3, test_request, test_request_done, test_configured, 0,
+};
+
+/**
+ * @brief SETUP パケットを作る
+ */
+static usb_setup_t setup(uint8_t type, uint8_t req, uint16_t value, uint16_t index, uint16_t length)
+{
+    usb_setup_t s = { type, req, value, index, length };
+    return s;
+}
+
+/**
+ * @brief GET_DESCRIPTOR の応答の長さとパケット分割
+ */
+static void test_get_descriptor(void)
+{
+    uint8_t buf[512];
+    uint16_t len;
+    usb_setup_t r;
+
+    /* デバイスディスクリプタ: 要求が短ければ要求の長さで切る (最初の 8 バイトだけ読むホスト) */
+    r = setup(0x80, USB_GET_DESCRIPTOR, USB_DESC_DEVICE << 8, 0, 8);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 8);
+    CHECK_EQ(g_model.npkt, 1);
+    CHECK(memcmp(buf, s_dev, 8) == 0);
+
+    /* 要求が長ければディスクリプタの長さ。短パケットで終わるので ZLP は送らない */
+    r = setup(0x80, USB_GET_DESCRIPTOR, USB_DESC_DEVICE << 8, 0, 255);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 18);
+    CHECK_EQ(g_model.npkt, 1);
+    CHECK(memcmp(buf, s_dev, 18) == 0);
+
+    /* コンフィギュレーションディスクリプタは wTotalLength 分 */
+    r = setup(0x80, USB_GET_DESCRIPTOR, USB_DESC_CONFIGURATION << 8, 0, 9);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 9);
+    r.wLength = 255;
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, sizeof(s_cfg));
+    CHECK(memcmp(buf, s_cfg, sizeof(s_cfg)) == 0);
+
+    /* 最大パケットサイズの倍数で要求より短い: ZLP で終端する */
+    r = setup(0x80, USB_GET_DESCRIPTOR, (USB_DESC_STRING << 8) | 1, 0x0409, 255);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 64);
+    CHECK_EQ(g_model.npkt, 2);
+    CHECK_EQ(g_model.pkt[0], 64);
+    CHECK_EQ(g_model.pkt[1], 0);
+    CHECK(memcmp(buf, s_str64, 64) == 0);
+
+    /* 要求とちょうど同じ長さ: ZLP は送らない (送ると model_control() が MODEL_PROTO を返す) */
+    r.wLength = 64;
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 64);
+    CHECK_EQ(g_model.npkt, 1);
+
+    /* 複数パケット: 64 + 64 + 2 */
+    r = setup(0x80, USB_GET_DESCRIPTOR, (USB_DESC_STRING << 8) | 2, 0x0409, 255);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 130);
+    CHECK_EQ(g_model.npkt, 3);
+    CHECK_EQ(g_model.pkt[2], 2);
+    CHECK(memcmp(buf, s_str130, 130) == 0);
+
+    /* 要求が 128 バイト (パケットの倍数) で途中まで: 2 パケットで終わる */
+    r.wLength = 128;
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 128);
+    CHECK_EQ(g_model.npkt, 2);
+
+    /* 存在しないディスクリプタはストール */
+    r = setup(0x80, USB_GET_DESCRIPTOR, (USB_DESC_STRING << 8) | 3, 0x0409, 255);
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    r = setup(0x80, USB_GET_DESCRIPTOR, (USB_DESC_CONFIGURATION << 8) | 1, 0, 255);
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    r = setup(0x80, USB_GET_DESCRIPTOR, 0x0600, 0, 10);    /* DEVICE_QUALIFIER */
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    CHECK_EQ(g_model.errors, 0);
+}
+
+/**
+ * @brief SET_ADDRESS はステータスステージの完了後にアドレスを切り替える
+ */
+static void test_set_address(void)
+{
+    usb_setup_t r = setup(0x00, USB_SET_ADDRESS, 0x25, 0, 0);
+    uint8_t buf[64];
+    uint16_t len;
+
+    model_setup(&r);
+    CHECK_EQ(g_model.addr, 0);                          /* ステータスステージの前はアドレス 0 のまま */
+    CHECK(g_model.ep[1].full);                          /* ステータスステージの ZLP を用意している */
+    CHECK_EQ(model_in(0x80, buf), 0);
+    CHECK_EQ(g_model.addr, 0x25);                       /* ZLP の送信完了で切り替わる */
+
+    /* 次の転送では保留中のアドレスが無いので、アドレスを書き直さない */
+    g_model.addr = 0;
+    r = setup(0x80, USB_GET_DESCRIPTOR, USB_DESC_DEVICE << 8, 0, 18);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(g_model.addr, 0);
+
+    /* ステータスステージの前にバスリセットされたら、アドレスは切り替えない */
+    r = setup(0x00, USB_SET_ADDRESS, 0x11, 0, 0);
+    model_setup(&r);
+    model_bus_reset();
+    r = setup(0x00, USB_SET_FEATURE, 0, 0, 0);          /* デバイスへの SET_FEATURE は未対応 (ストール) */
+    CHECK_EQ(model_control(&r, 0, 0), MODEL_STALL);
+    r = setup(0x80, USB_GET_CONFIGURATION, 0, 0, 1);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(g_model.addr, 0);
+}
+
+/**
+ * @brief 未対応のリクエストは EP0 をストールし、次の SETUP で解除される
+ */
+static void test_stall(void)
+{
+    uint8_t buf[64];
+    uint16_t len;
+    usb_setup_t r;
+
+    r = setup(0x80, 0x42, 0, 0, 4);                     /* 未定義の標準リクエスト */
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    CHECK(g_model.ep[0].stall && g_model.ep[1].stall);
+
+    r = setup(0x00, USB_SET_CONFIGURATION, 7, 0, 0);    /* 存在しないコンフィギュレーション */
+    CHECK_EQ(model_control(&r, 0, 0), MODEL_STALL);
+    CHECK_EQ(s_cfg_value, 0xFF);
+
+    r = setup(0x01, USB_SET_INTERFACE, 1, 0, 0);        /* 代替設定は無い */
+    CHECK_EQ(model_control(&r, 0, 0), MODEL_STALL);
+
+    r = setup(0xC0, 0x99, 0, 0, 4);                     /* クラスが受理しないベンダリクエスト */
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    r = setup(0x40, VENDOR_ECHO, 0, 0, 32);             /* データステージが長すぎる */
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+
+    /* ストールは次の SETUP で解除され、普通に応答する */
+    r = setup(0x80, USB_GET_STATUS, 0, 0, 2);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 2);
+
+    /* OUT データステージのあるベンダリクエスト */
+    memset(buf, 0xA5, 16);
+    r = setup(0x40, VENDOR_ECHO, 0, 0, 16);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(s_echo_done, 1);
+    CHECK(memcmp(s_echo, buf, 16) == 0);
+    CHECK_EQ(g_model.errors, 0);
+}
+
+/**
+ * @brief SET_CONFIGURATION とエンドポイントの HALT
+ */
+static void test_configuration(void)
+{
+    uint8_t buf[64];
+    uint16_t len;
+    usb_setup_t r;
+
+    r = setup(0x00, USB_SET_CONFIGURATION, 1, 0, 0);
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+    CHECK_EQ(usb_configuration(), 1);
+    CHECK_EQ(s_cfg_value, 1);
+    CHECK(g_model.configured);
+
+    r = setup(0x80, USB_GET_CONFIGURATION, 0, 0, 1);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 1);
+    CHECK_EQ(buf[0], 1);
+
+    r = setup(0x02, USB_SET_FEATURE, USB_FEATURE_ENDPOINT_HALT, 0x83, 0);
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+    CHECK(g_model.ep[7].stall);
+    r = setup(0x82, USB_GET_STATUS, 0, 0x83, 2);
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(buf[0], 1);
+    r = setup(0x02, USB_CLEAR_FEATURE, USB_FEATURE_ENDPOINT_HALT, 0x83, 0);
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+    CHECK(!g_model.ep[7].stall);
+
+    model_bus_reset();
+    CHECK_EQ(usb_configuration(), 0);
+    CHECK_EQ(s_cfg_value, 0);
+}
+
+/**
+ * @brief CDC-ACM のクラスリクエスト
+ */
+static void test_cdc_requests(void)
+{
+    static const uint8_t coding[7] = { 0x80, 0x25, 0x00, 0x00, 0, 0, 8 };    /* 9600 bps, 8N1 */
+    uint8_t buf[64];
+    uint16_t len;
+    usb_setup_t r;
+
+    cdc_init();
+    CHECK(g_model.inited && g_model.connected);
+    CHECK_EQ(cdc_baudrate(), 115200);
+
+    r = setup(0x00, USB_SET_CONFIGURATION, 1, 0, 0);
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+
+    memcpy(buf, coding, sizeof(coding));
+    r = setup(0x21, 0x20, 0, 0, 7);                     /* SET_LINE_CODING */
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(cdc_baudrate(), 9600);
+
+    memset(buf, 0, sizeof(buf));
+    r = setup(0xA1, 0x21, 0, 0, 7);                     /* GET_LINE_CODING */
+    CHECK_EQ(model_control(&r, buf, &len), 0);
+    CHECK_EQ(len, 7);
+    CHECK(memcmp(buf, coding, 7) == 0);
+
+    r = setup(0x21, 0x22, CDC_LINE_DTR | CDC_LINE_RTS, 0, 0);    /* SET_CONTROL_LINE_STATE */
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+    CHECK_EQ(cdc_line_state(), CDC_LINE_DTR | CDC_LINE_RTS);
+
+    r = setup(0x21, 0x23, 100, 0, 0);                   /* SEND_BREAK */
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+
+    r = setup(0x21, 0x20, 0, 0, 8);                     /* line coding より長い */
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    CHECK_EQ(cdc_baudrate(), 9600);
+    r = setup(0x22, 0x22, 0, 0, 0);                     /* 受信者がエンドポイント */
+    CHECK_EQ(model_control(&r, 0, 0), MODEL_STALL);
+    r = setup(0xA1, 0x30, 0, 0, 4);                     /* 未対応のクラスリクエスト */
+    CHECK_EQ(model_control(&r, buf, &len), MODEL_STALL);
+    CHECK_EQ(cdc_line_state(), CDC_LINE_DTR | CDC_LINE_RTS);
+
+    /* コンフィギュレーションが解除されたら制御線の状態も消える */
+    model_bus_reset();
+    CHECK_EQ(cdc_line_state(), 0);
+    CHECK_EQ(g_model.errors, 0);
+}
+
+/**
+ * @brief CDC-ACM のバルク転送 (受信リングが満杯のときの NAK、送信の ZLP)
+ */
+static void test_cdc_bulk(void)
+{
+    uint8_t pkt[CDC_PKT_SIZE], in[CDC_PKT_SIZE];
+    const uint8_t *rx;
+    uint16_t len;
+    usb_setup_t r = setup(0x00, USB_SET_CONFIGURATION, 1, 0, 0);
+    int i;
+
+    CHECK_EQ(model_control(&r, 0, 0), 0);
+
+    for (i = 0; i < CDC_RX_NPKT + 1; i++) {
+        memset(pkt, i, sizeof(pkt));
+        CHECK_EQ(model_out(CDC_EP_OUT, pkt, 10 + i), 0);
+    }
+    CHECK_EQ(model_out(CDC_EP_OUT, pkt, 1), MODEL_NAK);    /* リングとエンドポイントが満杯 */
+
+    for (i = 0; i < CDC_RX_NPKT + 1; i++) {
+        rx = cdc_rx_peek(&len);
+        CHECK(rx != 0);
+        if (!rx) break;
+        CHECK_EQ(len, 10 + i);
+        CHECK_EQ(rx[0], i);
+        cdc_rx_release();
+        model_run_kicks();                                 /* 残っていたパケットを読ませる */
+    }
+    CHECK(cdc_rx_peek(&len) == 0);
+
+    /* ちょうど 1 パケット: 続けて ZLP を送る */
+    memset(pkt, 0x5A, sizeof(pkt));
+    CHECK_EQ(cdc_write(pkt, CDC_PKT_SIZE), CDC_PKT_SIZE);
+    model_run_kicks();
+    CHECK_EQ(model_in(CDC_EP_IN, in), CDC_PKT_SIZE);
+    CHECK(memcmp(in, pkt, CDC_PKT_SIZE) == 0);
+    CHECK_EQ(model_in(CDC_EP_IN, in), 0);
+    CHECK_EQ(model_in(CDC_EP_IN, in), MODEL_NAK);
+
+    /* 短パケットで終わる転送には ZLP を付けない */
+    CHECK_EQ(cdc_write(pkt, CDC_PKT_SIZE + 3), CDC_PKT_SIZE + 3);
+    model_run_kicks();
+    CHECK_EQ(model_in(CDC_EP_IN, in), CDC_PKT_SIZE);
+    CHECK_EQ(model_in(CDC_EP_IN, in), 3);
+    CHECK_EQ(model_in(CDC_EP_IN, in), MODEL_NAK);
+    CHECK_EQ(g_model.errors, 0);
+
+    /* バスリセットで受信途中のパケットを捨てる (USB_FIQ をマスクして位置を戻す) */
+    CHECK_EQ(model_out(CDC_EP_OUT, pkt, 5), 0);
+    CHECK_EQ(model_out(CDC_EP_OUT, pkt, 6), 0);
+    CHECK(cdc_rx_peek(&len) != 0);
+    i = g_model.locks;
+    model_bus_reset();
+    CHECK(g_model.locks > i);
+    CHECK_EQ(g_model.locked, 0);
+    CHECK(cdc_rx_peek(&len) == 0);
+}
+
+int main(void)
+{
+    uint16_t i;
+
+    s_str64[0] = sizeof(s_str64);
+    s_str64[1] = USB_DESC_STRING;
+    s_str130[0] = sizeof(s_str130);
+    s_str130[1] = USB_DESC_STRING;
+    for (i = 2; i < sizeof(s_str130); i++) {
+        s_str130[i] = (i & 1) ? 0 : 'a' + i % 26;
+        if (i < sizeof(s_str64)) s_str64[i] = s_str130[i];
+    }
+
+    usb_init(&s_test_class);
+    model_bus_reset();
+    test_get_descriptor();
+    test_set_address();
+    test_stall();
+    test_configuration();
+    test_cdc_requests();
+    test_cdc_bulk();
+
+    return TEST_END();
+}
@@ -0,0 +1,267 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file usbmodel.c
+ * @brief USB デバイスコントローラのソフトウェアモデル (ホスト上のテスト用)
+ */
+
+#include <string.h>
+#include "usbmodel.h"
+
+model_t g_model;
+
+/**
+ * @brief 論理エンドポイントアドレスを物理エンドポイント番号に変換する (usbhw.c と同じ)
+ * @param[in] ep 論理エンドポイントアドレス (IN は 0x80 付き)
+ * @return 物理エンドポイント番号
+ */
+static uint8_t phy_ep(uint8_t ep)
+{
+    return ((ep & 0x0F) << 1) | (ep >> 7);
+}
+
+/**
+ * @brief パケットの送受信が終わったことを上位層に通知する (usbhw.c の dispatch_ep() に相当)
+ * @param[in] ep 論理エンドポイントアドレス
+ * @return なし
+ */
+static void notify(uint8_t ep)
+{
+    if ((ep & 0x0F) == 0) {
+        usb_on_ep0(ep);
+    } else {
+        usb_on_ep(ep);
+    }
+}
+
+/*
+ * usbhw.h の実装
+ */
+
+void usbhw_init(void)
+{
+    memset(&g_model, 0, sizeof(g_model));
+    g_model.inited = 1;
+}
+
+void usbhw_connect(uint8_t on)
+{
+    g_model.connected = on;
+}
+
+void usbhw_set_address(uint8_t addr)
+{
+    g_model.addr = addr;
+}
+
+void usbhw_configure(uint8_t on)
+{
+    uint8_t phy;
+
+    g_model.configured = on;
+    if (on) {
+        for (phy = 2; phy < MODEL_NEP; phy++) {
+            g_model.ep[phy].stall = 0;
+        }
+    }
+}
+
+uint16_t usbhw_read_ep(uint8_t ep, uint32_t *buf)
+{
+    model_ep_t *e = &g_model.ep[phy_ep(ep)];
+
+    if (!e->full) {
+        g_model.errors++;
+        return 0;
+    }
+    memcpy(buf, e->buf, (e->len + 3) & ~3);    /* 実機と同じく端数を含むワードも書く */
+    e->full = 0;
+    return e->len;
+}
+
+void usbhw_write_ep(uint8_t ep, const uint32_t *buf, uint16_t len)
+{
+    model_ep_t *e = &g_model.ep[phy_ep(ep)];
+
+    if (e->full || len > sizeof(e->buf)) {
+        g_model.errors++;
+        return;
+    }
+    memcpy(e->buf, buf, len);
+    e->len = len;
+    e->full = 1;
+}
+
+void usbhw_stall_ep(uint8_t ep, uint8_t stall)
+{
+    if ((ep & 0x0F) == 0) {
+        g_model.ep[0].stall = stall;    /* EP0 は両方向をストールする (条件付きストール) */
+        g_model.ep[1].stall = stall;
+    } else {
+        g_model.ep[phy_ep(ep)].stall = stall;
+    }
+}
+
+uint8_t usbhw_ep_status(uint8_t ep)
+{
+    model_ep_t *e = &g_model.ep[phy_ep(ep)];
+    return (e->full ? USB_EPSTAT_FE : 0) | (e->stall ? USB_EPSTAT_ST : 0);
+}
+
+void usbhw_kick_ep(uint8_t ep)
+{
+    g_model.kick |= 1 << phy_ep(ep);
+}
+
+uint32_t usbhw_lock(void)
+{
+    g_model.locks++;
+    return g_model.locked++;
+}
+
+void usbhw_unlock(uint32_t old)
+{
+    g_model.locked = old;
+}
+
+/*
+ * ホスト側の操作
+ */
+
+/**
+ * @brief バスリセット
+ * @return なし
+ */
+void model_bus_reset(void)
+{
+    memset(g_model.ep, 0, sizeof(g_model.ep));
+    g_model.addr = 0;
+    g_model.configured = 0;
+    g_model.kick = 0;
+    usb_on_reset();
+}
+
+/**
+ * @brief SETUP パケットを送る
+ * @param[in] req SETUP パケット
+ * @return なし
+ * @note SETUP パケットは EP0 のストールを解除し、送信待ちの IN パケットを捨てる。
+ */
+void model_setup(const usb_setup_t *req)
+{
+    model_ep_t *e = &g_model.ep[0];
+    uint8_t *p = (uint8_t *)e->buf;
+
+    g_model.ep[0].stall = 0;
+    g_model.ep[1].stall = 0;
+    g_model.ep[1].full = 0;
+    p[0] = req->bmRequestType;
+    p[1] = req->bRequest;
+    p[2] = req->wValue & 0xFF;
+    p[3] = req->wValue >> 8;
+    p[4] = req->wIndex & 0xFF;
+    p[5] = req->wIndex >> 8;
+    p[6] = req->wLength & 0xFF;
+    p[7] = req->wLength >> 8;
+    e->len = 8;
+    e->full = 1;
+    usb_on_setup();
+}
+
+/**
+ * @brief IN パケットを 1 つ受け取る
+ * @param[in] ep 論理エンドポイントアドレス (0x80 付き)
+ * @param[out] data 受信データの格納先 (最大パケットサイズ分)
+ * @return 受信したバイト数, MODEL_STALL, MODEL_NAK
+ */
+int model_in(uint8_t ep, uint8_t *data)
+{
+    model_ep_t *e = &g_model.ep[phy_ep(ep)];
+    uint16_t len;
+
+    if (e->stall) return MODEL_STALL;
+    if (!e->full) return MODEL_NAK;
+    len = e->len;
+    if (data) memcpy(data, e->buf, len);
+    e->full = 0;
+    notify(ep);
+    return len;
+}
+
+/**
+ * @brief OUT パケットを 1 つ送る
+ * @param[in] ep 論理エンドポイントアドレス
+ * @param[in] data 送信データ
+ * @param[in] len バイト数 (最大パケットサイズ以下)
+ * @return 0: 受理された, MODEL_STALL, MODEL_NAK
+ */
+int model_out(uint8_t ep, const uint8_t *data, uint16_t len)
+{
+    model_ep_t *e = &g_model.ep[phy_ep(ep)];
+
+    if (e->stall) return MODEL_STALL;
+    if (e->full) return MODEL_NAK;
+    if (len) memcpy(e->buf, data, len);
+    e->len = len;
+    e->full = 1;
+    notify(ep);
+    return 0;
+}
+
+/**
+ * @brief usbhw_kick_ep() で発生させた割込みを処理する
+ * @return なし
+ */
+void model_run_kicks(void)
+{
+    while (g_model.kick) {
+        uint8_t phy = __builtin_ctz(g_model.kick);
+        g_model.kick &= ~(1 << phy);
+        notify(((phy & 1) << 7) | (phy >> 1));
+    }
+}
+
+/**
+ * @brief コントロール転送を 1 回行う (ホストの動作)
+ * @param[in] req SETUP パケット
+ * @param[in,out] data データステージのデータ (IN なら wLength バイトの領域)
+ * @param[out] len IN データステージで受信したバイト数 (0 可)
+ * @return 0: 成功, MODEL_STALL, MODEL_NAK, MODEL_PROTO
+ * @details IN データステージは wLength バイトを受け取るか、短いパケット (ZLP を含む) で終わる [USB 2.0 8.5.3.2]。
+ *          終わった後にデバイスがさらにパケットを用意していたら MODEL_PROTO とする。
+ */
+int model_control(const usb_setup_t *req, uint8_t *data, uint16_t *len)
+{
+    uint16_t total = 0;
+    int n;
+
+    g_model.npkt = 0;
+    model_setup(req);
+
+    if ((req->bmRequestType & USB_REQ_DIR_IN) && req->wLength > 0) {
+        do {
+            n = model_in(0x80, data + total);
+            if (n < 0) return n;
+            if (total + n > req->wLength) return MODEL_PROTO;
+            if (g_model.npkt < MODEL_NPKT) g_model.pkt[g_model.npkt++] = n;
+            total += n;
+        } while (n == USB_EP0_SIZE && total < req->wLength);
+        n = model_out(0x00, 0, 0);                  /* ステータスステージ */
+        if (n < 0) return n;
+        if (g_model.ep[1].full) return MODEL_PROTO;
+    } else {
+        while (total < req->wLength) {
+            uint16_t m = (req->wLength - total < USB_EP0_SIZE) ? req->wLength - total : USB_EP0_SIZE;
+            n = model_out(0x00, data + total, m);
+            if (n < 0) return n;
+            total += m;
+        }
+        n = model_in(0x80, 0);                      /* ステータスステージ */
+        if (n < 0) return n;
+        if (n != 0) return MODEL_PROTO;
+        total = 0;
+    }
+
+    if (len) *len = total;
+    return 0;
+}
@@ -0,0 +1,63 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file usbmodel.h
+ * @brief USB デバイスコントローラのソフトウェアモデル (ホスト上のテスト用)
+ * @details usbhw.h の関数を実装して usbhw.c の代わりにリンクし、ホスト側の操作
+ *          (SETUP/OUT パケットを送る、IN パケットを受け取る) を model_*() で行う。
+ *          パケットの送受信が終わるたびに、実機の割込みと同じく usb_on_*() を呼ぶ。
+ *          エンドポイントのバッファは物理エンドポイントごとに 1 つ (シングルバッファ) とする。
+ */
+
+#ifndef __USBMODEL_H__
+#define __USBMODEL_H__
+
+#include <stdint.h>
+#include "usb.h"
+#include "usbhw.h"
+
+#define MODEL_NEP  8                    /* 物理エンドポイントの数 */
+#define MODEL_NPKT 16                   /* model_control() が記録する IN パケット数 */
+
+/* model_in(), model_out(), model_control() の戻り値 */
+#define MODEL_STALL -1                  /* エンドポイントがストールしている */
+#define MODEL_NAK   -2                  /* 送るパケットが無い / バッファが空いていない */
+#define MODEL_PROTO -3                  /* コントロール転送の手順の誤り */
+
+/**
+ * 物理エンドポイント
+ */
+typedef struct model_ep {
+    uint32_t buf[USB_EP0_SIZE / 4];
+    uint16_t len;
+    uint8_t full;                       /* OUT: 受信済み, IN: 送信待ち */
+    uint8_t stall;
+} model_ep_t;
+
+/**
+ * コントローラの状態
+ */
+typedef struct model {
+    model_ep_t ep[MODEL_NEP];
+    uint8_t inited;
+    uint8_t connected;
+    uint8_t configured;
+    uint8_t addr;                       /* usbhw_set_address() で設定されたアドレス */
+    uint8_t kick;                       /* usbhw_kick_ep() された物理エンドポイントのビット */
+    uint8_t locked;                     /* usbhw_lock() のネストの深さ (0 でなければ USB_FIQ は来ない) */
+    uint16_t locks;                     /* usbhw_lock() を呼ばれた回数 */
+    uint16_t errors;                    /* 空のバッファの読み出し、送信待ちのバッファへの書き込み */
+    uint16_t pkt[MODEL_NPKT];           /* 直前の model_control() の IN データステージのパケット長 */
+    uint8_t npkt;
+} model_t;
+
+extern model_t g_model;
+
+void model_bus_reset(void);
+void model_setup(const usb_setup_t *req);
+int model_in(uint8_t ep, uint8_t *data);
+int model_out(uint8_t ep, const uint8_t *data, uint16_t len);
+void model_run_kicks(void);
+int model_control(const usb_setup_t *req, uint8_t *data, uint16_t *len);
+
+#endif
@@ -0,0 +1,63 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file clkplan.c
+ * @brief clkplan.h で決まるクロック構成を表示する (ホストで動かす)
+ * @details 例題と同じ -D を付けて clkplan.h をコンパイルするので、制約に合わない構成なら
+ *          ファームウェアと同じ静的アサーションでコンパイルが止まる。\n
+ *          ビルド: 各例題のディレクトリで make clkplan (CFLAGS の -D を引き継ぐ)
+ * @code
+ * % gmake clkplan
+ * % gmake clkplan CFLAGS+=-DCLKPLAN_HZ=48000000UL
+ * @endcode
+ */
+
+#include <stdio.h>
+#include "clkplan.h"
+
+/**
+ * @brief 周波数を MHz で表示する
+ * @param[in] name 項目名
+ * @param[in] hz 周波数 [Hz]
+ * @param[in] note 補足
+ * @return なし
+ */
+static void line(const char *name, unsigned long hz, const char *note)
+{
+    printf("  %-14s %8.3f MHz  %s\n", name, hz / 1e6, note);
+}
+
+/**
+ * @brief クロックツリーとレジスタの値を表示する
+ * @return 0
+ */
+int main(void)
+{
+    char buf[64];
+
+    printf("clock plan (clkplan.h)\n");
+    line("sys_osc_clk", __XTAL, "crystal");
+    line("sys_pllclkin", CLKPLAN_PLLIN_HZ, CLKPLAN_SRC ? "SYSPLLCLKSEL = sys_osc" : "SYSPLLCLKSEL = irc");
+    if (CLKPLAN_PLL) {
+        snprintf(buf, sizeof(buf), "M = %d, P = %d, FCCO = %.3f MHz (156..320)",
+                 (int)CLKPLAN_M, (int)CLKPLAN_P, CLKPLAN_FCCO_HZ / 1e6);
+        line("sys_pllclkout", CLKPLAN_MAIN_HZ, buf);
+    }
+    line("main_clk", CLKPLAN_MAIN_HZ,
+         CLKPLAN_MAINCLKSEL == 3 ? "MAINCLKSEL = pll out" :
+         CLKPLAN_MAINCLKSEL == 1 ? "MAINCLKSEL = pll in" : "MAINCLKSEL = irc");
+    snprintf(buf, sizeof(buf), "SYSAHBCLKDIV = %d", (int)CLKPLAN_AHBDIV);
+    line("system_clk", CLKPLAN_HZ, buf);
+    printf("  %-14s %8d clk  FLASHTIM = %d\n", "flash access", (int)CLKPLAN_FLASHTIM + 1, (int)CLKPLAN_FLASHTIM);
+    if (CLKPLAN_USB) {
+        snprintf(buf, sizeof(buf), "M = %d, P = %d, FCCO = %.3f MHz (156..320)",
+                 (int)CLKPLAN_USB_M, (int)CLKPLAN_USB_P, CLKPLAN_USB_FCCO_HZ / 1e6);
+        line("usb_pllclkout", CLKPLAN_USB_HZ, buf);
+    }
+    printf("registers\n");
+    printf("  SYSPLLCLKSEL = 0x%02X, MAINCLKSEL = 0x%02X, SYSAHBCLKDIV = 0x%02X\n",
+           (unsigned)CLKPLAN_SYSPLLCLKSEL, (unsigned)CLKPLAN_MAINCLKSEL, (unsigned)CLKPLAN_AHBDIV);
+    if (CLKPLAN_PLL) printf("  SYSPLLCTRL = 0x%02X\n", (unsigned)CLKPLAN_SYSPLLCTRL);
+    if (CLKPLAN_USB) printf("  USBPLLCTRL = 0x%02X\n", (unsigned)CLKPLAN_USBPLLCTRL);
+    return 0;
+}
@@ -0,0 +1,158 @@
+#!/bin/sh
+
+#
+# クラッシュレコード (common/include/fault.h の fault_record_t) を解析して表示する
+# フロー:
+#   1. ダンプファイルが指定されなければ OpenOCD でターゲットから g_fault_record を吸い出す
+#   2. レコードをワード列に変換して例外番号、レジスタ、フォルトステータスを表示する
+#   3. PC, LR とスタック中のコードアドレスらしき値を addr2line でシンボルに変換する
+# スタック中の値はそれらしいものを拾っているだけなので、バックトレースは参考程度とすること
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+ADDR2LINE=$ARCH-addr2line
+OPENOCD=openocd
+OCDCFG=`dirname $0`/../lpc1343qsb.cfg
+SYMBOL=g_fault_record
+MAGIC=544C5546                      # FAULT_MAGIC
+NWORDS=40                           # fault_record_t のワード数
+TEXTSTART=0x400                     # コード領域の先頭 (ベクタテーブルの直後)
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: faultdump elffile [dumpfile]" 1>&2
+    exit 1
+}
+
+#
+# sym_addr(elf, sym)
+# ELF ファイルからシンボルのアドレスを 16 進数 (0x 付き) で返す
+#
+sym_addr() {
+    local a=`$NM $1 | awk -v s=$2 '$3 == s { print $1 }'`
+    if [ "$a" = "" ]; then
+        echo "error: symbol $2 not found." 1>&2
+        exit 1
+    fi
+    printf "0x%s" $a
+}
+
+#
+# fetch(elf, out)
+# OpenOCD でターゲットのメモリからクラッシュレコードを吸い出す
+#
+fetch() {
+    local addr=`sym_addr $1 $SYMBOL`
+    $OPENOCD -f $OCDCFG -c "init" -c "halt" \
+        -c "dump_image $2 $addr $(($NWORDS * 4))" -c "shutdown" > /dev/null 2>&1
+    if [ ! -s $2 ]; then
+        echo "error: failed to read the record from the target." 1>&2
+        exit 1
+    fi
+}
+
+#
+# symbolize(elf, addr)
+# コードアドレスを "関数名 at ファイル:行" に変換する (Thumb ビットは落とす)
+#
+symbolize() {
+    $ADDR2LINE -f -p -e $1 `printf "0x%x" $(($2 & ~1))`
+}
+
+#
+# メイン関数
+#
+main() {
+    if [ $# -lt 1 ]; then
+        usage
+    fi
+
+    local elf=$1
+    local dump=$2
+    if [ "$dump" = "" ]; then
+        dump=`mktemp`
+        trap "rm -f $dump" EXIT
+        fetch $elf $dump
+    fi
+
+    # ワード列 (リトルエンディアン) を 1 行 1 ワードに並べる
+    local words=`od -A n -t x4 -v -N $(($NWORDS * 4)) $dump | tr -s ' ' '\n' | grep -v '^$'`
+    if [ `echo "$words" | wc -l` -lt $NWORDS ]; then
+        echo "error: dump is too small."
+        exit 1
+    fi
+    if [ `echo "$words" | sed -n 1p | tr 'a-f' 'A-F'` != $MAGIC ]; then
+        echo "no crash record (magic mismatch)."
+        exit 0
+    fi
+
+    echo "$words" | awk '
+    function h2n(s,    n, i) {
+        n = 0
+        for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        return n
+    }
+    function hex(v) { return sprintf("0x%08X", v) }
+    function bit(v, n) { return int(v / 2 ^ n) % 2 }
+    function flags(v, names,    s, n, k, i) {
+        s = ""
+        n = split(names, k, " ")
+        for (i = 1; i <= n; i += 2) {
+            if (bit(v, k[i])) s = s " " k[i + 1]
+        }
+        return s == "" ? " -" : s
+    }
+    { w[NR - 1] = h2n($1) }
+    END {
+        split("- Reset NMI HardFault MemManage BusFault UsageFault - - - - SVCall DebugMon - PendSV SysTick", exn, " ")
+        split("I2C TMR16B0 TMR16B1 TMR32B0 TMR32B1 SSP0 UART USBIRQ USBFIQ ADC WDT BOD PIO3 PIO2 PIO1 PIO0 SSP1", irqn, " ")
+        v = w[1]
+        if (v < 16) name = exn[v + 1]
+        else if (v < 16 + 40) name = sprintf("IRQ %d (WAKEUP%d)", v - 16, v - 16)
+        else name = sprintf("IRQ %d (%s)", v - 16, irqn[v - 16 - 40 + 1])
+        printf "vector     : %d %s\n", v, name
+        printf "exc_return : %s (%s stack)\n", hex(w[2]), bit(w[2], 2) ? "process" : "main"
+        for (i = 0; i < 13; i++) printf "r%-2d        : %s\n", i, hex(w[4 + i])
+        printf "sp         : %s\n", hex(w[3])
+        printf "lr         : %s\n", hex(w[17])
+        printf "pc         : %s\n", hex(w[18])
+        printf "xpsr       : %s\n", hex(w[19])
+        printf "cfsr       : %s%s\n", hex(w[20]), flags(w[20], \
+            "0 IACCVIOL 1 DACCVIOL 3 MUNSTKERR 4 MSTKERR 8 IBUSERR 9 PRECISERR 10 IMPRECISERR " \
+            "11 UNSTKERR 12 STKERR 16 UNDEFINSTR 17 INVSTATE 18 INVPC 19 NOCP 24 UNALIGNED 25 DIVBYZERO")
+        printf "hfsr       : %s%s\n", hex(w[21]), flags(w[21], "1 VECTTBL 30 FORCED 31 DEBUGEVT")
+        printf "mmfar      : %s%s\n", hex(w[22]), bit(w[20], 7) ? "" : " (invalid)"
+        printf "bfar       : %s%s\n", hex(w[23]), bit(w[20], 15) ? "" : " (invalid)"
+        printf "stack      :"
+        for (i = 0; i < 16; i++) printf "%s%s", (i % 4 == 0) ? "\n  " : " ", hex(w[24 + i])
+        printf "\n"
+    }'
+
+    # バックトレース: PC, LR, スタック中の奇数 (Thumb) かつコード領域内の値
+    local textend=`sym_addr $elf _data_org`
+    echo "backtrace  :"
+    echo "$words" | awk -v lo=$(($TEXTSTART)) -v hi=$(($textend)) '
+    function h2n(s,    n, i) {
+        n = 0
+        for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        return n
+    }
+    { w[NR] = h2n($1) }
+    END {
+        printf "pc %d\n", w[19]
+        printf "lr %d\n", w[18]
+        for (i = 25; i <= NR; i++) {
+            if (w[i] % 2 == 1 && w[i] >= lo && w[i] < hi) printf "stack[%d] %d\n", i - 25, w[i]
+        }
+    }' | while read tag addr
+    do
+        printf "  %-9s 0x%08X  %s\n" $tag $addr "`symbolize $elf $addr`"
+    done
+
+    exit 0
+}
+
+main $*
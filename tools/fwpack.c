@@ -0,0 +1,508 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file fwpack.c
+ * @brief ファームウェア更新ストリームの作成と送信 (ホストで動かす)
+ * @details イメージを LZ77 で圧縮し、-b で今書き込まれているイメージを与えれば
+ *          そこからのコピーも使って差分にする (形式は boot/unpack.h)。
+ *          作ったストリームは、ブートローダと同じく古いイメージの上に書き込み先を
+ *          上書きしながら展開してみて、元のイメージに戻ることを確かめてから出力する。\n
+ *          ビルド: cd boot; make fwpack (build/fwpack ができる)
+ * @code
+ * % fwpack -o eltica.fwp eltica.bin                    # 圧縮したストリームを作る
+ * % fwpack -b old.bin -d /dev/ttyU0 eltica.bin         # 差分を作ってブートローダに送る
+ * @endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "boot.h"
+#include "unpack.h"
+
+#define HASH_BITS  12
+#define HASH_SIZE  (1 << HASH_BITS)
+#define MAX_CHAIN  512                  /* 一致を探す候補の数の上限 */
+#define MAX_IMAGE  0x10000              /* 位置は 16 ビットで表す */
+
+/**
+ * 圧縮の状態
+ */
+typedef struct packer {
+    const uint8_t *img;                 /* 新しいイメージ */
+    uint32_t size;
+    const uint8_t *base;                /* 古いイメージ (0 なら差分を作らない) */
+    uint32_t base_size;
+    int32_t head[HASH_SIZE];            /* 新しいイメージのハッシュ連鎖 */
+    int32_t prev[MAX_IMAGE];
+    int32_t bhead[HASH_SIZE];           /* 古いイメージのハッシュ連鎖 */
+    int32_t bprev[MAX_IMAGE];
+    uint8_t *out;                       /* ペイロード */
+    uint32_t len;
+    uint32_t lit;                       /* まだ出力していないリテラルの先頭 */
+} packer_t;
+
+/**
+ * 一致
+ */
+typedef struct match {
+    uint32_t len;
+    uint32_t src;                       /* コピー元の位置 */
+    uint8_t old;                        /* !0 なら古いイメージから */
+} match_t;
+
+/**
+ * 展開の検査に使う模擬フラッシュ (ブートローダの main.c と同じ規則で展開する)
+ */
+typedef struct sim {
+    const uint8_t *in;
+    uint32_t in_len;
+    uint32_t in_pos;
+    uint8_t flash[(BOOT_APP_MAX + FWP_SECTOR - 1) / FWP_SECTOR * FWP_SECTOR];
+    uint8_t page[256];
+    uint8_t oldsec[FWP_SECTOR];
+    uint32_t pos;
+    uint32_t flushed;
+    int32_t erased;
+    uint8_t saved;
+    uint32_t base_size;
+} sim_t;
+
+static uint8_t *load(const char *path, uint32_t *size);
+static void pack(packer_t *pk);
+static match_t find(packer_t *pk, uint32_t o);
+static void insert(int32_t *head, int32_t *prev, const uint8_t *p, uint32_t i);
+static uint32_t hash(const uint8_t *p);
+static void emit_literals(packer_t *pk, uint32_t end);
+static void emit_match(packer_t *pk, const match_t *m);
+static int verify(const packer_t *pk, const fwp_hdr_t *h);
+static int16_t sim_get(void *ctx);
+static int16_t sim_peek(void *ctx, uint32_t pos);
+static int16_t sim_old(void *ctx, uint32_t pos);
+static int8_t sim_put(void *ctx, uint8_t c);
+static void sim_flush(sim_t *s);
+static int send(const char *dev, const fwp_hdr_t *h, const uint8_t *payload, uint32_t len);
+static int send_block(int fd, const uint8_t *p, uint32_t n);
+static int recv_byte(int fd, int ms);
+static void put32(uint8_t *p, uint32_t v);
+static void usage(void);
+
+/**
+ * @brief メイン関数
+ * @return 0: 成功, 1: 失敗
+ */
+int main(int argc, char **argv)
+{
+    static packer_t pk;
+    const char *base = 0, *outfile = 0, *dev = 0;
+    uint32_t sum, i;
+    fwp_hdr_t h;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:o:d:")) != -1) {
+        switch (opt) {
+        case 'b': base = optarg; break;
+        case 'o': outfile = optarg; break;
+        case 'd': dev = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind + 1 != argc || (!outfile && !dev)) usage();
+
+    pk.img = load(argv[optind], &pk.size);
+    if (pk.size < 32 || pk.size > BOOT_APP_MAX) {
+        fprintf(stderr, "error: image size %u is out of range (32..%u).\n", pk.size, BOOT_APP_MAX);
+        return 1;
+    }
+    for (sum = 0, i = 0; i < 8; i++) {
+        sum += pk.img[i * 4] | (pk.img[i * 4 + 1] << 8) | (pk.img[i * 4 + 2] << 16) | ((uint32_t)pk.img[i * 4 + 3] << 24);
+    }
+    if (sum != 0) {
+        fprintf(stderr, "error: no vector table checksum (run lpcsum first).\n");
+        return 1;
+    }
+    if (base) {
+        pk.base = load(base, &pk.base_size);
+        if (pk.base_size > BOOT_APP_MAX) {
+            fprintf(stderr, "error: base image is too large.\n");
+            return 1;
+        }
+    }
+
+    pk.out = malloc(pk.size * 2 + 16);
+    pack(&pk);
+
+    h.magic = FWP_MAGIC;
+    h.size = pk.size;
+    h.crc = fwp_crc32(0, pk.img, pk.size);
+    h.base_size = pk.base ? pk.base_size : 0;
+    h.base_crc = pk.base ? fwp_crc32(0, pk.base, pk.base_size) : 0;
+    h.hcrc = fwp_crc32(0, (const uint8_t *)&h, sizeof(h) - 4);
+
+    if (verify(&pk, &h) < 0) {
+        fprintf(stderr, "error: the stream does not unpack to the image (bug).\n");
+        return 1;
+    }
+    printf("%s: %u -> %u bytes (%.1f %%)%s\n", argv[optind], pk.size, pk.len,
+           100.0 * pk.len / pk.size, pk.base ? ", delta" : "");
+
+    if (outfile) {
+        FILE *fp = fopen(outfile, "wb");
+        if (!fp || fwrite(&h, sizeof(h), 1, fp) != 1 || fwrite(pk.out, 1, pk.len, fp) != pk.len || fclose(fp)) {
+            fprintf(stderr, "error: cannot write %s.\n", outfile);
+            return 1;
+        }
+    }
+    if (dev && send(dev, &h, pk.out, pk.len) < 0) return 1;
+    return 0;
+}
+
+/**
+ * @brief ファイルを読み込む
+ * @return 内容 (失敗したら終了する)
+ */
+static uint8_t *load(const char *path, uint32_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    uint8_t *buf = malloc(MAX_IMAGE + 1);
+
+    if (!fp) {
+        fprintf(stderr, "error: cannot open %s.\n", path);
+        exit(1);
+    }
+    *size = fread(buf, 1, MAX_IMAGE + 1, fp);
+    fclose(fp);
+    return buf;
+}
+
+/**
+ * @brief イメージを圧縮する (1 つ先まで見る貪欲法)
+ * @return なし
+ */
+static void pack(packer_t *pk)
+{
+    uint32_t o, i;
+
+    memset(pk->head, 0xFF, sizeof(pk->head));
+    memset(pk->bhead, 0xFF, sizeof(pk->bhead));
+    for (i = 0; pk->base && i + FWP_MIN_MATCH <= pk->base_size; i++) {
+        insert(pk->bhead, pk->bprev, pk->base, i);
+    }
+
+    o = 0;
+    pk->lit = 0;
+    while (o < pk->size) {
+        match_t m = find(pk, o);
+        if (m.len > FWP_MIN_MATCH && o + 1 < pk->size) {
+            if (o + FWP_MIN_MATCH <= pk->size) insert(pk->head, pk->prev, pk->img, o);
+            match_t n = find(pk, o + 1);
+            if (n.len > m.len + 1) {
+                o++;                    /* 1 バイトずらした方が長く一致する */
+                m = n;
+            } else {
+                emit_literals(pk, o);
+                emit_match(pk, &m);
+                for (i = 1; i < m.len; i++) {
+                    if (o + i + FWP_MIN_MATCH <= pk->size) insert(pk->head, pk->prev, pk->img, o + i);
+                }
+                o += m.len;
+                pk->lit = o;
+                continue;
+            }
+        }
+        if (m.len > FWP_MIN_MATCH) {
+            emit_literals(pk, o);
+            emit_match(pk, &m);
+            for (i = 0; i < m.len; i++) {
+                if (o + i + FWP_MIN_MATCH <= pk->size) insert(pk->head, pk->prev, pk->img, o + i);
+            }
+            o += m.len;
+            pk->lit = o;
+        } else {
+            if (o + FWP_MIN_MATCH <= pk->size) insert(pk->head, pk->prev, pk->img, o);
+            o++;
+        }
+    }
+    emit_literals(pk, o);
+}
+
+/**
+ * @brief 位置 o から始まる最長の一致を探す
+ * @return 一致 (len が FWP_MIN_MATCH 以下なら使わない)
+ * @details 古いイメージからのコピーは、各バイトについてコピー元が出力位置のセクタの
+ *          先頭以降にあるものに限る (それより前は展開中に消去されている)。
+ */
+static match_t find(packer_t *pk, uint32_t o)
+{
+    uint32_t max = pk->size - o;
+    match_t best = { 0, 0, 0 };
+    int32_t c;
+    int n;
+
+    if (max > FWP_MAX_MATCH) max = FWP_MAX_MATCH;
+    if (max < FWP_MIN_MATCH) return best;
+
+    for (c = pk->head[hash(pk->img + o)], n = 0; c >= 0 && n < MAX_CHAIN; c = pk->prev[c], n++) {
+        uint32_t len = 0;
+        if (o - c > 0x10000) break;
+        while (len < max && pk->img[c + len] == pk->img[o + len]) len++;
+        if (len > best.len) {
+            best.len = len;
+            best.src = c;
+            best.old = 0;
+        }
+    }
+
+    for (c = pk->bhead[hash(pk->img + o)], n = 0; pk->base && c >= 0 && n < MAX_CHAIN; c = pk->bprev[c], n++) {
+        uint32_t len = 0;
+        if (c > 0xFFFF) continue;
+        while (len < max && c + len < pk->base_size && pk->base[c + len] == pk->img[o + len]
+               && c + len >= (o + len) / FWP_SECTOR * FWP_SECTOR) {
+            len++;
+        }
+        if (len > best.len) {
+            best.len = len;
+            best.src = c;
+            best.old = 1;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief ハッシュ連鎖に位置 i を加える
+ * @return なし
+ */
+static void insert(int32_t *head, int32_t *prev, const uint8_t *p, uint32_t i)
+{
+    uint32_t k = hash(p + i);
+
+    prev[i] = head[k];
+    head[k] = i;
+}
+
+/**
+ * @brief 3 バイトのハッシュ
+ * @return ハッシュ値
+ */
+static uint32_t hash(const uint8_t *p)
+{
+    return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief pk->lit から end の手前までをリテラルとして出力する
+ * @return なし
+ */
+static void emit_literals(packer_t *pk, uint32_t end)
+{
+    while (pk->lit < end) {
+        uint32_t n = end - pk->lit;
+        if (n > 128) n = 128;
+        pk->out[pk->len++] = n - 1;
+        memcpy(pk->out + pk->len, pk->img + pk->lit, n);
+        pk->len += n;
+        pk->lit += n;
+    }
+}
+
+/**
+ * @brief コピーの命令を出力する
+ * @return なし
+ */
+static void emit_match(packer_t *pk, const match_t *m)
+{
+    uint32_t n = m->len - FWP_MIN_MATCH;
+    uint32_t a = m->old ? m->src : pk->lit - m->src - 1;
+
+    if (n < 63) {
+        pk->out[pk->len++] = (m->old ? 0xC0 : 0x80) | n;
+    } else {
+        pk->out[pk->len++] = (m->old ? 0xC0 : 0x80) | 63;
+        pk->out[pk->len++] = n - 63;
+    }
+    pk->out[pk->len++] = a;
+    pk->out[pk->len++] = a >> 8;
+}
+
+/**
+ * @brief ストリームを古いイメージの上に展開して、新しいイメージに戻ることを確かめる
+ * @return 0: 戻る, -1: 戻らない
+ */
+static int verify(const packer_t *pk, const fwp_hdr_t *h)
+{
+    static sim_t s;
+    fwp_io_t io = { sim_get, sim_peek, sim_old, sim_put, &s };
+
+    memset(s.flash, 0xFF, sizeof(s.flash));
+    if (pk->base) memcpy(s.flash, pk->base, pk->base_size);
+    s.in = pk->out;
+    s.in_len = pk->len;
+    s.in_pos = 0;
+    s.pos = 0;
+    s.flushed = 0;
+    s.erased = -1;
+    s.saved = 0;
+    s.base_size = h->base_size;
+
+    if (fwp_unpack(&io, h) < 0) return -1;
+    if (s.pos > s.flushed) sim_flush(&s);
+    if (s.in_pos != s.in_len) return -1;
+    return fwp_crc32(0, s.flash, h->size) == h->crc ? 0 : -1;
+}
+
+static int16_t sim_get(void *ctx)
+{
+    sim_t *s = ctx;
+    return (s->in_pos < s->in_len) ? s->in[s->in_pos++] : -1;
+}
+
+static int16_t sim_peek(void *ctx, uint32_t pos)
+{
+    sim_t *s = ctx;
+    return (pos < s->flushed) ? s->flash[pos] : s->page[pos - s->flushed];
+}
+
+static int16_t sim_old(void *ctx, uint32_t pos)
+{
+    sim_t *s = ctx;
+    int32_t sec = pos / FWP_SECTOR;
+
+    if (sec == s->erased && s->saved) return s->oldsec[pos % FWP_SECTOR];
+    if (sec <= s->erased) return -1;
+    return s->flash[pos];
+}
+
+static int8_t sim_put(void *ctx, uint8_t c)
+{
+    sim_t *s = ctx;
+
+    if (s->pos >= BOOT_APP_MAX) return -1;
+    s->page[s->pos++ - s->flushed] = c;
+    if (s->pos - s->flushed == sizeof(s->page)) sim_flush(s);
+    return 0;
+}
+
+static void sim_flush(sim_t *s)
+{
+    int32_t sec = s->flushed / FWP_SECTOR;
+    uint32_t i;
+
+    for (i = s->pos - s->flushed; i < sizeof(s->page); i++) s->page[i] = 0xFF;
+    if (sec > s->erased) {
+        s->saved = s->base_size > (uint32_t)sec * FWP_SECTOR;
+        if (s->saved) memcpy(s->oldsec, s->flash + sec * FWP_SECTOR, FWP_SECTOR);
+        memset(s->flash + sec * FWP_SECTOR, 0xFF, FWP_SECTOR);
+        s->erased = sec;
+    }
+    memcpy(s->flash + s->flushed, s->page, sizeof(s->page));
+    s->flushed += sizeof(s->page);
+}
+
+/**
+ * @brief ストリームをブートローダに送る
+ * @return 0: 成功, -1: 失敗
+ */
+static int send(const char *dev, const fwp_hdr_t *h, const uint8_t *payload, uint32_t len)
+{
+    struct termios tio;
+    uint32_t off, n;
+    int fd, c = -1, i;
+
+    if ((fd = open(dev, O_RDWR | O_NOCTTY)) < 0 || tcgetattr(fd, &tio) < 0) {
+        fprintf(stderr, "error: %s: %s\n", dev, strerror(errno));
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd, TCSANOW, &tio);
+    tcflush(fd, TCIOFLUSH);
+
+    printf("waiting for the bootloader (reset the board) ...\n");
+    for (i = 0; i < 3000; i++) {
+        uint8_t sync = BOOT_SYNC;
+        if (write(fd, &sync, 1) != 1) break;
+        if ((c = recv_byte(fd, 10)) == BOOT_ACK) break;
+    }
+    if (c != BOOT_ACK) {
+        fprintf(stderr, "error: no response.\n");
+        return -1;
+    }
+
+    c = send_block(fd, (const uint8_t *)h, sizeof(*h));
+    for (off = 0; c == BOOT_ACK && off < len; off += n) {
+        n = (len - off < BOOT_BLOCK) ? len - off : BOOT_BLOCK;
+        c = send_block(fd, payload + off, n);
+        printf("\r%u / %u", off + n, len);
+        fflush(stdout);
+    }
+    printf("\n");
+
+    if (c == BOOT_DONE) {
+        printf("done.\n");
+        close(fd);
+        return 0;
+    }
+    if (c == BOOT_ERROR) {
+        fprintf(stderr, "error: bootloader error %d.\n", recv_byte(fd, 1000));
+    } else {
+        fprintf(stderr, "error: unexpected response %d.\n", c);
+    }
+    close(fd);
+    return -1;
+}
+
+/**
+ * @brief ブロックを送って応答を待つ (BOOT_NAK なら送り直す)
+ * @return 応答 (BOOT_ACK, BOOT_DONE, BOOT_ERROR), -1: タイムアウト
+ */
+static int send_block(int fd, const uint8_t *p, uint32_t n)
+{
+    uint8_t buf[BOOT_BLOCK + 5];
+    int tries, c = -1;
+
+    buf[0] = n - 1;
+    memcpy(buf + 1, p, n);
+    put32(buf + 1 + n, fwp_crc32(0, p, n));
+
+    for (tries = 0; tries < 8; tries++) {
+        if (write(fd, buf, n + 5) != (ssize_t)(n + 5)) return -1;
+        c = recv_byte(fd, 3000);        /* セクタの消去を含む */
+        if (c != BOOT_NAK) break;
+    }
+    return c;
+}
+
+/**
+ * @brief 1 バイト受信する
+ * @return 受信したバイト, -1: タイムアウト
+ */
+static int recv_byte(int fd, int ms)
+{
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    uint8_t c;
+
+    if (poll(&pfd, 1, ms) <= 0 || read(fd, &c, 1) != 1) return -1;
+    return c;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: fwpack [-b base.bin] [-o out.fwp] [-d tty] image.bin\n");
+    exit(1);
+}
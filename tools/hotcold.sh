@@ -0,0 +1,255 @@
+#!/bin/sh
+
+#
+# 関数の実行頻度 (プロファイル) からコードの配置を決める
+# フロー:
+#   profile: 1. PC のサンプルを集める (OpenOCD の profile コマンド, または -s で渡したファイル)
+#            2. ELF の呼び出しグラフから、RAM の DATA 領域を初期化する前に走る関数を
+#               "# noram 関数名" の行で出力する
+#            3. ELF のシンボルでサンプルを関数ごとに数え、"サンプル数 サイズ 関数名" を多い順に出力する
+#   ld:      1. プロファイルのサンプルがある関数を多い順に hot, ない関数を cold とする
+#            2. hot の先頭から -r バイト以内をフラッシュではなく RAM に置く (noram の関数は除く)
+#            3. リンカスクリプトが INCLUDE する layout_hot.ld, layout_ram.ld, layout_cold.ld を書く
+#   bench:   1. 2 つの ELF (make TRACE=1) を順に書き込んで動かし、tools/isrtrace.sh で割込みを記録する
+#            2. 例外番号ごとの実行時間の平均を並べて比べる
+# 各関数が別のセクション (.text.関数名) になるよう -ffunction-sections でビルドする (make LAYOUT=1)。
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+OBJDUMP=$ARCH-objdump
+OPENOCD=openocd
+OCDCFG=`dirname $0`/../lpc1343qsb.cfg
+ISRTRACE=`dirname $0`/isrtrace.sh
+ROMEND=0x8000                       # PC をサンプリングする範囲の終わり (フラッシュ)
+# RAM の DATA 領域の初期化は reset_handler の中で main の前に行う。したがって reset_handler と、
+# そこから main 以外を呼び出した先は RAM に置いてはいけない
+NORAM_ROOT=reset_handler
+NORAM_STOP=main
+# noram の行がない (この仕組みより前の) プロファイルで使う一覧
+NORAM="reset_handler sys_capture_reset sys_init fault_init initseq_run"
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: hotcold profile [-t seconds] [-s pcfile] elffile" 1>&2
+    echo "       hotcold ld [-r rambytes] -o dir [proffile]" 1>&2
+    echo "       hotcold bench [-t seconds] before.elf after.elf" 1>&2
+    exit 1
+}
+
+#
+# h2n の awk 関数 (16 進文字列を数値にする)
+#
+H2N='
+function h2n(s,    n, i) {
+    n = 0
+    s = tolower(s)
+    sub(/^0x/, "", s)
+    for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+    return n
+}'
+
+#
+# gmon2pc(gmonfile)
+# OpenOCD の profile が書いた gmon.out のヒストグラムを "アドレス サンプル数" にする
+# (ヘッダ 53 バイトの後に 16 ビットのカウンタが並ぶ)
+#
+gmon2pc() {
+    set -- `od -A n -j 21 -N 12 -t u4 $1` $1
+    od -A n -j 53 -v -t u2 $4 | awk -v lo=$1 -v hi=$2 -v nb=$3 '
+    { for (i = 1; i <= NF; i++) { if ($i > 0) printf "%x %d\n", lo + int(n * (hi - lo) / nb), $i; n++ } }'
+}
+
+#
+# noram(elf)
+# NORAM_ROOT から呼び出しグラフ (bl, blx <sym>, 他関数への b; tools/stackcheck.sh と同じ) を
+# NORAM_STOP の手前までたどり、見つけた関数を "# noram 関数名" の行で出力する
+#
+noram() {
+    $OBJDUMP -d $1 | awk -v root=$NORAM_ROOT -v stop=$NORAM_STOP '
+    /^[0-9a-f]+ <[^>]+>:$/ { f = substr($2, 2, length($2) - 3); next }
+    /\tblx?\t[0-9a-f]+ <[^+>]+>/ || /\tb(\.w|\.n)?\t[0-9a-f]+ <[^+>]+>/ {
+        t = $NF; t = substr(t, 2, length(t) - 2)
+        if (t != f && !((f, t) in seen)) { seen[f, t] = 1; callee[f, ++ncall[f]] = t }
+        next
+    }
+    /\tblx\tr[0-9]+/ || /\tblx\t(ip|lr)/ { indirect[f] = 1 }
+    END {
+        n = 1; q[1] = root; done[root] = 1; done[stop] = 1
+        for (i = 1; i <= n; i++) {
+            f = q[i]
+            print "# noram", f
+            if (f in indirect) print "warning: " f " calls through a function pointer (not followed)" > "/dev/stderr"
+            for (j = 1; j <= ncall[f]; j++) {
+                if (!(callee[f, j] in done)) { done[callee[f, j]] = 1; q[++n] = callee[f, j] }
+            }
+        }
+    }'
+}
+
+#
+# profile(elf, pcfile)
+# PC のサンプル ("アドレス [サンプル数]", 16 進) を関数ごとに数えて出力する
+#
+profile() {
+    noram $1
+    $NM -S -n --defined-only $1 | awk '$3 ~ /^[tTwW]$/ { print "F", $1, $2, $4 }' |
+    cat - $2 | awk "$H2N"'
+    BEGIN { nf = 0 }
+    $1 == "F" {
+        a = h2n($2); a -= a % 2
+        lo[nf] = a; hi[nf] = a + h2n($3); name[nf] = $4; cnt[nf] = 0; nf++
+        next
+    }
+    NF >= 1 {
+        pc = h2n($1); c = (NF >= 2) ? $2 : 1
+        l = 0; h = nf - 1
+        while (l < h) {                                 # pc 以下で最後に始まる関数
+            m = int((l + h + 1) / 2)
+            if (lo[m] <= pc) l = m; else h = m - 1
+        }
+        if (nf > 0 && lo[l] <= pc && pc < hi[l]) { cnt[l] += c; total += c } else lost += c
+    }
+    END {
+        # 同じ名前の static 関数は同じセクション名になるので、まとめて数える
+        for (i = 0; i < nf; i++) { c2[name[i]] += cnt[i]; sz[name[i]] += hi[i] - lo[i] }
+        printf "# %d samples (%d outside functions)\n", total, lost
+        fflush()
+        for (f in c2) printf "%d %d %s\n", c2[f], sz[f], f | "sort -k1,1nr -k3,3"
+    }'
+}
+
+#
+# layout(dir, rambytes, proffile)
+# リンカスクリプトの断片を書く
+#
+layout() {
+    local hot=$1/layout_hot.ld ram=$1/layout_ram.ld cold=$1/layout_cold.ld
+
+    echo "/* hot: ${3:-no profile} */" > $hot
+    echo "/* hot in RAM (up to $2 bytes): ${3:-no profile} */" > $ram
+    echo "/* cold: ${3:-no profile} */" > $cold
+    if [ "$3" = "" ]; then
+        return 0
+    fi
+    local deny=`awk '$1 == "#" && $2 == "noram" { printf "%s ", $3 }' $3`
+    awk -v budget=$2 -v noram="${deny:-$NORAM}" -v hot=$hot -v ram=$ram -v cold=$cold '
+    BEGIN { split(noram, a, " "); for (i in a) deny[a[i]] = 1 }
+    /^#/ || NF < 3 { next }
+    $1 == 0 { printf "    *(.text.%s)\n", $3 >> cold; next }
+    !($3 in deny) && used + $2 <= budget {
+        used += $2
+        printf "    *(.text.%s)\n", $3 >> ram
+        next
+    }
+    { printf "    *(.text.%s)\n", $3 >> hot }' $3
+}
+
+#
+# isrstat(elf)
+# 今動いているファームウェアの割込みの統計 ("名前<TAB>回数<TAB>平均") を出力する
+#
+isrstat() {
+    $ISRTRACE -o /dev/null $1 2>&1 >/dev/null | awk '
+    /^#/ || /^error/ { next }
+    NF >= 7 {
+        n = $0
+        sub(/ +[0-9]+ +[0-9]+ +[0-9]+ +[0-9]+ +[0-9-]+ +[0-9-]+ *$/, "", n)
+        printf "%s\t%d\t%d\n", n, $(NF - 5), $(NF - 3)
+    }'
+}
+
+#
+# bench(seconds, before, after)
+# 2 つのファームウェアの割込みの実行時間を比べる
+#
+bench() {
+    local a=`mktemp` b=`mktemp`
+    trap "rm -f $a $b" EXIT
+
+    for elf in $2 $3; do
+        $OPENOCD -f $OCDCFG -c "init" -c "program $elf verify reset" -c "shutdown" > /dev/null 2>&1
+        if [ $? -ne 0 ]; then
+            echo "error: failed to program $elf." 1>&2
+            exit 1
+        fi
+        sleep $1
+        if [ $elf = $2 ]; then isrstat $elf > $a; else isrstat $elf > $b; fi
+    done
+    if [ ! -s $a ] || [ ! -s $b ]; then
+        echo "error: no interrupt statistics (build both with make TRACE=1)." 1>&2
+        exit 1
+    fi
+
+    awk -F '\t' '
+    FNR == NR { old[$1] = $3; next }
+    ($1 in old) {
+        d = (old[$1] > 0) ? ($3 - old[$1]) * 100 / old[$1] : 0
+        printf "%-32s %8d %8d %+7.1f%%\n", $1, old[$1], $3, d
+    }
+    BEGIN { printf "%-32s %8s %8s %8s\n", "# cycles (avg)", "before", "after", "diff" }' $a $b
+}
+
+#
+# メイン関数
+#
+main() {
+    local cmd=$1 sec=10 pcs="" out="" rambytes=0
+
+    if [ $# -lt 1 ]; then
+        usage
+    fi
+    shift
+
+    while getopts t:s:o:r: OPT
+    do
+        case $OPT in
+            "t" ) sec=$OPTARG;;
+            "s" ) pcs=$OPTARG;;
+            "o" ) out=$OPTARG;;
+            "r" ) rambytes=$OPTARG;;
+              * ) usage;;
+        esac
+    done
+    shift `expr $OPTIND - 1`
+
+    case $cmd in
+        "profile" )
+            if [ $# -lt 1 ]; then
+                usage
+            fi
+            if [ "$pcs" = "" ]; then
+                local gmon=`mktemp`
+                pcs=`mktemp`
+                trap "rm -f $gmon $pcs" EXIT
+                # 動かしたまま PC をサンプリングする (フラッシュの範囲だけ)
+                $OPENOCD -f $OCDCFG -c "init" -c "profile $sec $gmon 0 $ROMEND" -c "shutdown" > /dev/null 2>&1
+                if [ ! -s $gmon ]; then
+                    echo "error: failed to sample the PC of the target." 1>&2
+                    exit 1
+                fi
+                gmon2pc $gmon > $pcs
+            fi
+            profile $1 $pcs
+            ;;
+        "ld" )
+            if [ "$out" = "" ]; then
+                usage
+            fi
+            layout $out $rambytes $1
+            ;;
+        "bench" )
+            if [ $# -lt 2 ]; then
+                usage
+            fi
+            bench $sec $1 $2
+            ;;
+        * )
+            usage
+            ;;
+    esac
+}
+
+main $*
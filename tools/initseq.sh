@@ -0,0 +1,127 @@
+#!/bin/sh
+
+#
+# 初期化シーケンス (common/include/initseq.h) を ELF ファイルから読み出して表示する
+# フロー:
+#   1. SVD からレジスタのアドレスと名前 (ペリフェラル.レジスタ) の表を作る
+#      (derivedFrom のペリフェラルは派生元のレジスタを持つ。NVIC の ISER/ICER は固定で加える)
+#   2. 名前が initseq_ で始まるシンボルを探し、そのセクションのファイル内の位置から表を読む
+#   3. 1 手順 (2 ワード) ずつ、種類, レジスタ名, 値を表示する
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+OBJDUMP=$ARCH-objdump
+SVD=`dirname $0`/../common/svd/LPC1343-subset.svd
+PREFIX=initseq_
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: initseq elffile [svdfile]" 1>&2
+    exit 1
+}
+
+#
+# regmap(svd)
+# "アドレス (16 進) 名前" を出力する
+#
+regmap() {
+    tr '\r\n\t' '   ' < $1 | sed 's/</\n</g' | awk '
+    function num(s,    n, i) {
+        s = tolower(s)
+        gsub(/[ \t]/, "", s)
+        n = 0
+        if (s ~ /^0x/) {
+            for (i = 3; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        } else {
+            n = s + 0
+        }
+        return n
+    }
+    function body(s) { sub(/^[^>]*>/, "", s); gsub(/^ +| +$/, "", s); return s }
+    /^<peripheral[ >]/ {
+        inp = 1; np++; pname[np] = ""; nr[np] = 0
+        if (match($0, /derivedFrom="[^"]*"/)) from[np] = substr($0, RSTART + 13, RLENGTH - 14)
+        next
+    }
+    /^<\/peripheral>/ { inp = 0; next }
+    /^<register>/ { inr = 1; n = ++nr[np]; next }
+    /^<\/register>/ { inr = 0; next }
+    /^<field>/ { inf = 1; next }
+    /^<\/field>/ { inf = 0; next }
+    /^<cluster>/ { inr = -1; next }
+    inp && !inr && /^<name>/ { pname[np] = body($0); pidx[pname[np]] = np; next }
+    inp && !inr && /^<baseAddress>/ { base[np] = num(body($0)); next }
+    inr > 0 && !inf && /^<name>/ { rname[np, n] = body($0); next }
+    inr > 0 && !inf && /^<addressOffset>/ { roff[np, n] = num(body($0)); next }
+    END {
+        for (p = 1; p <= np; p++) {
+            q = (p in from) ? pidx[from[p]] : p
+            for (r = 1; r <= nr[q]; r++) printf "%x %s.%s\n", base[p] + roff[q, r], pname[p], rname[q, r]
+        }
+        for (i = 0; i < 2; i++) {
+            printf "%x NVIC.ISER%d\n", 3758153984 + i * 4, i           # 0xE000E100
+            printf "%x NVIC.ICER%d\n", 3758153984 + 128 + i * 4, i
+        }
+    }'
+}
+
+#
+# dump(elf, svd)
+# initseq_* の表を表示する
+#
+dump() {
+    local map=`mktemp` tabs=`mktemp`
+    trap "rm -f $map $tabs" EXIT
+
+    regmap $2 > $map
+    $OBJDUMP -h $1 | awk '$1 ~ /^[0-9]+$/ { print "S", $2, $3, $4, $6 }' > $tabs
+    $NM -S $1 | awk -v p=$PREFIX 'index($4, p) == 1 && $3 ~ /^[rRdD]$/ { print "T", $1, $2, $4 }' >> $tabs
+
+    awk -v elf=$1 '
+    function h2n(s,    n, i) {
+        n = 0
+        s = tolower(s)
+        for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        return n
+    }
+    FNR == NR { reg[$1] = $2; next }
+    $1 == "S" { sn++; sname[sn] = $2; ssize[sn] = h2n($3); svma[sn] = h2n($4); soff[sn] = h2n($5); next }
+    $1 == "T" { tn++; taddr[tn] = h2n($2); tsize[tn] = h2n($3); tname[tn] = $4; next }
+    function regname(a) { return (sprintf("%x", a) in reg) ? reg[sprintf("%x", a)] : sprintf("0x%08X", a) }
+    END {
+        split("write set clr poll", opname, " ")
+        for (t = 1; t <= tn; t++) {
+            for (s = 1; s <= sn; s++) if (svma[s] <= taddr[t] && taddr[t] < svma[s] + ssize[s]) break
+            if (s > sn) continue
+            printf "%s (%s, %d steps)\n", tname[t], sname[s], tsize[t] / 8
+            cmd = sprintf("od -A n -v -t x4 -j %d -N %d %s", soff[s] + taddr[t] - svma[s], tsize[t], elf)
+            nw = 0
+            while ((cmd | getline line) > 0) {
+                m = split(line, f, " ")
+                for (i = 1; i <= m; i++) w[nw++] = h2n(f[i])
+            }
+            close(cmd)
+            for (i = 0; i + 1 < nw; i += 2) {
+                op = w[i] % 4; a = w[i] - op; v = w[i + 1]
+                if (a == 0 && op == 0) printf "    %-6s %-24s %d\n", "delay", "", v
+                else if (a == 0 && op == 2) printf "    %-6s %-24s 0x%08X\n", "mask", "", v
+                else printf "    %-6s %-24s 0x%08X\n", opname[op + 1], regname(a), v
+            }
+        }
+    }' $map $tabs
+}
+
+#
+# メイン関数
+#
+main() {
+    if [ $# -lt 1 ]; then
+        usage
+    fi
+    dump $1 ${2:-$SVD}
+}
+
+main $*
@@ -0,0 +1,188 @@
+#!/bin/sh
+
+#
+# 割込みのトレース (common/include/isrtrace.h) を Chrome/Perfetto のトレース (JSON) にする
+# フロー:
+#   1. ダンプファイルが指定されなければ OpenOCD でターゲットを止めて g_isrtrace を吸い出す
+#   2. 例外番号ごとの元のハンドラのアドレスを ELF のシンボルで名前にする
+#   3. レコードの時刻を CYCCNT の上位ビット (EPOCH レコード) で 32 ビットに戻し、
+#      ハンドラの出入りを B/E イベントとして出力する (ネストは入れ子で表示される)
+#   4. 例外番号ごとの回数, 実行時間 (ネストした割込みを含む), 起動間隔の最小/最大を標準エラーに出す
+# 結果は chrome://tracing か https://ui.perfetto.dev で開く。
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+OPENOCD=openocd
+OCDCFG=`dirname $0`/../lpc1343qsb.cfg
+SYMBOL=g_isrtrace
+MAGIC=54525349                      # ISRTRACE_MAGIC
+HDRWORDS=5                          # isrtrace_t の handler より前のワード数
+NVEC=73                             # NUM_VECTORS
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: isrtrace [-o jsonfile] elffile [tracedump]" 1>&2
+    exit 1
+}
+
+#
+# h2n の awk 関数 (16 進文字列を数値にする)
+#
+H2N='
+function h2n(s,    n, i) {
+    n = 0
+    s = tolower(s)
+    for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+    return n
+}'
+
+#
+# convert(elf, dump)
+# ダンプをトレースの JSON にして標準出力に書く
+#
+convert() {
+    local syms=`mktemp`
+    $NM $1 | awk '$2 ~ /^[tTwW]$/ { print $1, $3 }' > $syms
+    od -A n -t x4 -v $2 | tr -s ' ' '\n' | grep -v '^$' | awk "$H2N"'
+    NR == FNR { sym[h2n($1)] = $2; next }
+    { w[n++] = h2n($1) }
+    function vecname(v) {
+        if (v == 15) return "SysTick"
+        if (v >= 16) return "IRQ" (v - 16)
+        return "exception " v
+    }
+    function event(ph, v, t) {
+        printf "%s\n{\"name\":\"%s\",\"cat\":\"irq\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":1", \
+               sep, name[v], ph, (t - t0) * 1e6 / hz
+        if (ph == "B") printf ",\"args\":{\"vector\":%d}", v
+        printf "}"
+        sep = ","
+    }
+    END {
+        if (n < '$HDRWORDS' + '$NVEC' || w[0] != h2n("'$MAGIC'")) {
+            print "error: no trace buffer (magic mismatch)." > "/dev/stderr"
+            exit 1
+        }
+        size = w[1]; wr = w[2]; hz = w[4]
+        if (hz == 0 || n < '$HDRWORDS' + '$NVEC' + size) {
+            print "error: broken trace buffer." > "/dev/stderr"
+            exit 1
+        }
+        for (v = 0; v < '$NVEC'; v++) {
+            a = w['$HDRWORDS' + v]; a -= a % 2
+            name[v] = vecname(v)
+            if ((a in sym) && sym[a] != "wrap") name[v] = sym[a] " (" name[v] ")"
+        }
+
+        # 古い順に並べる (一周していたら wr - size より前は上書きされている)
+        cnt = (wr < size) ? wr : size
+        if (wr > size) printf "# overwritten %d words\n", wr - size > "/dev/stderr"
+        for (i = 0; i < cnt; i++) r[i] = w['$HDRWORDS' + '$NVEC' + (wr - cnt + i) % size]
+
+        # 最初の EPOCH より前のレコードは、その 1 つ前の上位ビットに属する
+        hi = 0
+        for (i = 0; i < cnt; i++) {
+            if (r[i] % 128 == 127) {
+                if (i > 0) hi = (int(r[i] / 256) + 255) % 256
+                break
+            }
+        }
+
+        printf "{\"displayTimeUnit\":\"ns\",\"traceEvents\":["
+        printf "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"handler mode\"}}"
+        sep = ","
+        carry = 0; depth = 0; t0 = -1
+        for (i = 0; i < cnt; i++) {
+            k = r[i] % 256
+            if (k % 128 == 127) {
+                e = int(r[i] / 256) % 256
+                if (e < hi) carry++
+                hi = e
+                continue
+            }
+            t = (carry * 256 + hi) * 16777216 + int(r[i] / 256)
+            if (t0 < 0) t0 = t
+            v = k % 128
+            if (k < 128) {
+                stk[depth] = v; st[depth] = t; depth++
+                if (v in last) {
+                    p = t - last[v]
+                    if (!(v in pmin) || p < pmin[v]) pmin[v] = p
+                    if (p > pmax[v]) pmax[v] = p
+                }
+                last[v] = t
+                event("B", v, t)
+            } else if (depth > 0 && stk[depth - 1] == v) {
+                depth--
+                d = t - st[depth]
+                cntv[v]++; sum[v] += d
+                if (!(v in dmin) || d < dmin[v]) dmin[v] = d
+                if (d > dmax[v]) dmax[v] = d
+                event("E", v, t)
+            }                                           # 出口だけ残っているもの (先頭が上書きされた) は捨てる
+        }
+        print "\n]}"
+
+        printf "# %d Hz, cycles: count dur_min dur_avg dur_max period_min period_max\n", hz > "/dev/stderr"
+        for (v = 0; v < '$NVEC'; v++) {
+            if (!(v in cntv)) continue
+            printf "%-32s %6d %8d %8d %8d %10s %10s\n", name[v], cntv[v], dmin[v], sum[v] / cntv[v], dmax[v], \
+                   (v in pmin) ? pmin[v] : "-", (v in pmax) ? pmax[v] : "-" > "/dev/stderr"
+        }
+    }' $syms -
+    local ret=$?
+    rm -f $syms
+    return $ret
+}
+
+#
+# メイン関数
+#
+main() {
+    local out=""
+
+    while getopts o: OPT
+    do
+        case $OPT in
+            "o" ) out=$OPTARG;;
+              * ) usage;;
+        esac
+    done
+
+    shift `expr $OPTIND - 1`
+    if [ $# -lt 1 ]; then
+        usage
+    fi
+
+    local elf=$1
+    local dump=$2
+
+    if [ "$dump" = "" ]; then
+        local sym=`$NM -S $elf | awk -v s=$SYMBOL '$4 == s { print $1, $2 }'`
+        if [ "$sym" = "" ]; then
+            echo "error: symbol $SYMBOL not found." 1>&2
+            exit 1
+        fi
+        set -- $sym
+        dump=`mktemp`
+        trap "rm -f $dump" EXIT
+        # 吸い出す間に上書きされないように、ターゲットを一時的に止める
+        $OPENOCD -f $OCDCFG -c "init" -c "halt" -c "dump_image $dump 0x$1 $((0x$2))" -c "resume" \
+            -c "shutdown" > /dev/null 2>&1
+        if [ ! -s $dump ]; then
+            echo "error: failed to read the trace from the target." 1>&2
+            exit 1
+        fi
+    fi
+
+    if [ "$out" = "" ]; then
+        convert $elf $dump
+    else
+        convert $elf $dump > $out
+    fi
+}
+
+main $*
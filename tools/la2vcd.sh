@@ -0,0 +1,151 @@
+#!/bin/sh
+
+#
+# ロジックアナライザ (common/include/la.h) のキャプチャを VCD ファイルにする
+# フロー:
+#   1. ダンプファイルが指定されなければ OpenOCD で g_la を吸い出す
+#      (la_capture() が戻った後に読むので、ターゲットは止めない)
+#   2. 残っているレコードを古い順に並べ、続いたサンプル数を足してサンプルの番号に戻す
+#   3. 値が変わったピンだけを、その時刻 (サンプルの番号 / サンプリング周波数) に出力する
+#   4. トリガのサンプルに trigger のパルスを置く
+# 結果は GTKWave や PulseView で開く。
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+OPENOCD=openocd
+OCDCFG=`dirname $0`/../lpc1343qsb.cfg
+SYMBOL=g_la
+MAGIC=5043414c                      # LA_MAGIC
+HDRWORDS=6                          # la_capture_t の buf より前のワード数
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: la2vcd [-o vcdfile] elffile [capturedump]" 1>&2
+    exit 1
+}
+
+#
+# convert(dump)
+# ダンプを VCD にして標準出力に書く
+#
+convert() {
+    od -A n -t x4 -v $1 | tr -s ' ' '\n' | grep -v '^$' | awk '
+    function h2n(s,    n, i) {
+        n = 0
+        s = tolower(s)
+        for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        return n
+    }
+    function ns(i) {
+        return int(i * 1e9 / rate + 0.5)
+    }
+    { w[n++] = h2n($1) }
+    END {
+        if (n < '$HDRWORDS' || w[0] != h2n("'$MAGIC'")) {
+            print "error: no capture (magic mismatch)." > "/dev/stderr"
+            exit 1
+        }
+        size = w[1]; wr = w[2]; trig = w[3]; rate = w[4]
+        mask = w[5] % 65536; port = int(w[5] / 65536) % 256; status = int(w[5] / 16777216)
+        if (rate == 0 || n < '$HDRWORDS' + size) {
+            print "error: broken capture." > "/dev/stderr"
+            exit 1
+        }
+        split("idle done full timeout", sname, " ")
+        printf "# P%d mask 0x%03x, %d Hz, %s\n", port, mask, rate, sname[status + 1] > "/dev/stderr"
+
+        # 古い順に並べる (一周していたら wr - size より前は上書きされている)
+        cnt = (wr < size) ? wr : size
+        if (wr > size) printf "# overwritten %d records\n", wr - size > "/dev/stderr"
+
+        print "$timescale 1 ns $end"
+        printf "$scope module P%d $end\n", port
+        npin = 0
+        for (b = 0; b < 12; b++) {
+            if (int(mask / 2 ^ b) % 2 == 0) continue
+            pin[npin] = b; id[npin] = sprintf("%c", 34 + npin)
+            printf "$var wire 1 %s P%d_%d $end\n", id[npin], port, b
+            npin++
+        }
+        print "$var wire 1 ! trigger $end"
+        print "$upscope $end"
+        print "$enddefinitions $end"
+
+        idx = 0; off = -1
+        for (i = 0; i < cnt; i++) {
+            k = wr - cnt + i
+            r = w['$HDRWORDS' + k % size]
+            v = r % 4096
+            if (off >= 0 && off < idx) { printf "#%d\n0!\n", ns(off); off = -1 }
+            ev = ""
+            for (j = 0; j < npin; j++) {
+                bit = int(v / 2 ^ pin[j]) % 2
+                if (i == 0 || bit != last[j]) ev = ev bit id[j] "\n"
+                last[j] = bit
+            }
+            if (off == idx) { ev = ev "0!\n"; off = -1 }
+            if (k == trig) {
+                ev = ev "1!\n"; off = idx + 1                 # トリガのパルスは 1 サンプルの幅
+                printf "# trigger at %d ns\n", ns(idx) > "/dev/stderr"
+            } else if (i == 0) {
+                ev = ev "0!\n"
+            }
+            if (i == 0) printf "#%d\n$dumpvars\n%s$end\n", ns(idx), ev
+            else if (ev != "") printf "#%d\n%s", ns(idx), ev
+            idx += int(r / 4096)
+        }
+        if (off >= 0 && off < idx) printf "#%d\n0!\n", ns(off)
+        printf "#%d\n", ns(idx)
+        printf "# %d samples, %d records\n", idx, cnt > "/dev/stderr"
+    }'
+}
+
+#
+# メイン関数
+#
+main() {
+    local out=""
+
+    while getopts o: OPT
+    do
+        case $OPT in
+            "o" ) out=$OPTARG;;
+              * ) usage;;
+        esac
+    done
+
+    shift `expr $OPTIND - 1`
+    if [ $# -lt 1 ]; then
+        usage
+    fi
+
+    local elf=$1
+    local dump=$2
+
+    if [ "$dump" = "" ]; then
+        local sym=`$NM -S $elf | awk -v s=$SYMBOL '$4 == s { print $1, $2 }'`
+        if [ "$sym" = "" ]; then
+            echo "error: symbol $SYMBOL not found." 1>&2
+            exit 1
+        fi
+        set -- $sym
+        dump=`mktemp`
+        trap "rm -f $dump" EXIT
+        $OPENOCD -f $OCDCFG -c "init" -c "dump_image $dump 0x$1 $((0x$2))" -c "shutdown" > /dev/null 2>&1
+        if [ ! -s $dump ]; then
+            echo "error: failed to read the capture from the target." 1>&2
+            exit 1
+        fi
+    fi
+
+    if [ "$out" = "" ]; then
+        convert $dump
+    else
+        convert $dump > $out
+    fi
+}
+
+main $*
@@ -0,0 +1,231 @@
+#!/bin/sh
+
+#
+# LOG() (common/include/log.h) が出力したバイナリログを ELF の書式文字列で整形して表示する
+# フロー:
+#   1. ELF から .logstr (書式文字列) と .text, .rodata (%s で参照される文字列) を取り出す
+#   2. ログをワード列にする
+#        リングバッファ: ダンプファイルが指定されなければ OpenOCD で g_log_ring を吸い出し、
+#                        表示した分だけ読み出し位置 (rd) を進める
+#        ITM (-i)      : SWO のキャプチャファイルから指定ポートのパケットを取り出す
+#   3. ヘッダ (引数の数 << 28 | 書式 ID) と引数からメッセージを組み立てる
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+OBJDUMP=$ARCH-objdump
+OPENOCD=openocd
+OCDCFG=`dirname $0`/../lpc1343qsb.cfg
+SYMBOL=g_log_ring
+MAGIC=474f4c42                      # LOG_RING_MAGIC
+HDRWORDS=5                          # log_ring_t の buf より前のワード数
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: logdump elffile [ringdump]" 1>&2
+    echo "       logdump -i [-p port] elffile swodump" 1>&2
+    exit 1
+}
+
+#
+# h2n の awk 関数 (16 進文字列を数値にする)
+#
+H2N='
+function h2n(s,    n, i) {
+    n = 0
+    s = tolower(s)
+    for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+    return n
+}'
+
+#
+# sections(elf)
+# .logstr を "L <アドレス> <16 進バイト列>", .text と .rodata を "R ..." の形で出力する
+#
+sections() {
+    $OBJDUMP -s -j .logstr $1 | awk '/^ [0-9a-f]+ / { print "L", $1, substr($0, length($1) + 3, 35) }'
+    $OBJDUMP -s -j .text -j .rodata $1 | awk '/^ [0-9a-f]+ / { print "R", $1, substr($0, length($1) + 3, 35) }'
+}
+
+#
+# ring_words(elf, dump)
+# リングバッファのダンプから未読のワードを 1 行 1 ワード (16 進) で出力する
+#
+ring_words() {
+    od -A n -t x4 -v $2 | tr -s ' ' '\n' | grep -v '^$' | awk "$H2N"'
+    { w[NR - 1] = h2n($1) }
+    END {
+        if (NR < '$HDRWORDS' || w[0] != h2n("'$MAGIC'")) {
+            print "error: no log ring (magic mismatch)." > "/dev/stderr"
+            exit 1
+        }
+        size = w[1]; wr = w[2]; rd = w[3]
+        if (w[4] > 0) printf "# dropped %d\n", w[4]
+        if ((wr - rd + 4294967296) % 4294967296 > size) {
+            print "error: broken ring indices." > "/dev/stderr"
+            exit 1
+        }
+        for (i = rd; i != wr; i = (i + 1) % 4294967296) printf "%08x\n", w['$HDRWORDS' + i % size]
+        printf "# wr %d\n", wr
+    }'
+}
+
+#
+# itm_words(port, dump)
+# SWO のキャプチャ (ITM パケット列) からポート port の 4 バイトパケットを 1 行 1 ワードで出力する
+#
+itm_words() {
+    od -A n -t x1 -v $2 | tr -s ' ' '\n' | grep -v '^$' | awk -v port=$1 "$H2N"'
+    BEGIN { need = 0; cont = 0; zeros = 0 }
+    {
+        b = h2n($1)
+        if (need > 0) {                                 # ソフトウェア/ハードウェアソースのペイロード
+            v += b * mul; mul *= 256
+            if (--need == 0 && keep) printf "%08x\n", v
+            next
+        }
+        if (cont) { cont = (b >= 128); next }           # タイムスタンプ/拡張パケットの続き
+        if (b == 0) { zeros++; next }
+        if (b == 128 && zeros >= 5) { zeros = 0; next } # 同期パケット
+        zeros = 0
+        if (b == 112) { print "# overflow"; next }
+        if (b % 4 != 0) {
+            need = (b % 4 == 3) ? 4 : b % 4
+            keep = (need == 4 && int(b / 4) % 2 == 0 && int(b / 8) == port)
+            v = 0; mul = 1
+        } else {
+            cont = (b >= 128)
+        }
+    }'
+}
+
+#
+# format(elf)
+# 標準入力のワード列をレコードに区切って整形する
+#
+format() {
+    local mem=`mktemp`
+    sections $1 > $mem
+    awk "$H2N"'
+    # 16 進バイト列をバイト配列に展開する
+    NR == FNR {
+        hex = $3 $4 $5 $6
+        a = h2n($2)
+        for (i = 1; i < length(hex); i += 2) {
+            if ($1 == "L") L[a++] = h2n(substr(hex, i, 2)); else R[a++] = h2n(substr(hex, i, 2))
+        }
+        next
+    }
+    function cstr(m, a,    s) {
+        s = ""
+        while ((a in m) && m[a] != 0) s = s sprintf("%c", m[a++])
+        return s
+    }
+    function conv(spec, c, v) {
+        if (c == "d" || c == "i") return sprintf(spec, v >= 2147483648 ? v - 4294967296 : v)
+        if (c == "s") return (v in R) ? sprintf(spec, cstr(R, v)) : sprintf("<0x%08x>", v)
+        if (c == "p") return sprintf("0x%08x", v)
+        if (c == "c") return sprintf("%c", v % 256)
+        if (c ~ /[ouxX]/) return sprintf(spec, v)
+        return sprintf("<0x%08x>", v)                   # 浮動小数点数などは値をそのまま出す
+    }
+    function emit(    f, out, i, k, c, spec) {
+        if (!(id in L)) {
+            printf "?? id 0x%07x:", id
+            for (i = 0; i < nargs; i++) printf " 0x%08x", arg[i]
+            printf "\n"
+            return
+        }
+        f = cstr(L, id)
+        out = ""; k = 0
+        for (i = 1; i <= length(f); i++) {
+            c = substr(f, i, 1)
+            if (c != "%") { out = out c; continue }
+            spec = "%"
+            while (++i <= length(f)) {
+                c = substr(f, i, 1)
+                if (c ~ /[-+ #0-9.]/) spec = spec c
+                else if (c !~ /[hlzjt]/) break          # 長さ修飾子は捨てる (引数はすべて 32 ビット)
+            }
+            if (c == "%") out = out "%"
+            else out = out conv(spec c, c, arg[k++])
+        }
+        print out
+    }
+    /^#/ { if ($2 != "wr") print; next }
+    {
+        w = h2n($1)
+        if (left == 0) {
+            nargs = left = int(w / 268435456); id = w % 268435456
+        } else {
+            arg[nargs - left--] = w
+        }
+        if (left == 0) emit()
+    }' $mem -
+    rm -f $mem
+}
+
+#
+# メイン関数
+#
+main() {
+    local itm=0
+    local port=0
+
+    while getopts ip: OPT
+    do
+        case $OPT in
+            "i" ) itm=1;;
+            "p" ) port=$OPTARG;;
+              * ) usage;;
+        esac
+    done
+
+    shift `expr $OPTIND - 1`
+    if [ $# -lt 1 ] || [ $itm = 1 -a $# -lt 2 ]; then
+        usage
+    fi
+
+    local elf=$1
+    local dump=$2
+
+    if [ $itm = 1 ]; then
+        itm_words $port $dump | format $elf
+        exit 0
+    fi
+
+    if [ "$dump" != "" ]; then
+        ring_words $elf $dump | format $elf
+        exit 0
+    fi
+
+    # ターゲットは止めずに読む (ターゲットは未読の領域を上書きしない)
+    local sym=`$NM -S $elf | awk -v s=$SYMBOL '$4 == s { print $1, $2 }'`
+    if [ "$sym" = "" ]; then
+        echo "error: symbol $SYMBOL not found." 1>&2
+        exit 1
+    fi
+    set -- $sym
+    local addr=0x$1
+    dump=`mktemp`
+    trap "rm -f $dump" EXIT
+    $OPENOCD -f $OCDCFG -c "init" -c "dump_image $dump $addr $((0x$2))" -c "shutdown" > /dev/null 2>&1
+    if [ ! -s $dump ]; then
+        echo "error: failed to read the ring from the target." 1>&2
+        exit 1
+    fi
+
+    local words
+    words=`ring_words $elf $dump` || exit 1
+    echo "$words" | format $elf
+
+    # 表示した分を読み出し済みにする
+    local wr=`echo "$words" | awk '$2 == "wr" { print $3 }'`
+    $OPENOCD -f $OCDCFG -c "init" -c "mww $(($addr + 12)) $wr" -c "shutdown" > /dev/null 2>&1
+
+    exit 0
+}
+
+main $*
@@ -0,0 +1,81 @@
+#!/bin/sh
+
+#
+# 2 つのリビジョンで同じソースファイルをコンパイルし、セクションサイズを比べる
+# フロー:
+#   1. 各リビジョンの common/ を git archive で一時ディレクトリに取り出す (WORK は作業ツリー)
+#   2. 例題の Makefile と同じオプションで指定のファイルをコンパイルする
+#   3. arm-none-eabi-size の text, data, bss を並べて差分を表示する
+# 実行サイクルの比較は bench/ (make run BASELINE=...) で行う
+#
+
+ARCH=arm-none-eabi
+CC=$ARCH-gcc
+SIZE=$ARCH-size
+CFLAGS="-Wall -march=armv7-m -mthumb -ffreestanding"
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: sizecmp [-O level] rev1 rev2 file..." 1>&2
+    echo "       (rev WORK means the working tree; files are relative to common/src)" 1>&2
+    exit 1
+}
+
+#
+# build(rev, dir, file)
+# リビジョン rev の file をコンパイルして "text data bss" を出力する
+#
+build() {
+    local src=$2/$1
+    if [ ! -d $src ]; then
+        mkdir -p $src
+        if [ $1 = WORK ]; then
+            cp -r $ROOT/common $src/
+        else
+            git -C $ROOT archive $1 common | tar -x -C $src
+        fi
+    fi
+    $CC $CFLAGS -I$src/common/include -c -o $2/$1.o $src/common/src/$3 || exit 1
+    $SIZE $2/$1.o | awk 'NR == 2 { print $1, $2, $3 }'
+}
+
+#
+# メイン関数
+#
+main() {
+    while getopts O: OPT
+    do
+        case $OPT in
+            "O" ) CFLAGS="$CFLAGS -O$OPTARG";;
+              * ) usage;;
+        esac
+    done
+
+    shift `expr $OPTIND - 1`
+    if [ $# -lt 3 ]; then
+        usage
+    fi
+
+    ROOT=`dirname $0`/..
+    local rev1=$1
+    local rev2=$2
+    shift 2
+
+    local tmp=`mktemp -d`
+    trap "rm -rf $tmp" EXIT
+
+    printf "%-16s %8s %8s %8s   %8s %8s %8s\n" file "text1" "data1" "bss1" "text2" "data2" "bss2"
+    for f in $*
+    do
+        set -- `build $rev1 $tmp $f` `build $rev2 $tmp $f`
+        if [ $# -ne 6 ]; then
+            echo "error: failed to compile $f." 1>&2
+            exit 1
+        fi
+        printf "%-16s %8d %8d %8d   %8d %8d %8d  (text %+d)\n" $f $1 $2 $3 $4 $5 $6 $(($4 - $1))
+    done
+}
+
+main $*
@@ -0,0 +1,227 @@
+#!/bin/sh
+
+#
+# メインスタックの最悪使用量を静的に見積もり、スタック領域に収まるかを検査する
+# フロー:
+#   1. -fstack-usage が出力した *.su から関数ごとのフレームサイズを得る
+#   2. ELF の逆アセンブル結果から呼び出しグラフ (bl, blx <sym>, 他関数への b) を得る。
+#      naked 関数は *.su では 0 バイトになるので、命令 (push, stmdb sp!, sub sp) が積む分を数える
+#   3. ベクタテーブル (vectors のシンボルのサイズ分) からエントリポイント
+#      (reset_handler と各例外/割込みハンドラ) を得る
+#   4. エントリポイントごとに最深の呼び出し経路を求め、割込みのネストを加えた合計を
+#      スタック領域のサイズ (_main_sp - _stack_bottom) と比べる。
+#      同じプリエンプション優先度のハンドラは互いに割り込まないので、優先度ごとに最深の
+#      ハンドラ 1 つだけを加える。優先度は -p で指定し、指定のないハンドラはリセット時の値
+#      (NMI は -2, HardFault は -1, それ以外は 0) とする
+# 関数ポインタ経由の呼び出し (blx レジスタ) と再帰は静的に追えないので警告を出す
+# (vector_install() で実行時に登録するハンドラは -e で指定すること)
+#
+
+ARCH=arm-none-eabi
+NM=$ARCH-nm
+OBJDUMP=$ARCH-objdump
+EXCFRAME=36                         # 例外エントリで積まれるフレーム (8 ワード + 境界調整 1 ワード)
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: stackcheck [-n nest] [-e entry]... [-p handler=prio]... elffile sudir" 1>&2
+    exit 1
+}
+
+#
+# メイン関数
+#
+main() {
+    local nest=0
+    local extra=""
+    local prios=""
+
+    while getopts n:e:p: OPT
+    do
+        case $OPT in
+            "n" ) nest=$OPTARG;;
+            "e" ) extra="$extra $OPTARG";;
+            "p" ) prios="$prios $OPTARG";;
+              * ) usage;;
+        esac
+    done
+
+    shift `expr $OPTIND - 1`
+    if [ $# -lt 2 ]; then
+        usage
+    fi
+
+    local elf=$1
+    local sudir=$2
+    local nvec=`$NM -S $elf | awk '$4 == "vectors" { print $2 }'`
+
+    nvec=`printf "%d" 0x${nvec:-0}`
+    nvec=`expr $nvec / 4`
+
+    # 入力を 1 つのストリームにまとめて awk で処理する
+    #   S <関数> <バイト数> <種別>   : フレームサイズ
+    #   F <関数>                     : 関数の先頭
+    #   C <呼び出し先>               : 直前の F の関数からの呼び出し
+    #   P <バイト数>                 : 直前の F の関数の命令がスタックに積むバイト数
+    #   I                            : 直前の F の関数に間接呼び出しがある
+    #   A <アドレス> <関数> <種別>   : シンボル
+    #   V <アドレス>                 : ベクタテーブルのエントリ
+    #   Z <シンボル> <アドレス>      : スタック領域の境界
+    #   E <関数>                     : 追加のエントリポイント
+    #   Q <関数> <優先度>            : ハンドラのプリエンプション優先度
+    {
+        cat $sudir/*.su 2>/dev/null | awk -F '\t' '{ n = split($1, a, ":"); print "S", a[n], $2, $3 }'
+
+        $OBJDUMP -d $elf | awk '
+        /^[0-9a-f]+ <[^>]+>:$/ { f = substr($2, 2, length($2) - 3); print "F", f; next }
+        /\tblx?\t[0-9a-f]+ <[^+>]+>/ || /\tb(\.w|\.n)?\t[0-9a-f]+ <[^+>]+>/ {
+            t = $NF; t = substr(t, 2, length(t) - 2)
+            if (t != f) print "C", t
+            next
+        }
+        /\tblx\tr[0-9]+/ || /\tblx\t(ip|lr)/ { print "I"; next }
+        /\tpush(\.w)?\t\{/ || /\tstmdb(\.w)?\tsp!, \{/ {
+            r = $0; sub(/^[^{]*\{/, "", r); sub(/\}.*$/, "", r)
+            n = split(r, a, ",")
+            c = n
+            for (i = 1; i <= n; i++) {                  # r4-r11 のような範囲も数える
+                if (match(a[i], /r[0-9]+-r[0-9]+/)) { split(substr(a[i], RSTART + 1, RLENGTH - 1), b, "-r"); c += b[2] - b[1] }
+            }
+            print "P", c * 4
+            next
+        }
+        /\tsub(\.w)?\tsp, (sp, )?#[0-9]+/ { r = $0; sub(/^.*#/, "", r); print "P", r + 0 }'
+
+        $NM $elf | awk 'toupper($2) ~ /^[TW]$/ { print "A", $1, $3, $2 } $3 == "_main_sp" || $3 == "_stack_bottom" { print "Z", $3, $1 }'
+
+        # ベクタテーブル (リトルエンディアンのワード列)。.romvector の残りは 0xFF で埋まっている
+        $OBJDUMP -s -j .romvector $elf | awk -v nvec=$nvec '/^ [0-9a-f]+ / {
+            for (i = 2; i <= 5 && i <= NF; i++) {
+                w = $i
+                if (length(w) != 8) continue
+                if (nvec > 0 ? n++ >= nvec : w == "ffffffff") exit
+                print "V", substr(w, 7, 2) substr(w, 5, 2) substr(w, 3, 2) substr(w, 1, 2)
+            }
+        }'
+
+        for e in $extra; do
+            echo "E $e"
+        done
+        for p in $prios; do
+            echo "Q ${p%%=*} ${p#*=}"
+        done
+    } | awk -v nest=$nest -v excframe=$EXCFRAME '
+    function h2n(s,    n, i) {
+        s = tolower(s)
+        n = 0
+        for (i = 1; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        return n
+    }
+    # 関数 f から呼び出し先をたどった最大スタック使用量 (バイト)
+    function depth(f,    i, d, m, c) {
+        if (f in memo) return memo[f]
+        if (f in onpath) {
+            print "warning: recursion through " f " (not bounded)" > "/dev/stderr"
+            return 0
+        }
+        onpath[f] = 1
+        if (!(f in frame) || frame[f] == 0) {
+            # naked 関数 (*.su では 0) とアセンブラの関数は、命令が積むバイト数を使う
+            if (!(f in frame) && !(f in pushed) && !(f in warned)) {
+                print "warning: no stack usage for " f " (assumed 0)" > "/dev/stderr"; warned[f] = 1
+            }
+            frame[f] = pushed[f] + 0
+        }
+        m = 0
+        for (i = 1; i <= ncall[f]; i++) {
+            c = callee[f, i]
+            d = depth(c)
+            if (d > m) { m = d; via[f] = c }
+        }
+        delete onpath[f]
+        memo[f] = frame[f] + m
+        return memo[f]
+    }
+    function path(f,    s) {
+        s = f
+        while (f in via) { f = via[f]; s = s " > " f }
+        return s
+    }
+    $1 == "S" {
+        if (!($2 in frame) || $3 > frame[$2]) frame[$2] = $3
+        if ($4 ~ /dynamic/ && $4 !~ /bounded/) dyn[$2] = 1
+    }
+    $1 == "F" { cur = $2; ncall[cur] += 0 }
+    $1 == "P" { pushed[cur] += $2 }
+    $1 == "C" { if (!((cur, $2) in seen)) { seen[cur, $2] = 1; callee[cur, ++ncall[cur]] = $2 } }
+    $1 == "I" { indirect[cur] = 1 }
+    $1 == "A" { a = h2n($2); if (!(a in sym) || symtype[a] == "W") { sym[a] = $3; symtype[a] = toupper($4) } }    # 別名なら強いシンボルを採る
+    $1 == "Z" { bound[$2] = h2n($3) }
+    $1 == "V" { vec[nvec++] = h2n($2) }
+    $1 == "E" { ext[++nent] = $2 }
+    $1 == "Q" { prio[$2] = $3 + 0 }
+    END {
+        # ベクタ 1 (リセット) はスレッド、2 以降は例外/割込みハンドラ (ベクタ 7 はチェックサム)。
+        # 同じ関数が優先度の違う複数のベクタにあれば、優先度ごとに 1 つのハンドラとして扱う
+        thread = sym[vec[1] - vec[1] % 2]
+        for (i = 2; i < nvec; i++) {
+            if (i == 7 || vec[i] == 0) continue
+            h = sym[vec[i] - vec[i] % 2]
+            if (h == "") continue
+            p = (i == 2) ? -2 : (i == 3) ? -1 : (h in prio) ? prio[h] : 0
+            if ((h, p) in isrseen) continue
+            isrseen[h, p] = 1
+            isr[++nisr] = h; ip[nisr] = p
+        }
+        for (i = 1; i <= nent; i++) {
+            h = ext[i]
+            p = (h in prio) ? prio[h] : 0
+            if ((h, p) in isrseen) continue
+            isrseen[h, p] = 1
+            isr[++nisr] = h; ip[nisr] = p
+        }
+
+        for (f in dyn) print "warning: " f " has a dynamic stack frame" > "/dev/stderr"
+        for (f in indirect) print "warning: " f " calls through a function pointer (not followed)" > "/dev/stderr"
+
+        t = depth(thread)
+        printf "%-24s %6d  %s\n", "thread", t, path(thread)
+
+        # 優先度ごとに最深のハンドラを採り、それらを深い順に nest 段までネストし得るものとして加算する
+        for (i = 1; i <= nisr; i++) d[i] = depth(isr[i]) + excframe
+        for (i = 1; i <= nisr; i++) {
+            for (j = i + 1; j <= nisr; j++) {
+                if (d[j] > d[i]) {
+                    x = d[i]; d[i] = d[j]; d[j] = x; x = isr[i]; isr[i] = isr[j]; isr[j] = x; x = ip[i]; ip[i] = ip[j]; ip[j] = x
+                }
+            }
+        }
+        total = t
+        nlevel = 0
+        for (i = 1; i <= nisr; i++) {
+            if (ip[i] in top) {
+                note = "  (same priority as " top[ip[i]] ")"
+            } else if (nest > 0 && nlevel >= nest) {
+                top[ip[i]] = isr[i]
+                note = "  (not nested)"
+            } else {
+                top[ip[i]] = isr[i]
+                nlevel++
+                total += d[i]
+                note = ""
+            }
+            printf "%-24s %6d  [%d] %s%s\n", isr[i], d[i], ip[i], path(isr[i]), note
+        }
+
+        size = bound["_main_sp"] - bound["_stack_bottom"]
+        printf "%-24s %6d / %d bytes\n", "worst case", total, size
+        if (total > size) {
+            print "error: worst-case stack usage exceeds the stack region." > "/dev/stderr"
+            exit 1
+        }
+    }'
+}
+
+main $*
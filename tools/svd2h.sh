@@ -0,0 +1,296 @@
+#!/bin/sh
+
+#
+# CMSIS-SVD ファイルからペリフェラルレジスタの構造体オーバーレイのヘッダを生成する
+# フロー:
+#   1. SVD (XML) をタグ 1 個につき 1 行に並べ直す
+#   2. awk でペリフェラル, レジスタ, ビットフィールドを読み取る
+#      (derivedFrom のペリフェラルは派生元の構造体を共有する)
+#   3. ペリフェラルごとに
+#        - volatile メンバの構造体 (<名前>_regs_t)。隙間は __reserved で埋め、
+#          アドレスが重なるレジスタは共用体にする
+#        - offsetof によるオフセットの静的検査
+#        - ビットフィールドの定数 <名前>_<レジスタ>_<フィールド>_Pos / _Msk
+#      を、最後にベースアドレス <名前>_BASE (-D で差し替え可) とポインタ LPC_<名前> を出力する
+# 構造体名は headerStructName があればそれを、なければペリフェラル名を小文字にして使う。
+# cluster と、レジスタ単位の derivedFrom には対応していない
+#
+
+#
+# Usage を表示して終了する
+#
+usage() {
+    echo "usage: svd2h svdfile header" 1>&2
+    exit 1
+}
+
+#
+# メイン関数
+#
+main() {
+    if [ $# -lt 2 ]; then
+        usage
+    fi
+
+    local svd=$1
+    local out=$2
+
+    tr '\r\n\t' '   ' < $svd | sed 's/</\n</g' | awk -v svdname=`basename $svd` -v hname=`basename $out` '
+    function num(s,    n, i, c) {
+        s = tolower(s)
+        gsub(/[ \t]/, "", s)
+        n = 0
+        if (s ~ /^0x/) {
+            for (i = 3; i <= length(s); i++) n = n * 16 + index("0123456789abcdef", substr(s, i, 1)) - 1
+        } else if (s ~ /^#/) {
+            for (i = 2; i <= length(s); i++) n = n * 2 + (substr(s, i, 1) == "1")
+        } else {
+            n = s + 0
+        }
+        return n
+    }
+    function hex(v, w) { return sprintf("0x%0" w "X", v) }
+    function text(s) {
+        gsub(/^ +| +$/, "", s)
+        gsub(/ +/, " ", s)
+        gsub(/&lt;/, "<", s); gsub(/&gt;/, ">", s); gsub(/&quot;/, "\"", s); gsub(/&apos;/, "\047", s)
+        gsub(/&amp;/, "\\&", s)
+        return s
+    }
+    function ctype(size) { return size == 8 ? "uint8_t" : (size == 16 ? "uint16_t" : "uint32_t") }
+
+    BEGIN {
+        split("name description baseAddress addressOffset size access dim dimIncrement dimIndex " \
+              "bitOffset bitWidth lsb msb bitRange headerStructName", t, " ")
+        for (i in t) leaf[t[i]] = 1
+        np = 0; sp = 0; devsize = 32
+    }
+
+    # コメント
+    incomment { if ($0 ~ /-->/) incomment = 0; next }
+    /^<!--/ { if ($0 !~ /-->/) incomment = 1; next }
+    /^<[?!]/ { next }
+
+    /^</ {
+        tag = $0
+        sub(/^<\/?/, "", tag)
+        sub(/[ \/>].*/, "", tag)
+        body = $0
+        sub(/^[^>]*>/, "", body)
+
+        if ($0 ~ /^<\//) {                              # 閉じタグ
+            if (leaf[tag]) next
+            if (tag == "register") end_register()
+            sp--
+            next
+        }
+        if ($0 ~ /\/>/ && $0 !~ />[^>]*[^ ]/) {          # 空要素
+            if (tag == "peripheral") open_peripheral($0)
+            next
+        }
+        if (leaf[tag]) {
+            parent = stack[sp]
+            set(parent, tag, text(body))
+            next
+        }
+        stack[++sp] = tag
+        if (tag == "peripheral") open_peripheral($0)
+        else if (tag == "register") {
+            if (stack[sp - 1] != "registers") { skip_reg = 1; warn("cluster") }
+            else { nr = ++RN[np]; R_size[np, nr] = psize[np]; R_access[np, nr] = "read-write"; skip_reg = 0 }
+        }
+        else if (tag == "field") { nf = ++FN[np, nr] }
+        else if (tag == "cluster") warn("cluster")
+        next
+    }
+
+    function warn(what) { printf "svd2h: %s is not supported, skipped.\n", what > "/dev/stderr" }
+
+    function open_peripheral(line,    d) {
+        np++
+        RN[np] = 0
+        psize[np] = devsize
+        if (match(line, /derivedFrom="[^"]*"/)) {
+            d = substr(line, RSTART + 13, RLENGTH - 14)
+            P_derived[np] = d
+        }
+    }
+
+    function set(parent, tag, v) {
+        if (parent == "device") {
+            if (tag == "name") device = v
+            else if (tag == "size") devsize = num(v)
+        } else if (parent == "peripheral") {
+            if (tag == "name") { P_name[np] = v; pidx[v] = np }
+            else if (tag == "description") P_desc[np] = v
+            else if (tag == "baseAddress") P_base[np] = num(v)
+            else if (tag == "headerStructName") P_struct[np] = v
+            else if (tag == "size") psize[np] = num(v)
+        } else if (parent == "register" && !skip_reg) {
+            if (tag == "name") R_name[np, nr] = v
+            else if (tag == "description") R_desc[np, nr] = v
+            else if (tag == "addressOffset") R_off[np, nr] = num(v)
+            else if (tag == "size") R_size[np, nr] = num(v)
+            else if (tag == "access") R_access[np, nr] = v
+            else if (tag == "dim") R_dim[np, nr] = num(v)
+            else if (tag == "dimIncrement") R_inc[np, nr] = num(v)
+            else if (tag == "dimIndex") R_idx[np, nr] = v
+        } else if (parent == "field" && !skip_reg) {
+            if (tag == "name") F_name[np, nr, nf] = v
+            else if (tag == "description") F_desc[np, nr, nf] = v
+            else if (tag == "bitOffset" || tag == "lsb") F_lsb[np, nr, nf] = num(v)
+            else if (tag == "bitWidth") F_width[np, nr, nf] = num(v)
+            else if (tag == "msb") F_msb[np, nr, nf] = num(v)
+            else if (tag == "bitRange") {
+                v = substr(v, 2, length(v) - 2)
+                split(v, b, ":")
+                F_msb[np, nr, nf] = num(b[1]); F_lsb[np, nr, nf] = num(b[2])
+            }
+        }
+    }
+
+    # "MR%s" (dim 付き) を MR0, MR1, ... の個別のレジスタに展開する。"X[%s]" は配列のまま
+    function end_register(    n, i, k, idx, lo, hi, name, src) {
+        if (skip_reg) { skip_reg = 0; return }
+        name = R_name[np, nr]
+        if (!R_dim[np, nr] || name ~ /\[%s\]/) {
+            sub(/\[%s\]/, "", R_name[np, nr])
+            return
+        }
+        if (R_idx[np, nr] ~ /^[0-9]+-[0-9]+$/) {
+            split(R_idx[np, nr], b, "-"); n = 0
+            for (k = b[1] + 0; k <= b[2] + 0; k++) idx[n++] = k
+        } else if (R_idx[np, nr] != "") {
+            n = split(R_idx[np, nr], t, ",")
+            for (k = 1; k <= n; k++) idx[k - 1] = text(t[k])
+        } else {
+            n = R_dim[np, nr]
+            for (k = 0; k < n; k++) idx[k] = k
+        }
+        src = nr
+        for (i = 0; i < n; i++) {
+            if (i > 0) nr = ++RN[np]
+            R_name[np, nr] = name; sub(/%s/, idx[i], R_name[np, nr])
+            R_desc[np, nr] = R_desc[np, src]
+            R_off[np, nr] = R_off[np, src] + i * R_inc[np, src]
+            R_size[np, nr] = R_size[np, src]
+            R_access[np, nr] = R_access[np, src]
+            R_dim[np, nr] = 0
+            if (i > 0) {
+                FN[np, nr] = FN[np, src]
+                for (k = 1; k <= FN[np, src]; k++) {
+                    F_name[np, nr, k] = F_name[np, src, k]; F_desc[np, nr, k] = F_desc[np, src, k]
+                    F_lsb[np, nr, k] = F_lsb[np, src, k]; F_width[np, nr, k] = F_width[np, src, k]
+                    F_msb[np, nr, k] = F_msb[np, src, k]
+                }
+            }
+        }
+        R_dim[np, src] = 0
+    }
+
+    # レジスタ j のバイト数 (配列なら全体)
+    function rbytes(p, j) { return (R_dim[p, j] ? R_dim[p, j] : 1) * R_size[p, j] / 8 }
+
+    function member(p, j, indent,    decl, q) {
+        q = (R_access[p, j] == "read-only") ? "const volatile " : "volatile "
+        decl = q ctype(R_size[p, j]) " " R_name[p, j] (R_dim[p, j] ? "[" R_dim[p, j] "]" : "") ";"
+        printf "%s%-40s /* %s %s */\n", indent, decl, hex(R_off[p, j], 3), R_desc[p, j]
+    }
+
+    function emit_struct(p, sname,    n, i, j, k, t, ord, pos, nres, gap, end, w) {
+        # アドレス順に並べる (挿入ソート)
+        n = RN[p]
+        for (i = 1; i <= n; i++) ord[i] = i
+        for (i = 2; i <= n; i++) {
+            t = ord[i]
+            for (k = i - 1; k >= 1 && R_off[p, ord[k]] > R_off[p, t]; k--) ord[k + 1] = ord[k]
+            ord[k + 1] = t
+        }
+
+        printf "/*\n * %s: %s\n */\n", P_name[p], P_desc[p]
+        printf "typedef struct %s_regs {\n", sname
+        pos = 0; nres = 0
+        for (i = 1; i <= n; i = k) {
+            j = ord[i]
+            gap = R_off[p, j] - pos
+            if (gap < 0) {
+                printf "svd2h: %s.%s overlaps the previous register.\n", P_name[p], R_name[p, j] > "/dev/stderr"
+                exit 1
+            }
+            if (gap > 0) {
+                w = (gap % 4 == 0 && pos % 4 == 0) ? 4 : 1
+                printf "    %-40s /* %s */\n", sprintf("%s __reserved%d[%d];", w == 4 ? "uint32_t" : "uint8_t", nres++, gap / w), hex(pos, 3)
+            }
+            # 同じアドレスのレジスタは共用体にまとめる
+            for (k = i + 1; k <= n && R_off[p, ord[k]] == R_off[p, j]; k++);
+            if (k - i > 1) {
+                printf "    union {\n"
+                end = 0
+                for (t = i; t < k; t++) {
+                    member(p, ord[t], "        ")
+                    if (rbytes(p, ord[t]) > end) end = rbytes(p, ord[t])
+                }
+                printf "    };\n"
+            } else {
+                member(p, j, "    ")
+                end = rbytes(p, j)
+            }
+            pos = R_off[p, j] + end
+        }
+        printf "} %s_regs_t;\n\n", sname
+
+        for (i = 1; i <= n; i++) {
+            j = ord[i]
+            printf "_Static_assert(offsetof(%s_regs_t, %s) == %s, \"%s.%s\");\n", \
+                sname, R_name[p, j], hex(R_off[p, j], 3), P_name[p], R_name[p, j]
+        }
+        printf "\n"
+    }
+
+    function emit_fields(p, prefix,    j, k, w, any) {
+        any = 0
+        for (j = 1; j <= RN[p]; j++) {
+            for (k = 1; k <= FN[p, j]; k++) {
+                w = F_width[p, j, k] ? F_width[p, j, k] : F_msb[p, j, k] - F_lsb[p, j, k] + 1
+                printf "#define %-40s %d\n", prefix "_" R_name[p, j] "_" F_name[p, j, k] "_Pos", F_lsb[p, j, k]
+                printf "#define %-40s (%sU << %d)", prefix "_" R_name[p, j] "_" F_name[p, j, k] "_Msk", \
+                    hex(2 ^ w - 1, 1), F_lsb[p, j, k]
+                printf "%s\n", F_desc[p, j, k] != "" ? "    /* " F_desc[p, j, k] " */" : ""
+                any = 1
+            }
+        }
+        if (any) printf "\n"
+    }
+
+    END {
+        guard = "__" toupper(hname) "__"
+        gsub(/[^A-Z0-9_]/, "_", guard)
+
+        printf "/* -*- coding: utf-8 -*- */\n\n"
+        printf "/**\n * @file %s\n", hname
+        printf " * @brief %s ペリフェラルレジスタの構造体オーバーレイ\n", device
+        printf " * @details tools/svd2h.sh で %s から生成した。手で編集しないこと。\n */\n\n", svdname
+        printf "#ifndef %s\n#define %s\n\n#include <stdint.h>\n#include <stddef.h>\n\n", guard, guard
+
+        for (p = 1; p <= np; p++) {
+            if (P_derived[p] != "") continue
+            sname[p] = tolower(P_struct[p] != "" ? P_struct[p] : P_name[p])
+            emit_struct(p, sname[p])
+            emit_fields(p, toupper(sname[p]))
+        }
+
+        printf "/*\n * ベースアドレス\n */\n\n"
+        for (p = 1; p <= np; p++) {
+            s = (P_derived[p] != "") ? sname[pidx[P_derived[p]]] : sname[p]
+            if (s == "") {
+                printf "svd2h: %s is derived from unknown %s.\n", P_name[p], P_derived[p] > "/dev/stderr"
+                exit 1
+            }
+            printf "#ifndef %s_BASE\n  #define %s_BASE %s\n#endif\n", P_name[p], P_name[p], hex(P_base[p], 8)
+            printf "#define LPC_%-8s ((%s_regs_t *)%s_BASE)\n\n", P_name[p], s, P_name[p]
+        }
+        printf "#endif\n"
+    }' > $out
+}
+
+main $*
@@ -0,0 +1,49 @@
+/* -*- coding: utf-8 -*- */
+
+/**
+ * @file main.c
+ * @brief ユーザプログラムの main 関数
+ */
+
+#include <stdint.h>
+#include "system.h"
+#include "cdc.h"
+#include "isrtrace.h"
+
+/**
+ * @brief USB 仮想 COM ポートで受信したデータをそのまま送り返す (エコーバック)
+ * @return 0: 正常終了
+ * @details 受信パケットごとに LED3 を反転させる。
+ */
+int main(void)
+{
+    uint8_t led = 0;
+
+    gpio_init();
+    gpio_set_dir(3, 0, 1);    /* GPIO3_0: LED 出力 */
+    gpio_write(3, 0, led);
+
+    cdc_init();
+    #if (ISRTRACE_ENABLE)
+        isrtrace_start();    /* tools/isrtrace.sh で吸い出す */
+    #endif
+
+    while (1) {
+        uint16_t i, len;
+        const uint8_t *rx = cdc_rx_peek(&len);
+        uint8_t *tx;
+
+        if (rx == 0 || (tx = cdc_tx_alloc()) == 0) continue;
+
+        for (i = 0; i < len; i++) {
+            tx[i] = rx[i];
+        }
+        cdc_tx_commit(len);
+        cdc_rx_release();
+
+        led = !led;
+        gpio_write(3, 0, led);
+    }
+
+    return 0;
+}